@@ -11,6 +11,11 @@
 #include <zeno/types/ListObject.h>
 #include "AudioFile.h"
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <string_view>
 
 #define MINIMP3_IMPLEMENTATION
 #define MINIMP3_FLOAT_OUTPUT
@@ -88,6 +93,40 @@ static std::shared_ptr<PrimitiveObject> readMp3(std::string path) {
     return std::move(result);
 }
 
+// Decoded clips keyed by path, modification time and size, so cooking the
+// graph again does not decode the same file again. Callers get a copy of the
+// cached primitive, since audio nodes like AudioTrim edit their input in place.
+static std::shared_ptr<PrimitiveObject> readAudioCached(std::string const &path, bool isMp3) {
+    static std::mutex mtx;
+    static std::list<std::pair<std::string, std::shared_ptr<PrimitiveObject>>> cache;
+    constexpr size_t kMaxCachedClips = 8;
+
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    auto fsize = std::filesystem::file_size(path, ec);
+    auto key = path + '|' + std::to_string(mtime) + '|' + std::to_string(fsize);
+
+    std::shared_ptr<PrimitiveObject> decoded;
+    {
+        std::lock_guard lck(mtx);
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            if (it->first == key) {
+                cache.splice(cache.begin(), cache, it);
+                decoded = it->second;
+                break;
+            }
+        }
+    }
+    if (!decoded) {
+        decoded = isMp3 ? readMp3(path) : readWav(path);
+        std::lock_guard lck(mtx);
+        cache.emplace_front(key, decoded);
+        if (cache.size() > kMaxCachedClips)
+            cache.pop_back();
+    }
+    return std::make_shared<PrimitiveObject>(*decoded);
+}
+
     struct ReadWavFile : zeno::INode {
         virtual void apply() override {
             auto path = get_input<StringObject>("path")->get(); // std::string
@@ -140,11 +179,11 @@ static std::shared_ptr<PrimitiveObject> readMp3(std::string path) {
             if(pFile !=NULL) {
                 if (strcmp(pFile, ".wav") == 0) {
                     zeno::log_debug("is wave");
-                    auto result = zeno::readWav(path);
+                    auto result = zeno::readAudioCached(path, false);
                     set_output("wave", result);
                 } else if (strcmp(pFile, ".mp3") == 0) {
                     zeno::log_debug("is mp3");
-                    auto result = zeno::readMp3(path);
+                    auto result = zeno::readAudioCached(path, true);
                     set_output("wave", result);
                 }
             }
@@ -543,4 +582,231 @@ static std::shared_ptr<PrimitiveObject> readMp3(std::string path) {
             "audio",
         },
     });
+
+    // Short-time power spectrum of a whole clip, computed once so that every
+    // per-frame query below is a table lookup. Frame f covers the samples
+    // [f * hop, f * hop + window).
+    struct AudioSpectrogramObject : IObjectClone<AudioSpectrogramObject> {
+        int window = 1024;
+        int hop = 512;
+        float sampleRate = 44100;
+        int frames = 0;
+        int bins = 0; // window / 2 + 1
+        std::vector<double> cumPower; // [frame][bin + 1], prefix sums of |X|^2 over bins
+        std::vector<float> energy;    // sum of |X|^2 over the full spectrum / window, as AudioBeats
+        std::vector<float> flux;      // positive spectral flux, onset strength
+        std::vector<float> avgH;      // mean of energy over the 43 frames up to f
+        std::vector<float> varH;      // variance of energy over the same frames
+        float minE = 0, maxE = 0;
+
+        int frameAt(float time) const {
+            int f = int(std::floor(time * sampleRate / hop));
+            return std::clamp(f, 0, std::max(frames - 1, 0));
+        }
+
+        float square(int f, int bin) const {
+            return float(cumPower[(size_t)f * (bins + 1) + bin + 1] - cumPower[(size_t)f * (bins + 1) + bin]);
+        }
+
+        // |X|^2 summed over the bins whose center frequency lies in [lowHz, highHz]
+        float bandEnergy(int f, float lowHz, float highHz) const {
+            int lo = std::clamp(int(std::ceil(lowHz * window / sampleRate)), 0, bins);
+            int hi = std::clamp(int(std::floor(highHz * window / sampleRate)) + 1, lo, bins);
+            auto row = cumPower.data() + (size_t)f * (bins + 1);
+            return float(row[hi] - row[lo]);
+        }
+    };
+
+    static std::shared_ptr<AudioSpectrogramObject> computeSpectrogram(std::vector<float> const &value, float sampleRate,
+                                                                       int window, int hop, std::string const &windowFunc) {
+        auto res = std::make_shared<AudioSpectrogramObject>();
+        res->window = window;
+        res->hop = hop;
+        res->sampleRate = sampleRate;
+        res->bins = window / 2 + 1;
+        res->frames = value.empty() ? 0 : int((value.size() + hop - 1) / hop);
+        int N = window, B = res->bins, F = res->frames;
+
+        std::vector<double> coef(N, 1.0);
+        if (windowFunc == "hamming") {
+            for (int i = 0; i < N; i++)
+                coef[i] = 0.54 - 0.46 * std::cos(2.0 * M_PI * i / (N - 1));
+        } else if (windowFunc == "hann") {
+            for (int i = 0; i < N; i++)
+                coef[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / (N - 1));
+        }
+
+        res->cumPower.resize((size_t)F * (B + 1));
+        res->energy.resize(F);
+        std::vector<float> mag((size_t)F * B);
+#pragma omp parallel
+        {
+            // Aquila FFT objects keep work buffers, one per thread
+            auto fft = Aquila::FftFactory::getFft(N);
+            std::vector<double> samples(N);
+#pragma omp for schedule(dynamic, 16)
+            for (int f = 0; f < F; f++) {
+                size_t base = (size_t)f * hop;
+                for (int i = 0; i < N; i++)
+                    samples[i] = value[std::min(base + i, value.size() - 1)] * coef[i];
+                Aquila::SpectrumType spectrums = fft->fft(samples.data());
+                double *row = res->cumPower.data() + (size_t)f * (B + 1);
+                row[0] = 0;
+                double E = 0;
+                for (int k = 0; k < N; k++) {
+                    double sq = spectrums[k].real() * spectrums[k].real() + spectrums[k].imag() * spectrums[k].imag();
+                    E += sq;
+                    if (k < B) {
+                        row[k + 1] = row[k] + sq;
+                        mag[(size_t)f * B + k] = (float)std::sqrt(sq);
+                    }
+                }
+                res->energy[f] = float(E / N);
+            }
+        }
+
+        res->flux.assign(F, 0.f);
+#pragma omp parallel for
+        for (int f = 1; f < F; f++) {
+            float sum = 0;
+            for (int k = 0; k < B; k++)
+                sum += std::max(0.f, mag[(size_t)f * B + k] - mag[(size_t)(f - 1) * B + k]);
+            res->flux[f] = sum;
+        }
+
+        // sliding statistics of the last 43 frames through prefix sums
+        constexpr int kHistory = 43;
+        res->avgH.resize(F);
+        res->varH.resize(F);
+        std::vector<double> s1(F + 1, 0.0), s2(F + 1, 0.0);
+        for (int f = 0; f < F; f++) {
+            s1[f + 1] = s1[f] + res->energy[f];
+            s2[f + 1] = s2[f] + (double)res->energy[f] * res->energy[f];
+        }
+        for (int f = 0; f < F; f++) {
+            int b = std::max(f + 1 - kHistory, 0), n = f + 1 - b;
+            double avg = (s1[f + 1] - s1[b]) / n;
+            res->avgH[f] = float(avg);
+            res->varH[f] = float(std::max(0.0, (s2[f + 1] - s2[b]) / n - avg * avg));
+        }
+        if (F) {
+            auto [mn, mx] = std::minmax_element(res->energy.begin(), res->energy.end());
+            res->minE = *mn;
+            res->maxE = *mx;
+        }
+        return res;
+    }
+
+    struct AudioSpectrogram : zeno::INode {
+        virtual void apply() override {
+            auto wave = get_input<PrimitiveObject>("wave");
+            auto window = get_input2<int>("window");
+            auto hop = get_input2<int>("hop");
+            auto windowFunc = get_input2<std::string>("windowFunc");
+            if (window < 2 || (window & (window - 1)) != 0)
+                throw makeError("AudioSpectrogram: window must be a power of two");
+            if (hop <= 0)
+                throw makeError("AudioSpectrogram: hop must be positive");
+            auto &value = wave->attr<float>("value");
+            float sampleRate = wave->userData().get<zeno::NumericObject>("SampleRate")->get<float>();
+
+            // the graph cooks once per frame, keep the last few spectrograms by the
+            // content of the samples: any node may have edited them in place, and
+            // hashing is far cheaper than the transforms
+            static std::mutex mtx;
+            static std::list<std::pair<std::string, std::shared_ptr<AudioSpectrogramObject>>> cache;
+            constexpr size_t kMaxCached = 8;
+            auto samplesHash = std::hash<std::string_view>{}({(const char *)value.data(), value.size() * sizeof(float)});
+            auto key = std::to_string(samplesHash) + '|' + std::to_string(value.size()) + '|' + std::to_string(sampleRate)
+                       + '|' + std::to_string(window) + '|' + std::to_string(hop) + '|' + windowFunc;
+            std::shared_ptr<AudioSpectrogramObject> spec;
+            {
+                std::lock_guard lck(mtx);
+                for (auto it = cache.begin(); it != cache.end(); ++it) {
+                    if (it->first == key) {
+                        cache.splice(cache.begin(), cache, it);
+                        spec = it->second;
+                        break;
+                    }
+                }
+            }
+            if (!spec) {
+                spec = computeSpectrogram(value, sampleRate, window, hop, windowFunc);
+                std::lock_guard lck(mtx);
+                cache.emplace_front(key, spec);
+                if (cache.size() > kMaxCached)
+                    cache.pop_back();
+            }
+            set_output("spectrogram", std::move(spec));
+        }
+    };
+    ZENDEFNODE(AudioSpectrogram, {
+        {
+            "wave",
+            {"int", "window", "1024"},
+            {"int", "hop", "512"},
+            {"enum none hamming hann", "windowFunc", "none"},
+        },
+        {
+            "spectrogram",
+        },
+        {},
+        {
+            "audio",
+        },
+    });
+
+    struct AudioSpectrogramSample : zeno::INode {
+        virtual void apply() override {
+            auto spec = get_input<AudioSpectrogramObject>("spectrogram");
+            if (spec->frames == 0)
+                throw makeError("AudioSpectrogramSample: empty spectrogram");
+            int f = spec->frameAt(get_input2<float>("time"));
+
+            float E = spec->energy[f];
+            float threshold = get_input2<float>("threshold");
+            int beat = E - threshold > (-15 * spec->varH[f] + 1.55) * spec->avgH[f];
+            float range = spec->maxE - spec->minE;
+            set_output("beat", std::make_shared<NumericObject>(beat));
+            set_output("onset", std::make_shared<NumericObject>(spec->flux[f]));
+            set_output("E", std::make_shared<NumericObject>(E));
+            set_output("uniE", std::make_shared<NumericObject>(range > 0 ? (E - spec->minE) / range : 0.f));
+            set_output("var_H", std::make_shared<NumericObject>(spec->varH[f]));
+            auto band = get_input2<zeno::vec2f>("bandHz");
+            set_output("bandEnergy", std::make_shared<NumericObject>(spec->bandEnergy(f, band[0], band[1])));
+
+            auto fft_prim = std::make_shared<PrimitiveObject>();
+            fft_prim->resize(spec->bins);
+            auto &freq = fft_prim->add_attr<float>("freq");
+            auto &square = fft_prim->add_attr<float>("square");
+            auto &power = fft_prim->add_attr<float>("power");
+            for (int i = 0; i < spec->bins; i++) {
+                freq[i] = float(i);
+                square[i] = spec->square(f, i);
+                power[i] = square[i] / spec->window;
+            }
+            set_output("FFTPrim", fft_prim);
+        }
+    };
+    ZENDEFNODE(AudioSpectrogramSample, {
+        {
+            "spectrogram",
+            {"float", "time", "0"},
+            {"float", "threshold", "0.005"},
+            {"vec2f", "bandHz", "0,200"},
+        },
+        {
+            "beat",
+            "onset",
+            "E",
+            "uniE",
+            "var_H",
+            "bandEnergy",
+            "FFTPrim",
+        },
+        {},
+        {
+            "audio",
+        },
+    });
 } // namespace zeno
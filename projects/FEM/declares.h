@@ -30,6 +30,7 @@
 #include <Eigen/Geometry> 
 
 #include <type_traits>
+#include <array>
 #include <variant>
 
 #include <cstdlib>
@@ -115,6 +116,14 @@ struct FEMIntegrator : zeno::IObject {
     std::vector<double> _elmCharacteristicNorm;
 
     SpMat _connMatrix;
+    // for every element, the offsets of its 12x12 hessian entries (row major)
+    // into the value array of _connMatrix, so that assembly skips coeffRef
+    std::vector<std::array<int,144>> _elmHIndices;
+
+    // the symbolic factorisation only depends on _connMatrix, it is redone
+    // only when PrecomputeFEMInfo rebuilds the connectivity
+    Eigen::SimplicialLDLT<SpMat> _LDLTSolver;
+    bool _patternAnalyzed = false;
 
     size_t _stepID;
 
@@ -154,6 +163,21 @@ struct FEMIntegrator : zeno::IObject {
         _connMatrix.setFromTriplets(connTriplets.begin(),connTriplets.end());
         _connMatrix.makeCompressed();
 
+        _elmHIndices.resize(nm_elms);
+        #pragma omp parallel for
+        for (auto elm_id = 0; elm_id < nm_elms; ++elm_id) {
+            const auto& elm = prim->quads[elm_id];
+            for (size_t i = 0; i < 12; ++i)
+                for (size_t j = 0; j < 12; ++j) {
+                    auto row = elm[i / 3] * 3 + i % 3;
+                    auto col = elm[j / 3] * 3 + j % 3;
+                    auto beg = _connMatrix.innerIndexPtr() + _connMatrix.outerIndexPtr()[col];
+                    auto end = _connMatrix.innerIndexPtr() + _connMatrix.outerIndexPtr()[col + 1];
+                    _elmHIndices[elm_id][i * 12 + j] = int(std::lower_bound(beg, end, row) - _connMatrix.innerIndexPtr());
+                }
+        }
+        _patternAnalyzed = false;
+
         // _elmVolume.resize(nm_elms);
         _elmdFdx.resize(nm_elms);
         _elmMinv.resize(nm_elms);
@@ -487,17 +511,16 @@ struct FEMIntegrator : zeno::IObject {
             return obj;
     }
 
-    FEM_Scaler EvalObjDerivHessian(const std::shared_ptr<PrimitiveObject>& shape,
+    // evaluate the element-wise energy, gradient and hessian without assembling them
+    void EvalElmObjDerivHessians(const std::shared_ptr<PrimitiveObject>& shape,
         const std::shared_ptr<PrimitiveObject>& elmView,
         const std::shared_ptr<PrimitiveObject>& interpShape,
-        VecXd& deriv,VecXd& HValBuffer,bool enforce_spd) {
-            FEM_Scaler obj = 0;
-            size_t clen = _staticPtr->GetCouplingLength();
+        std::vector<double>& objBuffer,std::vector<Vec12d>& derivBuffer,
+        std::vector<Mat12x12d>& HBuffer,bool enforce_spd) {
             size_t nm_elms = shape->quads.size();
-
-            std::vector<double> objBuffer(nm_elms);
-            std::vector<Vec12d> derivBuffer(nm_elms);
-            std::vector<Mat12x12d> HBuffer(nm_elms);
+            objBuffer.resize(nm_elms);
+            derivBuffer.resize(nm_elms);
+            HBuffer.resize(nm_elms);
 
             const auto& cpos = shape->attr<zeno::vec3f>("curPos");
             const auto& ppos = shape->attr<zeno::vec3f>("prePos");
@@ -540,47 +563,95 @@ struct FEMIntegrator : zeno::IObject {
                         elm_traj,
                         &objBuffer[elm_id],derivBuffer[elm_id],HBuffer[elm_id],enforce_spd);
                 }
-
-                // if(elm_id == 0)
-                //     std::cout << "ELM_H<" << elm_id << ">:" << HBuffer[elm_id].squaredNorm() << std::endl;
             }
+    }
 
-            // for(size_t elm_id = 0;elm_id < nm_elms;++elm_id){
-            //     auto tet = shape->quads[elm_id];
-            //     for(size_t i = 0;i < 4;++i)
-            //         if(tet[i] == shape->quads[11221][0]){
-            //             std::cout << "add<" << shape->quads[11221][0] << "> : " << derivBuffer[elm_id].segment(i*3,3).transpose() << std::endl;
-            //         }
-            // }
-
-
-            deriv.setZero();
-            HValBuffer.setZero();
+    FEM_Scaler EvalObjDerivHessian(const std::shared_ptr<PrimitiveObject>& shape,
+        const std::shared_ptr<PrimitiveObject>& elmView,
+        const std::shared_ptr<PrimitiveObject>& interpShape,
+        VecXd& deriv,VecXd& HValBuffer,bool enforce_spd) {
+            size_t nm_elms = shape->quads.size();
 
-            // std::cout << "SIZE_OF_H_MATRIX : " << HValBuffer.size() << std::endl;
+            std::vector<double> objBuffer;
+            std::vector<Vec12d> derivBuffer;
+            std::vector<Mat12x12d> HBuffer;
+            EvalElmObjDerivHessians(shape,elmView,interpShape,objBuffer,derivBuffer,HBuffer,enforce_spd);
 
-            // std::cout << "ASSEMBLE_HERE" << std::endl;
-            for(size_t elm_id = 0;elm_id < nm_elms;++elm_id){
-                auto tet = shape->quads[elm_id];
+            FEM_Scaler obj = 0;
+            for(size_t elm_id = 0;elm_id < nm_elms;++elm_id)
                 obj += objBuffer[elm_id];
-                // std::cout << "ASSEMBLE_ELM_VECTOR" << std::endl;
-                AssembleElmVector(tet,derivBuffer[elm_id],deriv);
-                // std::cout << "ASSEMBLE_ELM_MATRIX" << std::endl;
-                AssembleElmMatrixAdd(tet,HBuffer[elm_id],MatHelper::MapHMatrixRef(shape->size(),_connMatrix,HValBuffer.data()));
-                // std::cout << "FINISH ASSEMBLING" << std::endl;
-            }
 
-            // auto tet = shape->quads[11221];
-            // std::cout << "g1:\n" <<  
-            //     -deriv.segment(tet[0]*3,3).transpose() << "\t" << 
-            //     -deriv.segment(tet[1]*3,3).transpose() << "\t" << 
-            //     -deriv.segment(tet[2]*3,3).transpose() << "\t" << 
-            //     -deriv.segment(tet[3]*3,3).transpose() << std::endl;
-            
-            // std::cout << "FINISH ASSEMBLING" << std::endl;
+            AssembleElmVectors(shape->quads.values,derivBuffer,deriv);
+            AssembleElmMatrices(HBuffer,HValBuffer);
             return obj;
     }
 
+    // scatter the element hessians into the value array of _connMatrix in parallel
+    void AssembleElmMatrices(const std::vector<Mat12x12d>& elm_Hs,VecXd& HValBuffer) const {
+        HValBuffer.setZero();
+        constexpr int seg = 8;
+        const auto nseg = (elm_Hs.size() + seg - 1) / seg;
+        #pragma omp parallel for
+        for(auto ii = 0;ii < nseg;++ii)
+        for(size_t k = 0; k != seg; ++k) {
+            size_t elm_id = ii * seg + k;
+            if (elm_id >= elm_Hs.size()) break;
+            const auto& idx = _elmHIndices[elm_id];
+            for(size_t i = 0;i != 12;++i)
+                for(size_t j = 0;j != 12;++j)
+                    AtomicDoubleAdd(&HValBuffer.data()[idx[i * 12 + j]],elm_Hs[elm_id](i,j));
+        }
+    }
+
+    // numerically refactorise the hessian, reusing the symbolic analysis of the
+    // connectivity pattern across Newton iterations and frames
+    bool FactorizeHessian(size_t nm_verts,VecXd& HValBuffer) {
+        auto H = MatHelper::MapHMatrix(nm_verts,_connMatrix,HValBuffer.data());
+        if(!_patternAnalyzed){
+            _LDLTSolver.analyzePattern(H);
+            _patternAnalyzed = true;
+        }
+        _LDLTSolver.factorize(H);
+        return _LDLTSolver.info() == Eigen::Success;
+    }
+
+    // y = H * x, with H given by the unassembled element hessians
+    void ApplyElmMatrices(const std::vector<zeno::vec4i>& elms,const std::vector<Mat12x12d>& elm_Hs,
+            const VecXd& x,VecXd& y) const {
+        y.setZero();
+        constexpr int seg = 8;
+        const auto nseg = (elms.size() + seg - 1) / seg;
+        #pragma omp parallel for
+        for(auto ii = 0;ii < nseg;++ii)
+        for(size_t k = 0; k != seg; ++k) {
+            size_t elm_id = ii * seg + k;
+            if (elm_id >= elms.size()) break;
+            const auto& elm = elms[elm_id];
+            Vec12d xe;
+            for(size_t i = 0;i != 4;++i)
+                xe.segment(i*3,3) = x.segment(elm[i]*3,3);
+            Vec12d ye = elm_Hs[elm_id] * xe;
+            for(size_t j = 0;j != 12;++j)
+                AtomicDoubleAdd(&y.data()[elm[j/3] * 3 + j % 3],ye[j]);
+        }
+    }
+
+    // the inverse 3x3 diagonal blocks of the assembled hessian, used as block-Jacobi preconditioner
+    void ComputeBlockJacobi(const std::vector<zeno::vec4i>& elms,const std::vector<Mat12x12d>& elm_Hs,
+            size_t nm_verts,std::vector<Mat3x3d>& invDiag) const {
+        invDiag.assign(nm_verts,Mat3x3d::Zero());
+        for(size_t elm_id = 0;elm_id < elms.size();++elm_id)
+            for(size_t i = 0;i != 4;++i)
+                invDiag[elms[elm_id][i]] += elm_Hs[elm_id].block<3,3>(i*3,i*3);
+        #pragma omp parallel for
+        for(auto i = 0;i < nm_verts;++i){
+            if(fabs(invDiag[i].determinant()) > 1e-20)
+                invDiag[i] = invDiag[i].inverse().eval();
+            else
+                invDiag[i].setIdentity();
+        }
+    }
+
     void RetrieveElmCurrentShape(size_t elm_id,Vec12d& elm_vec,const std::shared_ptr<PrimitiveObject>& shape) const{  
         const auto& elm = shape->quads[elm_id];
         const auto& cpos = shape->attr<zeno::vec3f>("curPos");
@@ -590,7 +661,7 @@ struct FEMIntegrator : zeno::IObject {
 
 
 
-    void AssembleElmVectors(const std::vector<zeno::vec4i>& elms,const std::vector<Vec12d>& elm_vecs,VecXd& global_vec) const {
+    static double AtomicDoubleAdd(double* dst, double val) {
         auto atomicCas = [](int64_t* dest,int64_t expected,int64_t desired) {
 #if defined(_MSC_VER)
             return InterlockedCompareExchange64(dest, desired, expected);   // (__int64 *)
@@ -599,17 +670,17 @@ struct FEMIntegrator : zeno::IObject {
             return expected;
 #endif
         };
-        auto atomicDoubleAdd = [&atomicCas](double*dst, double val) {
-            static_assert(sizeof(double) == sizeof(int64_t), "sizeof float != sizeof int");
-            int64_t oldVal = reinterpret_bits<int64_t>(*dst);
-            int64_t newVal = reinterpret_bits<int64_t>(reinterpret_bits<double>(oldVal) + val), readVal{};
-            while ((readVal = atomicCas((int64_t*)dst, oldVal, newVal)) != oldVal) {
-                oldVal = readVal;
-                newVal = reinterpret_bits<int64_t>(reinterpret_bits<double>(readVal) + val);
-            }
-            return reinterpret_bits<double>(oldVal);
-        };
+        static_assert(sizeof(double) == sizeof(int64_t), "sizeof float != sizeof int");
+        int64_t oldVal = reinterpret_bits<int64_t>(*dst);
+        int64_t newVal = reinterpret_bits<int64_t>(reinterpret_bits<double>(oldVal) + val), readVal{};
+        while ((readVal = atomicCas((int64_t*)dst, oldVal, newVal)) != oldVal) {
+            oldVal = readVal;
+            newVal = reinterpret_bits<int64_t>(reinterpret_bits<double>(readVal) + val);
+        }
+        return reinterpret_bits<double>(oldVal);
+    }
 
+    void AssembleElmVectors(const std::vector<zeno::vec4i>& elms,const std::vector<Vec12d>& elm_vecs,VecXd& global_vec) const {
         global_vec.setZero();
 
         // #pragma omp parallel for
@@ -619,7 +690,7 @@ struct FEMIntegrator : zeno::IObject {
         //     auto v_id = elm[(i%12)/3];
         //     auto d_id = (i % 12) % 3;
         //     auto val = elm_vecs[elm_id][i % 12];
-        //     atomicDoubleAdd(&global_vec.data()[v_id * 3 + d_id],val);
+        //     AtomicDoubleAdd(&global_vec.data()[v_id * 3 + d_id],val);
         // }
 
 #if 0
@@ -631,7 +702,7 @@ struct FEMIntegrator : zeno::IObject {
                 auto v_id = elm[j/3];
                 auto d_id = j % 3;
                 auto val = elm_vecs[elm_id][j];
-                atomicDoubleAdd(&global_vec.data()[v_id * 3 + d_id],val);
+                AtomicDoubleAdd(&global_vec.data()[v_id * 3 + d_id],val);
             }
         }
 #else
@@ -647,7 +718,7 @@ struct FEMIntegrator : zeno::IObject {
                 auto v_id = elm[j/3];
                 auto d_id = j % 3;
                 auto val = elm_vecs[elm_id][j];
-                atomicDoubleAdd(&global_vec.data()[v_id * 3 + d_id],val);
+                AtomicDoubleAdd(&global_vec.data()[v_id * 3 + d_id],val);
             }
         }
 #endif
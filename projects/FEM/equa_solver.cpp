@@ -388,9 +388,6 @@ ZENDEFNODE(SolveFEMFast,{
 struct SolveFEM : zeno::INode {
     virtual void apply() override {
         // std::cout << "BEGIN SOLVER " << std::endl;
-        Eigen::SparseLU<SpMat> _LUSolver;
-        Eigen::SimplicialLDLT<SpMat> _LDLTSolver;
-
         auto integrator = get_input<FEMIntegrator>("integrator");
         auto shape = get_input<PrimitiveObject>("shape");
         auto elmView = get_input<PrimitiveObject>("elmView");
@@ -409,6 +406,9 @@ struct SolveFEM : zeno::INode {
         auto c2 = get_input2<float>("CurvatureCoeff");
         auto beta = get_input2<float>("BTL_shrinkingRate");
         auto epsilon = get_input2<float>("epsilon");
+        auto use_pcg = get_input2<std::string>("linearSolver") == "PCG";
+        auto max_cg_iters = get_input2<int>("maxCGIters");
+        auto cg_tol = get_input2<float>("cgTolerance");
 
         std::vector<Vec2d> wolfeBuffer;
         wolfeBuffer.resize(max_linesearch);
@@ -418,7 +418,17 @@ struct SolveFEM : zeno::INode {
         VecXd r,HBuffer,dp;
         r.resize(shape->size() * 3);
         dp.resize(shape->size() * 3);
-        HBuffer.resize(integrator->_connMatrix.nonZeros());
+        if(!use_pcg)
+            HBuffer.resize(integrator->_connMatrix.nonZeros());
+
+        // element-wise buffers of the matrix-free path
+        std::vector<double> elmObjs;
+        std::vector<Vec12d> elmDerivs;
+        std::vector<Mat12x12d> elmHs;
+
+        int total_linesearch = 0;
+        int total_linear_iters = 0;
+        FEM_Scaler total_solve_time = 0;
 
         auto& cpos = shape->attr<zeno::vec3f>("curPos");
         auto& ppos = shape->attr<zeno::vec3f>("prePos");
@@ -441,7 +451,14 @@ struct SolveFEM : zeno::INode {
         FEM_Scaler e0,e1,eg0;
         do{
 
-            e0 = integrator->EvalObjDerivHessian(shape,elmView,interpShape,r,HBuffer,true);
+            if(use_pcg){
+                integrator->EvalElmObjDerivHessians(shape,elmView,interpShape,elmObjs,elmDerivs,elmHs,true);
+                e0 = 0;
+                for(auto obj : elmObjs)
+                    e0 += obj;
+                integrator->AssembleElmVectors(shape->quads.values,elmDerivs,r);
+            }else
+                e0 = integrator->EvalObjDerivHessian(shape,elmView,interpShape,r,HBuffer,true);
             // std::cout << "FINISH EVAL A X B" << std::endl;
             
             if(iter_idx == 0)
@@ -515,9 +532,15 @@ struct SolveFEM : zeno::INode {
             r *= -1;
 
             clock_t begin_solve = clock();
-            _LDLTSolver.compute(MatHelper::MapHMatrix(shape->size(),integrator->_connMatrix,HBuffer.data()));
-            dp = _LDLTSolver.solve(r);
+            if(use_pcg){
+                total_linear_iters += SolvePCG(*integrator,shape->quads.values,elmHs,shape->size(),r,dp,max_cg_iters,cg_tol);
+            }else{
+                if(!integrator->FactorizeHessian(shape->size(),HBuffer))
+                    throw std::runtime_error("hessian factorization failed");
+                dp = integrator->_LDLTSolver.solve(r);
+            }
             clock_t end_solve = clock();
+            total_solve_time += (float)(end_solve - begin_solve)/CLOCKS_PER_SEC;
 
             // std::cout << "INTERNAL SIZE : " << r.norm() << "\t" << dp.norm() << HBuffer.norm() << std::endl;
 
@@ -552,6 +575,7 @@ struct SolveFEM : zeno::INode {
 
                     armijo_condition = double(e1) - double(e0) - double(c1)*double(alpha)*double(eg0);
                 }while(/*(e1 > e0 + c1*alpha*eg0)*/ armijo_condition > 0.0f /* || (fabs(eg1) > c2*fabs(eg0))*/ && (search_idx < max_linesearch));
+                total_linesearch += search_idx;
 
                 if(search_idx == max_linesearch){
                     std::cout << "LINESEARCH EXCEED" << std::endl;
@@ -572,7 +596,51 @@ struct SolveFEM : zeno::INode {
         }
         std::cout << "FINISH STEPPING " << "\t" << iter_idx << "\t" << r.norm() << std::endl;
         set_output("shape",shape); 
+        set_output("newtonIters",std::make_shared<zeno::NumericObject>((int)iter_idx));
+        set_output("lineSearchIters",std::make_shared<zeno::NumericObject>(total_linesearch));
+        set_output("linearIters",std::make_shared<zeno::NumericObject>(total_linear_iters));
+        set_output("residual",std::make_shared<zeno::NumericObject>((float)r.norm()));
+        set_output("solveTime",std::make_shared<zeno::NumericObject>((float)total_solve_time));
+    }
 
+    // matrix-free block-Jacobi preconditioned CG on the unassembled element hessians
+    static int SolvePCG(const FEMIntegrator& integrator,const std::vector<zeno::vec4i>& elms,
+            const std::vector<Mat12x12d>& elm_Hs,size_t nm_verts,
+            const VecXd& b,VecXd& x,int max_iters,FEM_Scaler tol){
+        std::vector<Mat3x3d> invDiag;
+        integrator.ComputeBlockJacobi(elms,elm_Hs,nm_verts,invDiag);
+        auto precond = [&](const VecXd& src,VecXd& des){
+            #pragma omp parallel for
+            for(auto i = 0;i < nm_verts;++i)
+                des.segment<3>(i*3) = invDiag[i] * src.segment<3>(i*3);
+        };
+
+        x.setZero();
+        VecXd r = b,z(b.size()),p,Ap(b.size());
+        precond(r,z);
+        p = z;
+        FEM_Scaler rz = r.dot(z);
+        FEM_Scaler bnorm = b.norm();
+
+        int iter = 0;
+        for(;iter < max_iters && r.norm() > tol * bnorm;++iter){
+            integrator.ApplyElmMatrices(elms,elm_Hs,p,Ap);
+            FEM_Scaler pAp = p.dot(Ap);
+            if(pAp <= 0){
+                // fall back to the preconditioned gradient if no CG step was taken
+                if(iter == 0)
+                    x = z;
+                break;
+            }
+            FEM_Scaler alpha = rz / pAp;
+            x += alpha * p;
+            r -= alpha * Ap;
+            precond(r,z);
+            FEM_Scaler rz_new = r.dot(z);
+            p = z + (rz_new / rz) * p;
+            rz = rz_new;
+        }
+        return iter;
     }
 
     static void UpdateCurrentShape(std::shared_ptr<PrimitiveObject> prim,const VecXd& dp,double alpha){
@@ -585,9 +653,10 @@ struct SolveFEM : zeno::INode {
 ZENDEFNODE(SolveFEM,{
     {"integrator","shape","elmView","skin",{"int","maxNRIters","10"},{"int","maxBTLs","10"},{"float","ArmijoCoeff","0.01"},
         {"float","CurvatureCoeff","0.9"},{"float","BTL_shrinkingRate","0.5"},
-        {"float","epsilon","1e-8"}
+        {"float","epsilon","1e-8"},
+        {"enum LDLT PCG","linearSolver","LDLT"},{"int","maxCGIters","500"},{"float","cgTolerance","1e-6"}
     },
-    {"shape"},
+    {"shape","newtonIters","lineSearchIters","linearIters","residual","solveTime"},
     {},
     {"FEM"},
 });
@@ -12,6 +12,7 @@
 #include <cmath>
 #include <zeno/utils/log.h>
 #include <opencv2/opencv.hpp>
+#include "TiledImage.h"
 
 namespace zeno {
 
@@ -202,6 +203,19 @@ static void HSVtoRGB(float h, float s, float v, float &r, float &g, float &b)
     }
 }
 
+// Pointwise image nodes accept both PrimitiveObject images and TiledImageObject.
+// On a TiledImageObject the op is only queued, so that consecutive pointwise
+// nodes get fused into one pass; on a PrimitiveObject it runs right away.
+static void applyPointwise(std::shared_ptr<IObject> const &image, TiledImageObject::PointwiseOp op) {
+    if (auto tiled = std::dynamic_pointer_cast<TiledImageObject>(image)) {
+        tiled->push(std::move(op));
+    } else if (auto prim = std::dynamic_pointer_cast<PrimitiveObject>(image)) {
+        applyPointwiseToPrimitive(prim.get(), op);
+    } else {
+        throw std::runtime_error("expect image (PrimitiveObject or TiledImageObject)");
+    }
+}
+
 
 /*struct ImageResize: INode {//TODO::FIX BUG
     void apply() override {
@@ -403,19 +417,56 @@ ZENDEFNODE(ImageFlip, {
     {"image"},
 });
 
-struct ImageRGB2HSV : INode {
+// Converts an image to the tiled planar layout; pointwise nodes applied to
+// the result are fused until ImageFromTiled is reached.
+struct ImageToTiled : INode {
     virtual void apply() override {
         auto image = get_input<PrimitiveObject>("image");
-        float H = 0, S = 0, V = 0;
-        for (auto i = 0; i < image->verts.size(); i++){
-            float R = image->verts[i][0];
-            float G = image->verts[i][1];
-            float B = image->verts[i][2];
-            zeno::RGBtoHSV(R, G, B, H, S, V);
-            image->verts[i][0]= H;
-            image->verts[i][1]= S;
-            image->verts[i][2]= V;
-        }
+        set_output("image", TiledImageObject::fromPrimitive(image.get()));
+    }
+};
+
+ZENDEFNODE(ImageToTiled, {
+    {
+        {"image"},
+    },
+    {
+        {"image"},
+    },
+    {},
+    { "image" },
+});
+
+struct ImageFromTiled : INode {
+    virtual void apply() override {
+        auto image = get_input<TiledImageObject>("image");
+        set_output("image", image->toPrimitive());
+    }
+};
+
+ZENDEFNODE(ImageFromTiled, {
+    {
+        {"image"},
+    },
+    {
+        {"image"},
+    },
+    {},
+    { "image" },
+});
+
+struct ImageRGB2HSV : INode {
+    virtual void apply() override {
+        auto image = get_input("image");
+        applyPointwise(image, [] (float *r, float *g, float *b, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                float H = 0, S = 0, V = 0;
+                zeno::RGBtoHSV(r[i], g[i], b[i], H, S, V);
+                r[i] = H;
+                g[i] = S;
+                b[i] = V;
+            }
+        });
         set_output("image", image);
     }
 };
@@ -433,17 +484,16 @@ ZENDEFNODE(ImageRGB2HSV, {
 
 struct ImageHSV2RGB : INode {
     virtual void apply() override {
-        auto image = get_input<PrimitiveObject>("image");
-        float R = 0, G = 0, B = 0;
-        for (auto i = 0; i < image->verts.size(); i++){
-            float H = image->verts[i][0];
-            float S = image->verts[i][1];
-            float V = image->verts[i][2];
-            zeno::HSVtoRGB(H, S, V, R, G, B);
-            image->verts[i][0]= R ;
-            image->verts[i][1]= G ;
-            image->verts[i][2]= B ;
-        }
+        auto image = get_input("image");
+        applyPointwise(image, [] (float *r, float *g, float *b, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                float R = 0, G = 0, B = 0;
+                zeno::HSVtoRGB(r[i], g[i], b[i], R, G, B);
+                r[i] = R;
+                g[i] = G;
+                b[i] = B;
+            }
+        });
         set_output("image", image);
     }
 };
@@ -461,28 +511,24 @@ ZENDEFNODE(ImageHSV2RGB, {
 
 struct ImageEditHSV : INode {//TODO::FIX BUG
     virtual void apply() override {
-        auto image = get_input<PrimitiveObject>("image");
-        float H = 0, S = 0, V = 0;
+        auto image = get_input("image");
         float Hi = get_input2<float>("H");
         float Si = get_input2<float>("S");
         float Vi = get_input2<float>("V");
-        for (auto i = 0; i < image->verts.size(); i++) {
-            float R = image->verts[i][0];
-            float G = image->verts[i][1];
-            float B = image->verts[i][2];
-            zeno::RGBtoHSV(R, G, B, H, S, V);
-            //S = S + (S - 0.5)*(Si-1);
-            //V = V + (V - 0.5)*(Vi-1);
-            //S = S + (Si - 1) * (S < 0.5 ? S : 1.0 - S);
-            //V = V + (Vi - 1) * (V < 0.5 ? V : 1.0 - V);
-            H = fmod(H + Hi, 360.0);
-            S = S * Si;
-            V = V * Vi;
-            zeno::HSVtoRGB(H, S, V, R, G, B);
-            image->verts[i][0] = R;
-            image->verts[i][1] = G;
-            image->verts[i][2] = B;
-        }
+        applyPointwise(image, [=] (float *r, float *g, float *b, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                float H = 0, S = 0, V = 0;
+                zeno::RGBtoHSV(r[i], g[i], b[i], H, S, V);
+                //S = S + (S - 0.5)*(Si-1);
+                //V = V + (V - 0.5)*(Vi-1);
+                //S = S + (Si - 1) * (S < 0.5 ? S : 1.0 - S);
+                //V = V + (Vi - 1) * (V < 0.5 ? V : 1.0 - V);
+                H = fmod(H + Hi, 360.0);
+                S = S * Si;
+                V = V * Vi;
+                zeno::HSVtoRGB(H, S, V, r[i], g[i], b[i]);
+            }
+        });
         set_output("image", image);
     }
 };
@@ -720,15 +766,18 @@ ZENDEFNODE(ImageBlur, {
 
 struct ImageEditContrast : INode {
     virtual void apply() override {
-        auto image = get_input<PrimitiveObject>("image");
+        auto image = get_input("image");
         float ContrastRatio = get_input2<float>("ContrastRatio");
         float ContrastCenter = get_input2<float>("ContrastCenter");
-        auto &ud = image->userData();
-        int w = ud.get2<int>("w");
-        int h = ud.get2<int>("h");
-        for (auto i = 0; i < image->verts.size(); i++) {
-            image->verts[i] = image->verts[i] + (image->verts[i]-ContrastCenter) * (ContrastRatio-1);
-        }
+        // v + (v - c) * (k - 1) == v * k + c * (1 - k)
+        float scale = ContrastRatio, offset = ContrastCenter * (1 - ContrastRatio);
+        applyPointwise(image, [=] (float *r, float *g, float *b, size_t n) {
+            for (float *c: {r, g, b}) {
+#pragma omp simd
+                for (size_t i = 0; i < n; i++)
+                    c[i] = c[i] * scale + offset;
+            }
+        });
         set_output("image", image);
     }
 };
@@ -747,10 +796,14 @@ ZENDEFNODE(ImageEditContrast, {
 
 struct ImageEditInvert : INode{
     virtual void apply() override {
-        auto image = get_input<PrimitiveObject>("image");
-        for (auto i = 0; i < image->verts.size(); i++) {
-            image->verts[i] = 1 - image->verts[i];
-        }
+        auto image = get_input("image");
+        applyPointwise(image, [] (float *r, float *g, float *b, size_t n) {
+            for (float *c: {r, g, b}) {
+#pragma omp simd
+                for (size_t i = 0; i < n; i++)
+                    c[i] = 1 - c[i];
+            }
+        });
         set_output("image", image);
     }
 };
@@ -837,38 +890,40 @@ ZENDEFNODE(ImageToNormalMap, {
 
 struct ImageGray : INode {
     void apply() override {
-        auto image = get_input<PrimitiveObject>("image");
+        auto image = get_input("image");
         auto mode = get_input2<std::string>("mode");
-        auto &ud = image->userData();
-        int w = ud.get2<int>("w");
-        int h = ud.get2<int>("h");
-        for (auto i = 0; i < image->verts.size(); i++) {
-            vec3f &v = image->verts[i];
-            if(mode=="Average"){
-                float avg = (v[0] + v[1] + v[2]) / 3;
-                v = vec3f(avg);
-            }
-            else if(mode=="Luminance"){
-                float lumi = 0.3 * v[0] + 0.59 * v[1] + 0.11 * v[2];//(GIMP/PS)
-                v =vec3f(lumi);
-            }
-            else if(mode=="Red"){
-                v = vec3f(v[0]);
-            }
-            else if(mode=="Green"){
-                v = vec3f(v[1]);
-            }
-            else if(mode=="Blue"){
-                v = vec3f(v[2]);
-            }
-            else if(mode=="MaxComponent"){
-                float max = std::max(v[0], std::max(v[1], v[2]));
-                v = vec3f(max);
-            }
-            else if(mode=="MinComponent"){
-                float min = std::min(v[0], std::min(v[1], v[2]));
-                v = vec3f(min);
-            }
+        // weights of r, g, b for the linear modes
+        vec3f wgt(1.f / 3);
+        if(mode=="Luminance"){
+            wgt = vec3f(0.3, 0.59, 0.11);//(GIMP/PS)
+        }
+        else if(mode=="Red"){
+            wgt = vec3f(1, 0, 0);
+        }
+        else if(mode=="Green"){
+            wgt = vec3f(0, 1, 0);
+        }
+        else if(mode=="Blue"){
+            wgt = vec3f(0, 0, 1);
+        }
+        if(mode=="MaxComponent" || mode=="MinComponent"){
+            bool isMax = mode=="MaxComponent";
+            applyPointwise(image, [=] (float *r, float *g, float *b, size_t n) {
+#pragma omp simd
+                for (size_t i = 0; i < n; i++) {
+                    float v = isMax ? std::max(r[i], std::max(g[i], b[i])) : std::min(r[i], std::min(g[i], b[i]));
+                    r[i] = g[i] = b[i] = v;
+                }
+            });
+        }
+        else {
+            applyPointwise(image, [=] (float *r, float *g, float *b, size_t n) {
+#pragma omp simd
+                for (size_t i = 0; i < n; i++) {
+                    float v = wgt[0] * r[i] + wgt[1] * g[i] + wgt[2] * b[i];
+                    r[i] = g[i] = b[i] = v;
+                }
+            });
         }
         set_output("image", image);
     }
@@ -1233,37 +1288,28 @@ ZENDEFNODE(ImageColor2, {
 
 struct ImageClamp: INode {//Add Unpremultiplied Space Option?
     void apply() override {
-        auto image = get_input<PrimitiveObject>("image");
+        auto image = get_input("image");
         auto background = get_input2<std::string>("ClampedValue");
-        auto &ud = image->userData();
-        int w = ud.get2<int>("w");
-        int h = ud.get2<int>("h");
         auto up = get_input2<float>("Max");
         auto low = get_input2<float>("Min");
         if(background == "LimitValue"){
-        for (auto i = 0; i < image->verts.size(); i++) {
-            image->verts[i] = zeno::clamp(image->verts[i], low, up);
-            }
-        }
-        else if(background == "Black"){
-            for (auto i = 0; i < image->verts.size(); i++) {
-                vec3f &v = image->verts[i];
-                for(int j = 0; j < 3; j++){
-                    if((v[j]<low) || (v[j]>up)){
-                        v[j] = 0;
-                    }
+            applyPointwise(image, [=] (float *r, float *g, float *b, size_t n) {
+                for (float *c: {r, g, b}) {
+#pragma omp simd
+                    for (size_t i = 0; i < n; i++)
+                        c[i] = std::min(std::max(c[i], low), up);
                 }
-            }
+            });
         }
-        else if(background == "White"){
-            for (auto i = 0; i < image->verts.size(); i++) {
-                vec3f &v = image->verts[i];
-                for(int j = 0; j < 3; j++){
-                    if((v[j]<low) || (v[j]>up)){
-                        v[j] = 1;
-                    }
+        else if(background == "Black" || background == "White"){
+            float fill = background == "White" ? 1 : 0;
+            applyPointwise(image, [=] (float *r, float *g, float *b, size_t n) {
+                for (float *c: {r, g, b}) {
+#pragma omp simd
+                    for (size_t i = 0; i < n; i++)
+                        c[i] = (c[i] < low) || (c[i] > up) ? fill : c[i];
                 }
-            }
+            });
         }
 
         set_output("image", image);
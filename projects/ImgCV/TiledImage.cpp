@@ -0,0 +1,104 @@
+#include "TiledImage.h"
+#include <zeno/types/UserData.h>
+#include <algorithm>
+
+namespace zeno {
+
+void TiledImageObject::resize(int w_, int h_) {
+    w = w_;
+    h = h_;
+    tilesX = (w + kTileSize - 1) / kTileSize;
+    tilesY = (h + kTileSize - 1) / kTileSize;
+    data.assign(numTiles() * 3 * kTilePixels, 0.f);
+}
+
+void TiledImageObject::flush() {
+    if (pending.empty())
+        return;
+    // padding pixels of border tiles are processed too, they are never read back
+#pragma omp parallel for schedule(dynamic)
+    for (intptr_t t = 0; t < (intptr_t)numTiles(); t++) {
+        float *r = channel(t, 0), *g = channel(t, 1), *b = channel(t, 2);
+        for (auto const &op: pending)
+            op(r, g, b, kTilePixels);
+    }
+    pending.clear();
+}
+
+std::shared_ptr<TiledImageObject> TiledImageObject::fromPrimitive(PrimitiveObject *prim) {
+    auto &ud = prim->userData();
+    int w = ud.get2<int>("w");
+    int h = ud.get2<int>("h");
+    if ((size_t)w * h != prim->verts.size())
+        throw std::runtime_error("TiledImageObject: image size mismatch");
+    auto img = std::make_shared<TiledImageObject>();
+    img->resize(w, h);
+    auto const &verts = prim->verts;
+#pragma omp parallel for schedule(dynamic)
+    for (intptr_t t = 0; t < (intptr_t)img->numTiles(); t++) {
+        int x0 = t % img->tilesX * kTileSize, y0 = t / img->tilesX * kTileSize;
+        int nx = std::min(kTileSize, w - x0), ny = std::min(kTileSize, h - y0);
+        float *r = img->channel(t, 0), *g = img->channel(t, 1), *b = img->channel(t, 2);
+        for (int ly = 0; ly < ny; ly++) {
+            auto const *row = verts.data() + (size_t)(y0 + ly) * w + x0;
+            for (int lx = 0; lx < nx; lx++) {
+                r[ly * kTileSize + lx] = row[lx][0];
+                g[ly * kTileSize + lx] = row[lx][1];
+                b[ly * kTileSize + lx] = row[lx][2];
+            }
+        }
+    }
+    if (verts.has_attr("alpha"))
+        img->alpha = verts.attr<float>("alpha");
+    return img;
+}
+
+std::shared_ptr<PrimitiveObject> TiledImageObject::toPrimitive() {
+    flush();
+    auto prim = std::make_shared<PrimitiveObject>();
+    prim->verts.resize((size_t)w * h);
+    prim->userData().set2("isImage", 1);
+    prim->userData().set2("w", w);
+    prim->userData().set2("h", h);
+    auto &verts = prim->verts;
+#pragma omp parallel for schedule(dynamic)
+    for (intptr_t t = 0; t < (intptr_t)numTiles(); t++) {
+        int x0 = t % tilesX * kTileSize, y0 = t / tilesX * kTileSize;
+        int nx = std::min(kTileSize, w - x0), ny = std::min(kTileSize, h - y0);
+        float *r = channel(t, 0), *g = channel(t, 1), *b = channel(t, 2);
+        for (int ly = 0; ly < ny; ly++) {
+            auto *row = verts.data() + (size_t)(y0 + ly) * w + x0;
+            for (int lx = 0; lx < nx; lx++)
+                row[lx] = vec3f(r[ly * kTileSize + lx], g[ly * kTileSize + lx], b[ly * kTileSize + lx]);
+        }
+    }
+    if (!alpha.empty())
+        verts.add_attr<float>("alpha") = alpha;
+    return prim;
+}
+
+void applyPointwiseToPrimitive(PrimitiveObject *prim, TiledImageObject::PointwiseOp const &op) {
+    constexpr size_t N = TiledImageObject::kTilePixels;
+    auto &verts = prim->verts;
+    size_t nchunks = (verts.size() + N - 1) / N;
+#pragma omp parallel
+    {
+        std::vector<float> buf(3 * N);
+        float *r = buf.data(), *g = r + N, *b = g + N;
+#pragma omp for schedule(dynamic)
+        for (intptr_t c = 0; c < (intptr_t)nchunks; c++) {
+            size_t base = c * N, n = std::min(N, verts.size() - base);
+            auto *p = verts.data() + base;
+            for (size_t i = 0; i < n; i++) {
+                r[i] = p[i][0];
+                g[i] = p[i][1];
+                b[i] = p[i][2];
+            }
+            op(r, g, b, n);
+            for (size_t i = 0; i < n; i++)
+                p[i] = vec3f(r[i], g[i], b[i]);
+        }
+    }
+}
+
+}
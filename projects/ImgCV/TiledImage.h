@@ -0,0 +1,51 @@
+#ifndef ZENO_TILEDIMAGE_H
+#define ZENO_TILEDIMAGE_H
+#include <zeno/core/IObject.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace zeno {
+    // Planar RGB image split into square tiles, each tile storing its three
+    // channels contiguously. Pointwise operators are not run immediately but
+    // queued in `pending`; flush() runs the whole queue tile by tile, so a
+    // chain of pointwise nodes costs a single pass over memory.
+    struct TiledImageObject : IObjectClone<TiledImageObject> {
+        static constexpr int kTileSize = 64;
+        static constexpr int kTilePixels = kTileSize * kTileSize;
+
+        // op(r, g, b, n) transforms n pixels of three planar channels in place
+        using PointwiseOp = std::function<void(float *, float *, float *, size_t)>;
+
+        int w = 0, h = 0;
+        int tilesX = 0, tilesY = 0;
+        std::vector<float> data; // [tile][channel][pixel]
+        std::vector<PointwiseOp> pending;
+        std::vector<float> alpha; // row-major, carried through untouched
+
+        void resize(int w_, int h_);
+
+        size_t numTiles() const {
+            return (size_t)tilesX * tilesY;
+        }
+
+        float *channel(size_t tile, int c) {
+            return data.data() + (tile * 3 + c) * kTilePixels;
+        }
+
+        void push(PointwiseOp op) {
+            pending.push_back(std::move(op));
+        }
+
+        void flush();
+
+        static std::shared_ptr<TiledImageObject> fromPrimitive(PrimitiveObject *prim);
+        std::shared_ptr<PrimitiveObject> toPrimitive();
+    };
+
+    // Runs a pointwise op over an interleaved PrimitiveObject image, in
+    // parallel chunks of kTilePixels that are transposed to planar and back.
+    void applyPointwiseToPrimitive(PrimitiveObject *prim, TiledImageObject::PointwiseOp const &op);
+}
+#endif //ZENO_TILEDIMAGE_H
@@ -105,8 +105,8 @@ extern "C"
     {
         return PyZeno::lastError.catched([=]
                                          {
-            auto optr = PyZeno::lutObject.access(object_).get();
-            auto& vec = dynamic_cast<SmallVecObject *>(optr)->value;
+            auto obj = PyZeno::lutObject.access(object_);
+            auto& vec = dynamic_cast<SmallVecObject *>(obj.get())->value;
             std::visit(
                 [dims_Ret_ = dims_Ret_, dim_xRet_ = dim_xRet_, dim_yRet_ = dim_yRet_, typeRet_ = typeRet_, ptrRet_ = ptrRet_, data_ptr = data_ptr] (auto &vec) {
                     using vec_t = RM_CVREF_T(vec); 
@@ -140,8 +140,8 @@ extern "C"
     {
         return PyZeno::lastError.catched([=]
                                          {
-            auto optr = PyZeno::lutObject.access(object).get();
-            auto& vector = dynamic_cast<ZsVectorObject *>(optr)->value;
+            auto obj = PyZeno::lutObject.access(object);
+            auto& vector = dynamic_cast<ZsVectorObject *>(obj.get())->value;
             std::visit([=](auto &vector){
                 *ptrRet = reinterpret_cast<void *>(&vector);
                 *memsrcRet = static_cast<int>(vector.memspace());
@@ -163,8 +163,8 @@ extern "C"
     {
         return PyZeno::lastError.catched([=]
                                          {
-            auto optr = PyZeno::lutObject.access(object).get();
-            auto& tv = dynamic_cast<ZsTileVectorObject *>(optr)->value;
+            auto obj = PyZeno::lutObject.access(object);
+            auto& tv = dynamic_cast<ZsTileVectorObject *>(obj.get())->value;
             std::visit([=](auto &tv){
                 *ptrRet = reinterpret_cast<void *>(&tv);
                 *memsrcRet = static_cast<int>(tv.memspace());
@@ -5,6 +5,8 @@ Zeno Python API module
 
 import ctypes
 import functools
+import sys
+import weakref
 from typing import Union, Optional, Any, Iterator, Iterable, Callable
 from types import MappingProxyType
 
@@ -62,6 +64,12 @@ def init_zeno_lib(path: str):
     define(ctypes.c_uint32, 'Zeno_InvokeObjectFactory', ctypes.POINTER(ctypes.c_uint64), ctypes.c_char_p, ctypes.py_object)
     define(ctypes.c_uint32, 'Zeno_InvokeObjectDefactory', ctypes.c_uint64, ctypes.c_char_p, ctypes.POINTER(ctypes.py_object))
     define(ctypes.c_uint32, 'Zeno_InvokeCFunctionPtr', ctypes.py_object, ctypes.c_char_p, ctypes.POINTER(ctypes.py_object))
+    define(ctypes.c_uint32, 'Zeno_CreateObjectsInt', ctypes.POINTER(ctypes.c_uint64), ctypes.POINTER(ctypes.c_int), ctypes.c_size_t, ctypes.c_size_t)
+    define(ctypes.c_uint32, 'Zeno_CreateObjectsFloat', ctypes.POINTER(ctypes.c_uint64), ctypes.POINTER(ctypes.c_float), ctypes.c_size_t, ctypes.c_size_t)
+    define(ctypes.c_uint32, 'Zeno_GetObjectsInt', ctypes.POINTER(ctypes.c_uint64), ctypes.POINTER(ctypes.c_int), ctypes.c_size_t, ctypes.c_size_t)
+    define(ctypes.c_uint32, 'Zeno_GetObjectsFloat', ctypes.POINTER(ctypes.c_uint64), ctypes.POINTER(ctypes.c_float), ctypes.c_size_t, ctypes.c_size_t)
+    define(ctypes.c_uint32, 'Zeno_DestroyObjects', ctypes.POINTER(ctypes.c_uint64), ctypes.c_size_t)
+    define(ctypes.c_uint32, 'Zeno_GetObjectPrimDataAll', ctypes.c_uint64, ctypes.c_int, ctypes.POINTER(ctypes.c_size_t), ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_void_p), ctypes.POINTER(ctypes.c_size_t), ctypes.POINTER(ctypes.c_int))
 
 
 class ZenoObject:
@@ -317,7 +325,7 @@ class _MappingProxyWrapper:
 
 class ZenoPrimitiveObject(ZenoObject):
     def _getArray(self, kind: int):
-        return _AttrVectorWrapper(self._handle, kind)
+        return _AttrVectorWrapper(self._handle, kind, self)
 
     def __repr__(self) -> str:
         return '[zeno primitive at {}]'.format(self._handle)
@@ -412,17 +420,57 @@ class ZenoPrimitiveObject(ZenoObject):
         return self.HoudiniStyleAccessor(self)
 
 
+# spans whose memory has been handed out to NumPy, per (primitive, kind);
+# resizing that array would leave those views dangling
+_exportedSpans: dict[tuple[int, int], weakref.WeakSet] = {}
+
+
+def _releaseSpan(key: tuple[int, int]):
+    # runs as a span dies, the set may still count its dead reference, so look for live ones
+    views = _exportedSpans.get(key)
+    if views is not None and next(iter(views), None) is None:
+        del _exportedSpans[key]
+
+
 class _MemSpanWrapper:
     _ptr: int
     _len: int
     _type: Any
     _dim: int
+    _owner: Any
 
-    def __init__(self, ptr_: int, len_: int, type_: Any, dim_: int):
+    _typestrLut = {
+        ctypes.c_float: 'f4',
+        ctypes.c_int: 'i4',
+    }
+
+    def __init__(self, ptr_: int, len_: int, type_: Any, dim_: int, owner_: Any = None):
         self._ptr = ptr_
         self._len = len_
         self._type = type_
         self._dim = dim_
+        self._owner = owner_
+
+    @property
+    def __array_interface__(self) -> dict:
+        if isinstance(self._owner, _AttrVectorWrapper):
+            key = (self._owner._handle, self._owner._kind)
+            views = _exportedSpans.setdefault(key, weakref.WeakSet())
+            if self not in views:
+                views.add(self)
+                weakref.finalize(self, _releaseSpan, key)
+        return {
+            'version': 3,
+            'shape': (self._len, self._dim) if self._dim != 1 else (self._len,),
+            'typestr': ('<' if sys.byteorder == 'little' else '>') + self._typestrLut[self._type],
+            'data': (self._ptr or 0, False),
+        }
+
+    def as_numpy(self, np=None):
+        '''writable view of the attribute without copying, valid until the array is resized'''
+        if np is None:
+            import numpy as np
+        return np.asarray(self)
 
     def __repr__(self) -> str:
         return '[zeno attribute at {} of len {} with type {} and dim {}]'.format(self._ptr, self._len, self._type, self._dim)
@@ -541,9 +589,10 @@ class _AttrVectorWrapper:
         (int, 4): 7,
     }
 
-    def __init__(self, handle: int, kind: int):
+    def __init__(self, handle: int, kind: int, owner: Any = None):
         self._handle = handle
         self._kind = kind
+        self._owner = owner
 
     def add_attr(self, attrName: str, dataType: tuple[type, int]):
         dataTypeInd = self._typeUnlut[dataType]
@@ -555,7 +604,7 @@ class _AttrVectorWrapper:
         lenRet_ = ctypes.c_size_t()
         typeRet_ = ctypes.c_int()
         api.Zeno_GetObjectPrimData(ctypes.c_uint64(self._handle), ctypes.c_int(self._kind), ctypes.c_char_p(attrName.encode()), ctypes.pointer(ptrRet_), ctypes.pointer(lenRet_), ctypes.pointer(typeRet_))
-        return _MemSpanWrapper(ptrRet_.value, lenRet_.value, self._typeLut[typeRet_.value], self._dimLut[typeRet_.value])  # type: ignore
+        return _MemSpanWrapper(ptrRet_.value, lenRet_.value, self._typeLut[typeRet_.value], self._dimLut[typeRet_.value], self)  # type: ignore
 
     def keys(self) -> list[str]:
         count_ = ctypes.c_size_t(0)
@@ -566,10 +615,19 @@ class _AttrVectorWrapper:
         return keys
 
     def values(self) -> list[_MemSpanWrapper]:
-        return [self.attr(k) for k in self.keys()]
+        return [v for k, v in self.items()]
 
     def items(self) -> list[tuple[str, _MemSpanWrapper]]:
-        return [(k, self.attr(k)) for k in self.keys()]
+        count_ = ctypes.c_size_t(0)
+        null_ = ctypes.c_void_p(0)
+        api.Zeno_GetObjectPrimDataAll(ctypes.c_uint64(self._handle), ctypes.c_int(self._kind), ctypes.pointer(count_), ctypes.cast(null_, ctypes.POINTER(ctypes.c_char_p)), ctypes.cast(null_, ctypes.POINTER(ctypes.c_void_p)), ctypes.cast(null_, ctypes.POINTER(ctypes.c_size_t)), ctypes.cast(null_, ctypes.POINTER(ctypes.c_int)))
+        n = count_.value
+        keys_ = (ctypes.c_char_p * n)()
+        ptrs_ = (ctypes.c_void_p * n)()
+        lens_ = (ctypes.c_size_t * n)()
+        types_ = (ctypes.c_int * n)()
+        api.Zeno_GetObjectPrimDataAll(ctypes.c_uint64(self._handle), ctypes.c_int(self._kind), ctypes.pointer(count_), keys_, ptrs_, lens_, types_)
+        return [(keys_[i].decode(), _MemSpanWrapper(ptrs_[i], lens_[i], self._typeLut[types_[i]], self._dimLut[types_[i]], self)) for i in range(n)]  # type: ignore
 
     def __iter__(self) -> Iterator[tuple[str, _MemSpanWrapper]]:
         return iter(self.items())
@@ -594,6 +652,9 @@ class _AttrVectorWrapper:
         return lenRet_.value
 
     def resize(self, newSize: int):
+        views = _exportedSpans.get((self._handle, self._kind))
+        if views:
+            raise BufferError('cannot resize: {} NumPy view(s) of this array are still alive'.format(len(views)))
         api.Zeno_ResizeObjectPrimData(ctypes.c_uint64(self._handle), ctypes.c_int(self._kind), ctypes.c_size_t(newSize))
 
 
@@ -12,6 +12,7 @@
 #include <zeno/utils/string.h>
 #include <zeno/utils/scope_exit.h>
 #include <zeno/extra/CAPIInternals.h>
+#include <zeno/extra/PyGIL.h>
 #include <zeno_Python_config.h>
 #include <cwchar>
 #include <utility>
@@ -32,6 +33,8 @@ static std::wstring s2ws(std::string const &s) {
 }
 
 
+static PyThreadState *mainThreadState = nullptr;
+
 static int defPythonInit = getSession().eventCallbacks->hookEvent("init", [] {
     log_debug("Initializing Python...");
     Py_SetPythonHome(s2ws(getAssetDir(ZENO_PYTHON_LIB_DIR, "..")).c_str());
@@ -42,13 +45,23 @@ static int defPythonInit = getSession().eventCallbacks->hookEvent("init", [] {
 #else
     Py_SetProgramName(s2ws(getAssetDir(ZENO_PYTHON_MODULE_DIR, "ze/zenobundlepython.sh")).c_str());
 #endif
+    // a host that embeds Python itself has released the GIL after its setup
+    bool ownsInterpreter = !Py_IsInitialized();
     Py_Initialize();
     std::string libpath = getAssetDir(ZENO_PYTHON_MODULE_DIR);
 #ifdef _WIN32
     libpath = replace_all(libpath, "\\", "\\\\");
 #endif
     std::string dllfile = ZENO_PYTHON_DLL_FILE;
-    if (PyRun_SimpleString(("__import__('sys').path.insert(0, '" + libpath + "'); import ze; ze.initDLLPath('" + dllfile + "')").c_str()) < 0) {
+    int ret;
+    {
+        PyGILGuard gil;
+        ret = PyRun_SimpleString(("__import__('sys').path.insert(0, '" + libpath + "'); import ze; ze.initDLLPath('" + dllfile + "')").c_str());
+    }
+    // zeno runs without the GIL from now on, Python code takes it via PyGILGuard
+    if (ownsInterpreter)
+        mainThreadState = PyEval_SaveThread();
+    if (ret < 0) {
         log_warn("Failed to initialize Python module");
         return;
     }
@@ -57,6 +70,10 @@ static int defPythonInit = getSession().eventCallbacks->hookEvent("init", [] {
 });
 
 static int defPythonExit = getSession().eventCallbacks->hookEvent("exit", [] {
+    if (!mainThreadState)
+        return;
+    PyEval_RestoreThread(mainThreadState);
+    mainThreadState = nullptr;
     Py_Finalize();
 });
 
@@ -64,15 +81,18 @@ struct PythonFunctor {
     PyObject *pyFunc;
 
     explicit PythonFunctor(PyObject *pyFunc_) : pyFunc(pyFunc_) {
+        PyGILGuard gil;
         Py_INCREF(pyFunc);
     }
 
     PythonFunctor(PythonFunctor const &that) : pyFunc(that.pyFunc) {
+        PyGILGuard gil;
         Py_INCREF(pyFunc);
     }
 
     PythonFunctor &operator=(PythonFunctor const &that) {
         if (std::addressof(that) != this) {
+            PyGILGuard gil;
             Py_DECREF(pyFunc);
             pyFunc = that.pyFunc;
             Py_INCREF(pyFunc);
@@ -81,10 +101,12 @@ struct PythonFunctor {
     }
 
     ~PythonFunctor() {
+        PyGILGuard gil;
         Py_DECREF(pyFunc);
     }
 
     std::map<std::string, zany> operator()(std::map<std::string, zany> args) const {
+        PyGILGuard gil;
         std::map<std::string, zany> rets;
         PyObject *pyKwargs = PyDict_New();
         scope_exit pyKwargsDel = [=] {
@@ -143,6 +165,7 @@ struct PythonFunctor {
 };
 
 static Zeno_Object factoryFunctionObject(void *inObj_) {
+    PyGILGuard gil;
     PyObject *tmpFunc = reinterpret_cast<PyObject *>(inObj_);
     auto funcObj = std::make_shared<FunctionObject>(PythonFunctor(tmpFunc));
     Zeno_Object funcHandle = capiLoadObjectSharedPtr(funcObj);
@@ -152,6 +175,7 @@ static Zeno_Object factoryFunctionObject(void *inObj_) {
 static int defFunctionObjectFactory = capiRegisterObjectFactory("FunctionObject", factoryFunctionObject);
 
 static PyObject *callFunctionObjectCFunc(PyObject *pyHandleAndKwargs_) {
+    PyGILGuard gil;
     PyObject *pyHandleVal = PyTuple_GetItem(pyHandleAndKwargs_, 0);
     PyObject *pyKwargs = PyTuple_GetItem(pyHandleAndKwargs_, 1);
     Zeno_Object obj = PyLong_AsUnsignedLongLong(pyHandleVal);
@@ -175,7 +199,10 @@ static PyObject *callFunctionObjectCFunc(PyObject *pyHandleAndKwargs_) {
             objParams.emplace(std::move(keyStr), capiFindObjectSharedPtr(handle));
         }
     }
-    objParams = objFunc->call(objParams);
+    {
+        PyGILRelease nogil;
+        objParams = objFunc->call(objParams);
+    }
     PyDict_Clear(pyKwargs);
     for (auto const &[k, v]: objParams) {
         PyObject *handleObj = PyLong_FromUnsignedLongLong(capiLoadObjectSharedPtr(v));
@@ -187,6 +214,7 @@ static PyObject *callFunctionObjectCFunc(PyObject *pyHandleAndKwargs_) {
 static int defCallFunctionObjectCFunc = capiRegisterCFunctionPtr("FunctionObject_call", reinterpret_cast<void *(*)(void *)>(callFunctionObjectCFunc));
 
 static void *defactoryFunctionObject(Zeno_Object inHandle_) {
+    PyGILGuard gil;
     auto objSp = capiFindObjectSharedPtr(inHandle_);
     auto funcObj = dynamic_cast<FunctionObject *>(objSp.get());
     if (!funcObj) throw makeError<TypeError>(typeid(FunctionObject), typeid(*objSp),
@@ -217,6 +245,7 @@ struct PythonScript : INode {
     void apply() override {
         auto args = has_input("args") ? get_input<DictObject>("args") : std::make_shared<DictObject>();
         auto path = get_input2<std::string>("path");
+        PyGILGuard gil;
         int ret;
         PyObject *argsDict = PyDict_New();
         scope_exit argsDel = [=] {
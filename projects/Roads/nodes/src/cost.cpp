@@ -202,6 +202,8 @@ namespace {
         int ConnectiveMask;
         ZENO_DECLARE_INPUT_FIELD(ConnectiveMask, "Connective Mask", false, "", "4");
 
+        // Edge costs do not depend on the angle, so the search runs on the 2D grid and this is unused.
+        // Kept so saved graphs still load, apply() warns when it is set.
         int AngleMask;
         ZENO_DECLARE_INPUT_FIELD(AngleMask, "Angle Mask", false, "", "4");
 
@@ -217,6 +219,12 @@ namespace {
         zeno::vec2f Goal;
         ZENO_DECLARE_INPUT_FIELD(Goal, "Goal Point");
 
+        std::shared_ptr<zeno::PrimitiveObject> ExtraStarts = nullptr;
+        ZENO_DECLARE_INPUT_FIELD(ExtraStarts, "Extra Start Points (Vert xy)", true);
+
+        std::shared_ptr<zeno::PrimitiveObject> ExtraGoals = nullptr;
+        ZENO_DECLARE_INPUT_FIELD(ExtraGoals, "Extra Goal Points (Vert xy)", true);
+
         std::shared_ptr<zeno::CurveObject> HeightCurve = nullptr;
         ZENO_DECLARE_INPUT_FIELD(HeightCurve, "Height Cost Control", true);
 
@@ -249,104 +257,94 @@ namespace {
         void apply() override {
             RoadsAssert(AutoParameter->Nx * AutoParameter->Ny <= AutoParameter->GradientList.size(), "Bad nx ny.");
 
-            CostPoint GoalPoint{static_cast<size_t>(AutoParameter->Goal[0]), static_cast<size_t>(AutoParameter->Goal[1]), 0};
-            CostPoint StartPoint{static_cast<size_t>(AutoParameter->Start[0]), static_cast<size_t>(AutoParameter->Start[1]), 0};
+            const size_t Nx = AutoParameter->Nx, Ny = AutoParameter->Ny;
 
-            DefaultedHashMap<CostPoint, CostPoint> Predecessor;
-            DefaultedHashMap<CostPoint, float> CostMap;
+            if (AutoParameter->AngleMask != 4 || inputBounds.count("Angle Mask")) {
+                zeno::log_warn("[Roads] \"Angle Mask\" is ignored, the path search no longer has angle states.");
+            }
 
-            size_t Nx = AutoParameter->Nx, Ny = AutoParameter->Ny;
+            auto ToGridIndex = [Nx, Ny](float x, float y) -> size_t {
+                RoadsAssert(x >= 0 && y >= 0 && size_t(x) < Nx && size_t(y) < Ny, "[Roads] Point out of grid.");
+                return size_t(x) + size_t(y) * Nx;
+            };
 
-            auto MapFuncGen = [](const std::shared_ptr<zeno::CurveObject> &Curve, float Threshold) -> std::function<float(float)> {
-                if (Curve) {
-                    return [Curve, Threshold](float In) -> float {
-                        if (Threshold > 0 && In > Threshold) {
-                            return 9e06f;
-                        }
-                        return Curve->eval(float(In));
-                    };
-                } else {
-                    zeno::log_warn("[Roads] Invalid Curve !");
-                    return [Threshold](float In) -> float {
-                        if (Threshold > 0 && In > Threshold) {
-                            return 9e06f;
-                        }
-                        return In;
-                    };
+            ArrayList<size_t> Sources{ToGridIndex(AutoParameter->Start[0], AutoParameter->Start[1])};
+            ArrayList<size_t> Goals{ToGridIndex(AutoParameter->Goal[0], AutoParameter->Goal[1])};
+            if (AutoParameter->ExtraStarts) {
+                for (const auto &P: AutoParameter->ExtraStarts->verts) Sources.push_back(ToGridIndex(P[0], P[1]));
+            }
+            if (AutoParameter->ExtraGoals) {
+                for (const auto &P: AutoParameter->ExtraGoals->verts) Goals.push_back(ToGridIndex(P[0], P[1]));
+            }
+
+            auto CurveCost = [](const std::shared_ptr<zeno::CurveObject> &Curve, float Threshold, float In) -> float {
+                if (Threshold > 0 && In > Threshold) {
+                    return 9e06f;
                 }
+                return Curve ? Curve->eval(In) : In;
             };
-
-            auto HeightCostFunc = MapFuncGen(AutoParameter->HeightCurve, -1.0f);
-            auto GradientCostFunc = MapFuncGen(AutoParameter->GradientCurve, -1.0f);
-            auto CurvatureCostFunc = MapFuncGen(AutoParameter->CurvatureCurve, AutoParameter->CurvatureThreshold);
-
-            DynamicGrid<CostPoint> CostGrid(AutoParameter->Nx, AutoParameter->Ny);
-            CostGrid.resize(AutoParameter->Nx * AutoParameter->Ny);
-            //#pragma omp parallel for
-            for (size_t i = 0; i < AutoParameter->Nx * AutoParameter->Ny; ++i) {
-                size_t x = i % AutoParameter->Nx;
-                size_t y = i / AutoParameter->Ny;
-                CostGrid[i] = (CostPoint{x, y, 0, AutoParameter->PositionList[i].at(1), AutoParameter->GradientList[i]});
+            if (!AutoParameter->HeightCurve || !AutoParameter->GradientCurve || !AutoParameter->CurvatureCurve) {
+                zeno::log_warn("[Roads] Invalid Curve !");
             }
 
-            auto CalcCurvature = [&CostGrid, Nx](const CostPoint &A, const CostPoint &B, const CostPoint &C) -> float {
-                float Height_A = float(CostGrid[A[0] + A[1] * Nx].Height);
-                float Height_B = float(CostGrid[B[0] + B[1] * Nx].Height);
-                float Height_C = float(CostGrid[C[0] + C[1] * Nx].Height);
+            // Per-cell cost layers, read by every edge evaluation
+            ArrayList<float> HeightLayer(Nx * Ny), GradientLayer(Nx * Ny);
+#pragma omp parallel for
+            for (int64_t i = 0; i < int64_t(Nx * Ny); ++i) {
+                HeightLayer[i] = AutoParameter->PositionList[i].at(1);
+                GradientLayer[i] = AutoParameter->GradientList[i];
+            }
 
-                Eigen::Vector4f BA = {float(A[0] - B[0]), float(A[1] - B[1]), float(Height_A - Height_B), float(A[2] - B[2])};
-                Eigen::Vector4f BC = {float(C[0] - B[0]), float(C[1] - B[1]), float(Height_C - Height_B), float(C[2] - B[2])};
+            auto CalcCurvature = [&HeightLayer, Nx](size_t A, size_t B, size_t C) -> float {
+                Eigen::Vector3f BA = {float(int64_t(A % Nx) - int64_t(B % Nx)), float(int64_t(A / Nx) - int64_t(B / Nx)), HeightLayer[A] - HeightLayer[B]};
+                Eigen::Vector3f BC = {float(int64_t(C % Nx) - int64_t(B % Nx)), float(int64_t(C / Nx) - int64_t(B / Nx)), HeightLayer[C] - HeightLayer[B]};
                 float Magnitude_BC = BC.norm();
 
-                Eigen::Vector4f BA_Normalized = BA.normalized();
-                Eigen::Vector4f BC_Normalized = BC.normalized();
-
-                float Magnitude_Change = (BC_Normalized - BA_Normalized).norm();
+                float Magnitude_Change = (BC.normalized() - BA.normalized()).norm();
                 return Magnitude_Change / (Magnitude_BC * Magnitude_BC) * BC.z();
             };
 
-            const size_t IndexMax = AutoParameter->Nx * AutoParameter->Ny - 1;
-            std::function<float(const CostPoint &, const CostPoint &)> CostFunc = [&CalcCurvature, &HeightCostFunc, &GradientCostFunc, &CurvatureCostFunc, &CostGrid, &Predecessor, IndexMax, Nx, Ny](const CostPoint &A, const CostPoint &B) mutable -> float {
-                size_t ia = A[0] + A[1] * Nx;
-                size_t ib = B[0] + B[1] * Nx;
-
-                //constexpr size_t Seed = 12306;
-                //size_t Hash = (ia + 0x9e3779b9 + (Seed << 4) + (Seed >> 2)) ^ (ib * 0x9e3779b9 + (Seed << 2) + (Seed >> 4));
-
-                // We assume that A already searched and have a predecessor
-                const CostPoint &PrevPoint = Predecessor[A];
-
-                // Calc curvature
+            auto HeightCurve = AutoParameter->HeightCurve, GradientCurve = AutoParameter->GradientCurve, CurvatureCurve = AutoParameter->CurvatureCurve;
+            const float CurvatureThreshold = AutoParameter->CurvatureThreshold;
+            auto CostFunc = [&](size_t A, size_t B, size_t PrevPoint) -> float {
                 float Curvature = CalcCurvature(PrevPoint, A, B);
+                return CurveCost(HeightCurve, -1.0f, std::abs(HeightLayer[A] - HeightLayer[B])) + CurveCost(GradientCurve, -1.0f, std::abs(GradientLayer[A] - GradientLayer[B])) + CurveCost(CurvatureCurve, CurvatureThreshold, std::abs(Curvature));
+            };
 
-                float Cost = HeightCostFunc(float(std::abs(CostGrid[ia].Height - CostGrid[ib].Height))) + GradientCostFunc(float(std::abs(CostGrid[ia].Gradient - CostGrid[ib].Gradient))) + CurvatureCostFunc(float(std::abs(Curvature)));
-                return Cost;
+            // A step spans at most sqrt(2) * MaskK cells and, for non-decreasing curves, costs at least the
+            // curves at zero, which bounds the remaining cost from below. Multiple goals fall back to Dijkstra.
+            const int32_t MaskK = std::max(AutoParameter->ConnectiveMask, 1);
+            const float FlatStepCost = std::max(0.0f, CurveCost(HeightCurve, -1.0f, 0.0f) + CurveCost(GradientCurve, -1.0f, 0.0f) + CurveCost(CurvatureCurve, CurvatureThreshold, 0.0f));
+            const float HeuristicScale = Goals.size() == 1 ? std::max(0.0f, AutoParameter->WeightHeuristic) * FlatStepCost / (float(std::sqrt(2.0)) * float(MaskK)) : 0.0f;
+            const int64_t GoalX = int64_t(Goals[0] % Nx), GoalY = int64_t(Goals[0] / Nx);
+            auto Heuristic = [HeuristicScale, GoalX, GoalY, Nx](size_t Index) -> float {
+                if (HeuristicScale == 0.0f) return 0.0f;
+                const float dx = float(int64_t(Index % Nx) - GoalX), dy = float(int64_t(Index / Nx) - GoalY);
+                return HeuristicScale * std::sqrt(dx * dx + dy * dy);
             };
 
             zeno::log_info("[Roads] Generating trajectory...");
 
-            ROADS_TIMING_PRE_GENERATED;
-
-            ROADS_TIMING_BLOCK("AStar Extended", roads::energy::RoadsShortestPath(StartPoint, GoalPoint, CostPoint{static_cast<size_t>(AutoParameter->Nx), static_cast<size_t>(AutoParameter->Ny)}, AutoParameter->ConnectiveMask, AutoParameter->AngleMask, AutoParameter->WeightHeuristic, Predecessor, CostMap, CostFunc));
+            energy::GridPathFinder PathFinder(Nx, Ny, MaskK);
 
-            zeno::log_info("[Roads] Result Predecessor Size: {}; CostMap Size: {}", Predecessor.size(), CostMap.size());
-
-            CostPoint Current = GoalPoint;
+            ROADS_TIMING_PRE_GENERATED;
 
-            ArrayList<size_t> Path;
-            while (Current != StartPoint) {
-                Path.push_back(Current[0] + Current[1] * AutoParameter->Nx);
-                Current = Predecessor[Current];
-            }
-            Path.push_back(StartPoint[0] + StartPoint[1] * AutoParameter->Nx);
+            ROADS_TIMING_BLOCK("AStar Extended", PathFinder.Search(Sources, Goals, CostFunc, Heuristic));
 
             if (AutoParameter->bRemoveTriangles) {
                 AutoParameter->Primitive->tris.clear();
             }
 
-            AutoParameter->Primitive->lines.resize(Path.size() - 1);
-            for (size_t i = 0; i < Path.size() - 1; ++i) {
-                AutoParameter->Primitive->lines[i] = zeno::vec2i(int(Path[i]), int(Path[i + 1]));
+            AutoParameter->Primitive->lines.clear();
+            for (size_t Goal: Goals) {
+                ArrayList<size_t> Path = PathFinder.ExtractPath(Goal);
+                if (Path.empty()) {
+                    zeno::log_error("[Roads] Goal ({}, {}) is unreachable.", Goal % Nx, Goal / Nx);
+                    continue;
+                }
+                for (size_t i = 0; i + 1 < Path.size(); ++i) {
+                    AutoParameter->Primitive->lines.push_back(zeno::vec2i(int(Path[i]), int(Path[i + 1])));
+                }
             }
         }
     };
@@ -1,11 +1,18 @@
 #pragma once
 
 #include "pch.h"
+#include <algorithm>
+#include <cstring>
 #include <functional>
+#include <limits>
 #include <numeric>
 #include <queue>
 #include <unordered_map>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 //#include "boost/graph/use_mpi.hpp"
 #include "boost/graph/adjacency_list.hpp"
 #include "boost/graph/graph_concepts.hpp"
@@ -64,133 +71,188 @@ namespace roads {
             return GreatestCommonDivisor(j, i % j);
         }
 
-        template<typename PointType = IntPoint2D>
-        void RoadsShortestPath(const PointType &StartPoint, const PointType &GoalPoint, const PointType &Bounds, const int32_t MaskK, const int32_t MaskA, const float WeightHeuristic, DefaultedHashMap<PointType, PointType> &PredecessorList, DefaultedHashMap<PointType, float> &CostTo, const std::function<float(const PointType &, const PointType &)> &CostFunction) {
-            auto NewCostFunc = [&CostFunction, &GoalPoint, &Bounds](const PointType &a, const PointType &b) -> float {
-                float Result = CostFunction(a, b);
-                if (Result < 0) {
-                    printf("[Roads] Minus cost P1(%d,%d) P2(%d,%d) Cost=%f.", a[0], a[1], b[0], b[1], Result);
-                    throw std::runtime_error("[Roads] Minus edge weight detected.");
-                }
-                return Result;
-                //return CostFunction(a, b) + std::abs<float>(GoalPoint[0] - b[0]) + std::abs<float>(GoalPoint[1] - b[1]);
-            };
-
-            std::unordered_map<std::pair<PointType, PointType>, float> SimpleCost;
-            std::function<float(const PointType &, const PointType &, bool)> StraightCost = [&NewCostFunc, MaskK, &SimpleCost, &StraightCost](const PointType &From, const PointType &To, bool bMoveX = true) mutable -> float {
-                auto CurrentPair = std::make_pair(From, To);
-                if (SimpleCost.count(CurrentPair)) {
-                    return SimpleCost[CurrentPair];
-                }
-
-                if (From[0] == To[0] && From[1] == To[1]) {
-                    SimpleCost[CurrentPair] = 0.0f;
-                    return 0.0f;
-                }
+        inline size_t HighestBit(uint32_t X) {
+#if defined(_MSC_VER)
+            unsigned long Index;
+            return _BitScanReverse(&Index, X) ? size_t(Index) + 1 : 0;
+#else
+            return X ? size_t(32 - __builtin_clz(X)) : 0;
+#endif
+        }
 
-                PointType NextPoint = From;
+        /**
+         * Monotone priority queue (radix heap) for non-negative float keys.
+         * Keys are compared through their IEEE bit patterns, which keep the order of
+         * non-negative floats. Pushing a key below the last popped one is clamped to it,
+         * so an inconsistent heuristic only delays a point instead of breaking the queue.
+         */
+        template<typename ValueType>
+        class RadixHeap {
+        public:
+            void Push(float Key, const ValueType &Value) {
+                uint32_t Bits = std::max(KeyBits(Key), Last);
+                Buckets[HighestBit(Bits ^ Last)].emplace_back(Bits, Value);
+                ++Size;
+            }
 
-                if (To[0] != From[0]) {
-                    if (std::abs<int32_t>(From[0] - To[0]) <= MaskK) {
-                        NextPoint[0] = To[0];
-                    } else if (From[0] < To[0]) {
-                        NextPoint[0] += MaskK;
-                    } else {
-                        NextPoint[0] -= MaskK;
+            ValueType Pop() {
+                if (Buckets[0].empty()) {
+                    size_t i = 1;
+                    while (Buckets[i].empty()) ++i;
+                    Last = std::min_element(Buckets[i].begin(), Buckets[i].end())->first;
+                    for (const auto &Item: Buckets[i]) {
+                        Buckets[HighestBit(Item.first ^ Last)].push_back(Item);
                     }
+                    Buckets[i].clear();
                 }
-                if (To[1] != From[1]) {
-                    if (std::abs<int32_t>(From[1] - To[1]) <= MaskK) {
-                        NextPoint[1] = To[1];
-                    } else if (From[1] < To[1]) {
-                        NextPoint[1] += MaskK;
-                    } else {
-                        NextPoint[1] -= MaskK;
-                    }
-                }
-
-                //printf("---- A(%d,%d) B(%d,%d)\n", NextPoint[0], NextPoint[0], To[1], To[1]);
-
-                float Cost = NewCostFunc(From, NextPoint) + StraightCost(NextPoint, To, !bMoveX);
-                SimpleCost[CurrentPair] = Cost;
-                return Cost;
-            };
-
-            // Adding Chebyshev distance as heuristic function
-            auto Comparator = [&CostTo, &GoalPoint, &Bounds, &StraightCost, WeightHeuristic](const PointType &Point1, const PointType &Point2) {
-                //float DeltaA = std::max(std::abs<int32_t>(Point1[0] - GoalPoint[0]) / Bounds[0], std::abs<int32_t>(Point1[1] - GoalPoint[1]) / Bounds[1]);
-                //float DeltaB = std::max(std::abs<int32_t>(Point2[0] - GoalPoint[0]) / Bounds[0], std::abs<int32_t>(Point2[1] - GoalPoint[1]) / Bounds[1]);
-                //float DeltaA = std::abs<int32_t>(Point1[0] - GoalPoint[0]) + std::abs<int32_t>(Point1[1] - GoalPoint[1]);
-                //float DeltaB = std::abs<int32_t>(Point2[0] - GoalPoint[0]) + std::abs<int32_t>(Point2[1] - GoalPoint[1]);
-                //float DeltaA = std::sqrt(std::pow(Point1[0] - GoalPoint[0], 2) + std::pow(Point1[1] - GoalPoint[1], 2));
-                //float DeltaB = std::sqrt(std::pow(Point2[0] - GoalPoint[0], 2) + std::pow(Point2[1] - GoalPoint[1], 2));
-
-                float DeltaA = StraightCost(Point1, GoalPoint, true);
-                float DeltaB = StraightCost(Point2, GoalPoint, true);
-
-                float CostA = CostTo.DefaultAt(Point1, std::numeric_limits<float>::max()) + WeightHeuristic * DeltaA;
-                float CostB = CostTo.DefaultAt(Point2, std::numeric_limits<float>::max()) + WeightHeuristic * DeltaB;
-                return CostA > CostB;
-            };
-
-            // initialize a priority queue Q with the initial point StartPoint
-            CostTo.reserve(Bounds[0] * Bounds[1] * MaskA);
-            std::priority_queue<PointType, ArrayList<PointType>, decltype(Comparator)> Q(Comparator);
-            for (size_t a = 0; a < MaskA; a++) {
-                PointType NewPoint = StartPoint;
-                NewPoint[2] = a;
-                CostTo[StartPoint] = 0.f;
+                ValueType Value = Buckets[0].back().second;
+                Buckets[0].pop_back();
+                --Size;
+                return Value;
             }
 
-            PredecessorList[StartPoint] = StartPoint;
-            Q.push(StartPoint);
+            bool Empty() const {
+                return Size == 0;
+            }
 
-            std::unordered_map<PointType, bool> Visual;
+            void Clear() {
+                for (auto &Bucket: Buckets) Bucket.clear();
+                Size = 0;
+                Last = 0;
+            }
 
-            // while Q is not empty
-            while (!Q.empty()) {
-                // select the point p_ij from the priority queue with the smallest cost value c(p_ij)
-                PointType Point = Q.top();
-                Q.pop();
+        private:
+            static uint32_t KeyBits(float Key) {
+                uint32_t Bits;
+                std::memcpy(&Bits, &Key, sizeof(Bits));
+                return Bits;
+            }
 
-                // if destination has been found p_ij = b, stop the algorithm
-                if (GoalPoint == Point) {
-                    break;
+            std::array<ArrayList<std::pair<uint32_t, ValueType>>, 33> Buckets;
+            size_t Size = 0;
+            uint32_t Last = 0;
+        };
+
+        /**
+         * Dense-grid shortest path engine. Costs, predecessors and states of the Nx * Ny cells
+         * live in flat arrays indexed by x + y * Nx, and open points are kept in a RadixHeap.
+         *
+         * One Search() may start from several sources and settle several goals, every reached
+         * cell then holds its cheapest path to the nearest source, which ExtractPath() walks back.
+         * Without goals the whole grid is settled.
+         */
+        class GridPathFinder {
+        public:
+            GridPathFinder(size_t InNx, size_t InNy, int32_t MaskK) : Nx(InNx), Ny(InNy) {
+                for (int32_t dx = -MaskK; dx <= MaskK; ++dx) {
+                    for (int32_t dy = -MaskK; dy <= MaskK; ++dy) {
+                        if (GreatestCommonDivisor(std::abs(dx), std::abs(dy)) == 1) {
+                            Neighbours.push_back({dx, dy});
+                        }
+                    }
                 }
+            }
 
-                if (Visual.find(Point) != std::end(Visual)) {
-                    continue;
+            /**
+             * @param CostFunc float(size_t From, size_t To, size_t Prev), Prev is the predecessor of From (From itself for sources).
+             * @param Heuristic float(size_t Index), must not be negative. Use a zero heuristic for Dijkstra.
+             */
+            template<typename CostFuncType, typename HeuristicFuncType>
+            void Search(const ArrayList<size_t> &Sources, const ArrayList<size_t> &Goals, CostFuncType &&CostFunc, HeuristicFuncType &&Heuristic) {
+                const size_t Num = Nx * Ny;
+                CostTo.assign(Num, std::numeric_limits<float>::max());
+                Predecessor.assign(Num, InvalidIndex);
+                State.assign(Num, 0);
+                Queue.Clear();
+
+                size_t GoalsLeft = 0;
+                for (size_t Goal: Goals) {
+                    if (Goal < Num && !(State[Goal] & GoalFlag)) {
+                        State[Goal] |= GoalFlag;
+                        ++GoalsLeft;
+                    }
                 }
-                Visual[Point] = 1;
-
-                //printf("-- P(%d,%d) %f\n", Point[0], Point[1], CostTo[Point]);
-
-                // extended mask for angle
-                for (size_t angle = 0; angle < MaskA; ++angle) {
-                    // step3. for all points q ∈ M_k(p_ij)
-                    for (int32_t dx = -MaskK; dx <= MaskK; ++dx) {
-                        for (int32_t dy = -MaskK; dy <= MaskK; ++dy) {
-                            if (GreatestCommonDivisor(std::abs(dx), std::abs(dy)) == 1) {
-                                PointType NeighbourPoint{Point[0] + dx, Point[1] + dy, angle};
-                                if (NeighbourPoint[0] < 0 || NeighbourPoint[1] < 0 || NeighbourPoint[0] >= Bounds[0] || NeighbourPoint[1] >= Bounds[1]) continue;
-
-                                float NewCost = CostTo[Point] + NewCostFunc(Point, NeighbourPoint);
-                                if (NewCost < 0) {
-                                    throw std::runtime_error("[Roads] Graph should not have negative weight. Check your curve !");
-                                }
-                                //printf("---- N(%d,%d) %f\n", NeighbourPoint[0], NeighbourPoint[1], NewCost);
-
-                                if (NewCost < CostTo.DefaultAt(NeighbourPoint, std::numeric_limits<float>::max())) {
-                                    PredecessorList[NeighbourPoint] = Point;
-                                    CostTo[NeighbourPoint] = NewCost;
-                                    Q.push(NeighbourPoint);
-                                }
-                            }
+                for (size_t Source: Sources) {
+                    if (Source >= Num) continue;
+                    CostTo[Source] = 0.f;
+                    Predecessor[Source] = Source;
+                    Queue.Push(Heuristic(Source), Source);
+                }
+
+                while (!Queue.Empty()) {
+                    const size_t Point = Queue.Pop();
+                    if (State[Point] & ClosedFlag) continue;
+                    State[Point] |= ClosedFlag;
+
+                    if ((State[Point] & GoalFlag) && --GoalsLeft == 0) {
+                        break;
+                    }
+
+                    const int64_t x = int64_t(Point % Nx), y = int64_t(Point / Nx);
+                    const float PointCost = CostTo[Point];
+                    const size_t Prev = Predecessor[Point];
+                    for (const auto &Offset: Neighbours) {
+                        const int64_t nx = x + Offset[0], ny = y + Offset[1];
+                        if (nx < 0 || ny < 0 || nx >= int64_t(Nx) || ny >= int64_t(Ny)) continue;
+                        const size_t Neighbour = size_t(nx + ny * int64_t(Nx));
+                        if (State[Neighbour] & ClosedFlag) continue;
+
+                        const float Cost = CostFunc(Point, Neighbour, Prev);
+                        if (Cost < 0) {
+                            printf("[Roads] Minus cost P1(%lld,%lld) P2(%lld,%lld) Cost=%f.", (long long) x, (long long) y, (long long) nx, (long long) ny, Cost);
+                            throw std::runtime_error("[Roads] Minus edge weight detected.");
+                        }
+                        const float NewCost = PointCost + Cost;
+                        if (NewCost < CostTo[Neighbour]) {
+                            CostTo[Neighbour] = NewCost;
+                            Predecessor[Neighbour] = Point;
+                            Queue.Push(NewCost + Heuristic(Neighbour), Neighbour);
                         }
                     }
                 }
             }
-        }
+
+            bool Reached(size_t Index) const {
+                return Index < Predecessor.size() && Predecessor[Index] != InvalidIndex;
+            }
+
+            /**
+             * @return Cells from Goal back to its source, both included. Empty if Goal was not reached.
+             */
+            ArrayList<size_t> ExtractPath(size_t Goal) const {
+                ArrayList<size_t> Path;
+                if (!Reached(Goal)) return Path;
+                size_t Current = Goal;
+                Path.push_back(Current);
+                while (Predecessor[Current] != Current) {
+                    Current = Predecessor[Current];
+                    Path.push_back(Current);
+                }
+                return Path;
+            }
+
+            const ArrayList<float> &GetCostTo() const {
+                return CostTo;
+            }
+
+            const ArrayList<size_t> &GetPredecessor() const {
+                return Predecessor;
+            }
+
+            static constexpr size_t InvalidIndex = std::numeric_limits<size_t>::max();
+
+            size_t Nx, Ny;
+            ArrayList<std::array<int32_t, 2>> Neighbours;
+
+        private:
+            static constexpr uint8_t ClosedFlag = 1;
+            static constexpr uint8_t GoalFlag = 2;
+
+            ArrayList<float> CostTo;
+            ArrayList<size_t> Predecessor;
+            ArrayList<uint8_t> State;
+            RadixHeap<size_t> Queue;
+        };
     }// namespace energy
 
     namespace spline {
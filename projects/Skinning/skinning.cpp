@@ -9,10 +9,10 @@
 #include <igl/directed_edge_parents.h>
 #include <igl/forward_kinematics.h>
 #include <igl/deform_skeleton.h>
-#include <igl/dqs.h>
 
-
-#include <igl/lbs_matrix.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
 
 #include "skinning_iobject.h"
 
@@ -68,186 +68,350 @@ ZENDEFNODE(BlendPoses, {
     {"Skinning"},
 });
 
-// input the forward kinematics result
-struct DoSkinning : zeno::INode {
-    virtual void apply() override {
-        auto shape = get_input<PrimitiveObject>("shape");
-        auto algorithm = get_param<std::string>(("algorithm"));
-        auto attr_prefix = get_param<std::string>("attr_prefix");
-        auto outputChannel = get_param<std::string>("out_channel");
-
-        auto Qs_ = get_input<zeno::ListObject>("Qs")->get<NumericObject>();
-        auto Ts_ = get_input<zeno::ListObject>("Ts")->get<NumericObject>();
-
-        // std::cout << "GOT QS AND TS INPUT" << std::endl;
-        size_t dim = 3;
-        size_t nm_handles = 0;
-
-
-        auto& out_chan = shape->add_attr<zeno::vec3f>(outputChannel);
-        // std::cout << "CHECKOUT_1" << std::endl;
-
-        while(true){
-            std::string attr_name = attr_prefix + "_" + std::to_string(nm_handles);
-            if(shape->has_attr(attr_name)){
-                nm_handles++;
-                continue;
-            }
-            break;
+static size_t countSkinningHandles(PrimitiveObject *shape, std::string const &attr_prefix) {
+    size_t nm_handles = 0;
+    while(shape->has_attr(attr_prefix + "_" + std::to_string(nm_handles)))
+        nm_handles++;
+    return nm_handles;
+}
+
+// Gathers the weight attributes <prefix>_0 .. <prefix>_{n-1} into top-k sparse
+// influences. maxInfluences == 0 keeps every nonzero weight, so the result is
+// exact; otherwise the k largest weights are kept and rescaled to the same sum.
+static std::shared_ptr<SkinningBinding> bindSkinningWeights(PrimitiveObject *shape, std::string const &attr_prefix, size_t maxInfluences) {
+    size_t nm_handles = countSkinningHandles(shape, attr_prefix);
+    if(nm_handles == 0)
+        throw std::runtime_error("The Skinned Prim Does Not Have Weight Attr");
+    size_t nv = shape->size();
+
+    std::vector<float const *> W(nm_handles);
+    for(size_t i = 0;i < nm_handles;++i)
+        W[i] = shape->attr<float>(attr_prefix + "_" + std::to_string(i)).data();
+
+    size_t k = 0;
+    bool has_nan = false;
+#pragma omp parallel for reduction(max:k) reduction(||:has_nan)
+    for(intptr_t j = 0;j < (intptr_t)nv;++j){
+        size_t cnt = 0;
+        for(size_t i = 0;i < nm_handles;++i){
+            has_nan = has_nan || std::isnan(W[i][j]);
+            cnt += W[i][j] != 0;
         }
-
-        Eigen::MatrixXd W;
-        W.resize(shape->size(),nm_handles);
-        for(size_t i = 0;i < nm_handles;++i){ 
-            std::string attr_name = attr_prefix +  "_" + std::to_string(i);
-            for(size_t j = 0;j < shape->size();++j){
-                if(!shape->has_attr(attr_name)){
-                    std::cout << "DO NOT HAVE " << attr_name << std::endl;
-                    std::cout << "NM_QS_AND_TS : " << nm_handles << std::endl;
-                    throw std::runtime_error("The Skinned Prim Does Not Have Weight Attr");
-                }
-                W(j,i) = shape->attr<float>(attr_name)[j];
-                if(std::isnan(W(j,i))){
-                    std::cout << "NAN VALUE DETECTED IN SKINNING WEIGHT MATRIX : " << j << "\t" << i << "\t" << W(j,i) << std::endl;
-                    throw std::runtime_error("NAN VALUE DETECTED IN SKINNING WEIGHT MATRIX");
+        k = std::max(k, cnt);
+    }
+    if(has_nan)
+        throw std::runtime_error("NAN VALUE DETECTED IN SKINNING WEIGHT MATRIX");
+    if(maxInfluences)
+        k = std::min(k, maxInfluences);
+    k = std::max(k, (size_t)1);
+
+    auto res = std::make_shared<SkinningBinding>();
+    res->nverts = nv;
+    res->nhandles = nm_handles;
+    res->k = k;
+    res->idx.assign(k * nv, 0);
+    res->wgt.assign(k * nv, 0.f);
+    for(int d = 0;d < 3;++d)
+        res->rest[d].resize(nv);
+
+#pragma omp parallel
+    {
+        std::vector<std::pair<float, int>> infl;
+#pragma omp for
+        for(intptr_t j = 0;j < (intptr_t)nv;++j){
+            infl.clear();
+            float sum = 0;
+            for(size_t i = 0;i < nm_handles;++i){
+                if(W[i][j] != 0){
+                    infl.emplace_back(W[i][j], (int)i);
+                    sum += W[i][j];
                 }
             }
+            float scale = 1;
+            if(infl.size() > k){
+                std::partial_sort(infl.begin(), infl.begin() + k, infl.end(),
+                    [](auto const &a, auto const &b){ return std::abs(a.first) > std::abs(b.first); });
+                infl.resize(k);
+                float kept = 0;
+                for(auto const &[w, id] : infl)
+                    kept += w;
+                if(kept != 0)
+                    scale = sum / kept;
+            }
+            for(size_t s = 0;s < infl.size();++s){
+                res->idx[s * nv + j] = infl[s].second;
+                res->wgt[s * nv + j] = infl[s].first * scale;
+            }
+            for(int d = 0;d < 3;++d)
+                res->rest[d][j] = shape->verts[j][d];
         }
+    }
+    return res;
+}
+
+// Reads the per-handle transformations, running forward kinematics over the
+// rest bones first when FK is enabled.
+static void collectSkinningTransforms(zeno::ListObject *Qs_list, zeno::ListObject *Ts_list, size_t nm_handles,
+        bool do_FK, PrimitiveObject *bones, RotationList &Qs, std::vector<Eigen::Vector3d> &Ts) {
+    auto Qs_ = Qs_list->get<NumericObject>();
+    auto Ts_ = Ts_list->get<NumericObject>();
+    if(Qs_.size() < nm_handles || Ts_.size() < nm_handles)
+        throw std::runtime_error("THE NUMBER OF RIGGING TRANSFORMATIONS DOES NOT MATCH THE SKINNING WEIGHTS");
+
+    std::vector<Eigen::Vector3d> LFT;
+    RotationList LFQ;
+    for(size_t i = 0;i < nm_handles;++i){
+        auto t = Ts_[i]->get<zeno::vec3f>();
+        auto q = Qs_[i]->get<zeno::vec4f>();
+        if(std::isnan(zeno::length(t)) || std::isnan(zeno::length(q))){
+            std::cout << "T<" << i << "> : " << t[0] << "\t" << t[1] << "\t" << t[2] << std::endl;
+            std::cout << "Q<" << i << "> : " << q[0] << "\t" << q[1] << "\t" << q[2] << "\t" << q[3] << std::endl;
+            throw std::runtime_error("NAN RIGGING AFFINE TRANSFORMATION DETECTED");
+        }
+        LFT.emplace_back(t[0],t[1],t[2]);
+        LFQ.emplace_back(q[3],q[0],q[1],q[2]);
+    }
 
-        std::vector<Eigen::Vector3d> Ts;
-        RotationList Qs;
-
+    if(!do_FK){
+        Qs = std::move(LFQ);
+        Ts = std::move(LFT);
+        return;
+    }
+    if(!bones){
+        throw std::runtime_error("INPUT JOINTS INFOR FOR FORWARD KINEMATICS");
+    }
 
+    Eigen::MatrixXd C;
+    Eigen::MatrixXi BE;
 
-        // std::cout << "CHECKOUT_2" << std::endl;
+    C.resize(bones->size(),3);
+    BE.resize(bones->lines.size(),2);
 
-        auto do_FK = get_param<int>("FK");
-        if(!do_FK){
-            std::cout << "GLOBAL TRANSFORMATION BLENDING" << std::endl;
-            std::cout << "NM_HANDLES : " << nm_handles << std::endl;
-            for(size_t i = 0;i < nm_handles;++i){
-                if(std::isnan(zeno::length(Ts_[i]->get<zeno::vec3f>())) || std::isnan(zeno::length(Qs_[i]->get<zeno::vec4f>()))){
-                    std::cout << "NAN RIGGING AFFINE TRANSFORMATION DETECTED" << std::endl;
-                    std::cout << "T<" << i << "> : " << Eigen::Vector3d(Ts_[i]->get<zeno::vec3f>()[0],
-                        Ts_[i]->get<zeno::vec3f>()[1],
-                        Ts_[i]->get<zeno::vec3f>()[2]).transpose() << std::endl;
-
-                    std::cout << "Q<" << i << "> : " << Eigen::Vector4d(Qs_[i]->get<zeno::vec4f>()[0],
-                        Qs_[i]->get<zeno::vec4f>()[1],
-                        Qs_[i]->get<zeno::vec4f>()[2],
-                        Qs_[i]->get<zeno::vec4f>()[3]).transpose() << std::endl;
-
-                    throw std::runtime_error("NAN RIGGING AFFINE TRANSFORMATION DETECTED");
-                }
+    for(size_t i = 0;i < bones->size();++i){
+        C.row(i) << bones->verts[i][0],bones->verts[i][1],bones->verts[i][2];
+    }
 
-                Ts.emplace_back(Ts_[i]->get<zeno::vec3f>()[0],
-                    Ts_[i]->get<zeno::vec3f>()[1],
-                    Ts_[i]->get<zeno::vec3f>()[2]);
-                Qs.emplace_back(Qs_[i]->get<zeno::vec4f>()[3],
-                    Qs_[i]->get<zeno::vec4f>()[0],
-                    Qs_[i]->get<zeno::vec4f>()[1],
-                    Qs_[i]->get<zeno::vec4f>()[2]);
-            }
+    for(size_t i = 0;i < bones->lines.size();++i)
+        BE.row(i) << bones->lines[i][0],bones->lines[i][1];
+
+    Eigen::VectorXi P;
+    igl::directed_edge_parents(BE,P);
+    igl::forward_kinematics(C,BE,P,LFQ,LFT,Qs,Ts);
+}
+
+// Packs the per-handle blending parameters handle-major: the 3x4 row-major
+// affine matrix for LBS, the real then dual quaternion (w, x, y, z) for DQS.
+static std::vector<float> packSkinningHandles(bool dqs, RotationList const &Qs, std::vector<Eigen::Vector3d> const &Ts) {
+    size_t stride = dqs ? 8 : 12;
+    std::vector<float> res(Qs.size() * stride);
+    for(size_t e = 0;e < Qs.size();++e){
+        float *h = res.data() + e * stride;
+        if(dqs){
+            Eigen::Quaterniond dual = Eigen::Quaterniond(0,Ts[e][0],Ts[e][1],Ts[e][2]) * Qs[e];
+            dual.coeffs() *= 0.5;
+            h[0] = Qs[e].w(); h[1] = Qs[e].x(); h[2] = Qs[e].y(); h[3] = Qs[e].z();
+            h[4] = dual.w(); h[5] = dual.x(); h[6] = dual.y(); h[7] = dual.z();
         }else{
-            if(!has_input("restBones")){
-                throw std::runtime_error("INPUT JOINTS INFOR FOR FORWARD KINEMATICS");
+            Eigen::Matrix3d R = Qs[e].toRotationMatrix();
+            for(int r = 0;r < 3;++r){
+                h[r * 4 + 0] = R(r,0);
+                h[r * 4 + 1] = R(r,1);
+                h[r * 4 + 2] = R(r,2);
+                h[r * 4 + 3] = Ts[e][r];
             }
-            auto bones = get_input<PrimitiveObject>("restBones");
-            std::vector<Eigen::Vector3d> LFT;
-            RotationList LFQ;
-            for(size_t i = 0;i < nm_handles;++i){
-                LFT.emplace_back(Ts_[i]->get<zeno::vec3f>()[0],
-                    Ts_[i]->get<zeno::vec3f>()[1],
-                    Ts_[i]->get<zeno::vec3f>()[2]);
-                LFQ.emplace_back(Qs_[i]->get<zeno::vec4f>()[3],
-                    Qs_[i]->get<zeno::vec4f>()[0],
-                    Qs_[i]->get<zeno::vec4f>()[1],
-                    Qs_[i]->get<zeno::vec4f>()[2]);
-            }
-
-            Eigen::MatrixXd C;
-            Eigen::MatrixXi BE;
-
-            C.resize(bones->size(),3);
-            BE.resize(bones->lines.size(),2);
-
-            for(size_t i = 0;i < bones->size();++i){
-                C.row(i) << bones->verts[i][0],bones->verts[i][1],bones->verts[i][2];
+        }
+    }
+    return res;
+}
+
+// Skins every vertex of the binding once per frame. Vertices are processed in
+// blocks so the sparse weights and rest positions of a block are loaded once
+// and reused by all frames, and the inner loops over a block vectorize.
+static void skinVertices(SkinningBinding const &bd, bool dqs,
+        std::vector<std::vector<float>> const &frames, std::vector<zeno::vec3f *> const &outs) {
+    constexpr size_t kBlock = 256;
+    size_t nv = bd.nverts;
+    size_t nblocks = (nv + kBlock - 1) / kBlock;
+#pragma omp parallel for schedule(static)
+    for(intptr_t blk = 0;blk < (intptr_t)nblocks;++blk){
+        size_t v0 = blk * kBlock, vn = std::min(kBlock, nv - v0);
+        float const *rx = bd.rest[0].data() + v0;
+        float const *ry = bd.rest[1].data() + v0;
+        float const *rz = bd.rest[2].data() + v0;
+        for(size_t f = 0;f < frames.size();++f){
+            float const *H = frames[f].data();
+            zeno::vec3f *out = outs[f] + v0;
+            if(!dqs){
+                float ox[kBlock] = {}, oy[kBlock] = {}, oz[kBlock] = {};
+                for(size_t s = 0;s < bd.k;++s){
+                    int const *id = bd.idx.data() + s * nv + v0;
+                    float const *wt = bd.wgt.data() + s * nv + v0;
+#pragma omp simd
+                    for(size_t i = 0;i < vn;++i){
+                        float const *A = H + id[i] * 12;
+                        float w = wt[i];
+                        ox[i] += w * (A[0] * rx[i] + A[1] * ry[i] + A[2] * rz[i] + A[3]);
+                        oy[i] += w * (A[4] * rx[i] + A[5] * ry[i] + A[6] * rz[i] + A[7]);
+                        oz[i] += w * (A[8] * rx[i] + A[9] * ry[i] + A[10] * rz[i] + A[11]);
+                    }
+                }
+                for(size_t i = 0;i < vn;++i)
+                    out[i] = zeno::vec3f(ox[i], oy[i], oz[i]);
+            }else{
+                float b[8][kBlock] = {};
+                for(size_t s = 0;s < bd.k;++s){
+                    int const *id = bd.idx.data() + s * nv + v0;
+                    float const *wt = bd.wgt.data() + s * nv + v0;
+#pragma omp simd
+                    for(size_t i = 0;i < vn;++i){
+                        float const *D = H + id[i] * 8;
+                        float w = wt[i];
+                        for(int c = 0;c < 8;++c)
+                            b[c][i] += w * D[c];
+                    }
+                }
+                // algorithm 1 of "Geometric skinning with approximate dual
+                // quaternion blending" (Kavan et al.), as in igl::dqs
+#pragma omp simd
+                for(size_t i = 0;i < vn;++i){
+                    float inv = 1 / std::sqrt(b[0][i] * b[0][i] + b[1][i] * b[1][i] + b[2][i] * b[2][i] + b[3][i] * b[3][i]);
+                    float a0 = b[0][i] * inv, dx = b[1][i] * inv, dy = b[2][i] * inv, dz = b[3][i] * inv;
+                    float ae = b[4][i] * inv, ex = b[5][i] * inv, ey = b[6][i] * inv, ez = b[7][i] * inv;
+                    float vx = rx[i], vy = ry[i], vz = rz[i];
+                    // c = d0 x v + a0 v
+                    float cx = dy * vz - dz * vy + a0 * vx;
+                    float cy = dz * vx - dx * vz + a0 * vy;
+                    float cz = dx * vy - dy * vx + a0 * vz;
+                    // v + 2 d0 x c + 2 (a0 de - ae d0 + d0 x de)
+                    float ux = vx + 2 * (dy * cz - dz * cy) + 2 * (a0 * ex - ae * dx + dy * ez - dz * ey);
+                    float uy = vy + 2 * (dz * cx - dx * cz) + 2 * (a0 * ey - ae * dy + dz * ex - dx * ez);
+                    float uz = vz + 2 * (dx * cy - dy * cx) + 2 * (a0 * ez - ae * dz + dx * ey - dy * ex);
+                    out[i] = zeno::vec3f(ux, uy, uz);
+                }
             }
-
-            for(size_t i = 0;i < bones->lines.size();++i)
-                BE.row(i) << bones->lines[i][0],bones->lines[i][1];
-
-            Eigen::VectorXi P;
-            igl::directed_edge_parents(BE,P);
-            // std::cout << "DO FORWARD KINEMATICS" << std::endl;
-            igl::forward_kinematics(C,BE,P,LFQ,LFT,Qs,Ts);
         }
+    }
+}
+
+static bool hasNanVertex(zeno::vec3f const *pos, size_t n) {
+    bool has_nan = false;
+#pragma omp parallel for reduction(||:has_nan)
+    for(intptr_t i = 0;i < (intptr_t)n;++i)
+        has_nan = has_nan || std::isnan(pos[i][0] + pos[i][1] + pos[i][2]);
+    return has_nan;
+}
+
+// Binds the skinning weights of a shape once, so that DoSkinning can reuse the
+// sparse weights and the rest pose across frames instead of rebuilding them.
+struct BindSkinningWeights : zeno::INode {
+    virtual void apply() override {
+        auto shape = get_input<PrimitiveObject>("shape");
+        auto attr_prefix = get_param<std::string>("attr_prefix");
+        auto maxInfluences = get_param<int>("maxInfluences");
+        set_output("binding", bindSkinningWeights(shape.get(), attr_prefix, std::max(maxInfluences, 0)));
+    }
+};
 
+ZENDEFNODE(BindSkinningWeights, {
+    {"shape"},
+    {"binding"},
+    {{"string","attr_prefix","sw"},{"int","maxInfluences","0"}},
+    {"Skinning"},
+});
 
+static std::shared_ptr<SkinningBinding> getSkinningBinding(zeno::INode *node, PrimitiveObject *shape) {
+    if(node->has_input("binding")){
+        auto binding = node->get_input<SkinningBinding>("binding");
+        if(binding->nverts != shape->size())
+            throw std::runtime_error("THE SKINNING BINDING DOES NOT MATCH THE SHAPE");
+        return binding;
+    }
+    return bindSkinningWeights(shape, node->get_param<std::string>("attr_prefix"),
+        std::max(node->get_param<int>("maxInfluences"), 0));
+}
 
-        // std::cout << "CHECKOUT_3" << std::endl;
-
-        Eigen::MatrixXd T(nm_handles*(dim+1),dim);
-        for(int e = 0;e<nm_handles;e++){
-            Eigen::Affine3d a = Eigen::Affine3d::Identity();
-            a.translate(Ts[e]);
-            a.rotate(Qs[e]);
-            T.block(e*(dim+1),0,dim+1,dim) =
-                a.matrix().transpose().block(0,0,dim+1,dim);
-        }
-        // Compute deformation via LBS as matrix multiplication
-        Eigen::MatrixXd U,V;
-        V.resize(shape->size(),3);
-        for(size_t i = 0;i < V.rows();++i)
-            V.row(i) << shape->verts[i][0],shape->verts[i][1],shape->verts[i][2];
-
+// input the forward kinematics result
+struct DoSkinning : zeno::INode {
+    virtual void apply() override {
+        auto shape = get_input<PrimitiveObject>("shape");
+        auto algorithm = get_param<std::string>(("algorithm"));
+        auto outputChannel = get_param<std::string>("out_channel");
+        auto do_FK = get_param<int>("FK");
+        auto bones = has_input("restBones") ? get_input<PrimitiveObject>("restBones") : nullptr;
 
-        if(std::isnan(V.norm()) || std::isnan(W.norm()) || std::isnan(T.norm())){
-            std::cout << V.norm() << "\t" << W.norm() << std::endl;
-            throw std::runtime_error("IN SKINNING NAN VW DETECTED");
-        }
+        auto binding = getSkinningBinding(this, shape.get());
 
-        if(algorithm == "DQS"){
-            // std::cout << "DQS SKINNING " << std::endl;
-            igl::dqs(V,W,Qs,Ts,U);
-        }else if(algorithm == "LBS"){
-            Eigen::MatrixXd M;
-            igl::lbs_matrix(V,W,M);
-            U = M*T;
-        }        
+        std::vector<Eigen::Vector3d> Ts;
+        RotationList Qs;
+        collectSkinningTransforms(get_input<zeno::ListObject>("Qs").get(), get_input<zeno::ListObject>("Ts").get(),
+            binding->nhandles, do_FK, bones.get(), Qs, Ts);
 
+        bool dqs = algorithm == "DQS";
         auto deformed_shape = std::make_shared<zeno::PrimitiveObject>(*shape);// automatic copy all the attributes
-        // deformed_shape->resize(shape->size());
-        // deformed_shape->tris.resize(shape->tris.size());
-        // deformed_shape->quads.resize(shape->quads.size());
-
-        if(std::isnan(U.norm())){
-            std::cout << "W : \n" << W << std::endl;
-            std::cout << "NAN DEFORMED SHAPE DETECTED: " << U.norm() << std::endl;
-            std::cout << "AFFINE : " << std::endl;
-            for(size_t i = 0;i < nm_handles;++i){
-                std::cout << Qs[i].x() << "\t" 
-                            << Qs[i].y() << "\t" 
-                            << Qs[i].z() << "\t" 
-                            << Qs[i].w() << std::endl;
-                std::cout << Ts[i].transpose() << std::endl;
-            }
+        auto& out_chan = deformed_shape->add_attr<zeno::vec3f>(outputChannel);
+        skinVertices(*binding, dqs, {packSkinningHandles(dqs, Qs, Ts)}, {out_chan.data()});
 
+        if(hasNanVertex(out_chan.data(), out_chan.size()))
             throw std::runtime_error("NAN DEFORMED SHAPE DETECTED");
-        }
-        // std::cout << "CHECKOUT_4" << std::endl;
-        for(size_t i = 0;i < deformed_shape->size();++i)
-            out_chan[i] = zeno::vec3f(U.row(i)[0],U.row(i)[1],U.row(i)[2]);
 
         set_output("dshape",std::move(deformed_shape));
     }
 };
 
 ZENDEFNODE(DoSkinning, {
-    {"shape","Qs","Ts","restBones"},
+    {"shape","Qs","Ts","restBones","binding"},
     {"dshape"},
-    {{"enum LBS DQS","algorithm","DQS"},{"string","attr_prefix","sw"},{"string","out_channel","curPos"},{"int","FK","0"}},
+    {{"enum LBS DQS","algorithm","DQS"},{"string","attr_prefix","sw"},{"string","out_channel","curPos"},{"int","FK","0"},{"int","maxInfluences","0"}},
+    {"Skinning"},
+});
+
+// Skins a whole batch of poses in one pass: Qs and Ts are lists holding one
+// list of per-handle transformations per frame, dshapes gets one shape per frame.
+struct DoSkinningBatch : zeno::INode {
+    virtual void apply() override {
+        auto shape = get_input<PrimitiveObject>("shape");
+        auto algorithm = get_param<std::string>(("algorithm"));
+        auto outputChannel = get_param<std::string>("out_channel");
+        auto do_FK = get_param<int>("FK");
+        auto bones = has_input("restBones") ? get_input<PrimitiveObject>("restBones") : nullptr;
+
+        auto binding = getSkinningBinding(this, shape.get());
+
+        auto Qs_frames = get_input<zeno::ListObject>("Qs")->get<zeno::ListObject>();
+        auto Ts_frames = get_input<zeno::ListObject>("Ts")->get<zeno::ListObject>();
+        if(Qs_frames.size() != Ts_frames.size())
+            throw std::runtime_error("THE NUMBER OF QS AND TS FRAMES DOES NOT MATCH");
+
+        bool dqs = algorithm == "DQS";
+        std::vector<std::vector<float>> frames;
+        std::vector<std::shared_ptr<PrimitiveObject>> shapes;
+        std::vector<zeno::vec3f *> outs;
+        for(size_t f = 0;f < Qs_frames.size();++f){
+            std::vector<Eigen::Vector3d> Ts;
+            RotationList Qs;
+            collectSkinningTransforms(Qs_frames[f].get(), Ts_frames[f].get(), binding->nhandles, do_FK, bones.get(), Qs, Ts);
+            frames.push_back(packSkinningHandles(dqs, Qs, Ts));
+            auto deformed_shape = std::make_shared<zeno::PrimitiveObject>(*shape);
+            outs.push_back(deformed_shape->add_attr<zeno::vec3f>(outputChannel).data());
+            shapes.push_back(std::move(deformed_shape));
+        }
+
+        skinVertices(*binding, dqs, frames, outs);
+
+        auto res = std::make_shared<zeno::ListObject>();
+        for(auto &deformed_shape : shapes){
+            if(hasNanVertex(deformed_shape->attr<zeno::vec3f>(outputChannel).data(), deformed_shape->size()))
+                throw std::runtime_error("NAN DEFORMED SHAPE DETECTED");
+            res->arr.push_back(std::move(deformed_shape));
+        }
+        set_output("dshapes",std::move(res));
+    }
+};
+
+ZENDEFNODE(DoSkinningBatch, {
+    {"shape","Qs","Ts","restBones","binding"},
+    {"dshapes"},
+    {{"enum LBS DQS","algorithm","DQS"},{"string","attr_prefix","sw"},{"string","out_channel","curPos"},{"int","FK","0"},{"int","maxInfluences","0"}},
     {"Skinning"},
 });
 
@@ -28,4 +28,17 @@ struct SkinningWeight : zeno::IObject {
     Eigen::MatrixXd weight;
 };
 
+// Top-k sparse skinning weights plus the rest pose they were bound to, all
+// stored as SoA: influence slot s of vertex i lives at [s * nverts + i].
+// Unused slots carry handle 0 with weight 0.
+struct SkinningBinding : zeno::IObject {
+    SkinningBinding() = default;
+    size_t nverts = 0;
+    size_t nhandles = 0;
+    size_t k = 0;
+    std::vector<int> idx;
+    std::vector<float> wgt;
+    std::vector<float> rest[3];
+};
+
 };
\ No newline at end of file
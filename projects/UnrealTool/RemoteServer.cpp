@@ -36,6 +36,7 @@
 #include <zeno/extra/GraphException.h>
 #include <zeno/logger.h>
 #include <zeno/types/PrimitiveObject.h>
+#include <zeno/unreal/SubjectStream.h>
 #include <zeno/unreal/UnrealTool.h>
 #include <zeno/unreal/ZenoRemoteTypes.h>
 
@@ -144,6 +145,8 @@ namespace zeno {
         void FetchDataDiff(const httplib::Request &Req, httplib::Response &Res);
         static void PushData(const httplib::Request &Req, httplib::Response &Res);
         void FetchData(const httplib::Request &Req, httplib::Response &Res);
+        static void PushStream(const httplib::Request &Req, httplib::Response &Res);
+        static void FetchStream(const httplib::Request &Req, httplib::Response &Res);
 
         static void ParseGraphInfo(const httplib::Request &Req,
                                    httplib::Response &Res);
@@ -184,6 +187,8 @@ namespace zeno {
             Srv.Get("/subject/diff", HANDLER_SESSION_CHECK(FetchDataDiff));
             Srv.Post("/subject/push", HANDLER_SESSION_CHECK(PushData));
             Srv.Get("/subject/fetch", HANDLER_SESSION_CHECK(FetchData));
+            Srv.Post("/subject/stream/push", HANDLER_SESSION_CHECK(PushStream));
+            Srv.Get("/subject/stream/fetch", HANDLER_SESSION_CHECK(FetchStream));
             Srv.Post("/graph/parse", HANDLER_SESSION_CHECK(ParseGraphInfo));
             Srv.Post("/graph/param/push", HANDLER_SESSION_CHECK(PushParameter));
             Srv.Post("/graph/run", HANDLER_SESSION_CHECK(RunGraph));
@@ -245,7 +250,7 @@ namespace zeno {
 
     void ZenoRemoteServer::IndexPage(const httplib::Request &Req,
                                      httplib::Response &Res) {
-        Res.set_content(R"({"api_version": 1, "protocol": "msgpack"})",
+        Res.set_content(R"({"api_version": 1, "protocol": "msgpack", "stream_version": 1})",
                         "application/json");
     }
 
@@ -386,6 +391,59 @@ namespace zeno {
                         "application/binary");
     }
 
+    /**
+ * POST /subject/stream/push?session_key={string}&key={string}&base={int}
+ * BODY patch of zeno::remote::StreamSubject against version base, see EncodeStreamPatch
+ * base 0 or absent means the patch carries every chunk
+ * return the new subject version as text if success, status code 400 if failed
+ */
+    void ZenoRemoteServer::PushStream(const httplib::Request &Req,
+                                      httplib::Response &Res) {
+        std::string SessionKey = Req.has_param("session_key")
+                                     ? Req.get_param_value("session_key")
+                                     : ParseSessionKey(Req);
+        const std::string Key = Req.get_param_value("key");
+        const auto BaseVersion = static_cast<uint32_t>(
+            std::strtoul(Req.get_param_value("base").c_str(), nullptr, 10));
+        const std::string &Body = Req.body;
+        uint32_t Version = 0;
+        if (remote::StaticStreams.PushPatch(reinterpret_cast<const uint8_t *>(Body.data()),
+                                            Body.size(), Key, BaseVersion, SessionKey,
+                                            Version)) {
+            Res.set_content(std::to_string(Version), "text/plain");
+        } else {
+            Res.status = 400;
+        }
+    }
+
+    /**
+ * GET /subject/stream/fetch?key={string}&since={int}&compression={none|delta_rle}
+ * since is the subject version the client holds, 0 or absent for everything
+ * return patch with the chunks changed after that version, see EncodeStreamPatch
+ * return status code 404 if not found
+ */
+    void ZenoRemoteServer::FetchStream(const httplib::Request &Req,
+                                       httplib::Response &Res) {
+        std::string SessionKey = Req.has_param("session_key")
+                                     ? Req.get_param_value("session_key")
+                                     : ParseSessionKey(Req);
+        const std::string Key = Req.get_param_value("key");
+        const auto SinceVersion = static_cast<uint32_t>(
+            std::strtoul(Req.get_param_value("since").c_str(), nullptr, 10));
+        const remote::EStreamCompression Compression =
+            Req.get_param_value("compression") == "delta_rle"
+                ? remote::EStreamCompression::DeltaRLE
+                : remote::EStreamCompression::None;
+        std::vector<uint8_t> Data;
+        if (!remote::StaticStreams.Fetch(SessionKey, Key, SinceVersion, Compression,
+                                         Data)) {
+            Res.status = 404;
+            return;
+        }
+        Res.set_content(reinterpret_cast<const char *>(Data.data()), Data.size(),
+                        "application/binary");
+    }
+
     /**
  * POST /graph/parse
  * BODY a string of zsl file (json).
@@ -712,6 +770,8 @@ namespace zeno {
                 remote::SubjectContainer NewSubject =
                     IObjectExtractor<remote::ESubjectType::Mesh>{}(prim.get(),
                                                                    subject_name);
+                zeno::remote::StaticStreams.Push(
+                    remote::MakeMeshStream(subject_name, *prim));
                 zeno::remote::StaticRegistry.Push({
                     std::move(NewSubject),
                 });
@@ -719,6 +779,8 @@ namespace zeno {
                 remote::SubjectContainer NewSubject =
                     IObjectExtractor<remote::ESubjectType::HeightField>{}(prim.get(),
                                                                           subject_name);
+                zeno::remote::StaticStreams.Push(
+                    remote::MakeHeightFieldStream(subject_name, *prim));
                 zeno::remote::StaticRegistry.Push({
                     std::move(NewSubject),
                 });
@@ -886,6 +948,16 @@ namespace zeno {
       {"Unreal"}});
 
     struct SetExecutionResult : public INode {
+        static void PushStream(remote::StreamSubject &&Subject,
+                               const std::map<std::string, std::string> &Meta,
+                               const std::string &SessionKey) {
+            if (Subject.GetType() == remote::ESubjectType::Invalid) {
+                return;
+            }
+            Subject.Meta = Meta;
+            remote::StaticStreams.Push(std::move(Subject), SessionKey);
+        }
+
         void apply() override {
             const std::string ProcessorType = get_input2<std::string>("type");
             const remote::ESubjectType Type = remote::NameToSubjectType(ProcessorType);
@@ -911,11 +983,15 @@ namespace zeno {
                 remote::SubjectContainer NewSubject =
                     IObjectExtractor<remote::ESubjectType::Mesh>{}(Value.get(),
                                                                    SubjectName, Meta);
+                PushStream(remote::MakeMeshStream(SubjectName, *safe_dynamic_cast<PrimitiveObject>(Value.get())),
+                           Meta, SessionKey);
                 remote::StaticRegistry.Push({NewSubject}, SessionKey);
             } else if (Type == remote::ESubjectType::HeightField) {
                 remote::SubjectContainer NewSubject =
                     IObjectExtractor<remote::ESubjectType::HeightField>{}(
                         Value.get(), SubjectName, Meta);
+                PushStream(remote::MakeHeightFieldStream(SubjectName, *safe_dynamic_cast<PrimitiveObject>(Value.get())),
+                           Meta, SessionKey);
                 remote::StaticRegistry.Push({NewSubject}, SessionKey);
             } else if (Type == remote::ESubjectType::PointSet) {
                 remote::SubjectContainer NewSubject =
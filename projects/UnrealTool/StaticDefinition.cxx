@@ -1,7 +1,8 @@
-
 #include "zeno/unreal/UnrealTool.h"
+#include "zeno/unreal/SubjectStream.h"
 
 namespace zeno::remote {
     Flags StaticFlags;
     SubjectRegistry StaticRegistry;
+    StreamRegistry StaticStreams;
 }// namespace zeno::remote
@@ -0,0 +1,518 @@
+#include "zeno/unreal/SubjectStream.h"
+#include "zeno/unreal/UnrealTool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <zeno/para/parallel_for.h>
+#include <zeno/types/PrimitiveObject.h>
+
+namespace zeno::remote {
+
+    namespace {
+
+        constexpr uint32_t StreamMagic = 0x4d54535a;// "ZSTM"
+        constexpr uint16_t StreamFormatVersion = 1;
+
+        uint64_t HashChunk(const std::vector<uint8_t> &Bytes) {
+            uint64_t H = 0x9e3779b97f4a7c15ull ^ Bytes.size();
+            size_t Idx = 0;
+            for (; Idx + 8 <= Bytes.size(); Idx += 8) {
+                uint64_t W;
+                std::memcpy(&W, Bytes.data() + Idx, 8);
+                H = (H ^ (W * 0xff51afd7ed558ccdull)) * 0xc4ceb9fe1a85ec53ull;
+                H ^= H >> 29;
+            }
+            for (; Idx < Bytes.size(); Idx++) {
+                H = (H ^ Bytes[Idx]) * 1099511628211ull;
+            }
+            return H;
+        }
+
+        void HashChunks(StreamSubject &Subject) {
+            Subject.Hashes.resize(Subject.Chunks.size());
+            Subject.Versions.assign(Subject.Chunks.size(), 0);
+            parallel_for(Subject.Chunks.size(), [&](size_t Idx) {
+                Subject.Hashes[Idx] = HashChunk(Subject.Chunks[Idx]);
+            });
+        }
+
+        // Word size and interleaved lanes used by the delta step
+        std::pair<size_t, size_t> GetDeltaShape(ESubjectType Type) {
+            if (Type == ESubjectType::HeightField) {
+                return {2, 1};
+            }
+            return {4, 3};
+        }
+
+        std::vector<uint8_t> EncodeDeltaRLE(const std::vector<uint8_t> &Raw, size_t WordSize, size_t Lanes) {
+            const size_t NumWords = Raw.size() / WordSize;
+            std::vector<uint8_t> Planes(Raw.size());
+            for (size_t Idx = 0; Idx < NumWords; ++Idx) {
+                uint32_t Cur = 0, Prev = 0;
+                std::memcpy(&Cur, Raw.data() + Idx * WordSize, WordSize);
+                if (Idx >= Lanes) {
+                    std::memcpy(&Prev, Raw.data() + (Idx - Lanes) * WordSize, WordSize);
+                }
+                const uint32_t Delta = Cur - Prev;
+                for (size_t B = 0; B < WordSize; ++B) {
+                    Planes[B * NumWords + Idx] = static_cast<uint8_t>(Delta >> (8 * B));
+                }
+            }
+            std::copy(Raw.begin() + NumWords * WordSize, Raw.end(), Planes.begin() + NumWords * WordSize);
+
+            // Control byte below 0x80: that many plus one literal bytes follow, otherwise a run of (c - 0x80 + 1) zeros
+            std::vector<uint8_t> Out;
+            Out.reserve(Planes.size() / 2);
+            size_t Idx = 0;
+            while (Idx < Planes.size()) {
+                size_t Run = 0;
+                while (Idx + Run < Planes.size() && Planes[Idx + Run] == 0 && Run < 128) {
+                    ++Run;
+                }
+                if (Run >= 2) {
+                    Out.push_back(static_cast<uint8_t>(0x80 + Run - 1));
+                    Idx += Run;
+                    continue;
+                }
+                size_t End = Idx;
+                while (End < Planes.size() && End - Idx < 128 &&
+                       !(End + 1 < Planes.size() && Planes[End] == 0 && Planes[End + 1] == 0)) {
+                    ++End;
+                }
+                Out.push_back(static_cast<uint8_t>(End - Idx - 1));
+                Out.insert(Out.end(), Planes.begin() + Idx, Planes.begin() + End);
+                Idx = End;
+            }
+            return Out;
+        }
+
+        bool DecodeDeltaRLE(const uint8_t *Data, size_t Size, size_t RawSize, size_t WordSize, size_t Lanes,
+                            std::vector<uint8_t> &Raw) {
+            std::vector<uint8_t> Planes;
+            Planes.reserve(RawSize);
+            size_t Idx = 0;
+            while (Idx < Size) {
+                const uint8_t Ctrl = Data[Idx++];
+                if (Ctrl >= 0x80) {
+                    Planes.insert(Planes.end(), Ctrl - 0x80 + 1, 0);
+                } else {
+                    const size_t Len = Ctrl + 1;
+                    if (Idx + Len > Size) {
+                        return false;
+                    }
+                    Planes.insert(Planes.end(), Data + Idx, Data + Idx + Len);
+                    Idx += Len;
+                }
+                if (Planes.size() > RawSize) {
+                    return false;
+                }
+            }
+            if (Planes.size() != RawSize) {
+                return false;
+            }
+            const size_t NumWords = RawSize / WordSize;
+            Raw.resize(RawSize);
+            for (size_t W = 0; W < NumWords; ++W) {
+                uint32_t Delta = 0, Prev = 0;
+                for (size_t B = 0; B < WordSize; ++B) {
+                    Delta |= static_cast<uint32_t>(Planes[B * NumWords + W]) << (8 * B);
+                }
+                if (W >= Lanes) {
+                    std::memcpy(&Prev, Raw.data() + (W - Lanes) * WordSize, WordSize);
+                }
+                const uint32_t Cur = Delta + Prev;
+                std::memcpy(Raw.data() + W * WordSize, &Cur, WordSize);
+            }
+            std::copy(Planes.begin() + NumWords * WordSize, Planes.end(), Raw.begin() + NumWords * WordSize);
+            return true;
+        }
+
+        template<typename T>
+        void PutLE(std::vector<uint8_t> &Out, T Value) {
+            using U = std::make_unsigned_t<T>;
+            const U Bits = static_cast<U>(Value);
+            for (size_t B = 0; B < sizeof(T); ++B) {
+                Out.push_back(static_cast<uint8_t>(Bits >> (8 * B)));
+            }
+        }
+
+        void PutString(std::vector<uint8_t> &Out, const std::string &Str) {
+            PutLE<uint32_t>(Out, static_cast<uint32_t>(Str.size()));
+            Out.insert(Out.end(), Str.begin(), Str.end());
+        }
+
+        struct PatchReader {
+            const uint8_t *Data;
+            size_t Size;
+            size_t Pos = 0;
+            bool bOk = true;
+
+            template<typename T>
+            T Get() {
+                using U = std::make_unsigned_t<T>;
+                if (Pos + sizeof(T) > Size) {
+                    bOk = false;
+                    return T{};
+                }
+                U Bits = 0;
+                for (size_t B = 0; B < sizeof(T); ++B) {
+                    Bits |= static_cast<U>(static_cast<U>(Data[Pos + B]) << (8 * B));
+                }
+                Pos += sizeof(T);
+                return static_cast<T>(Bits);
+            }
+
+            const uint8_t *GetBytes(size_t Len) {
+                if (Pos + Len > Size) {
+                    bOk = false;
+                    return nullptr;
+                }
+                const uint8_t *Ptr = Data + Pos;
+                Pos += Len;
+                return Ptr;
+            }
+
+            std::string GetString() {
+                const auto Len = Get<uint32_t>();
+                const uint8_t *Ptr = GetBytes(Len);
+                return Ptr ? std::string(reinterpret_cast<const char *>(Ptr), Len) : std::string{};
+            }
+        };
+
+    }// namespace
+
+    StreamSubject MakeHeightFieldStream(const std::string &Name, const zeno::PrimitiveObject &Prim,
+                                        int32_t TileSize) {
+        StreamSubject Subject;
+        Subject.Name = Name;
+        if (!Prim.verts.has_attr("height") || TileSize <= 0) {
+            return Subject;
+        }
+        auto &HeightAttrs = Prim.verts.attr<float>("height");
+        // Currently height field are always square.
+        const auto N = static_cast<int32_t>(std::round(std::sqrt(Prim.verts.size())));
+        const int32_t TilesX = (N + TileSize - 1) / TileSize;
+        const int32_t TilesY = (N + TileSize - 1) / TileSize;
+        Subject.Type = static_cast<int16_t>(ESubjectType::HeightField);
+        Subject.Layout = {N, N, TileSize};
+        Subject.Chunks.resize(static_cast<size_t>(TilesX) * TilesY);
+        parallel_for(Subject.Chunks.size(), [&](size_t Tile) {
+            const int32_t X0 = static_cast<int32_t>(Tile % TilesX) * TileSize;
+            const int32_t Y0 = static_cast<int32_t>(Tile / TilesX) * TileSize;
+            const int32_t W = std::min(TileSize, N - X0), H = std::min(TileSize, N - Y0);
+            auto &Chunk = Subject.Chunks[Tile];
+            Chunk.resize(static_cast<size_t>(W) * H * 2);
+            size_t Out = 0;
+            for (int32_t Y = Y0; Y < Y0 + H; ++Y) {
+                for (int32_t X = X0; X < X0 + W; ++X) {
+                    constexpr uint16_t uint16Max = std::numeric_limits<uint16_t>::max();
+                    const size_t Idx = static_cast<size_t>(Y) * N + X;
+                    const float Height = Idx < HeightAttrs.size() ? HeightAttrs[Idx] : 0.f;
+                    const auto Value = static_cast<uint16_t>(
+                        std::round(zeno::clamp(Height * UE_LANDSCAPE_ZSCALE + 0x8000, 0.f,
+                                               static_cast<float>(uint16Max))));
+                    Chunk[Out++] = static_cast<uint8_t>(Value);
+                    Chunk[Out++] = static_cast<uint8_t>(Value >> 8);
+                }
+            }
+        });
+        HashChunks(Subject);
+        return Subject;
+    }
+
+    StreamSubject MakeMeshStream(const std::string &Name, const zeno::PrimitiveObject &Prim,
+                                 int32_t ChunkElements) {
+        StreamSubject Subject;
+        Subject.Name = Name;
+        if (ChunkElements <= 0) {
+            return Subject;
+        }
+        const size_t NumVerts = Prim.verts.size(), NumTris = Prim.tris.size();
+        const size_t VertChunks = (NumVerts + ChunkElements - 1) / ChunkElements;
+        const size_t TriChunks = (NumTris + ChunkElements - 1) / ChunkElements;
+        Subject.Type = static_cast<int16_t>(ESubjectType::Mesh);
+        Subject.Layout = {static_cast<int32_t>(NumVerts), static_cast<int32_t>(NumTris), ChunkElements};
+        Subject.Chunks.resize(VertChunks + TriChunks);
+        parallel_for(Subject.Chunks.size(), [&](size_t ChunkIdx) {
+            auto &Chunk = Subject.Chunks[ChunkIdx];
+            std::array<uint32_t, 3> Words;
+            const bool bVerts = ChunkIdx < VertChunks;
+            const size_t Base = (bVerts ? ChunkIdx : ChunkIdx - VertChunks) * ChunkElements;
+            const size_t Count = std::min<size_t>(ChunkElements, (bVerts ? NumVerts : NumTris) - Base);
+            Chunk.resize(Count * 12);
+            uint8_t *Out = Chunk.data();
+            for (size_t Idx = Base; Idx < Base + Count; ++Idx) {
+                if (bVerts) {
+                    const auto &Pos = Prim.verts[Idx];
+                    const float Swapped[3] = {Pos[0], Pos[2], Pos[1]};
+                    std::memcpy(Words.data(), Swapped, 12);
+                } else {
+                    const auto &Tri = Prim.tris[Idx];
+                    const int32_t Ind[3] = {Tri[0], Tri[1], Tri[2]};
+                    std::memcpy(Words.data(), Ind, 12);
+                }
+                for (uint32_t Word: Words) {
+                    for (size_t B = 0; B < 4; ++B) {
+                        *Out++ = static_cast<uint8_t>(Word >> (8 * B));
+                    }
+                }
+            }
+        });
+        HashChunks(Subject);
+        return Subject;
+    }
+
+    std::vector<uint8_t> EncodeStreamPatch(const StreamSubject &Subject, uint32_t SinceVersion,
+                                           EStreamCompression Compression) {
+        std::vector<uint32_t> Sent;
+        for (size_t Idx = 0; Idx < Subject.Chunks.size(); ++Idx) {
+            if (SinceVersion == 0 || Subject.Versions[Idx] > SinceVersion) {
+                Sent.push_back(static_cast<uint32_t>(Idx));
+            }
+        }
+
+        const auto [WordSize, Lanes] = GetDeltaShape(Subject.GetType());
+        std::vector<std::vector<uint8_t>> Encoded(Sent.size());
+        if (Compression == EStreamCompression::DeltaRLE) {
+            parallel_for(Sent.size(), [&, WordSize = WordSize, Lanes = Lanes](size_t Idx) {
+                Encoded[Idx] = EncodeDeltaRLE(Subject.Chunks[Sent[Idx]], WordSize, Lanes);
+            });
+        }
+
+        std::vector<uint8_t> Out;
+        PutLE<uint32_t>(Out, StreamMagic);
+        PutLE<uint16_t>(Out, StreamFormatVersion);
+        PutLE<int16_t>(Out, Subject.Type);
+        PutLE<uint32_t>(Out, Subject.Version);
+        for (int32_t Value: Subject.Layout) {
+            PutLE<int32_t>(Out, Value);
+        }
+        PutLE<uint32_t>(Out, static_cast<uint32_t>(Subject.Chunks.size()));
+        PutString(Out, Subject.Name);
+        PutLE<uint32_t>(Out, static_cast<uint32_t>(Subject.Meta.size()));
+        for (const auto &[Key, Value]: Subject.Meta) {
+            PutString(Out, Key);
+            PutString(Out, Value);
+        }
+        PutLE<uint32_t>(Out, static_cast<uint32_t>(Sent.size()));
+        for (size_t Idx = 0; Idx < Sent.size(); ++Idx) {
+            const auto &Raw = Subject.Chunks[Sent[Idx]];
+            // Fall back to raw bytes where compression does not pay off
+            const bool bCompressed = Compression != EStreamCompression::None && Encoded[Idx].size() < Raw.size();
+            const auto &Payload = bCompressed ? Encoded[Idx] : Raw;
+            PutLE<uint32_t>(Out, Sent[Idx]);
+            PutLE<uint32_t>(Out, Subject.Versions[Sent[Idx]]);
+            PutLE<uint64_t>(Out, Subject.Hashes[Sent[Idx]]);
+            PutLE<uint8_t>(Out, static_cast<uint8_t>(bCompressed ? Compression : EStreamCompression::None));
+            PutLE<uint32_t>(Out, static_cast<uint32_t>(Raw.size()));
+            PutLE<uint32_t>(Out, static_cast<uint32_t>(Payload.size()));
+            Out.insert(Out.end(), Payload.begin(), Payload.end());
+        }
+        return Out;
+    }
+
+    bool ApplyStreamPatch(StreamSubject &Local, const uint8_t *Data, size_t Size) {
+        PatchReader Reader{Data, Size};
+        if (Reader.Get<uint32_t>() != StreamMagic || Reader.Get<uint16_t>() != StreamFormatVersion) {
+            return false;
+        }
+        StreamSubject Result;
+        Result.Type = Reader.Get<int16_t>();
+        Result.Version = Reader.Get<uint32_t>();
+        for (int32_t &Value: Result.Layout) {
+            Value = Reader.Get<int32_t>();
+        }
+        const auto NumChunks = Reader.Get<uint32_t>();
+        Result.Name = Reader.GetString();
+        const auto NumMeta = Reader.Get<uint32_t>();
+        for (uint32_t Idx = 0; Idx < NumMeta && Reader.bOk; ++Idx) {
+            std::string Key = Reader.GetString();
+            Result.Meta[std::move(Key)] = Reader.GetString();
+        }
+        if (!Reader.bOk) {
+            return false;
+        }
+
+        // Chunks not in the patch are kept from the local copy, which must then have the same layout
+        const bool bSameShape = Local.Type == Result.Type && Local.Layout == Result.Layout &&
+                                Local.Chunks.size() == NumChunks;
+        Result.Chunks.resize(NumChunks);
+        Result.Hashes.assign(NumChunks, 0);
+        Result.Versions.assign(NumChunks, 0);
+        std::vector<bool> Received(NumChunks, false);
+        const auto [WordSize, Lanes] = GetDeltaShape(Result.GetType());
+        const auto NumSent = Reader.Get<uint32_t>();
+        for (uint32_t Idx = 0; Idx < NumSent; ++Idx) {
+            const auto ChunkIdx = Reader.Get<uint32_t>();
+            const auto ChunkVersion = Reader.Get<uint32_t>();
+            const auto Hash = Reader.Get<uint64_t>();
+            const auto Compression = static_cast<EStreamCompression>(Reader.Get<uint8_t>());
+            const auto RawSize = Reader.Get<uint32_t>();
+            const auto PayloadSize = Reader.Get<uint32_t>();
+            const uint8_t *Payload = Reader.GetBytes(PayloadSize);
+            if (!Reader.bOk || ChunkIdx >= NumChunks) {
+                return false;
+            }
+            auto &Chunk = Result.Chunks[ChunkIdx];
+            if (Compression == EStreamCompression::None) {
+                if (PayloadSize != RawSize) {
+                    return false;
+                }
+                Chunk.assign(Payload, Payload + PayloadSize);
+            } else if (Compression == EStreamCompression::DeltaRLE) {
+                if (!DecodeDeltaRLE(Payload, PayloadSize, RawSize, WordSize, Lanes, Chunk)) {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+            Result.Hashes[ChunkIdx] = Hash;
+            Result.Versions[ChunkIdx] = ChunkVersion;
+            Received[ChunkIdx] = true;
+        }
+        if (!bSameShape && std::find(Received.begin(), Received.end(), false) != Received.end()) {
+            return false;
+        }
+        for (uint32_t Idx = 0; Idx < NumChunks; ++Idx) {
+            if (Received[Idx]) {
+                continue;
+            }
+            Result.Chunks[Idx] = std::move(Local.Chunks[Idx]);
+            Result.Hashes[Idx] = Local.Hashes[Idx];
+            Result.Versions[Idx] = Local.Versions[Idx];
+        }
+        Local = std::move(Result);
+        return true;
+    }
+
+    size_t StreamRegistry::Push(StreamSubject &&Subject, const std::string &SessionKey) {
+        if (!StaticFlags.IsMainProcess()) {
+            return PushToMain(std::move(Subject), SessionKey);
+        }
+        std::lock_guard<std::mutex> Lock(Mutex);
+        return Merge(std::move(Subject), SessionKey);
+    }
+
+    bool StreamRegistry::PushPatch(const uint8_t *Data, size_t Size, const std::string &Key, uint32_t BaseVersion,
+                                   const std::string &SessionKey, uint32_t &OutVersion) {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        auto &Subjects = GetOrCreate(SessionalSubjects, SessionKey);
+        if (BaseVersion == 0) {
+            StreamSubject Subject;
+            if (!ApplyStreamPatch(Subject, Data, Size) || Subject.Name != Key) {
+                return false;
+            }
+            Merge(std::move(Subject), SessionKey);
+            OutVersion = Subjects[Key].Version;
+            return true;
+        }
+
+        // Runner diffed against BaseVersion, chunks it sent are stamped BaseVersion + 1
+        auto Iter = Subjects.find(Key);
+        if (Iter == Subjects.end() || Iter->second.Version != BaseVersion) {
+            return false;
+        }
+        StreamSubject &Stored = Iter->second;
+        if (!ApplyStreamPatch(Stored, Data, Size)) {
+            return false;
+        }
+        Stored.Name = Key;
+        Stored.Version = BaseVersion + 1;
+        OutVersion = Stored.Version;
+        return true;
+    }
+
+    size_t StreamRegistry::Merge(StreamSubject &&Subject, const std::string &SessionKey) {
+        auto &Subjects = GetOrCreate(SessionalSubjects, SessionKey);
+        StreamSubject &Old = Subjects[Subject.Name];
+        const bool bSameShape = Old.Type == Subject.Type && Old.Layout == Subject.Layout &&
+                                Old.Chunks.size() == Subject.Chunks.size();
+        const uint32_t NewVersion = Old.Version + 1;
+        Old.Name = Subject.Name;
+        Old.Type = Subject.Type;
+        Old.Layout = Subject.Layout;
+        Old.Meta = std::move(Subject.Meta);
+        Old.Version = NewVersion;
+        Old.Chunks.resize(Subject.Chunks.size());
+        Old.Hashes.resize(Subject.Chunks.size());
+        Old.Versions.resize(Subject.Chunks.size());
+        size_t NumChanged = 0;
+        for (size_t Idx = 0; Idx < Subject.Chunks.size(); ++Idx) {
+            if (bSameShape && Old.Hashes[Idx] == Subject.Hashes[Idx] && Old.Chunks[Idx] == Subject.Chunks[Idx]) {
+                continue;
+            }
+            Old.Chunks[Idx] = std::move(Subject.Chunks[Idx]);
+            Old.Hashes[Idx] = Subject.Hashes[Idx];
+            Old.Versions[Idx] = NewVersion;
+            ++NumChanged;
+        }
+        return NumChanged;
+    }
+
+    size_t StreamRegistry::PushToMain(StreamSubject &&Subject, const std::string &SessionKey) {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        auto &Subjects = GetOrCreate(SessionalSubjects, SessionKey);
+        // Runner side only keeps what the main process acknowledged: layout, hashes and its version
+        StreamSubject &Acked = Subjects[Subject.Name];
+        const bool bSameShape = Acked.Version != 0 && Acked.Type == Subject.Type &&
+                                Acked.Layout == Subject.Layout && Acked.Hashes.size() == Subject.Chunks.size();
+        uint32_t BaseVersion = bSameShape ? Acked.Version : 0;
+        size_t NumChanged = 0;
+        for (size_t Idx = 0; Idx < Subject.Chunks.size(); ++Idx) {
+            const bool bChanged = !bSameShape || Acked.Hashes[Idx] != Subject.Hashes[Idx];
+            Subject.Versions[Idx] = bChanged ? BaseVersion + 1 : BaseVersion;
+            NumChanged += bChanged;
+        }
+        if (bSameShape && NumChanged == 0 && Acked.Meta == Subject.Meta) {
+            return 0;
+        }
+        Subject.Version = BaseVersion;
+
+        httplib::Client Cli{ZENO_TOOL_SERVER_ADDRESS};
+        Cli.set_default_headers({{ZENO_SESSION_HEADER_KEY, ZENO_LOCAL_TOKEN}});
+        auto Post = [&](uint32_t Base) -> httplib::Result {
+            std::vector<uint8_t> Data = EncodeStreamPatch(Subject, Base, EStreamCompression::None);
+            const std::string &Url = StringFormat("/subject/stream/push?session_key=%s&key=%s&base=%u",
+                                                  SessionKey, Subject.Name, Base);
+            return Cli.Post(Url, reinterpret_cast<const char *>(Data.data()), Data.size(), "application/binary");
+        };
+        httplib::Result Response = Post(BaseVersion);
+        if (BaseVersion != 0 && (!Response || Response->status != 200)) {
+            // Main process lost or moved past our base, send everything once
+            BaseVersion = 0;
+            Subject.Version = 0;
+            NumChanged = Subject.Chunks.size();
+            Response = Post(BaseVersion);
+        }
+        if (!Response || Response->status != 200) {
+            Subjects.erase(Subject.Name);
+            return NumChanged;
+        }
+        Acked.Type = Subject.Type;
+        Acked.Layout = Subject.Layout;
+        Acked.Meta = std::move(Subject.Meta);
+        Acked.Hashes = std::move(Subject.Hashes);
+        Acked.Version = static_cast<uint32_t>(std::strtoul(Response->body.c_str(), nullptr, 10));
+        return NumChanged;
+    }
+
+    bool StreamRegistry::Fetch(const std::string &SessionKey, const std::string &Key, uint32_t SinceVersion,
+                               EStreamCompression Compression, std::vector<uint8_t> &OutData) {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        for (const std::string &Session: {SessionKey, std::string{}}) {
+            auto SessionIter = SessionalSubjects.find(Session);
+            if (SessionIter == SessionalSubjects.end()) {
+                continue;
+            }
+            auto Iter = SessionIter->second.find(Key);
+            if (Iter != SessionIter->second.end()) {
+                OutData = EncodeStreamPatch(Iter->second, SinceVersion, Compression);
+                return true;
+            }
+        }
+        return false;
+    }
+
+}// namespace zeno::remote
@@ -6,4 +6,7 @@ namespace zeno::remote {
 
     struct SubjectRegistry;
     extern SubjectRegistry StaticRegistry;
+
+    struct StreamRegistry;
+    extern StreamRegistry StaticStreams;
 }
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "ZenoRemoteTypes.h"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace zeno {
+struct PrimitiveObject;
+}
+
+namespace zeno::remote {
+
+enum class EStreamCompression : uint8_t {
+    None = 0,
+    // Per element delta, byte planes, zero run length. Cheap and good on smooth terrain.
+    DeltaRLE = 1,
+};
+
+/**
+ * @brief StreamSubject
+ * @note  HeightField or Mesh split into fixed size chunks, each with its hash and the subject
+ *        version it last changed in. Clients fetch only chunks newer than the version they hold.
+ *        HeightField: TileSize x TileSize tiles of uint16 samples, row major inside a tile,
+ *        tiles row major, border tiles clipped. Layout is {Nx, Ny, TileSize}.
+ *        Mesh: runs of ChunkElements vertices (3 x float, Y and Z swapped as in Mesh) followed by
+ *        runs of ChunkElements triangles (3 x int32). Layout is {NumVertices, NumTriangles, ChunkElements}.
+ *        Chunk bytes are little-endian.
+ */
+struct StreamSubject {
+    std::string Name;
+    int16_t/* ESubjectType */ Type = static_cast<int16_t>(ESubjectType::Invalid);
+    uint32_t Version = 0;
+    std::map<std::string, std::string> Meta;
+    std::array<int32_t, 3> Layout {0, 0, 0};
+    std::vector<uint64_t> Hashes;
+    std::vector<uint32_t> Versions;
+    std::vector<std::vector<uint8_t>> Chunks;
+
+    ESubjectType GetType() const {
+        return static_cast<ESubjectType>(Type);
+    }
+};
+
+/**
+ * Build a tiled stream from a primitive with float attribute "height", remapped like IObjectExtractor<HeightField>
+ * @return Stream with Type Invalid if the attribute is missing
+ */
+StreamSubject MakeHeightFieldStream(const std::string& Name, const zeno::PrimitiveObject& Prim, int32_t TileSize = 256);
+
+/**
+ * Build a chunked stream from primitive verts and tris
+ */
+StreamSubject MakeMeshStream(const std::string& Name, const zeno::PrimitiveObject& Prim, int32_t ChunkElements = 16384);
+
+/**
+ * Encode chunks changed after SinceVersion, SinceVersion 0 sends everything
+ * @note Wire format, all integers little-endian:
+ *       "ZSTM" u16 FormatVersion i16 Type u32 Version i32 Layout[3] u32 NumChunks
+ *       str Name u32 NumMeta (str Key, str Value)... u32 NumSent
+ *       (u32 Index u32 ChunkVersion u64 Hash u8 Compression u32 RawSize u32 Size bytes[Size])...
+ *       where str is u32 length followed by bytes
+ */
+std::vector<uint8_t> EncodeStreamPatch(const StreamSubject& Subject, uint32_t SinceVersion, EStreamCompression Compression);
+
+/**
+ * Apply a patch made by EncodeStreamPatch, this is all a client needs to mirror a subject
+ * @return false if the patch is malformed, Local is left untouched then
+ */
+bool ApplyStreamPatch(StreamSubject& Local, const uint8_t* Data, size_t Size);
+
+/**
+ * Streamed subjects, diffed chunk by chunk against the previous push
+ */
+struct StreamRegistry {
+    std::mutex Mutex;
+    std::map<std::string, std::map<std::string, StreamSubject>> SessionalSubjects;
+
+    /**
+     * Push subject, in child process only chunks whose hash changed since the last acknowledged push
+     * are forwarded to the main process
+     * @note Does not fire StaticRegistry.Callback, push the matching SubjectContainer afterwards to notify
+     * @return Number of chunks that changed
+     */
+    size_t Push(StreamSubject&& Subject, const std::string& SessionKey = "");
+
+    /**
+     * Apply a patch sent by a child process, BaseVersion 0 means the patch carries every chunk
+     * @return false if the patch is malformed or BaseVersion is not the stored version
+     */
+    bool PushPatch(const uint8_t* Data, size_t Size, const std::string& Key, uint32_t BaseVersion,
+                   const std::string& SessionKey, uint32_t& OutVersion);
+
+    /**
+     * Encode changes of a subject since client version, search global subjects if not found in session
+     * @return false if not found
+     */
+    bool Fetch(const std::string& SessionKey, const std::string& Key, uint32_t SinceVersion,
+               EStreamCompression Compression, std::vector<uint8_t>& OutData);
+
+private:
+    size_t Merge(StreamSubject&& Subject, const std::string& SessionKey);
+    size_t PushToMain(StreamSubject&& Subject, const std::string& SessionKey);
+};
+
+}
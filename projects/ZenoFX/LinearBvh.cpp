@@ -2,9 +2,12 @@
 #include "SpatialUtils.hpp"
 #include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <exception>
 #include <iostream>
 #include <stdexcept>
+#include <zeno/types/UserData.h>
 #include <zeno/zeno.h>
 #if defined(_OPENMP)
 #include <omp.h>
@@ -12,6 +15,21 @@
 
 namespace zeno {
 
+/// morton code of a point in the unit cube
+static LBvh::Tu getMortonCode(const LBvh::TV &p) {
+  using Tu = LBvh::Tu;
+  auto expand_bits = [](Tu v) -> Tu { // expands lower 10-bits to 30 bits
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+  };
+  return (expand_bits((Tu)(p[0] * 1024.f)) << (Tu)2) |
+         (expand_bits((Tu)(p[1] * 1024.f)) << (Tu)1) |
+         expand_bits((Tu)(p[2] * 1024.f));
+}
+
 typename LBvh::BvFunc
 LBvh::getBvFunc(const std::shared_ptr<PrimitiveObject> &prim) const {
   constexpr auto ma = std::numeric_limits<float>::max();
@@ -163,6 +181,10 @@ void LBvh::build(const std::shared_ptr<PrimitiveObject> &prim, float thickness,
     }
     return;
   }
+  if (buildMethod == build_e::sah) {
+    buildSah(numLeaves);
+    return;
+  }
 
   constexpr int dim = 3;
   constexpr auto ma = std::numeric_limits<float>::max();
@@ -214,19 +236,6 @@ void LBvh::build(const std::shared_ptr<PrimitiveObject> &prim, float thickness,
   // wholeBox.second[1], wholeBox.second[2]);
 
   std::vector<std::pair<Tu, Ti>> records(numLeaves); // <mc, id>
-  /// morton codes
-  auto getMortonCode = [](const TV &p) -> Tu {
-    auto expand_bits = [](Tu v) -> Tu { // expands lower 10-bits to 30 bits
-      v = (v * 0x00010001u) & 0xFF0000FFu;
-      v = (v * 0x00000101u) & 0x0F00F00Fu;
-      v = (v * 0x00000011u) & 0xC30C30C3u;
-      v = (v * 0x00000005u) & 0x49249249u;
-      return v;
-    };
-    return (expand_bits((Tu)(p[0] * 1024.f)) << (Tu)2) |
-           (expand_bits((Tu)(p[1] * 1024.f)) << (Tu)1) |
-           expand_bits((Tu)(p[2] * 1024.f));
-  };
   {
     const auto lengths = wholeBox.second - wholeBox.first;
     auto getUniformCoord = [&wholeBox, &lengths](const TV &p) {
@@ -495,6 +504,246 @@ void LBvh::build(const std::shared_ptr<PrimitiveObject> &prim,
     build(prim, thickness, radiusAttr, element_c<element_e::point>);
 }
 
+void LBvh::build(const std::shared_ptr<PrimitiveObject> &prim, float thickness,
+                 std::string radiusAttr, element_e et) {
+  if (et == element_e::tet)
+    build(prim, thickness, radiusAttr, element_c<element_e::tet>);
+  else if (et == element_e::tri)
+    build(prim, thickness, radiusAttr, element_c<element_e::tri>);
+  else if (et == element_e::line)
+    build(prim, thickness, radiusAttr, element_c<element_e::line>);
+  else if (et == element_e::point)
+    build(prim, thickness, radiusAttr, element_c<element_e::point>);
+  else
+    build(prim, thickness, radiusAttr);
+}
+
+/// top-down binned SAH build, emitting the same preorder layout as the
+/// morton build (left child at node + 1, escape index in auxIndices) so
+/// that refit and every query work unchanged
+namespace {
+struct SahBuilder {
+  using Ti = LBvh::Ti;
+  using TV = LBvh::TV;
+  using Box = LBvh::Box;
+  static constexpr int numBins = 16;
+
+  LBvh &bvh;
+  const std::vector<Box> &leafBvs;
+  const std::vector<TV> &centers;
+  std::vector<Ti> &ids;
+
+  static Box merge(const Box &a, const Box &b) {
+    Box bv;
+    for (int d = 0; d != 3; ++d) {
+      bv.first[d] = std::min(a.first[d], b.first[d]);
+      bv.second[d] = std::max(a.second[d], b.second[d]);
+    }
+    return bv;
+  }
+  static float area(const Box &b) {
+    auto e = b.second - b.first;
+    return e[0] * e[1] + e[1] * e[2] + e[2] * e[0];
+  }
+
+  Ti split(Ti begin, Ti end) const {
+    constexpr auto ma = std::numeric_limits<float>::max();
+    constexpr auto mi = std::numeric_limits<float>::lowest();
+    Box cb{TV{ma, ma, ma}, TV{mi, mi, mi}};
+    for (Ti i = begin; i != end; ++i)
+      cb = merge(cb, Box{centers[ids[i]], centers[ids[i]]});
+    auto ext = cb.second - cb.first;
+    int axis = ext[0] > ext[1] ? (ext[0] > ext[2] ? 0 : 2) : (ext[1] > ext[2] ? 1 : 2);
+    Ti mid = begin + (end - begin) / 2;
+    if (ext[axis] > 0) {
+      const float lo = cb.first[axis], scale = numBins / ext[axis];
+      auto binOf = [&](Ti e) {
+        return std::min(numBins - 1, (int)((centers[e][axis] - lo) * scale));
+      };
+      Box bins[numBins];
+      Ti counts[numBins] = {};
+      for (auto &b : bins)
+        b = Box{TV{ma, ma, ma}, TV{mi, mi, mi}};
+      for (Ti i = begin; i != end; ++i) {
+        int b = binOf(ids[i]);
+        bins[b] = merge(bins[b], leafBvs[ids[i]]);
+        counts[b]++;
+      }
+      // sweep from the right, then from the left picking the cheapest plane
+      float rightArea[numBins];
+      Ti rightCount[numBins];
+      Box acc = bins[numBins - 1];
+      Ti cnt = counts[numBins - 1];
+      for (int b = numBins - 1; b > 0; --b) {
+        if (b != numBins - 1)
+          acc = merge(acc, bins[b]), cnt += counts[b];
+        rightArea[b] = area(acc);
+        rightCount[b] = cnt;
+      }
+      float bestCost = std::numeric_limits<float>::max();
+      int bestBin = -1;
+      acc = bins[0];
+      cnt = 0;
+      for (int b = 1; b != numBins; ++b) {
+        if (b != 1)
+          acc = merge(acc, bins[b - 1]);
+        cnt += counts[b - 1];
+        if (!cnt || !rightCount[b])
+          continue;
+        float cost = area(acc) * cnt + rightArea[b] * rightCount[b];
+        if (cost < bestCost)
+          bestCost = cost, bestBin = b;
+      }
+      if (bestBin != -1) {
+        auto it = std::partition(ids.begin() + begin, ids.begin() + end,
+                                 [&](Ti e) { return binOf(e) < bestBin; });
+        Ti m = (Ti)(it - ids.begin());
+        if (m != begin && m != end)
+          return m;
+      }
+      std::nth_element(ids.begin() + begin, ids.begin() + mid, ids.begin() + end,
+                       [&](Ti a, Ti b) { return centers[a][axis] < centers[b][axis]; });
+    }
+    return mid;
+  }
+
+  Box emit(Ti node, Ti parent, Ti begin, Ti end) {
+    bvh.parents[node] = parent;
+    if (end - begin == 1) {
+      const auto &bv = leafBvs[ids[begin]];
+      bvh.sortedBvs[node] = bv;
+      bvh.auxIndices[node] = ids[begin];
+      bvh.levels[node] = 0;
+      bvh.leafIndices[begin] = node;
+      return bv;
+    }
+    const Ti mid = split(begin, end);
+    const Ti lc = node + 1, rc = node + 2 * (mid - begin);
+    Box lb, rb;
+    if (end - begin > 4096) {
+#if defined(_OPENMP)
+#pragma omp task shared(lb)
+#endif
+      lb = emit(lc, node, begin, mid);
+      rb = emit(rc, node, mid, end);
+#if defined(_OPENMP)
+#pragma omp taskwait
+#endif
+    } else {
+      lb = emit(lc, node, begin, mid);
+      rb = emit(rc, node, mid, end);
+    }
+    const Ti escape = node + 2 * (end - begin) - 1;
+    bvh.levels[node] = bvh.levels[lc] + 1;
+    bvh.auxIndices[node] = escape < (Ti)bvh.sortedBvs.size() ? escape : -1;
+    return bvh.sortedBvs[node] = merge(lb, rb);
+  }
+};
+} // namespace
+
+void LBvh::buildSah(Ti numLeaves) {
+  std::vector<Box> leafBvs(numLeaves);
+  std::vector<TV> centers(numLeaves);
+  std::vector<Ti> ids(numLeaves);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for (Ti i = 0; i < numLeaves; ++i) {
+    leafBvs[i] = getBv(i);
+    centers[i] = (leafBvs[i].first + leafBvs[i].second) / 2;
+    ids[i] = i;
+  }
+  SahBuilder builder{*this, leafBvs, centers, ids};
+#if defined(_OPENMP)
+#pragma omp parallel
+#pragma omp single
+#endif
+  builder.emit(0, -1, 0, numLeaves);
+}
+
+typename LBvh::element_e LBvh::autoCategory(const PrimitiveObject &prim) noexcept {
+  if (prim.quads.size() > 0)
+    return element_e::tet;
+  else if (prim.tris.size() > 0)
+    return element_e::tri;
+  else if (prim.lines.size() > 0)
+    return element_e::line;
+  return element_e::point;
+}
+
+std::size_t LBvh::topologyHash(const PrimitiveObject &prim, element_e et, float thickness,
+                               const std::string &radiusAttr, build_e method) {
+  // FNV-1a over 32-bit words
+  std::uint64_t h = 14695981039346656037ull;
+  auto mix = [&h](std::uint32_t v) { h = (h ^ v) * 1099511628211ull; };
+  auto mixRange = [&mix](const auto &arr) {
+    const auto *p = reinterpret_cast<const std::uint32_t *>(arr.data());
+    const std::size_t n = arr.size() * sizeof(arr[0]) / sizeof(std::uint32_t);
+    mix((std::uint32_t)arr.size());
+    for (std::size_t i = 0; i != n; ++i)
+      mix(p[i]);
+  };
+  mix((std::uint32_t)et);
+  mix((std::uint32_t)method);
+  mix((std::uint32_t)prim.verts.size());
+  std::uint32_t tbits;
+  std::memcpy(&tbits, &thickness, sizeof(tbits));
+  mix(tbits);
+  for (char c : radiusAttr)
+    mix((std::uint32_t)(unsigned char)c);
+  if (et == element_e::tet)
+    mixRange(prim.quads.values);
+  else if (et == element_e::tri)
+    mixRange(prim.tris.values);
+  else if (et == element_e::line)
+    mixRange(prim.lines.values);
+  else if (et == element_e::point) {
+    // the point build fills in identity points when there are none
+    if (prim.points.size() > 0)
+      mixRange(prim.points.values);
+    else {
+      mix((std::uint32_t)prim.verts.size());
+      for (std::size_t i = 0; i != prim.verts.size(); ++i)
+        mix((std::uint32_t)i);
+    }
+  }
+  return (std::size_t)h;
+}
+
+void LBvh::rebind(const std::shared_ptr<PrimitiveObject> &prim) {
+  primPtr = prim;
+  getBv = getBvFunc(prim);
+}
+
+std::shared_ptr<LBvh> LBvh::getOrBuild(const std::shared_ptr<PrimitiveObject> &prim, float thickness,
+                                       std::string radiusAttr, element_e et, build_e method) {
+  if (et == element_e::unknown)
+    et = autoCategory(*prim);
+  const auto hash = topologyHash(*prim, et, thickness, radiusAttr, method);
+  const auto key = "lbvh_" + std::to_string((int)et);
+  auto &ud = prim->userData();
+  if (ud.has(key)) {
+    auto lbvh = std::dynamic_pointer_cast<LBvh>(ud.get(key));
+    if (lbvh && lbvh->topoHash == hash) {
+      if (lbvh->primPtr.lock() != prim) {
+        // the cache came along with a copy of the prim, leave the tree of
+        // the original untouched
+        lbvh = std::make_shared<LBvh>(*lbvh);
+        ud.set(key, lbvh);
+      }
+      lbvh->rebind(prim);
+      lbvh->refit();
+      return lbvh;
+    }
+  }
+  auto lbvh = std::make_shared<LBvh>();
+  lbvh->buildMethod = method;
+  lbvh->build(prim, thickness, radiusAttr, et);
+  lbvh->topoHash = hash;
+  ud.set(key, lbvh);
+  return lbvh;
+}
+
 void LBvh::refit() {
   std::shared_ptr<const PrimitiveObject> prim = primPtr.lock();
   if (!prim)
@@ -558,14 +807,16 @@ void LBvh::refit() {
   }
 }
 
-/// nearest primitive
+/// nearest primitive, on an already locked prim
 template <LBvh::element_e et>
-typename LBvh::TV LBvh::find_nearest(TV const &pos, Ti &id, float &dist,
-                                     element_t<et>) const {
-  std::shared_ptr<const PrimitiveObject> prim = primPtr.lock();
-  if (!prim)
-    throw std::runtime_error(
-        "the primitive object referenced by lbvh not available anymore");
+static LBvh::TV nearestIn(const LBvh &bvh, const PrimitiveObject *prim,
+                          LBvh::TV const &pos, LBvh::Ti &id, float &dist) {
+  using Ti = LBvh::Ti;
+  using TV = LBvh::TV;
+  using element_e = LBvh::element_e;
+  const auto &sortedBvs = bvh.sortedBvs;
+  const auto &levels = bvh.levels;
+  const auto &auxIndices = bvh.auxIndices;
   const auto &refpos = prim->attr<vec3f>("pos");
 
   const Ti numNodes = sortedBvs.size();
@@ -576,7 +827,7 @@ typename LBvh::TV LBvh::find_nearest(TV const &pos, Ti &id, float &dist,
     Ti level = levels[node];
     // level and node are always in sync
     for (; level; --level, ++node)
-      if (auto d = distance(sortedBvs[node], pos); d > dist)
+      if (auto d = LBvh::distance(sortedBvs[node], pos); d > dist)
         break;
     // leaf node check
     if (level == 0) {
@@ -621,6 +872,16 @@ typename LBvh::TV LBvh::find_nearest(TV const &pos, Ti &id, float &dist,
   return ws;
 }
 
+template <LBvh::element_e et>
+typename LBvh::TV LBvh::find_nearest(TV const &pos, Ti &id, float &dist,
+                                     element_t<et>) const {
+  std::shared_ptr<const PrimitiveObject> prim = primPtr.lock();
+  if (!prim)
+    throw std::runtime_error(
+        "the primitive object referenced by lbvh not available anymore");
+  return nearestIn<et>(*this, prim.get(), pos, id, dist);
+}
+
 template typename LBvh::TV LBvh::find_nearest<LBvh::element_e::point>(
     const LBvh::TV &, LBvh::Ti &, float &,
     typename LBvh::element_t<element_e::point>) const;
@@ -645,6 +906,180 @@ typename LBvh::TV LBvh::find_nearest(TV const &pos, Ti &id, float &dist) const {
     return find_nearest(pos, id, dist, element_c<element_e::point>);
 }
 
+std::vector<typename LBvh::Ti> LBvh::coherentOrder(const TV *pos, std::size_t n) const {
+  constexpr auto ma = std::numeric_limits<float>::max();
+  constexpr auto mi = std::numeric_limits<float>::lowest();
+  TV lo{ma, ma, ma}, hi{mi, mi, mi};
+  for (std::size_t i = 0; i != n; ++i)
+    for (int d = 0; d != 3; ++d) {
+      lo[d] = std::min(lo[d], pos[i][d]);
+      hi[d] = std::max(hi[d], pos[i][d]);
+    }
+  std::vector<std::pair<Tu, Ti>> records(n);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for (std::ptrdiff_t i = 0; i < (std::ptrdiff_t)n; ++i) {
+    TV uc;
+    for (int d = 0; d != 3; ++d)
+      uc[d] = hi[d] > lo[d] ? (pos[i][d] - lo[d]) / (hi[d] - lo[d]) : 0.f;
+    records[i] = std::make_pair(getMortonCode(uc), (Ti)i);
+  }
+  std::sort(std::begin(records), std::end(records));
+  std::vector<Ti> order(n);
+  for (std::size_t i = 0; i != n; ++i)
+    order[i] = records[i].second;
+  return order;
+}
+
+void LBvh::find_nearest_batch(const TV *pos, std::size_t n, Ti *ids, float *dists, TV *ws) const {
+  std::shared_ptr<const PrimitiveObject> prim = primPtr.lock();
+  if (!prim)
+    throw std::runtime_error(
+        "the primitive object referenced by lbvh not available anymore");
+  const auto order = coherentOrder(pos, n);
+  auto query = [&](auto t) {
+    constexpr element_e et = decltype(t)::value;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (std::ptrdiff_t k = 0; k < (std::ptrdiff_t)n; ++k) {
+      const auto i = order[k];
+      ids[i] = -1;
+      dists[i] = std::numeric_limits<float>::max();
+      ws[i] = nearestIn<et>(*this, prim.get(), pos[i], ids[i], dists[i]);
+    }
+  };
+  if (eleCategory == element_e::tet)
+    query(element_c<element_e::tet>);
+  else if (eleCategory == element_e::tri)
+    query(element_c<element_e::tri>);
+  else if (eleCategory == element_e::line)
+    query(element_c<element_e::line>);
+  else
+    query(element_c<element_e::point>);
+}
+
+/// ray-box slab test, narrowing [0, tmax]
+static bool rayHitsBox(const LBvh::Box &bv, const LBvh::TV &orig, const LBvh::TV &invDir, float tmax) {
+  float t0 = 0.f, t1 = tmax;
+  for (int d = 0; d != 3; ++d) {
+    float ta = (bv.first[d] - orig[d]) * invDir[d];
+    float tb = (bv.second[d] - orig[d]) * invDir[d];
+    if (ta > tb)
+      std::swap(ta, tb);
+    t0 = std::max(t0, ta);
+    t1 = std::min(t1, tb);
+  }
+  return t0 <= t1;
+}
+
+/// Moller-Trumbore, w receives the barycentric weights of a, b, c
+static bool rayHitsTri(const LBvh::TV &orig, const LBvh::TV &dir, const vec3f &a,
+                       const vec3f &b, const vec3f &c, float &t, LBvh::TV &w) {
+  auto e1 = b - a, e2 = c - a;
+  auto p = cross(dir, e2);
+  float inv = 1.f / dot(e1, p);
+  auto s = orig - a;
+  float u = dot(s, p) * inv;
+  if (!(u >= 0.f && u <= 1.f))
+    return false;
+  auto q = cross(s, e1);
+  float v = dot(dir, q) * inv;
+  if (!(v >= 0.f && u + v <= 1.f))
+    return false;
+  t = dot(e2, q) * inv;
+  w = vec3f{1.f - u - v, u, v};
+  return true;
+}
+
+bool LBvh::ray_intersect(TV const &orig, TV const &dir, float tmax, Ti &id, float &t, TV &w) const {
+  if (eleCategory != element_e::tri && eleCategory != element_e::tet)
+    throw std::runtime_error("ray queries need an lbvh built from triangles or tetrahedra");
+  std::shared_ptr<const PrimitiveObject> prim = primPtr.lock();
+  if (!prim)
+    throw std::runtime_error(
+        "the primitive object referenced by lbvh not available anymore");
+  const auto &refpos = prim->attr<vec3f>("pos");
+  const TV invDir{1.f / dir[0], 1.f / dir[1], 1.f / dir[2]};
+
+  bool hit = false;
+  float best = tmax;
+  auto testTri = [&](Ti eid, int a, int b, int c) {
+    float tt;
+    TV ww;
+    if (rayHitsTri(orig, dir, refpos[a], refpos[b], refpos[c], tt, ww) && tt >= 0.f && tt < best) {
+      best = tt, id = eid, w = ww, hit = true;
+    }
+  };
+  const Ti numNodes = sortedBvs.size();
+  Ti node = 0;
+  while (node != -1 && node != numNodes) {
+    Ti level = levels[node];
+    for (; level; --level, ++node)
+      if (!rayHitsBox(sortedBvs[node], orig, invDir, best))
+        break;
+    if (level == 0) {
+      if (rayHitsBox(sortedBvs[node], orig, invDir, best)) {
+        const auto eid = auxIndices[node];
+        if (eleCategory == element_e::tri) {
+          auto tri = prim->tris[eid];
+          testTri(eid, tri[0], tri[1], tri[2]);
+        } else {
+          auto tet = prim->quads[eid];
+          testTri(eid, tet[0], tet[1], tet[2]);
+          testTri(eid, tet[0], tet[1], tet[3]);
+          testTri(eid, tet[0], tet[2], tet[3]);
+          testTri(eid, tet[1], tet[2], tet[3]);
+        }
+      }
+      node++;
+    } else
+      node = auxIndices[node];
+  }
+  if (hit)
+    t = best;
+  return hit;
+}
+
+void LBvh::ray_intersect_batch(const TV *origs, const TV *dirs, std::size_t n, float tmax,
+                               Ti *ids, float *ts, TV *ws) const {
+  const auto order = coherentOrder(origs, n);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for (std::ptrdiff_t k = 0; k < (std::ptrdiff_t)n; ++k) {
+    const auto i = order[k];
+    ids[i] = -1;
+    ts[i] = tmax;
+    ws[i] = TV{0.f, 0.f, 0.f};
+    ray_intersect(origs[i], dirs[i], tmax, ids[i], ts[i], ws[i]);
+  }
+}
+
+void LBvh::radius_query_batch(const TV *pos, std::size_t n, float radius,
+                              std::vector<Ti> &offsets, std::vector<Ti> &nbrs) const {
+  offsets.assign(n + 1, 0);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for (std::ptrdiff_t i = 0; i < (std::ptrdiff_t)n; ++i) {
+    Ti cnt = 0;
+    iter_neighbors_radius(pos[i], radius, [&cnt](Ti) { ++cnt; });
+    offsets[i + 1] = cnt;
+  }
+  for (std::size_t i = 0; i != n; ++i)
+    offsets[i + 1] += offsets[i];
+  nbrs.resize(offsets[n]);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for (std::ptrdiff_t i = 0; i < (std::ptrdiff_t)n; ++i) {
+    Ti dst = offsets[i];
+    iter_neighbors_radius(pos[i], radius, [&](Ti eid) { nbrs[dst++] = eid; });
+  }
+}
+
 
 template <LBvh::element_e et>
 typename LBvh::TV LBvh::find_nearest_with_uv(TV const &pos, TV const &uv, Ti &id, float &dist,
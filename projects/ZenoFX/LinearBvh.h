@@ -16,6 +16,7 @@ namespace zeno {
 
 struct LBvh : IObjectClone<LBvh> {
   enum element_e { point = 0, line, tri, tet, unknown };
+  enum build_e { morton = 0, sah };
   template <element_e et>
   using element_t = std::integral_constant<element_e, et>;
   template <element_e et> static constexpr element_t<et> element_c{};
@@ -33,6 +34,8 @@ struct LBvh : IObjectClone<LBvh> {
   float thickness{0};
   std::string radiusAttr{""};
   element_e eleCategory{element_e::point}; // element category
+  build_e buildMethod{build_e::morton};
+  std::size_t topoHash{0}; // set by getOrBuild, identifies the connectivity
 
   LBvh() noexcept = default;
   LBvh(const std::shared_ptr<PrimitiveObject> &prim, float thickness = 0.f) {
@@ -57,6 +60,22 @@ struct LBvh : IObjectClone<LBvh> {
   void build(const std::shared_ptr<PrimitiveObject> &prim, float thickness, std::string radiusAttr, element_t<et>);
 
   void build(const std::shared_ptr<PrimitiveObject> &prim, float thickness, std::string radiusAttr);
+  void build(const std::shared_ptr<PrimitiveObject> &prim, float thickness, std::string radiusAttr, element_e et);
+
+  /// category chosen by the auto build: quads, then tris, lines and points
+  static element_e autoCategory(const PrimitiveObject &prim) noexcept;
+  /// hash of everything a refit cannot account for: element indices, counts
+  /// and the bounding volume parameters
+  static std::size_t topologyHash(const PrimitiveObject &prim, element_e et, float thickness,
+                                  const std::string &radiusAttr, build_e method = build_e::morton);
+  /// returns the bvh cached in the userData of prim, refitted to the current
+  /// positions, if the topology hash still matches; otherwise builds a new
+  /// one and caches it there. et == unknown picks the category automatically.
+  static std::shared_ptr<LBvh> getOrBuild(const std::shared_ptr<PrimitiveObject> &prim, float thickness,
+                                          std::string radiusAttr = {}, element_e et = element_e::unknown,
+                                          build_e method = build_e::morton);
+  /// points the bvh at another prim with the same topology, refit() afterwards
+  void rebind(const std::shared_ptr<PrimitiveObject> &prim);
 
 
   void refit();
@@ -172,9 +191,30 @@ struct LBvh : IObjectClone<LBvh> {
   return ws;
 }
 
+  /// batched closest-element queries, processed in morton order of the
+  /// query points so that neighbouring queries walk the same nodes
+  void find_nearest_batch(const TV *pos, std::size_t n, Ti *ids, float *dists, TV *ws) const;
+
+  /// closest hit of the ray orig + t * dir, t in [0, tmax], against tri or
+  /// tet faces; returns false if nothing is hit. w is the barycentric weight.
+  bool ray_intersect(TV const &orig, TV const &dir, float tmax, Ti &id, float &t, TV &w) const;
+  void ray_intersect_batch(const TV *origs, const TV *dirs, std::size_t n, float tmax,
+                           Ti *ids, float *ts, TV *ws) const;
+
+  /// elements whose bounds lie within radius of each query point, in CSR
+  /// layout: neighbors of query i are nbrs[offsets[i], offsets[i + 1])
+  void radius_query_batch(const TV *pos, std::size_t n, float radius,
+                          std::vector<Ti> &offsets, std::vector<Ti> &nbrs) const;
+
   std::shared_ptr<PrimitiveObject> retrievePrimitive(Ti eid) const;
   vec3f retrievePrimitiveCenter(Ti eid, const TV &w) const;
 
+private:
+  void buildSah(Ti numLeaves);
+  std::vector<Ti> coherentOrder(const TV *pos, std::size_t n) const;
+
+public:
+
   template <class F> void iter_neighbors(TV const &pos, F &&f) const {
     if (auto numLeaves = getNumLeaves(); numLeaves <= 2) {
       for (Ti i = 0; i != numLeaves; ++i) {
@@ -3,6 +3,7 @@
 #include <memory>
 #include <cstring>
 #include <string>
+#include <mutex>
 #include <map>
 
 namespace zfx::x64 {
@@ -17,11 +18,12 @@ struct Executable {
 
     struct Context {
         Executable *exec;
+        float const *consts;
         float locals[SimdWidth * 256];
 
         void execute() {
             auto entry = (void(*)(void *, void *, void *))exec->mem;
-            entry((void *)locals, (void *)exec->consts, (void *)exec->functable);
+            entry((void *)locals, (void *)consts, (void *)exec->functable);
         }
 
         float *channel(int chid) {
@@ -29,12 +31,8 @@ struct Executable {
         }
     };
 
-    inline float &parameter(int parid) {
-        return consts[parid];
-    }
-
     inline Context make_context() {
-        return {this};
+        return {this, consts};
     }
 
     Executable() = default;
@@ -46,10 +44,35 @@ struct Executable {
         );
 };
 
+// one run of an executable: parameters go to a private copy of its constants,
+// so threads sharing the cached executable don't overwrite each other's
+struct Instance {
+    static constexpr size_t SimdWidth = Executable::SimdWidth;
+
+    Executable *exec;
+    float consts[1024];
+
+    explicit Instance(Executable *exec) : exec(exec) {
+        std::memcpy(consts, exec->consts, sizeof(consts));
+    }
+
+    inline float &parameter(int parid) {
+        return consts[parid];
+    }
+
+    inline Executable::Context make_context() {
+        return {exec, consts};
+    }
+};
+
+// may be shared by nodes running on several threads, executables are never
+// evicted so the returned pointers stay valid
 struct Assembler {
     std::map<std::string, std::unique_ptr<Executable>> cache;
+    std::mutex mtx;
 
     Executable *assemble(std::string const &lines) {
+        std::lock_guard lck(mtx);
         if (auto it = cache.find(lines); it != cache.end()) {
             return it->second.get();
         }
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <tuple>
 #include <map>
 
@@ -116,8 +117,11 @@ struct Program {
     }
 };
 
+// may be shared by nodes running on several threads, programs are never
+// evicted so the returned pointers stay valid
 struct Compiler {
     std::map<std::string, std::unique_ptr<Program>> cache;
+    std::mutex mtx;
 
     Program *compile
         ( std::string const &code
@@ -128,9 +132,12 @@ struct Compiler {
         options.dump(ss);
         auto key = ss.str();
 
-        auto it = cache.find(key);
-        if (it != cache.end()) {
-            return it->second.get();
+        {
+            std::lock_guard lck(mtx);
+            auto it = cache.find(key);
+            if (it != cache.end()) {
+                return it->second.get();
+            }
         }
 
         auto 
@@ -148,9 +155,9 @@ struct Compiler {
         prog->params = params;
         prog->newsyms = newsyms;
 
-        auto raw_ptr = prog.get();
-        cache[key] = std::move(prog);
-        return raw_ptr;
+        std::lock_guard lck(mtx);
+        // another thread may have compiled the same code meanwhile
+        return cache.try_emplace(key, std::move(prog)).first->second.get();
     }
 };
 
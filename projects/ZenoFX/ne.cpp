@@ -21,9 +21,9 @@ namespace {
 static zfx::Compiler compiler;
 static zfx::x64::Assembler assembler;
 
-static void numeric_eval (zfx::x64::Executable *exec,
+static void numeric_eval (zfx::x64::Instance *inst,
                          std::vector<float> &chs) {
-    auto ctx = exec->make_context();
+    auto ctx = inst->make_context();
     for (int j = 0; j < chs.size(); j++) {
         ctx.channel(j)[0] = chs[j];
     }
@@ -130,7 +130,7 @@ struct NumericEval : zeno::INode {
         if (code.find("@result") == std::string::npos)
             code = "@result = ( " + code + " )";
         auto prog = compiler.compile(code, opts);
-        auto exec = assembler.assemble(prog->assembly);
+        zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
         //计算输出结果
         auto result = std::make_shared<zeno::NumericObject>();
@@ -165,7 +165,7 @@ struct NumericEval : zeno::INode {
         auto it = std::find(parnames.begin(), parnames.end(), std::pair{name , dimid});
         auto value = parvals.at(it - parnames.begin());
         dbg_printf("(value %f)\n", value);
-        exec->parameter(prog->param_id(name, dimid)) = value;
+        inst.parameter(prog->param_id(name, dimid)) = value;
     }
 
     std::vector<float> chs(prog->symbols.size());//初始化chs的大小
@@ -175,7 +175,7 @@ struct NumericEval : zeno::INode {
         assert(name[0] == '@');
     }
 
-    numeric_eval(exec, chs);
+    numeric_eval(&inst, chs);
 
     std::vector<float> resex(chs.size());
     for (int i = 0; i < chs.size(); i++) {
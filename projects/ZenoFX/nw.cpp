@@ -20,10 +20,10 @@ static zfx::Compiler compiler;
 static zfx::x64::Assembler assembler;
 
 static void numeric_wrangle
-    ( zfx::x64::Executable *exec
+    ( zfx::x64::Instance *inst
     , std::vector<float> &chs
     ) {
-    auto ctx = exec->make_context();
+    auto ctx = inst->make_context();
     for (int j = 0; j < chs.size(); j++) {
         ctx.channel(j)[0] = chs[j];
     }
@@ -128,7 +128,7 @@ struct NumericWrangle : zeno::INode {
         }
 
         auto prog = compiler.compile(code, opts);
-        auto exec = assembler.assemble(prog->assembly);
+        zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
         auto result = std::make_shared<zeno::DictObject>();
         for (auto const &[name, dim]: prog->newsyms) {
@@ -159,7 +159,7 @@ struct NumericWrangle : zeno::INode {
                 parnames.end(), std::pair{name, dimid});
             auto value = parvals.at(it - parnames.begin());
             dbg_printf("(valued %f)\n", value);
-            exec->parameter(prog->param_id(name, dimid)) = value;
+            inst.parameter(prog->param_id(name, dimid)) = value;
         }
 
         std::vector<float> chs(prog->symbols.size());
@@ -169,7 +169,7 @@ struct NumericWrangle : zeno::INode {
             assert(name[0] == '@');
         }
 
-        numeric_wrangle(exec, chs);
+        numeric_wrangle(&inst, chs);
 
         for (int i = 0; i < chs.size(); i++) {
             auto [name, dimid] = prog->symbols[i];
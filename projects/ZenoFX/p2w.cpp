@@ -25,7 +25,7 @@ struct Buffer {
 };
 
 static void vectors_wrangle
-    ( zfx::x64::Executable *exec
+    ( zfx::x64::Instance *inst
     , std::vector<Buffer> const &chs
     ) {
     if (chs.size() == 0)
@@ -36,20 +36,20 @@ static void vectors_wrangle
     }
 
     #pragma omp parallel for
-    for (int i = 0; i < size - exec->SimdWidth + 1; i += exec->SimdWidth) {
-        auto ctx = exec->make_context();
+    for (int i = 0; i < size - inst->SimdWidth + 1; i += inst->SimdWidth) {
+        auto ctx = inst->make_context();
         for (int j = 0; j < chs.size(); j++) {
-            for (int k = 0; k < exec->SimdWidth; k++)
+            for (int k = 0; k < inst->SimdWidth; k++)
                 ctx.channel(j)[k] = chs[j].base[chs[j].stride * (i + k)];
         }
         ctx.execute();
         for (int j = 0; j < chs.size(); j++) {
-            for (int k = 0; k < exec->SimdWidth; k++)
+            for (int k = 0; k < inst->SimdWidth; k++)
                  chs[j].base[chs[j].stride * (i + k)] = ctx.channel(j)[k];
         }
     }
-    for (int i = size / exec->SimdWidth * exec->SimdWidth; i < size; i++) {
-        auto ctx = exec->make_context();
+    for (int i = size / inst->SimdWidth * inst->SimdWidth; i < size; i++) {
+        auto ctx = inst->make_context();
         for (int j = 0; j < chs.size(); j++) {
             ctx.channel(j)[0] = chs[j].base[chs[j].stride * i];
         }
@@ -188,7 +188,7 @@ struct ParticlesTwoWrangle : zeno::INode {
         }
 
         auto prog = compiler.compile(code, opts);
-        auto exec = assembler.assemble(prog->assembly);
+        zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
         for (auto const &[name, dim]: prog->newsyms) {
             dbg_printf("auto-defined new attribute: %s with dim %d\n",
@@ -217,7 +217,7 @@ struct ParticlesTwoWrangle : zeno::INode {
                 parnames.end(), std::pair{name, dimid});
             auto value = parvals.at(it - parnames.begin());
             dbg_printf("(valued %f)\n", value);
-            exec->parameter(prog->param_id(name, dimid)) = value;
+            inst.parameter(prog->param_id(name, dimid)) = value;
         }
 
         std::vector<Buffer> chs(prog->symbols.size());
@@ -242,7 +242,7 @@ struct ParticlesTwoWrangle : zeno::INode {
             });
             chs[i] = iob;
         }
-        vectors_wrangle(exec, chs);
+        vectors_wrangle(&inst, chs);
 
         set_output("prim", std::move(prim));
     }
@@ -25,7 +25,7 @@ struct Buffer {
 };
 template <typename T>
 static void vectors_wrangle
-    ( zfx::x64::Executable *exec
+    ( zfx::x64::Instance *inst
     , std::vector<Buffer> const &chs
     , T *maskarr
     ) {
@@ -37,22 +37,22 @@ static void vectors_wrangle
     }
 
     #pragma omp parallel for
-    for (int i = 0; i < size - exec->SimdWidth + 1; i += exec->SimdWidth) {
-        auto ctx = exec->make_context();
+    for (int i = 0; i < size - inst->SimdWidth + 1; i += inst->SimdWidth) {
+        auto ctx = inst->make_context();
         for (int j = 0; j < chs.size(); j++) {
-            for (int k = 0; k < exec->SimdWidth; k++)
+            for (int k = 0; k < inst->SimdWidth; k++)
                 ctx.channel(j)[k] = chs[j].base[chs[j].stride * (i + k)];
         }
         ctx.execute();
-        for (int k = 0; k < exec->SimdWidth; k++) {
+        for (int k = 0; k < inst->SimdWidth; k++) {
             for (int j = 0; j < chs.size(); j++) {
                 if (maskarr[i + k] != 0)
                     chs[j].base[chs[j].stride * (i + k)] = ctx.channel(j)[k];
             }
         }
     }
-    for (int i = size / exec->SimdWidth * exec->SimdWidth; i < size; i++) {
-        auto ctx = exec->make_context();
+    for (int i = size / inst->SimdWidth * inst->SimdWidth; i < size; i++) {
+        auto ctx = inst->make_context();
         for (int j = 0; j < chs.size(); j++) {
             ctx.channel(j)[0] = chs[j].base[chs[j].stride * i];
         }
@@ -173,7 +173,7 @@ struct ParticlesMaskedWrangle : zeno::INode {
         }
 
         auto prog = compiler.compile(code, opts);
-        auto exec = assembler.assemble(prog->assembly);
+        zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
         for (auto const &[name, dim]: prog->newsyms) {
             dbg_printf("auto-defined new attribute: %s with dim %d\n",
@@ -198,7 +198,7 @@ struct ParticlesMaskedWrangle : zeno::INode {
                 parnames.end(), std::pair{name, dimid});
             auto value = parvals.at(it - parnames.begin());
             dbg_printf("(valued %f)\n", value);
-            exec->parameter(prog->param_id(name, dimid)) = value;
+            inst.parameter(prog->param_id(name, dimid)) = value;
         }
 
         std::vector<Buffer> chs(prog->symbols.size());
@@ -218,11 +218,11 @@ struct ParticlesMaskedWrangle : zeno::INode {
         std::string maskAttr = get_input2<std::string>("maskAttr");
         if(prim->attr_is<float>(maskAttr)){
             auto &maskarr = prim->attr<float>(maskAttr);
-            vectors_wrangle(exec, chs, maskarr.data());
+            vectors_wrangle(&inst, chs, maskarr.data());
         }
         else if(prim->attr_is<int>(maskAttr)){
             auto &maskarr = prim->attr<int>(maskAttr);
-            vectors_wrangle(exec, chs, maskarr.data());
+            vectors_wrangle(&inst, chs, maskarr.data());
         }
         else{
             throw std::runtime_error("mask type not supported");
@@ -30,7 +30,7 @@ struct Buffer {
   int which = 0;
 };
 
-static void sorted_bvh_vectors_wrangle(zfx::x64::Executable *exec,
+static void sorted_bvh_vectors_wrangle(zfx::x64::Instance *inst,
                                 std::vector<Buffer> const &chs,
                                 std::vector<Buffer> const &chs2,
                                 std::vector<zeno::vec3f> const &pos,
@@ -47,7 +47,7 @@ static void sorted_bvh_vectors_wrangle(zfx::x64::Executable *exec,
   for (int i = 0; i < pos.size(); i++) {
     using pair = std::pair<float, int>;
     std::vector<pair> neighbors;
-    auto ctx = exec->make_context();
+    auto ctx = inst->make_context();
     for (int k = 0; k < chs.size(); k++) {
       if (!chs[k].which)
         ctx.channel(k)[0] = chs[k].base[chs[k].stride * i];
@@ -77,7 +77,7 @@ static void sorted_bvh_vectors_wrangle(zfx::x64::Executable *exec,
   }
 }
 
-static void bvh_vectors_wrangle(zfx::x64::Executable *exec,
+static void bvh_vectors_wrangle(zfx::x64::Instance *inst,
                                 std::vector<Buffer> const &chs,
                                 std::vector<Buffer> const &chs2,
                                 std::vector<zeno::vec3f> const &pos,
@@ -89,7 +89,7 @@ static void bvh_vectors_wrangle(zfx::x64::Executable *exec,
 
 #pragma omp parallel for
   for (int i = 0; i < pos.size(); i++) {
-    auto ctx = exec->make_context();
+    auto ctx = inst->make_context();
     for (int k = 0; k < chs.size(); k++) {
       if (!chs[k].which)
         ctx.channel(k)[0] = chs[k].base[chs[k].stride * i];
@@ -111,7 +111,7 @@ static void bvh_vectors_wrangle(zfx::x64::Executable *exec,
   }
 }
 
-static void bvh_vectors_wrangle_radius_two(zfx::x64::Executable *exec,
+static void bvh_vectors_wrangle_radius_two(zfx::x64::Instance *inst,
                                 std::vector<Buffer> const &chs,
                                 std::vector<Buffer> const &chs2,
                                 const float *maskarr,
@@ -127,7 +127,7 @@ static void bvh_vectors_wrangle_radius_two(zfx::x64::Executable *exec,
 
 #pragma omp parallel for
   for (int i = 0; i < pos.size(); i++) {
-    auto ctx = exec->make_context();
+    auto ctx = inst->make_context();
     for (int k = 0; k < chs.size(); k++) {
       if (!chs[k].which)
         ctx.channel(k)[0] = chs[k].base[chs[k].stride * i];
@@ -185,6 +185,31 @@ static void bvh_vectors_wrangle_radius_two(zfx::x64::Executable *exec,
   }
 }
 
+/// index i minimizing the order less(i, j) over [0, n), the lowest index on
+/// ties; the reduction shared by the nearest primitive queries
+template <typename Less> static int parallel_argmin(int n, Less &&less) {
+  int best = -1;
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+  {
+    int local = -1;
+#if defined(_OPENMP)
+#pragma omp for nowait
+#endif
+    for (int i = 0; i < n; ++i)
+      if (local == -1 || less(i, local))
+        local = i;
+#if defined(_OPENMP)
+#pragma omp critical
+#endif
+    if (local != -1 &&
+        (best == -1 || less(local, best) || (local < best && !less(best, local))))
+      best = local;
+  }
+  return best;
+}
+
 struct ParticlesBuildBvh : zeno::INode {
   virtual void apply() override {
     auto primNei = get_input<zeno::PrimitiveObject>("primNei");
@@ -193,8 +218,10 @@ struct ParticlesBuildBvh : zeno::INode {
         has_input("radiusMin")
             ? get_input<zeno::NumericObject>("radiusMin")->get<float>()
             : -1.f;
-    auto lbvh = std::make_shared<zeno::LBvh>(
-        primNei, radius, zeno::LBvh::element_c<zeno::LBvh::element_e::point>);
+    auto lbvh = has_input("cache") && get_input2<bool>("cache")
+        ? zeno::LBvh::getOrBuild(primNei, radius, {}, zeno::LBvh::element_e::point)
+        : std::make_shared<zeno::LBvh>(
+            primNei, radius, zeno::LBvh::element_c<zeno::LBvh::element_e::point>);
     set_output("lbvh", std::move(lbvh));
   }
 };
@@ -202,7 +229,8 @@ struct ParticlesBuildBvh : zeno::INode {
 ZENDEFNODE(ParticlesBuildBvh, {
                                   {{"PrimitiveObject", "primNei"},
                                    {"float", "radius"},
-                                   {"float", "radiusMin"}},
+                                   {"float", "radiusMin"},
+                                   {"bool", "cache", "0"}},
                                   {{"LBvh", "lbvh"}},
                                   {},
                                   {"zenofx"},
@@ -216,34 +244,36 @@ struct BuildPrimitiveBvh : zeno::INode {
             ? get_input<zeno::NumericObject>("thickness")->get<float>()
             : 0.f;
     auto primType = get_param<std::string>("prim_type");
-    if (primType == "auto") {
-      auto lbvh = std::make_shared<zeno::LBvh>(prim, thickness);
-      set_output("lbvh", std::move(lbvh));
-    } else if (primType == "point") {
-      auto lbvh = std::make_shared<zeno::LBvh>(
-          prim, thickness, zeno::LBvh::element_c<zeno::LBvh::element_e::point>);
-      set_output("lbvh", std::move(lbvh));
-    } else if (primType == "line") {
-      auto lbvh = std::make_shared<zeno::LBvh>(
-          prim, thickness, zeno::LBvh::element_c<zeno::LBvh::element_e::line>);
-      set_output("lbvh", std::move(lbvh));
-    } else if (primType == "tri") {
-      auto lbvh = std::make_shared<zeno::LBvh>(
-          prim, thickness, zeno::LBvh::element_c<zeno::LBvh::element_e::tri>);
-      set_output("lbvh", std::move(lbvh));
-    } else if (primType == "quad") {
-      auto lbvh = std::make_shared<zeno::LBvh>(
-          prim, thickness, zeno::LBvh::element_c<zeno::LBvh::element_e::tet>);
-      set_output("lbvh", std::move(lbvh));
+    auto et = zeno::LBvh::element_e::unknown;
+    if (primType == "point")
+      et = zeno::LBvh::element_e::point;
+    else if (primType == "line")
+      et = zeno::LBvh::element_e::line;
+    else if (primType == "tri")
+      et = zeno::LBvh::element_e::tri;
+    else if (primType == "quad")
+      et = zeno::LBvh::element_e::tet;
+    auto method = get_param<std::string>("method") == "sah"
+        ? zeno::LBvh::build_e::sah : zeno::LBvh::build_e::morton;
+    // cached in the userData of prim, later cooks only refit while the
+    // topology stays the same
+    if (get_input2<bool>("cache")) {
+      set_output("lbvh", zeno::LBvh::getOrBuild(prim, thickness, {}, et, method));
+      return;
     }
+    auto lbvh = std::make_shared<zeno::LBvh>();
+    lbvh->buildMethod = method;
+    lbvh->build(prim, thickness, lbvh->radiusAttr, et);
+    set_output("lbvh", std::move(lbvh));
   }
 };
 
 ZENDEFNODE(BuildPrimitiveBvh,
            {
-               {{"PrimitiveObject", "prim"}, {"float", "thickness", "0"}},
+               {{"PrimitiveObject", "prim"}, {"float", "thickness", "0"}, {"bool", "cache", "0"}},
                {{"LBvh", "lbvh"}},
-               {{"enum auto point line tri quad", "prim_type", "auto"}},
+               {{"enum auto point line tri quad", "prim_type", "auto"},
+                {"enum morton sah", "method", "morton"}},
                {"zenofx"},
            });
 
@@ -283,12 +313,6 @@ ZENDEFNODE(RefitPrimitiveBvh, {
                               });
 
 struct QueryNearestPrimitive : zeno::INode {
-  struct KVPair {
-    zeno::vec3f w;
-    float dist;
-    int pid;
-    bool operator<(const KVPair &o) const noexcept { return dist < o.dist; }
-  };
   virtual void apply() override {
     using namespace zeno;
 
@@ -313,40 +337,21 @@ struct QueryNearestPrimitive : zeno::INode {
       auto &ws = prim->add_attr<zeno::vec3f>(weightTag);
       auto &closestPoints = prim->add_attr<zeno::vec3f>(closestPointTag);
 
-      std::vector<KVPair> kvs(prim->size());
-      std::vector<Ti> ids(prim->size(), -1);
+      const Ti n = prim->size();
+      std::vector<Ti> ids(n, -1);
+      lbvh->find_nearest_batch(prim->verts.data(), n, ids.data(), dists.data(), ws.data());
 #if defined(_OPENMP)
-#pragma omp parallel for schedule(guided, 4)
+#pragma omp parallel for
 #endif
-      for (Ti i = 0; i < prim->size(); ++i) {
-        kvs[i].dist = std::numeric_limits<float>::max();
-        kvs[i].pid = i;
-        kvs[i].w = lbvh->find_nearest(prim->verts[i], ids[i], kvs[i].dist);
+      for (Ti i = 0; i < n; ++i) {
         // record info as attribs
         bvhids[i] = ids[i];
-        dists[i] = kvs[i].dist;
-        ws[i] = kvs[i].w;
-        closestPoints[i] = lbvh->retrievePrimitiveCenter(ids[i], kvs[i].w);
+        closestPoints[i] = lbvh->retrievePrimitiveCenter(ids[i], ws[i]);
       }
 
-      KVPair mi{zeno::vec3f{0.f, 0.f, 0.f}, std::numeric_limits<float>::max(), -1};
-// ref:
-// https://stackoverflow.com/questions/28258590/using-openmp-to-get-the-index-of-minimum-element-parallelly
-#ifndef _MSC_VER
-#if defined(_OPENMP)
-#pragma omp declare reduction(minimum:KVPair                                   \
-                              : omp_out = omp_in < omp_out ? omp_in : omp_out) \
-    initializer(omp_priv = KVPair{zeno::vec3f{0.f, 0.f, 0.f}, std::numeric_limits <float>::max(), -1})
-#pragma omp parallel for reduction(minimum : mi)
-#endif
-#endif
-      for (Ti i = 0; i < kvs.size(); ++i) {
-        if (kvs[i].dist < mi.dist)
-          mi = kvs[i];
-      }
-      pid = mi.pid;
-      dist = mi.dist;
-      w = mi.w;
+      pid = parallel_argmin(n, [&dists](int a, int b) { return dists[a] < dists[b]; });
+      dist = dists[pid];
+      w = ws[pid];
       bvhId = ids[pid];
       line->verts.push_back(prim->verts[pid]);
 #if 0
@@ -461,33 +466,9 @@ struct QueryNearestPrimitiveWithUV : zeno::INode {
         closestPoints[i] = lbvh->retrievePrimitiveCenter(ids[i], kvs[i].w);
       }
 
-      KVPair mi{zeno::vec3f{0.f, 0.f, 0.f}, std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), -1};
-// ref:
-// https://stackoverflow.com/questions/28258590/using-openmp-to-get-the-index-of-minimum-element-parallelly
-#ifndef _MSC_VER
-#if defined(_OPENMP)
-#pragma omp declare reduction(minimum:KVPair                                   \
-                              : omp_out = omp_in < omp_out ? omp_in : omp_out) \
-    initializer(omp_priv = KVPair{zeno::vec3f{0.f, 0.f, 0.f}, std::numeric_limits <float>::max(), -1})
-#pragma omp parallel for reduction(minimum : mi)
-#endif
-#endif
-      for (Ti i = 0; i < kvs.size(); ++i) {
-#if 0
-        if (kvs[i].dist + std::numeric_limits<float>::epsilon() * 2  < mi.dist)
-          mi = kvs[i];
-        else if (kvs[i].dist < mi.dist + std::numeric_limits<float>::epsilon() * 2 && kvs[i].uvDist2 < mi.uvDist2)
-          mi = kvs[i];
-#else
-        if (strictly_greater(mi.dist, kvs[i].dist))
-          mi = kvs[i];
-        else if (loosely_greater(mi.dist, kvs[i].dist) && kvs[i].uvDist2 < mi.uvDist2)
-          mi = kvs[i];
-#endif
-      }
-      pid = mi.pid;
-      dist = mi.dist;
-      w = mi.w;
+      pid = parallel_argmin(kvs.size(), [&kvs](int a, int b) { return kvs[a] < kvs[b]; });
+      dist = kvs[pid].dist;
+      w = kvs[pid].w;
       bvhId = ids[pid];
       line->verts.push_back(prim->verts[pid]);
 #if 0
@@ -674,24 +655,9 @@ struct QueryNearestPrimitiveWithinGroup : zeno::INode {
         closestPoints[i] = lbvh->retrievePrimitiveCenter(ids[i], kvs[i].w);
       }
 
-      KVPair mi{zeno::vec3f{0.f, 0.f, 0.f}, std::numeric_limits<float>::max(), -1};
-// ref:
-// https://stackoverflow.com/questions/28258590/using-openmp-to-get-the-index-of-minimum-element-parallelly
-#ifndef _MSC_VER
-#if defined(_OPENMP)
-#pragma omp declare reduction(minimum:KVPair                                   \
-                              : omp_out = omp_in < omp_out ? omp_in : omp_out) \
-    initializer(omp_priv = KVPair{zeno::vec3f{0.f, 0.f, 0.f}, std::numeric_limits <float>::max(), -1})
-#pragma omp parallel for reduction(minimum : mi)
-#endif
-#endif
-      for (Ti i = 0; i < kvs.size(); ++i) {
-        if (kvs[i].dist < mi.dist)
-          mi = kvs[i];
-      }
-      pid = mi.pid;
-      dist = mi.dist;
-      w = mi.w;
+      pid = parallel_argmin(kvs.size(), [&kvs](int a, int b) { return kvs[a] < kvs[b]; });
+      dist = kvs[pid].dist;
+      w = kvs[pid].w;
       bvhId = ids[pid];
       line->verts.push_back(prim->verts[pid]);
 #if 0
@@ -736,6 +702,99 @@ ZENDEFNODE(QueryNearestPrimitiveWithinGroup, {
                                   });
 
 
+struct QueryPrimitiveBvhRays : zeno::INode {
+  virtual void apply() override {
+    using namespace zeno;
+
+    auto lbvh = get_input<LBvh>("lbvh");
+    auto prim = get_input<PrimitiveObject>("prim");
+    auto dirTag = get_input2<std::string>("dirTag");
+    auto tmax = get_input2<float>("tmax");
+    if (!prim->verts.has_attr(dirTag))
+      throw std::runtime_error("missing ray direction attribute [" + dirTag + "]");
+
+    using Ti = typename LBvh::Ti;
+    const Ti n = prim->size();
+    const auto &dirs = prim->attr<zeno::vec3f>(dirTag);
+    auto &bvhids = prim->add_attr<float>(get_input2<std::string>("idTag"));
+    auto &ts = prim->add_attr<float>(get_input2<std::string>("tTag"));
+    auto &ws = prim->add_attr<zeno::vec3f>(get_input2<std::string>("weightTag"));
+    auto &hitPoints = prim->add_attr<zeno::vec3f>(get_input2<std::string>("hitPointTag"));
+
+    std::vector<Ti> ids(n, -1);
+    lbvh->ray_intersect_batch(prim->verts.data(), dirs.data(), n, tmax, ids.data(), ts.data(), ws.data());
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+    for (Ti i = 0; i < n; ++i) {
+      bvhids[i] = ids[i];
+      hitPoints[i] = prim->verts[i] + ts[i] * dirs[i];
+    }
+    set_output("prim", std::move(prim));
+  }
+};
+
+ZENDEFNODE(QueryPrimitiveBvhRays, {
+                                      {{"PrimitiveObject", "prim"}, {"LBvh", "lbvh"},
+                                      {"string", "dirTag", "dir"},
+                                      {"float", "tmax", "1e30"},
+                                      {"string", "idTag", "bvh_id"},
+                                      {"string", "tTag", "bvh_t"},
+                                      {"string", "weightTag", "bvh_ws"},
+                                      {"string", "hitPointTag", "hit"}
+                                      },
+                                      {{"PrimitiveObject", "prim"}},
+                                      {},
+                                      {"zenofx"},
+                                  });
+
+struct QueryPrimitiveBvhRadius : zeno::INode {
+  virtual void apply() override {
+    using namespace zeno;
+
+    auto lbvh = get_input<LBvh>("lbvh");
+    auto prim = get_input<PrimitiveObject>("prim");
+    auto radius = get_input2<float>("radius");
+
+    using Ti = typename LBvh::Ti;
+    const Ti n = prim->size();
+    std::vector<Ti> offsets, nbrs;
+    lbvh->radius_query_batch(prim->verts.data(), n, radius, offsets, nbrs);
+
+    auto &counts = prim->add_attr<int>(get_input2<std::string>("countTag"));
+    const auto center = lbvh->eleCategory == LBvh::element_e::line
+        ? zeno::vec3f{.5f, .5f, 0.f} : zeno::vec3f{1.f / 3, 1.f / 3, 1.f / 3};
+    // one line per (query point, element) pair, ending at the element center
+    auto pairs = std::make_shared<PrimitiveObject>();
+    pairs->resize(nbrs.size() * 2);
+    pairs->lines.resize(nbrs.size());
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+    for (Ti i = 0; i < n; ++i) {
+      counts[i] = offsets[i + 1] - offsets[i];
+      for (Ti k = offsets[i]; k != offsets[i + 1]; ++k) {
+        pairs->verts[k * 2] = prim->verts[i];
+        pairs->verts[k * 2 + 1] = lbvh->retrievePrimitiveCenter(nbrs[k], center);
+        pairs->lines[k] = zeno::vec2i(k * 2, k * 2 + 1);
+      }
+    }
+    set_output("prim", std::move(prim));
+    set_output("pairs", std::move(pairs));
+  }
+};
+
+ZENDEFNODE(QueryPrimitiveBvhRadius, {
+                                      {{"PrimitiveObject", "prim"}, {"LBvh", "lbvh"},
+                                      {"float", "radius", "0"},
+                                      {"string", "countTag", "nbr_count"}
+                                      },
+                                      {{"PrimitiveObject", "prim"},
+                                       {"PrimitiveObject", "pairs"}},
+                                      {},
+                                      {"zenofx"},
+                                  });
+
 struct ParticlesNeighborBvhWrangle : zeno::INode {
   virtual void apply() override {
     auto prim = get_input<zeno::PrimitiveObject>("prim");
@@ -862,7 +921,7 @@ struct ParticlesNeighborBvhWrangle : zeno::INode {
         }
 
     auto prog = compiler.compile(code, opts);
-    auto exec = assembler.assemble(prog->assembly);
+    zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
     for (auto const &[name, dim] : prog->newsyms) {
       dbg_printf("auto-defined new attribute: %s with dim %d\n", name.c_str(),
@@ -891,7 +950,7 @@ struct ParticlesNeighborBvhWrangle : zeno::INode {
           std::find(parnames.begin(), parnames.end(), std::pair{name, dimid});
       auto value = parvals.at(it - parnames.begin());
       dbg_printf("(valued %f)\n", value);
-      exec->parameter(prog->param_id(name, dimid)) = value;
+      inst.parameter(prog->param_id(name, dimid)) = value;
     }
 
     std::vector<Buffer> chs(prog->symbols.size());
@@ -941,7 +1000,7 @@ struct ParticlesNeighborBvhWrangle : zeno::INode {
       chs2[i] = iob;
     }
 
-    bvh_vectors_wrangle(exec, chs, chs2, prim->attr<zeno::vec3f>("pos"),
+    bvh_vectors_wrangle(&inst, chs, chs2, prim->attr<zeno::vec3f>("pos"),
                         primNei->attr<zeno::vec3f>("pos"), get_input2<bool>("is_box"),
                         lbvh.get()->thickness * lbvh.get()->thickness, lbvh.get());
 
@@ -1088,7 +1147,7 @@ struct ParticlesNeighborBvhWrangleSorted : zeno::INode {
         }
 
     auto prog = compiler.compile(code, opts);
-    auto exec = assembler.assemble(prog->assembly);
+    zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
     for (auto const &[name, dim] : prog->newsyms) {
       dbg_printf("auto-defined new attribute: %s with dim %d\n", name.c_str(),
@@ -1117,7 +1176,7 @@ struct ParticlesNeighborBvhWrangleSorted : zeno::INode {
           std::find(parnames.begin(), parnames.end(), std::pair{name, dimid});
       auto value = parvals.at(it - parnames.begin());
       dbg_printf("(valued %f)\n", value);
-      exec->parameter(prog->param_id(name, dimid)) = value;
+      inst.parameter(prog->param_id(name, dimid)) = value;
     }
 
     std::vector<Buffer> chs(prog->symbols.size());
@@ -1167,7 +1226,7 @@ struct ParticlesNeighborBvhWrangleSorted : zeno::INode {
       chs2[i] = iob;
     }
 
-    sorted_bvh_vectors_wrangle(exec, chs, chs2, prim->attr<zeno::vec3f>("pos"),
+    sorted_bvh_vectors_wrangle(&inst, chs, chs2, prim->attr<zeno::vec3f>("pos"),
                         primNei->attr<zeno::vec3f>("pos"), get_input2<bool>("is_box"),
                         lbvh.get()->thickness * lbvh.get()->thickness, get_input2<int>("limit"), lbvh.get());
 
@@ -1320,7 +1379,7 @@ struct ParticlesNeighborBvhRadiusWrangle : zeno::INode {
         }
 
     auto prog = compiler.compile(code, opts);
-    auto exec = assembler.assemble(prog->assembly);
+    zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
     for (auto const &[name, dim] : prog->newsyms) {
       dbg_printf("auto-defined new attribute: %s with dim %d\n", name.c_str(),
@@ -1349,7 +1408,7 @@ struct ParticlesNeighborBvhRadiusWrangle : zeno::INode {
           std::find(parnames.begin(), parnames.end(), std::pair{name, dimid});
       auto value = parvals.at(it - parnames.begin());
       dbg_printf("(valued %f)\n", value);
-      exec->parameter(prog->param_id(name, dimid)) = value;
+      inst.parameter(prog->param_id(name, dimid)) = value;
     }
 
     std::vector<Buffer> chs(prog->symbols.size());
@@ -1400,7 +1459,7 @@ struct ParticlesNeighborBvhRadiusWrangle : zeno::INode {
     }
     std::string maskAttr = get_input2<std::string>("maskAttr");
     const auto &mask = maskAttr == "" ? std::vector<float>(prim->verts.size(), 1.0f) : prim->attr<float>(maskAttr);
-    bvh_vectors_wrangle_radius_two(exec, chs, chs2, mask.data(), prim.get(), prim->attr<zeno::vec3f>("pos"), radiusAttr,
+    bvh_vectors_wrangle_radius_two(&inst, chs, chs2, mask.data(), prim.get(), prim->attr<zeno::vec3f>("pos"), radiusAttr,
                         primNei->attr<zeno::vec3f>("pos"), primNei.get(), 
                         get_input2<bool>("is_box"),
                         lbvh.get()->thickness, lbvh.get());
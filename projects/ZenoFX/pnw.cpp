@@ -140,7 +140,7 @@ struct HashGrid : zeno::IObject {
 };
 
 static void vectors_wrangle
-    ( zfx::x64::Executable *exec
+    ( zfx::x64::Instance *inst
     , std::vector<Buffer> const &chs
     , std::vector<Buffer> const &chs2
     , std::vector<zeno::vec3f> const &pos
@@ -151,7 +151,7 @@ static void vectors_wrangle
 
     #pragma omp parallel for
     for (int i = 0; i < pos.size(); i++) {
-        auto ctx = exec->make_context();
+        auto ctx = inst->make_context();
         for (int k = 0; k < chs.size(); k++) {
             if (!chs[k].which)
                 ctx.channel(k)[0] = chs[k].base[chs[k].stride * i];
@@ -311,7 +311,7 @@ struct ParticlesNeighborWrangle : zeno::INode {
         }
 
         auto prog = compiler.compile(code, opts);
-        auto exec = assembler.assemble(prog->assembly);
+        zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
         for (auto const &[name, dim]: prog->newsyms) {
             dbg_printf("auto-defined new attribute: %s with dim %d\n",
@@ -340,7 +340,7 @@ struct ParticlesNeighborWrangle : zeno::INode {
                 parnames.end(), std::pair{name, dimid});
             auto value = parvals.at(it - parnames.begin());
             dbg_printf("(valued %f)\n", value);
-            exec->parameter(prog->param_id(name, dimid)) = value;
+            inst.parameter(prog->param_id(name, dimid)) = value;
         }
 
         std::vector<Buffer> chs(prog->symbols.size());
@@ -390,7 +390,7 @@ struct ParticlesNeighborWrangle : zeno::INode {
             chs2[i] = iob;
         }
 
-        vectors_wrangle(exec, chs, chs2, prim->attr<zeno::vec3f>("pos"),
+        vectors_wrangle(&inst, chs, chs2, prim->attr<zeno::vec3f>("pos"),
                 hashgrid.get());
 
         set_output("prim", std::move(prim));
@@ -27,7 +27,7 @@ struct Buffer {
 
 
 static void vectors_wrangle
-    ( zfx::x64::Executable *exec
+    ( zfx::x64::Instance *inst
     , std::vector<Buffer> const &chs
     , std::vector<Buffer> const &chs2
     , std::vector<zeno::vec3f> const &pos
@@ -37,7 +37,7 @@ static void vectors_wrangle
 
     #pragma omp parallel for
     for (int i = 0; i < pos.size(); i++) {
-        auto ctx = exec->make_context();
+        auto ctx = inst->make_context();
         for (int k = 0; k < chs.size(); k++) {
             if (!chs[k].which)
                 ctx.channel(k)[0] = chs[k].base[chs[k].stride * i];
@@ -180,7 +180,7 @@ struct ParticleParticleWrangle : zeno::INode {
 
 
         auto prog = compiler.compile(code, opts);
-        auto exec = assembler.assemble(prog->assembly);
+        zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
         for (auto const &[name, dim]: prog->newsyms) {
             dbg_printf("auto-defined new attribute: %s with dim %d\n",
@@ -209,7 +209,7 @@ struct ParticleParticleWrangle : zeno::INode {
                 parnames.end(), std::pair{name, dimid});
             auto value = parvals.at(it - parnames.begin());
             dbg_printf("(valued %f)\n", value);
-            exec->parameter(prog->param_id(name, dimid)) = value;
+            inst.parameter(prog->param_id(name, dimid)) = value;
         }
 
         std::vector<Buffer> chs(prog->symbols.size());
@@ -260,7 +260,7 @@ struct ParticleParticleWrangle : zeno::INode {
             chs2[i] = iob;
         }
 
-        vectors_wrangle(exec, chs, chs2, prim->attr<zeno::vec3f>("pos"), primNei->attr<zeno::vec3f>("pos"));
+        vectors_wrangle(&inst, chs, chs2, prim->attr<zeno::vec3f>("pos"), primNei->attr<zeno::vec3f>("pos"));
 
         set_output("prim", std::move(prim));
     }
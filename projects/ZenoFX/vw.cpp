@@ -8,6 +8,8 @@
 #include <openvdb/tools/Prune.h>
 #include <openvdb/tools/ChangeBackground.h>
 #include <zeno/VDBGrid.h>
+#include <zeno/VDBPointsView.h>
+#include <openvdb/points/PointAttribute.h>
 #include <zfx/zfx.h>
 #include <zfx/x64.h>
 #include <cassert>
@@ -24,13 +26,13 @@ static zfx::Compiler compiler;
 static zfx::x64::Assembler assembler;
 
 template <class GridPtr>
-void vdb_wrangle(zfx::x64::Executable *exec, GridPtr &grid, bool modifyActive, bool changeBackground, bool hasPos) {
+void vdb_wrangle(zfx::x64::Instance *inst, GridPtr &grid, bool modifyActive, bool changeBackground, bool hasPos) {
     //ZENO_P(grid->background());
     auto wrangler = [&](auto &leaf, openvdb::Index leafpos) {
         std::visit([&] (auto hasPos) {
             for (auto iter = leaf.beginValueOn(); iter != leaf.endValueOn(); ++iter) {
                 iter.modifyValue([&](auto &v) {
-                    auto ctx = exec->make_context();
+                    auto ctx = inst->make_context();
                     if constexpr (std::is_same_v<std::decay_t<decltype(v)>, openvdb::Vec3f>) {
                         ctx.channel(0)[0] = v[0];
                         ctx.channel(1)[0] = v[1];
@@ -86,7 +88,7 @@ void vdb_wrangle(zfx::x64::Executable *exec, GridPtr &grid, bool modifyActive, b
     if (changeBackground) {
         auto v = grid->background();
         {
-            auto ctx = exec->make_context();
+            auto ctx = inst->make_context();
             openvdb::Vec3f p(0, 0, 0);
                     if constexpr (std::is_same_v<std::decay_t<decltype(v)>, openvdb::Vec3f>) {
                         ctx.channel(0)[0] = v[0];
@@ -213,7 +215,7 @@ struct VDBWrangle : zeno::INode {
         }
 
         auto prog = compiler.compile(code, opts);
-        auto exec = assembler.assemble(prog->assembly);
+        zfx::x64::Instance inst(assembler.assemble(prog->assembly));
 
         std::vector<float> pars(prog->params.size());
         for (int i = 0; i < pars.size(); i++) {
@@ -224,16 +226,16 @@ struct VDBWrangle : zeno::INode {
                 parnames.end(), std::pair{name, dimid});
             auto value = parvals.at(it - parnames.begin());
             dbg_printf("(valued %f)\n", value);
-            exec->parameter(prog->param_id(name, dimid)) = value;
+            inst.parameter(prog->param_id(name, dimid)) = value;
         }
         auto modifyActive = has_input("ModifyActive") ?
             (get_input<zeno::StringObject>("ModifyActive")->get())=="true" : false;
         auto changeBackground = has_input("ChangeBackground") ?
             (get_input<zeno::StringObject>("ChangeBackground")->get())=="true" : false;
         if (auto p = std::dynamic_pointer_cast<zeno::VDBFloatGrid>(grid); p)
-            vdb_wrangle(exec, p->m_grid, modifyActive, changeBackground, hasPos);
+            vdb_wrangle(&inst, p->m_grid, modifyActive, changeBackground, hasPos);
         else if (auto p = std::dynamic_pointer_cast<zeno::VDBFloat3Grid>(grid); p)
-            vdb_wrangle(exec, p->m_grid, modifyActive, changeBackground, hasPos);
+            vdb_wrangle(&inst, p->m_grid, modifyActive, changeBackground, hasPos);
 
         set_output("grid", std::move(grid));
     }
@@ -249,5 +251,195 @@ ZENDEFNODE(VDBWrangle, {
     {"zenofx"},
 });
 
+// Wrangles the attributes of a PointDataGrid leaf by leaf: each thread decodes
+// one leaf worth of the referenced channels, runs the program on it and writes
+// the result back, so no PrimitiveObject copy of the whole grid is ever made.
+// @pos and @vel alias the "P" and "v" point attributes.
+struct VDBPointsWrangle : zeno::INode {
+    virtual void apply() override {
+        auto grid = get_input<zeno::VDBPointsGrid>("grid");
+        auto code = get_input<zeno::StringObject>("zfxCode")->get();
+
+        auto toVdbName = [] (std::string const &key) -> std::string {
+            if (key == "pos") return "P";
+            if (key == "vel") return "v";
+            return key;
+        };
+
+        VDBPointsView view(grid->m_grid);
+        auto types = view.attr_types();
+
+        zfx::Options opts(zfx::Options::for_x64);
+        opts.detect_new_symbols = true;
+        for (auto const &[name, type]: types) {
+            if (type != 0 && type != 2)
+                continue;
+            auto key = name == "P" ? "pos" : name == "v" ? "vel" : name;
+            opts.define_symbol('@' + key, type == 2 ? 3 : 1);
+        }
+
+        auto params = has_input("params") ?
+            get_input<zeno::DictObject>("params") :
+            std::make_shared<zeno::DictObject>();
+        {
+        auto const &gs = *this->getGlobalState();
+        params->lut["PI"] = objectFromLiterial((float)(std::atan(1.f) * 4));
+        params->lut["F"] = objectFromLiterial((float)gs.frameid);
+        params->lut["DT"] = objectFromLiterial(gs.frame_time);
+        params->lut["T"] = objectFromLiterial(gs.frame_time * gs.frameid + gs.frame_time_elapsed);
+        for (auto const &[key, ref]: getThisGraph()->portalIns) {
+            if (auto i = code.find('$' + key); i != std::string::npos) {
+                i = i + key.size() + 1;
+                if (code.size() <= i || !std::isalnum(code[i])) {
+                    if (params->lut.count(key)) continue;
+                    dbg_printf("ref portal %s\n", key.c_str());
+                    auto res = getThisGraph()->callTempNode("PortalOut",
+                          {{"name:", objectFromLiterial(key)}}).at("port");
+                    params->lut[key] = std::move(res);
+                }
+            }
+        }
+        std::vector<std::string> keys;
+        for (auto const &[key, val]: params->lut) {
+            keys.push_back(key);
+        }
+        for (auto const &key: keys) {
+            if (!dynamic_cast<zeno::NumericObject*>(params->lut.at(key).get())) {
+                dbg_printf("ignored non-numeric %s\n", key.c_str());
+                params->lut.erase(key);
+            }
+        }
+        }
+        std::vector<float> parvals;
+        std::vector<std::pair<std::string, int>> parnames;
+        for (auto const &[key_, par]: params->getLiterial<zeno::NumericValue>()) {
+            auto key = '$' + key_;
+            auto dim = std::visit([&] (auto const &v) {
+                using T = std::decay_t<decltype(v)>;
+                if constexpr (std::is_convertible_v<T, zeno::vec3f>) {
+                    parvals.push_back(v[0]);
+                    parvals.push_back(v[1]);
+                    parvals.push_back(v[2]);
+                    parnames.emplace_back(key, 0);
+                    parnames.emplace_back(key, 1);
+                    parnames.emplace_back(key, 2);
+                    return 3;
+                } else if constexpr (std::is_convertible_v<T, zeno::vec2f>) {
+                    parvals.push_back(v[0]);
+                    parvals.push_back(v[1]);
+                    parnames.emplace_back(key, 0);
+                    parnames.emplace_back(key, 1);
+                    return 2;
+                } else if constexpr (std::is_convertible_v<T, float>) {
+                    parvals.push_back(v);
+                    parnames.emplace_back(key, 0);
+                    return 1;
+                } else return 0;
+            }, par);
+            opts.define_param(key, dim);
+        }
+        code = preApplyRefs(code, getThisGraph());
+
+        auto prog = compiler.compile(code, opts);
+        zfx::x64::Instance inst(assembler.assemble(prog->assembly));
+
+        bool newAttrs = false;
+        for (auto const &[name, dim]: prog->newsyms) {
+            assert(name[0] == '@');
+            auto vdbName = toVdbName(name.substr(1));
+            dbg_printf("auto-defined new point attribute: %s with dim %d\n", vdbName.c_str(), dim);
+            if (dim == 3) {
+                openvdb::points::appendAttribute<openvdb::Vec3f>(grid->m_grid->tree(), vdbName);
+            } else if (dim == 1) {
+                openvdb::points::appendAttribute<float>(grid->m_grid->tree(), vdbName);
+            } else {
+                err_printf("ERROR: bad attribute dimension for points: %d\n", dim);
+                continue;
+            }
+            types[vdbName] = dim == 3 ? 2 : 0;
+            newAttrs = true;
+        }
+        if (newAttrs)
+            view = VDBPointsView(grid->m_grid);
+
+        for (int i = 0; i < prog->params.size(); i++) {
+            auto [name, dimid] = prog->params[i];
+            assert(name[0] == '$');
+            auto it = std::find(parnames.begin(),
+                parnames.end(), std::pair{name, dimid});
+            auto value = parvals.at(it - parnames.begin());
+            inst.parameter(prog->param_id(name, dimid)) = value;
+        }
+
+        // distinct attributes referenced by the program, and their channels
+        std::vector<std::pair<std::string, int>> attrs;
+        std::vector<std::pair<int, int>> chattr(prog->symbols.size());
+        for (int i = 0; i < prog->symbols.size(); i++) {
+            auto [name, dimid] = prog->symbols[i];
+            assert(name[0] == '@');
+            auto vdbName = toVdbName(name.substr(1));
+            auto it = std::find_if(attrs.begin(), attrs.end(), [&] (auto const &a) { return a.first == vdbName; });
+            if (it == attrs.end()) {
+                attrs.emplace_back(vdbName, types.at(vdbName) == 2 ? 3 : 1);
+                it = attrs.end() - 1;
+            }
+            chattr[i] = {int(it - attrs.begin()), dimid};
+        }
+
+        std::atomic<size_t> escaped{0};
+        view.foreach_chunk([&] (size_t c, size_t, size_t n) {
+            std::vector<std::vector<float>> bufs(attrs.size());
+            for (int a = 0; a < attrs.size(); a++) {
+                auto const &[name, dim] = attrs[a];
+                bufs[a].resize(n * dim);
+                if (dim == 3)
+                    view.read_chunk(c, name, (zeno::vec3f *)bufs[a].data());
+                else
+                    view.read_chunk(c, name, bufs[a].data());
+            }
+            auto run = [&] (size_t i, size_t m) {
+                auto ctx = inst.make_context();
+                for (int j = 0; j < chattr.size(); j++) {
+                    auto [a, dimid] = chattr[j];
+                    auto stride = attrs[a].second;
+                    for (size_t k = 0; k < m; k++)
+                        ctx.channel(j)[k] = bufs[a][stride * (i + k) + dimid];
+                }
+                ctx.execute();
+                for (int j = 0; j < chattr.size(); j++) {
+                    auto [a, dimid] = chattr[j];
+                    auto stride = attrs[a].second;
+                    for (size_t k = 0; k < m; k++)
+                        bufs[a][stride * (i + k) + dimid] = ctx.channel(j)[k];
+                }
+            };
+            size_t i = 0;
+            for (; i + inst.SimdWidth <= n; i += inst.SimdWidth)
+                run(i, inst.SimdWidth);
+            for (; i < n; i++)
+                run(i, 1);
+            for (int a = 0; a < attrs.size(); a++) {
+                auto const &[name, dim] = attrs[a];
+                if (dim == 3)
+                    escaped += view.write_chunk(c, name, (zeno::vec3f const *)bufs[a].data());
+                else
+                    view.write_chunk(c, name, bufs[a].data());
+            }
+        });
+        if (view.commit())
+            dbg_printf("%zd points moved to new voxels\n", (size_t)escaped);
+
+        set_output("grid", std::move(grid));
+    }
+};
+
+ZENDEFNODE(VDBPointsWrangle, {
+    {{"VDBGrid", "grid"}, {"string", "zfxCode"},
+     {"DictObject:NumericObject", "params"}},
+    {{"VDBGrid", "grid"}},
+    {},
+    {"zenofx"},
+});
+
 }
 }
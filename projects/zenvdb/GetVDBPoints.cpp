@@ -2,7 +2,10 @@
 #include <zeno/ParticlesObject.h>
 #include <zeno/PrimitiveObject.h>
 #include <zeno/VDBGrid.h>
+#include <zeno/VDBPointsView.h>
 #include <zeno/utils/log.h>
+#include <zeno/utils/string.h>
+#include <zeno/utils/Error.h>
 #include <tbb/parallel_for.h>
 #include <thread>
 #include <map>
@@ -73,191 +76,50 @@ struct GetVDBPointsLeafCount : zeno::INode {
 };
 #endif
 
+static std::string vdbPointsAttrToPrim(std::string const &name) {
+    if (name == "P") return "pos";
+    if (name == "v") return "vel";
+    return name;
+}
+
+static std::string primAttrToVDBPoints(std::string const &name) {
+    if (name == "pos") return "P";
+    if (name == "vel") return "v";
+    return name;
+}
+
 struct VDBPointsToPrimitive : zeno::INode {
   virtual void apply() override {
     auto grid = get_input("grid")->as<VDBPointsGrid>()->m_grid;
+    auto allAttrs = has_input("allAttrs") && get_input2<bool>("allAttrs");
 
-    std::vector<openvdb::points::PointDataTree::LeafNodeType *> leafs;
-    grid->tree().getNodes(leafs);
-    zeno::log_info("VDBPointsToPrimitive: particle leaf nodes: {}\n", leafs.size());
-    auto transform = grid->transformPtr();
+    // decode leaf by leaf straight into the attribute arrays, no staging copy
+    VDBPointsView view(grid);
+    zeno::log_info("VDBPointsToPrimitive: particle leaf nodes: {}, particles: {}", view.numChunks(), view.size());
 
     auto ret = zeno::IObject::make<zeno::PrimitiveObject>();
-    size_t count = openvdb::points::pointCount(grid->tree());
-    zeno::log_info("VDBPointsToPrimitive: particles: {}\n", count);
-    ret->resize(count);
-    auto &retpos = ret->add_attr<zeno::vec3f>("pos");
-
-    auto hasVel = !leafs.size() || leafs[0]->hasAttribute("v") && leafs[0]->hasAttribute("P");
-
-    //tbb::concurrent_vector<std::tuple<zeno::vec3f,zeno::vec3f>> data(0);
-    if (hasVel) {
-      auto &retvel = ret->add_attr<zeno::vec3f>("vel");
-
-#if 0
-      using MapT = std::map<std::thread::id, size_t>;
-      using IterT = typename MapT::iterator;
-      MapT pars;
-      MapT offsets;
-      std::mutex mutex;
-
-      auto counter = [&](auto &range) {
-          IterT iter;
-          {
-              std::lock_guard<std::mutex> lk(mutex);
-              bool tag;
-              std::tie(iter, tag) = pars.insert(std::make_pair(std::this_thread::get_id(), 0));
-          }
-          size_t &inc = iter->second;
-          for (auto leafIter = range.begin(); leafIter; ++leafIter) {
-              size_t count = leafIter->pointCount();
-              inc += count;
-          }
-          //std::cout << "thread [" << std::this_thread::get_id() << "]: " << lcnt << "leafs, " << inc << "pars in total\n";
-      };
-      {
-        openvdb::tree::LeafManager<std::decay_t<decltype(grid->tree())>> leafman(grid->tree());
-        tbb::parallel_for(leafman.leafRange(), counter, tbb::static_partitioner());
-      }
-
-      size_t offset = 0;
-      for (const auto &[tid, sz] : pars) {
-        offsets.emplace(tid, offset);
-        offset += sz;
-      }
-
-      auto converter = [&](auto &range) {
-          auto offset = offsets[std::this_thread::get_id()];
-
-          for (auto leafIter = range.begin(); leafIter; ++leafIter) {
-
-              const openvdb::points::AttributeArray &positionArray = leafIter->constAttributeArray("P");
-              const openvdb::points::AttributeArray &velocityArray = leafIter->constAttributeArray("v");
-
-              openvdb::points::AttributeHandle<openvdb::Vec3f> positionHandle(positionArray);
-              openvdb::points::AttributeHandle<openvdb::Vec3f> velocityHandle(velocityArray);
-
-              for (auto indexIter = leafIter->beginIndexOn(); indexIter; ++indexIter) {
-                  openvdb::Vec3f voxelPosition = positionHandle.get(*indexIter);
-                  const openvdb::Vec3d xyz = indexIter.getCoord().asVec3d();
-                  openvdb::Vec3f worldPosition = grid->transform().indexToWorld(voxelPosition + xyz);
-
-                  openvdb::Vec3f particleVel = velocityHandle.get(*indexIter);
-
-                  retpos[offset] = zeno::vec3f(worldPosition[0], worldPosition[1], worldPosition[2]);
-                  retvel[offset++] = zeno::vec3f(particleVel[0], particleVel[1], particleVel[2]);
-              }
-          }
-      };
-      {
-        openvdb::tree::LeafManager<std::decay_t<decltype(grid->tree())>> leafman(grid->tree());
-        tbb::parallel_for(leafman.leafRange(), converter, tbb::static_partitioner());
-      }
-
-#else
-      size_t i = 0;
-      for (auto leafIter = grid->tree().cbeginLeaf(); leafIter; ++leafIter) {
-        const openvdb::points::AttributeArray &positionArray = leafIter->constAttributeArray("P");
-        const openvdb::points::AttributeArray &velocityArray = leafIter->constAttributeArray("v");
-
-        openvdb::points::AttributeHandle<openvdb::Vec3f> positionHandle(positionArray);
-        openvdb::points::AttributeHandle<openvdb::Vec3f> velocityHandle(velocityArray);
-
-        for (auto indexIter = leafIter->beginIndexOn(); indexIter; ++indexIter) {
-            openvdb::Vec3f voxelPosition = positionHandle.get(*indexIter);
-            const openvdb::Vec3d xyz = indexIter.getCoord().asVec3d();
-            openvdb::Vec3f worldPosition = grid->transform().indexToWorld(voxelPosition + xyz);
-
-            openvdb::Vec3f particleVel = velocityHandle.get(*indexIter);
-
-            retpos[i] = zeno::vec3f{worldPosition[0], worldPosition[1], worldPosition[2]};
-            retvel[i] = zeno::vec3f{particleVel[0], particleVel[1], particleVel[2]};
-            i++;
-        }
-      }
-#endif
-    } else {
-
-#if 0
-      using MapT = std::map<std::thread::id, size_t>;
-      using IterT = typename MapT::iterator;
-      MapT pars;
-      MapT offsets;
-      std::mutex mutex;
-
-      auto counter = [&](auto &range) {
-          IterT iter;
-          {
-              std::lock_guard<std::mutex> lk(mutex);
-              bool tag;
-              std::tie(iter, tag) = pars.insert(std::make_pair(std::this_thread::get_id(), 0));
-          }
-          size_t &inc = iter->second;
-          for (auto leafIter = range.begin(); leafIter; ++leafIter) {
-              size_t count = leafIter->pointCount();
-              inc += count;
-          }
-          //std::cout << "thread [" << std::this_thread::get_id() << "]: " << lcnt << "leafs, " << inc << "pars in total\n";
-      };
-      {
-        openvdb::tree::LeafManager<std::decay_t<decltype(grid->tree())>> leafman(grid->tree());
-        tbb::parallel_for(leafman.leafRange(), counter, tbb::static_partitioner());
-      }
-
-      size_t offset = 0;
-      for (const auto &[tid, sz] : pars) {
-        offsets.emplace(tid, offset);
-        offset += sz;
-      }
-
-      auto converter = [&](auto &range) {
-          auto offset = offsets[std::this_thread::get_id()];
-
-          for (auto leafIter = range.begin(); leafIter; ++leafIter) {
-              const openvdb::points::AttributeArray &positionArray = leafIter->constAttributeArray("P");
-
-              openvdb::points::AttributeHandle<openvdb::Vec3f> positionHandle(positionArray);
-
-              for (auto indexIter = leafIter->beginIndexOn(); indexIter; ++indexIter) {
-                  openvdb::Vec3f voxelPosition = positionHandle.get(*indexIter);
-                  const openvdb::Vec3d xyz = indexIter.getCoord().asVec3d();
-                  openvdb::Vec3f worldPosition = grid->transform().indexToWorld(voxelPosition + xyz);
-
-                  retpos[offset++] = zeno::vec3f(worldPosition[0], worldPosition[1], worldPosition[2]);
-              }
-          }
-      };
-      {
-        openvdb::tree::LeafManager<std::decay_t<decltype(grid->tree())>> leafman(grid->tree());
-        tbb::parallel_for(leafman.leafRange(), converter, tbb::static_partitioner());
-      }
-#else
-      size_t i = 0;
-      for (auto leafIter = grid->tree().cbeginLeaf(); leafIter; ++leafIter) {
-        const openvdb::points::AttributeArray &positionArray = leafIter->constAttributeArray("P");
-
-        openvdb::points::AttributeHandle<openvdb::Vec3f> positionHandle(positionArray);
-
-        for (auto indexIter = leafIter->beginIndexOn(); indexIter; ++indexIter) {
-            openvdb::Vec3f voxelPosition = positionHandle.get(*indexIter);
-            const openvdb::Vec3d xyz = indexIter.getCoord().asVec3d();
-            openvdb::Vec3f worldPosition = grid->transform().indexToWorld(voxelPosition + xyz);
-
-            retpos[i] = zeno::vec3f{worldPosition[0], worldPosition[1], worldPosition[2]};
-            i++;
-        }
-      }
-#endif
+    ret->resize(view.size());
+    ret->add_attr<zeno::vec3f>("pos");
+    for (auto const &[name, type]: view.attr_types()) {
+      if (!allAttrs && name != "P" && name != "v")
+        continue;
+      auto key = vdbPointsAttrToPrim(name);
+      if (type == 0)
+        view.read_all(name, ret->add_attr<float>(key).data());
+      else if (type == 1)
+        view.read_all(name, ret->add_attr<int>(key).data());
+      else if (type == 2)
+        view.read_all(name, ret->add_attr<zeno::vec3f>(key).data());
     }
 
-    zeno::log_info("VDBPointsToPrimitive: complete\n");
+    zeno::log_info("VDBPointsToPrimitive: complete");
     set_output("prim", ret);
   }
 };
 
 static int defVDBPointsToPrimitive = zeno::defNodeClass<VDBPointsToPrimitive>("VDBPointsToPrimitive",
     { /* inputs: */ {
-        "grid",
+        "grid", {"bool", "allAttrs", "0"},
     }, /* outputs: */ {
         "prim",
     }, /* params: */ {
@@ -265,7 +127,56 @@ static int defVDBPointsToPrimitive = zeno::defNodeClass<VDBPointsToPrimitive>("V
       "openvdb",
     }});
 
+// Writes the attributes of a primitive obtained from VDBPointsToPrimitive back
+// into the leaf attribute arrays of the same grid in place. Points whose new
+// position leaves their voxel are moved into their new leaves afterwards.
+struct VDBPointsSetAttrsFromPrimitive : zeno::INode {
+  virtual void apply() override {
+    auto grid = get_input<VDBPointsGrid>("grid");
+    auto prim = get_input<zeno::PrimitiveObject>("prim");
+    auto attrs = get_input2<std::string>("attrs");
+
+    VDBPointsView view(grid->m_grid);
+    if (view.size() != prim->size())
+      throw makeError("VDBPointsSetAttrsFromPrimitive: point count mismatch, "
+                      + std::to_string(prim->size()) + " vs " + std::to_string(view.size()));
+    auto types = view.attr_types();
+    size_t escaped = 0;
+    for (auto const &key: zeno::split_str(attrs, ' ')) {
+      if (key.empty())
+        continue;
+      auto name = primAttrToVDBPoints(key);
+      auto it = types.find(name);
+      if (it == types.end() || !prim->has_attr(key))
+        throw makeError("VDBPointsSetAttrsFromPrimitive: no such attribute: " + key);
+      prim->attr_visit<zeno::AttrAcceptAll>(key, [&] (auto const &arr) {
+        using T = std::decay_t<decltype(arr[0])>;
+        constexpr int type = std::is_same_v<T, float> ? 0 : std::is_same_v<T, int> ? 1
+                           : std::is_same_v<T, zeno::vec3f> ? 2 : -1;
+        if constexpr (type == -1) {
+          throw makeError("VDBPointsSetAttrsFromPrimitive: unsupported attribute type: " + key);
+        } else {
+          if (it->second != type)
+            throw makeError("VDBPointsSetAttrsFromPrimitive: attribute type mismatch: " + key);
+          escaped += view.write_all(name, arr.data());
+        }
+      });
+    }
+    if (view.commit())
+      zeno::log_info("VDBPointsSetAttrsFromPrimitive: {} particles moved to new voxels", escaped);
+    set_output("grid", std::move(grid));
+  }
+};
 
+static int defVDBPointsSetAttrsFromPrimitive = zeno::defNodeClass<VDBPointsSetAttrsFromPrimitive>("VDBPointsSetAttrsFromPrimitive",
+    { /* inputs: */ {
+        "grid", "prim", {"string", "attrs", "pos vel"},
+    }, /* outputs: */ {
+        "grid",
+    }, /* params: */ {
+    }, /* category: */ {
+      "openvdb",
+    }});
 
 
 struct GetVDBPointsDroplets : zeno::INode {
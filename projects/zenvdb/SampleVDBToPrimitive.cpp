@@ -5,8 +5,15 @@
 #include <zeno/VDBGrid.h>
 #include <zeno/utils/vec.h>
 #include <zeno/utils/UserData.h>
+#include <zeno/utils/morton.h>
+#include <zeno/utils/parallel_reduce.h>
+#include <zeno/utils/string.h>
+#include <zeno/types/ListObject.h>
 #include <zeno/zeno.h>
 #include <zeno/ZenoInc.h>
+#include <openvdb/tools/Interpolation.h>
+#include <tbb/parallel_sort.h>
+#include <algorithm>
 
 namespace zeno {
 
@@ -41,32 +48,61 @@ struct is_vdb_to_prim_convertible<std::vector<T>, std::void_t<typename attr_to_v
   static constexpr bool value = true;
 };
 
-template <class T>
-void sampleVDBAttribute(std::vector<vec3f> const &pos, std::vector<T> &arr,
-                        VDBGrid *ggrid) {
-  using VDBType = typename attr_to_vdb_type<T>::type;
-  auto ptr = dynamic_cast<VDBType *>(ggrid);
-  if (!ptr) {
-    zeno::log_error("ERROR: vdb attribute type mismatch!");
-    throw std::runtime_error("ERROR: vdb attribute type mismatch!");
-  }
-  auto grid = ptr->m_grid;
+// Per-thread sampling cursor: owns a value accessor so that the leaf cache
+// survives across consecutive (spatially sorted) samples of one thread.
+struct VDBSampleCursor {
+    virtual void sample(int const *idx, size_t n) = 0;
+    virtual ~VDBSampleCursor() = default;
+};
 
-#pragma omp parallel for
-  for (int i = 0; i < pos.size(); i++) {
-    auto p0 = pos[i];
-    auto p1 = vec_to_other<openvdb::Vec3R>(p0);
-    auto p2 = grid->worldToIndex(p1);
-    auto val = openvdb::tools::BoxSampler::sample(grid->getConstUnsafeAccessor(), p2);
-    if constexpr (attr_to_vdb_type<T>::is_scalar) {
-      arr[i] = val;
-    } else {
-      arr[i] = other_to_vec<3>(val);
+struct VDBSampleJob {
+    virtual std::unique_ptr<VDBSampleCursor> cursor() const = 0;
+    virtual ~VDBSampleJob() = default;
+};
+
+template <class Sampler, class T, class GridT>
+struct VDBSampleJobImpl : VDBSampleJob {
+    std::vector<vec3f> const &pos;
+    std::vector<T> &arr;
+    typename GridT::Ptr grid;
+    float remapMin, remapMax;
+
+    VDBSampleJobImpl(std::vector<vec3f> const &pos, std::vector<T> &arr,
+                     typename GridT::Ptr grid, float remapMin, float remapMax)
+        : pos(pos), arr(arr), grid(std::move(grid)), remapMin(remapMin), remapMax(remapMax) {}
+
+    struct Cursor : VDBSampleCursor {
+        VDBSampleJobImpl const *job;
+        typename GridT::ConstUnsafeAccessor acc;
+
+        explicit Cursor(VDBSampleJobImpl const *job)
+            : job(job), acc(job->grid->getConstUnsafeAccessor()) {}
+
+        virtual void sample(int const *idx, size_t n) override {
+            auto const &xform = job->grid->transform();
+            float scale = 1.f / (job->remapMax - job->remapMin);
+            for (size_t k = 0; k < n; k++) {
+                int i = idx[k];
+                auto p0 = (job->pos[i] - job->remapMin) * scale;
+                auto p1 = xform.worldToIndex(vec_to_other<openvdb::Vec3R>(p0));
+                auto val = Sampler::sample(acc, p1);
+                if constexpr (attr_to_vdb_type<T>::is_scalar) {
+                    job->arr[i] = val;
+                } else {
+                    job->arr[i] = other_to_vec<3>(val);
+                }
+            }
+        }
+    };
+
+    virtual std::unique_ptr<VDBSampleCursor> cursor() const override {
+        return std::make_unique<Cursor>(this);
     }
-  }
-}
+};
+
 template <class T>
-void sampleVDBAttribute2(
+std::unique_ptr<VDBSampleJob> makeVDBSampleJob(
+        std::string const &sampler,
         std::vector<vec3f> const &pos,
         std::vector<T> &arr,
         VDBGrid *ggrid,
@@ -79,21 +115,104 @@ void sampleVDBAttribute2(
         zeno::log_error("ERROR: vdb attribute type mismatch!");
         throw std::runtime_error("ERROR: vdb attribute type mismatch!");
     }
-    auto grid = ptr->m_grid;
-
-    #pragma omp parallel for
-    for (int i = 0; i < pos.size(); i++) {
-        auto p0 = (pos[i] - remapMin) / (remapMax - remapMin);
-        auto p1 = vec_to_other<openvdb::Vec3R>(p0);
-        auto p2 = grid->worldToIndex(p1);
-        auto val = openvdb::tools::BoxSampler::sample(grid->getConstUnsafeAccessor(), p2);
-        if constexpr (attr_to_vdb_type<T>::is_scalar) {
-            arr[i] = val;
-        } else {
-            arr[i] = other_to_vec<3>(val);
+    using GridT = typename std::decay_t<decltype(ptr->m_grid)>::element_type;
+    if (sampler == "Point")
+        return std::make_unique<VDBSampleJobImpl<openvdb::tools::PointSampler, T, GridT>>(
+            pos, arr, ptr->m_grid, remapMin, remapMax);
+    else if (sampler == "Quadratic")
+        return std::make_unique<VDBSampleJobImpl<openvdb::tools::QuadraticSampler, T, GridT>>(
+            pos, arr, ptr->m_grid, remapMin, remapMax);
+    else if (sampler == "Linear" || sampler.empty())
+        return std::make_unique<VDBSampleJobImpl<openvdb::tools::BoxSampler, T, GridT>>(
+            pos, arr, ptr->m_grid, remapMin, remapMax);
+    throw makeError<KeyError>(sampler, "sampler type");
+}
+
+// Visiting order of the sample points along a Morton curve over their
+// bounding box, so that neighbouring samples land in the same VDB leaves.
+static std::vector<int> mortonSampleOrder(std::vector<vec3f> const &pos) {
+    size_t n = pos.size();
+    std::vector<int> order(n);
+    if (n == 0)
+        return order;
+
+    vec3f bmin = parallel_reduce_array<vec3f>(n, pos[0], [&] (size_t i) { return pos[i]; },
+                                              [] (vec3f a, vec3f b) { return zeno::min(a, b); });
+    vec3f bmax = parallel_reduce_array<vec3f>(n, pos[0], [&] (size_t i) { return pos[i]; },
+                                              [] (vec3f a, vec3f b) { return zeno::max(a, b); });
+    vec3f extent = bmax - bmin;
+    float maxExtent = std::max({extent[0], extent[1], extent[2], 1e-20f});
+    float scale = float((1u << 21) - 1) / maxExtent;
+
+    std::vector<std::pair<uint64_t, int>> records(n);
+#pragma omp parallel for
+    for (intptr_t i = 0; i < n; i++) {
+        vec3f q = (pos[i] - bmin) * scale;
+        auto x = (uint64_t)zeno::clamp(q[0], 0.f, float((1u << 21) - 1));
+        auto y = (uint64_t)zeno::clamp(q[1], 0.f, float((1u << 21) - 1));
+        auto z = (uint64_t)zeno::clamp(q[2], 0.f, float((1u << 21) - 1));
+        records[i] = std::make_pair(morton3d::encode(x, y, z), (int)i);
+    }
+    tbb::parallel_sort(records.begin(), records.end());
+#pragma omp parallel for
+    for (intptr_t i = 0; i < n; i++) {
+        order[i] = records[i].second;
+    }
+    return order;
+}
+
+// Samples all jobs in one sweep over the Morton-sorted points. Each thread
+// walks a contiguous run of batches and keeps one cursor (accessor) per grid.
+static void runVDBSampleJobs(std::vector<int> const &order,
+                             std::vector<std::unique_ptr<VDBSampleJob>> const &jobs) {
+    constexpr size_t kBatchSize = 4096;
+    size_t nbatches = (order.size() + kBatchSize - 1) / kBatchSize;
+#pragma omp parallel
+    {
+        std::vector<std::unique_ptr<VDBSampleCursor>> cursors;
+        for (auto const &job: jobs)
+            cursors.push_back(job->cursor());
+#pragma omp for schedule(static)
+        for (intptr_t b = 0; b < nbatches; b++) {
+            size_t i0 = b * kBatchSize;
+            size_t i1 = std::min(i0 + kBatchSize, order.size());
+            for (auto const &cur: cursors)
+                cur->sample(order.data() + i0, i1 - i0);
         }
     }
 }
+
+template <class T>
+void sampleVDBAttribute(std::vector<vec3f> const &pos, std::vector<T> &arr,
+                        VDBGrid *ggrid, std::string const &sampler = "Linear") {
+  std::vector<std::unique_ptr<VDBSampleJob>> jobs;
+  jobs.push_back(makeVDBSampleJob(sampler, pos, arr, ggrid, 0.f, 1.f));
+  runVDBSampleJobs(mortonSampleOrder(pos), jobs);
+}
+
+template <class T>
+void sampleVDBAttribute2(
+        std::vector<vec3f> const &pos,
+        std::vector<T> &arr,
+        VDBGrid *ggrid,
+        float remapMin,
+        float remapMax,
+        std::string const &sampler = "Linear"
+) {
+    std::vector<std::unique_ptr<VDBSampleJob>> jobs;
+    jobs.push_back(makeVDBSampleJob(sampler, pos, arr, ggrid, remapMin, remapMax));
+    runVDBSampleJobs(mortonSampleOrder(pos), jobs);
+}
+
+static void addVDBSampleAttr(PrimitiveObject *prim, std::string const &attr, VDBGrid *grid) {
+    if (dynamic_cast<VDBFloatGrid *>(grid))
+        prim->add_attr<float>(attr);
+    else if (dynamic_cast<VDBFloat3Grid *>(grid))
+        prim->add_attr<vec3f>(attr);
+    else
+        throw zeno::Exception("unknown vdb grid type\n");
+}
+
 struct SampleVDBToPrimitive : INode {
   virtual void apply() override {
     auto prim = get_input<PrimitiveObject>("prim");
@@ -102,14 +221,9 @@ struct SampleVDBToPrimitive : INode {
     auto sampleby = get_input<StringObject>("sampleBy")->get();
     auto &pos = prim->attr<vec3f>(sampleby);
     auto type = get_param<std::string>(("SampleType"));
+    auto sampler = get_param<std::string>("Sampler");
 
-
-    if (dynamic_cast<VDBFloatGrid *>(grid.get()))
-        prim->add_attr<float>(attr);
-    else if (dynamic_cast<VDBFloat3Grid *>(grid.get()))
-        prim->add_attr<vec3f>(attr);
-    else
-        throw zeno::Exception("unknown vdb grid type\n");
+    addVDBSampleAttr(prim.get(), attr, grid.get());
 
     if(type == "Periodic")
     {
@@ -121,7 +235,7 @@ struct SampleVDBToPrimitive : INode {
     //std::visit([&](auto &vel) { 
     prim->attr_visit(attr, [&] (auto &vel) {
       if constexpr (is_vdb_to_prim_convertible<std::decay_t<decltype(vel)>>::value)
-        sampleVDBAttribute(pos, vel, grid.get()); 
+        sampleVDBAttribute(pos, vel, grid.get(), sampler);
     });
                //prim->attr(attr));
 
@@ -139,7 +253,45 @@ struct SampleVDBToPrimitive : INode {
 ZENDEFNODE(SampleVDBToPrimitive, {
                                      {"prim", "vdbGrid", {"string", "sampleBy","pos"}, {"string", "primAttr", "sdf"}},
                                      {"prim"},
-                                     {{"enum Clamp Periodic", "SampleType", "Clamp"}},
+                                     {{"enum Clamp Periodic", "SampleType", "Clamp"},
+                                      {"enum Linear Quadratic Point", "Sampler", "Linear"}},
+                                     {"openvdb"},
+                                 });
+
+struct SampleVDBsToPrimitive : INode {
+  virtual void apply() override {
+    auto prim = get_input<PrimitiveObject>("prim");
+    auto grids = get_input<ListObject>("vdbGrids")->get<VDBGrid>();
+    auto attrs = split_str(get_input2<std::string>("primAttrs"), {' ', ','});
+    auto sampleby = get_input2<std::string>("sampleBy");
+    auto sampler = get_input2<std::string>("sampler");
+    if (attrs.size() != grids.size())
+      throw makeError("number of primAttrs (" + std::to_string(attrs.size())
+                      + ") mismatch number of vdbGrids (" + std::to_string(grids.size()) + ")");
+
+    for (size_t g = 0; g < grids.size(); g++)
+      addVDBSampleAttr(prim.get(), attrs[g], grids[g].get());
+
+    auto &pos = prim->attr<vec3f>(sampleby);
+    std::vector<std::unique_ptr<VDBSampleJob>> jobs;
+    for (size_t g = 0; g < grids.size(); g++) {
+      prim->attr_visit(attrs[g], [&] (auto &arr) {
+        if constexpr (is_vdb_to_prim_convertible<std::decay_t<decltype(arr)>>::value)
+          jobs.push_back(makeVDBSampleJob(sampler, pos, arr, grids[g].get(), 0.f, 1.f));
+      });
+    }
+    runVDBSampleJobs(mortonSampleOrder(pos), jobs);
+
+    set_output("prim", std::move(prim));
+  }
+};
+
+ZENDEFNODE(SampleVDBsToPrimitive, {
+                                     {"prim", {"list", "vdbGrids"}, {"string", "sampleBy", "pos"},
+                                      {"string", "primAttrs", "sdf vel"},
+                                      {"enum Linear Quadratic Point", "sampler", "Linear"}},
+                                     {"prim"},
+                                     {},
                                      {"openvdb"},
                                  });
 
@@ -149,21 +301,14 @@ static void primSampleVDB(
         const std::string &dstChannel,
         std::shared_ptr<VDBGrid> grid,
         float remapMin,
-        float remapMax
+        float remapMax,
+        std::string const &sampler = "Linear"
 ) {
     auto &pos = prim->attr<vec3f>(srcChannel);
-    if (dynamic_cast<VDBFloatGrid *>(grid.get())) {
-        prim->add_attr<float>(dstChannel);
-    }
-    else if (dynamic_cast<VDBFloat3Grid *>(grid.get())) {
-        prim->add_attr<vec3f>(dstChannel);
-    }
-    else {
-        throw std::runtime_error("unknown vdb grid type");
-    }
+    addVDBSampleAttr(prim.get(), dstChannel, grid.get());
     prim->attr_visit(dstChannel, [&] (auto &vel) {
         if constexpr (is_vdb_to_prim_convertible<std::decay_t<decltype(vel)>>::value)
-            sampleVDBAttribute2(pos, vel, grid.get(), remapMin, remapMax);
+            sampleVDBAttribute2(pos, vel, grid.get(), remapMin, remapMax, sampler);
     });
 }
 
@@ -175,8 +320,9 @@ struct PrimSample3D : zeno::INode {
         auto srcChannel = get_input2<std::string>("srcChannel");
         auto remapMin = get_input2<float>("remapMin");
         auto remapMax = get_input2<float>("remapMax");
+        auto sampler = get_input2<std::string>("sampler");
 
-        primSampleVDB(prim, srcChannel, dstChannel, grid, remapMin, remapMax);
+        primSampleVDB(prim, srcChannel, dstChannel, grid, remapMin, remapMax, sampler);
         set_output("outPrim", std::move(prim));
     }
 };
@@ -188,6 +334,7 @@ ZENDEFNODE(PrimSample3D, {
         {"string", "dstChannel", "clr"},
         {"float", "remapMin", "0"},
         {"float", "remapMax", "1"},
+        {"enum Linear Quadratic Point", "sampler", "Linear"},
     },
     {
         {"PrimitiveObject", "outPrim"}
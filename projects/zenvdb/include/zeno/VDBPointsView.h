@@ -0,0 +1,234 @@
+#pragma once
+
+#include <zeno/VDBGrid.h>
+#include <zeno/utils/vec.h>
+#include <openvdb/points/PointDataGrid.h>
+#include <openvdb/points/AttributeArray.h>
+#include <openvdb/points/PointMove.h>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstring>
+
+namespace zeno {
+
+template <class T> struct vdb_points_attr_type {};
+template <> struct vdb_points_attr_type<float> { using type = float; };
+template <> struct vdb_points_attr_type<int> { using type = int32_t; };
+template <> struct vdb_points_attr_type<vec3f> { using type = openvdb::Vec3f; };
+
+// Leaf-chunked view over the attributes of a PointDataGrid. Every leaf is one
+// chunk, whose points map to the contiguous range [chunkBegin(i), chunkBegin(i) + chunkSize(i))
+// of the flattened point order (the order VDBPointsToPrimitive produces).
+// Chunks are decoded into caller buffers on demand, so consumers only ever
+// hold one leaf worth of unpacked data per thread, and the position codec
+// (FixedPointCodec in FastFLIP) is decompressed on the fly. The attribute
+// name "P" is exposed in world space.
+struct VDBPointsView {
+    using GridT = openvdb::points::PointDataGrid;
+    using LeafT = GridT::TreeType::LeafNodeType;
+
+    GridT::Ptr grid;
+    std::vector<LeafT *> leaves;
+    std::vector<size_t> offsets;
+
+    explicit VDBPointsView(GridT::Ptr grid_) : grid(std::move(grid_)) {
+        grid->tree().getNodes(leaves);
+        offsets.resize(leaves.size() + 1);
+        offsets[0] = 0;
+        tbb::parallel_for(size_t(0), leaves.size(), [&] (size_t i) {
+            offsets[i + 1] = leaves[i]->onPointCount();
+        });
+        for (size_t i = 0; i < leaves.size(); i++)
+            offsets[i + 1] += offsets[i];
+    }
+
+    size_t size() const {
+        return offsets.back();
+    }
+
+    size_t numChunks() const {
+        return leaves.size();
+    }
+
+    size_t chunkBegin(size_t chunk) const {
+        return offsets[chunk];
+    }
+
+    size_t chunkSize(size_t chunk) const {
+        return offsets[chunk + 1] - offsets[chunk];
+    }
+
+    bool has_attr(std::string const &name) const {
+        return !leaves.empty() && leaves[0]->hasAttribute(name);
+    }
+
+    // attribute names of the grid, together with their zeno attribute type
+    // (0 = float, 1 = int, 2 = vec3f, -1 = unsupported)
+    std::map<std::string, int> attr_types() const {
+        std::map<std::string, int> res;
+        if (leaves.empty())
+            return res;
+        auto const &attrSet = leaves[0]->attributeSet();
+        for (auto const &[name, pos]: attrSet.descriptor().map()) {
+            auto const *arr = attrSet.getConst(pos);
+            if (arr->hasValueType<float>())
+                res[name] = 0;
+            else if (arr->hasValueType<int32_t>())
+                res[name] = 1;
+            else if (arr->hasValueType<openvdb::Vec3f>())
+                res[name] = 2;
+            else
+                res[name] = -1;
+        }
+        return res;
+    }
+
+    template <class T>
+    void read_chunk(size_t chunk, std::string const &name, T *out) const {
+        using ValueT = typename vdb_points_attr_type<T>::type;
+        auto const &leaf = *leaves[chunk];
+        openvdb::points::AttributeHandle<ValueT> handle(leaf.constAttributeArray(name));
+        size_t i = 0;
+        if constexpr (std::is_same_v<T, vec3f>) {
+            if (name == "P") {
+                auto const &xform = grid->transform();
+                for (auto iter = leaf.beginIndexOn(); iter; ++iter) {
+                    auto p = xform.indexToWorld(handle.get(*iter) + iter.getCoord().asVec3d());
+                    out[i++] = vec3f(p[0], p[1], p[2]);
+                }
+                return;
+            }
+        }
+        for (auto iter = leaf.beginIndexOn(); iter; ++iter) {
+            auto v = handle.get(*iter);
+            if constexpr (std::is_same_v<T, vec3f>)
+                out[i++] = vec3f(v[0], v[1], v[2]);
+            else
+                out[i++] = v;
+        }
+    }
+
+    // Returns the number of points of this chunk that moved out of their
+    // voxel; their positions are parked until commit() rebuckets them.
+    template <class T>
+    size_t write_chunk(size_t chunk, std::string const &name, T const *in) {
+        using ValueT = typename vdb_points_attr_type<T>::type;
+        auto &leaf = *leaves[chunk];
+        openvdb::points::AttributeWriteHandle<ValueT> handle(leaf.attributeArray(name));
+        size_t i = 0;
+        if constexpr (std::is_same_v<T, vec3f>) {
+            if (name == "P") {
+                auto const &xform = grid->transform();
+                std::vector<openvdb::Vec3d> moved;
+                size_t escaped = 0;
+                for (auto iter = leaf.beginIndexOn(); iter; ++iter, ++i) {
+                    openvdb::Vec3d wpos(in[i][0], in[i][1], in[i][2]);
+                    auto off = xform.worldToIndex(wpos) - iter.getCoord().asVec3d();
+                    if (std::abs(off[0]) > 0.5 || std::abs(off[1]) > 0.5 || std::abs(off[2]) > 0.5) {
+                        if (moved.empty())
+                            moved.resize(leaf.pointCount(), openvdb::Vec3d(std::numeric_limits<double>::quiet_NaN()));
+                        moved[*iter] = wpos;
+                        escaped++;
+                        continue;
+                    }
+                    handle.set(*iter, openvdb::Vec3f(off));
+                }
+                if (escaped) {
+                    std::lock_guard lck(m_movedMtx);
+                    m_moved.emplace(leaf.origin(), std::move(moved));
+                }
+                return escaped;
+            }
+        }
+        for (auto iter = leaf.beginIndexOn(); iter; ++iter, ++i) {
+            if constexpr (std::is_same_v<T, vec3f>)
+                handle.set(*iter, ValueT(in[i][0], in[i][1], in[i][2]));
+            else
+                handle.set(*iter, ValueT(in[i]));
+        }
+        return 0;
+    }
+
+    // Moves the points that escaped their voxel in write_chunk into their
+    // new leaves. Invalidates the chunk layout of this view.
+    bool commit() {
+        if (m_moved.empty())
+            return false;
+        MovedDeformer deformer{&m_moved};
+        openvdb::points::movePoints(*grid, deformer);
+        m_moved.clear();
+        *this = VDBPointsView(std::move(grid));
+        return true;
+    }
+
+    // f(chunk, begin, count), chunks are dispatched in parallel
+    template <class F>
+    void foreach_chunk(F const &f) const {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, leaves.size()), [&] (auto const &r) {
+            for (size_t c = r.begin(); c != r.end(); c++)
+                f(c, offsets[c], offsets[c + 1] - offsets[c]);
+        });
+    }
+
+    template <class T>
+    void read_all(std::string const &name, T *out) const {
+        foreach_chunk([&] (size_t c, size_t base, size_t) {
+            read_chunk(c, name, out + base);
+        });
+    }
+
+    template <class T>
+    size_t write_all(std::string const &name, T const *in) {
+        std::atomic<size_t> escaped{0};
+        foreach_chunk([&] (size_t c, size_t base, size_t) {
+            escaped += write_chunk(c, name, in + base);
+        });
+        return escaped;
+    }
+
+    VDBPointsView(VDBPointsView &&other)
+        : grid(std::move(other.grid)), leaves(std::move(other.leaves)),
+          offsets(std::move(other.offsets)), m_moved(std::move(other.m_moved)) {}
+
+    VDBPointsView &operator=(VDBPointsView &&other) {
+        grid = std::move(other.grid);
+        leaves = std::move(other.leaves);
+        offsets = std::move(other.offsets);
+        m_moved = std::move(other.m_moved);
+        return *this;
+    }
+
+private:
+    using MovedMap = std::map<openvdb::Coord, std::vector<openvdb::Vec3d>>;
+
+    // world space positions of escaped points, indexed by the point index
+    // within their leaf; NaN marks points that stay where they are
+    struct MovedDeformer {
+        MovedMap const *moved;
+        std::vector<openvdb::Vec3d> const *cur = nullptr;
+
+        template <class LeafT_>
+        void reset(LeafT_ const &leaf, size_t = 0) {
+            auto it = moved->find(leaf.origin());
+            cur = it == moved->end() ? nullptr : &it->second;
+        }
+
+        template <class IndexIterT>
+        void apply(openvdb::Vec3d &position, IndexIterT const &iter) const {
+            if (cur && !std::isnan((*cur)[*iter][0]))
+                position = (*cur)[*iter];
+        }
+    };
+
+    MovedMap m_moved;
+    std::mutex m_movedMtx;
+};
+
+}
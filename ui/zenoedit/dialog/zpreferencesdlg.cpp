@@ -77,12 +77,14 @@ ZenoCachePane::ZenoCachePane(QWidget* parent) : QWidget(parent)
     QVariant varAutoCleanCache = inst.getValue(zsCacheAutoClean);
     QVariant varEnableShiftChangeFOV = inst.getValue(zsEnableShiftChangeFOV);
     QVariant varViewportPointSizeScale = inst.getValue(zsViewportPointSizeScale);
+    QVariant varViewportPreviewLodFaces = inst.getValue(zsViewportPreviewLodFaces);
 
     bool bEnableCache = varEnableCache.isValid() ? varEnableCache.toBool() : false;
     bool bTempCacheDir = varTempCacheDir.isValid() ? varTempCacheDir.toBool() : false;
     QString cacheRootDir = varCacheRoot.isValid() ? varCacheRoot.toString() : "";
     int cacheNum = varCacheNum.isValid() ? varCacheNum.toInt() : 1;
     double viewportPointSizeScale = varViewportPointSizeScale.isValid() ? varViewportPointSizeScale.toDouble() : 1;
+    int viewportPreviewLodFaces = varViewportPreviewLodFaces.isValid() ? varViewportPreviewLodFaces.toInt() : 0;
     bool bAutoCleanCache = varAutoCleanCache.isValid() ? varAutoCleanCache.toBool() : true;
     bool bEnableShiftChangeFOV = varEnableShiftChangeFOV.isValid() ? varEnableShiftChangeFOV.toBool() : true;
 
@@ -117,6 +119,14 @@ ZenoCachePane::ZenoCachePane(QWidget* parent) : QWidget(parent)
     m_pViewportPointSizeScaleSpinBox = new QDoubleSpinBox;
     m_pViewportPointSizeScaleSpinBox->setValue(viewportPointSizeScale);
 
+    //coarse meshes are only sent ahead when objects go straight to the viewport, not through the cache.
+    m_pViewportPreviewLodFacesSpinBox = new QSpinBox;
+    m_pViewportPreviewLodFacesSpinBox->setRange(0, 100000000);
+    m_pViewportPreviewLodFacesSpinBox->setSpecialValueText(tr("Off"));
+    m_pViewportPreviewLodFacesSpinBox->setValue(viewportPreviewLodFaces);
+    m_pViewportPreviewLodFacesSpinBox->setEnabled(!bEnableCache);
+    m_pViewportPreviewLodFacesSpinBox->setToolTip(tr("Show meshes above this many faces coarse first, not used with cache enabled"));
+
     m_pEnableCheckbox = new QCheckBox;
     m_pEnableCheckbox->setCheckState(bEnableCache ? Qt::Checked : Qt::Unchecked);
     connect(m_pEnableCheckbox, &QCheckBox::stateChanged, [=](bool state) {
@@ -131,6 +141,7 @@ ZenoCachePane::ZenoCachePane(QWidget* parent) : QWidget(parent)
         m_pPathEdit->setEnabled(state);
         m_pTempCacheDir->setEnabled(state);
         m_pAutoCleanCache->setEnabled(state && !m_pTempCacheDir->isChecked());
+        m_pViewportPreviewLodFacesSpinBox->setEnabled(!state);
     });
 
     QGridLayout* pLayout = new QGridLayout(this);
@@ -148,6 +159,8 @@ ZenoCachePane::ZenoCachePane(QWidget* parent) : QWidget(parent)
     pLayout->addWidget(m_pEnableShiftChangeFOV, 5, 1);
     pLayout->addWidget(new QLabel(tr("Viewport Point Size scale")), 6, 0);
     pLayout->addWidget(m_pViewportPointSizeScaleSpinBox, 6, 1);
+    pLayout->addWidget(new QLabel(tr("Viewport preview LOD faces")), 7, 0);
+    pLayout->addWidget(m_pViewportPreviewLodFacesSpinBox, 7, 1);
     QSpacerItem* pSpacerItem = new QSpacerItem(10, 10, QSizePolicy::Expanding);
     pLayout->addItem(pSpacerItem, 0, 2, 5);
     pLayout->setAlignment(Qt::AlignLeft | Qt::AlignTop);
@@ -163,6 +176,7 @@ void ZenoCachePane::saveValue()
     inst.setValue(zsCacheAutoClean, m_pAutoCleanCache->checkState() == Qt::Checked);
     inst.setValue(zsEnableShiftChangeFOV, m_pEnableShiftChangeFOV->checkState() == Qt::Checked);
     inst.setValue(zsViewportPointSizeScale, m_pViewportPointSizeScaleSpinBox->value());
+    inst.setValue(zsViewportPreviewLodFaces, m_pViewportPreviewLodFacesSpinBox->value());
 }
 
 //layout pane
@@ -33,6 +33,7 @@ private:
     QCheckBox* m_pEnableCheckbox;
     QSpinBox* m_pCacheNumSpinBox;
     QDoubleSpinBox* m_pViewportPointSizeScaleSpinBox;
+    QSpinBox* m_pViewportPreviewLodFacesSpinBox;
 
     QCheckBox* m_pEnableShiftChangeFOV;
 };
@@ -7,6 +7,7 @@
 #include <zeno/extra/GlobalStatus.h>
 #include <zeno/utils/logger.h>
 #include <zeno/core/Graph.h>
+#include <zeno/funcs/GraphCodec.h>
 #include <zeno/zeno.h>
 #include <zeno/types/StringObject.h>
 #include "zenoapplication.h"
@@ -168,7 +169,11 @@ struct ProgramRunData {
             return;
         }
 
-        g_proc->write(progJson.data(), progJson.size());
+        std::vector<char> progBin;
+        if (zeno::encodeGraphFromJson(progJson.c_str(), progBin))
+            g_proc->write(progBin.data(), progBin.size());
+        else
+            g_proc->write(progJson.data(), progJson.size());
         g_proc->closeWriteChannel();
 
         std::vector<char> buf(1<<20); // 1MB
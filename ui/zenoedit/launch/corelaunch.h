@@ -21,6 +21,8 @@ struct LAUNCH_PARAM {
     QString zsgPath;
     int projectFps = 24;
     QString paramPath;
+    int previewLodFaces = 0;    //heavy meshes are sent simplified to this many faces first, 0 to disable
+    bool keepRunnerAlive = false;   //reuse one runner process across runs, every run still loads and cooks the whole graph
 };
 
 void launchProgram(IGraphsModel *pModel, LAUNCH_PARAM param);
@@ -13,8 +13,15 @@
 #include <zeno/extra/EventCallbacks.h>
 #include <zeno/extra/assetDir.h>
 #include <zeno/funcs/ObjectCodec.h>
+#include <zeno/funcs/GraphCodec.h>
+#include <zeno/funcs/PrimitiveUtils.h>
+#include <zeno/types/PrimitiveObject.h>
 #include <zeno/zeno.h>
 #include <string>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 #ifdef ZENO_IPC_USE_TCP
 #include <QTcpServer>
 #include <QtWidgets>
@@ -86,7 +93,11 @@ static void send_packet(std::string_view info, const char *buf, size_t len) {
 }
 
 static int runner_start(std::string const &progJson, int sessionid, const LAUNCH_PARAM& param) {
-    zeno::log_trace("runner got program JSON: {}", progJson);
+    bool isBinary = zeno::isBinaryGraph(progJson.data(), progJson.size());
+    if (!isBinary)
+        zeno::log_trace("runner got program JSON: {}", progJson);
+    else
+        zeno::log_trace("runner got binary program of {} bytes", progJson.size());
     //MessageBox(0, "runner", "runner", MB_OK);           //convient to attach process by debugger, at windows.
     zeno::scope_exit sp([=]() { std::cout.flush(); });
     //zeno::TimerAtexitHelper timerHelper;
@@ -122,12 +133,16 @@ static int runner_start(std::string const &progJson, int sessionid, const LAUNCH
     };
 
     zeno::GraphException::catched([&] {
-        graph->loadGraph(progJson.c_str());
+        if (isBinary)
+            graph->loadGraphBinary(progJson.data(), progJson.size());
+        else
+            graph->loadGraph(progJson.c_str());
     }, *session->globalStatus);
     if (session->globalStatus->failed())
         return onfail();
 
     std::vector<char> buffer;
+    std::vector<std::string> refineKeys;
 
     session->globalComm->initFrameRange(graph->beginFrameNumber, graph->endFrameNumber);
     send_packet("{\"action\":\"frameRange\",\"key\":\""
@@ -242,12 +257,26 @@ static int runner_start(std::string const &progJson, int sessionid, const LAUNCH
             std::string sLockFile = param.cacheDir.toStdString() + "/" + zeno::iotags::sZencache_lockfile_prefix + std::to_string(frame) + ".lock";
             QLockFile lckFile(QString::fromStdString(sLockFile));
             bool ret = lckFile.tryLock();
-            //dump cache to disk.
+            //dump cache to disk, the ui reads it back as soon as finishFrame arrives.
             session->globalComm->dumpFrameCache(frame, param.applyLightAndCameraOnly, param.applyMaterialOnly);
+            session->globalComm->waitFrameCache(frame);
         } else {
             auto const& viewObjs = session->globalComm->getViewObjects();
             zeno::log_debug("runner got {} view objects", viewObjs.size());
             for (auto const& [key, obj] : viewObjs) {
+                //heavy meshes go out coarse first, the full object follows the frame.
+                auto prim = std::dynamic_pointer_cast<zeno::PrimitiveObject>(obj);
+                if (param.previewLodFaces > 0 && prim && prim->tris.size() > 4 * param.previewLodFaces
+                    && prim->polys.size() == 0 && prim->quads.size() == 0) {
+                    auto lod = zeno::primPreviewLod(prim.get(), param.previewLodFaces);
+                    if (zeno::encodeObject(lod.get(), buffer)) {
+                        send_packet("{\"action\":\"viewObject\",\"key\":\"" + key + kPreviewLodSuffix + "\"}",
+                            buffer.data(), buffer.size());
+                        refineKeys.push_back(key);
+                    }
+                    buffer.clear();
+                    continue;
+                }
                 if (zeno::encodeObject(obj.get(), buffer))
                     send_packet("{\"action\":\"viewObject\",\"key\":\"" + key + "\"}",
                         buffer.data(), buffer.size());
@@ -257,26 +286,21 @@ static int runner_start(std::string const &progJson, int sessionid, const LAUNCH
 
         send_packet("{\"action\":\"finishFrame\",\"key\":\"" + std::to_string(frame) + "\"}", "", 0);
 
+        for (auto const& key : refineKeys) {
+            if (zeno::encodeObject(session->globalComm->getViewObjects().m_curr.at(key).get(), buffer))
+                send_packet("{\"action\":\"refineObject\",\"key\":\"" + key + "\"}",
+                    buffer.data(), buffer.size());
+            buffer.clear();
+        }
+        refineKeys.clear();
+
         if (session->globalStatus->failed())
             return onfail();
     }
     return 0;
 }
 
-}
-int runner_main(const QCoreApplication& app);
-int runner_main(const QCoreApplication& app) {
-    //MessageBox(0, "runner", "runner", MB_OK);           //convient to attach process by debugger, at windows.
-
-#ifdef __linux__
-    stderr = freopen("/dev/stdout", "w", stderr);
-#endif
-    LAUNCH_PARAM param;
-    int sessionid = 0;
-    int port = -1;
-    std::string objcachedir = "";
-    QCommandLineParser cmdParser;
-    cmdParser.addHelpOption();
+static void addRunnerOptions(QCommandLineParser &cmdParser) {
     cmdParser.addOptions({
         {"runner", "runner", "runner"},
         {"sessionid", "sessionid", "sessionid"},
@@ -291,8 +315,12 @@ int runner_main(const QCoreApplication& app) {
         {"projectFps", "current project fps", "fps"},
         {"objcachedir", "objcachedir", "obj temp cache dir"},
         {"generator", "generator", "the node ident which trigger generate command"},
+        {"previewlod", "previewlod", "send heavy meshes simplified to this many faces before the full ones"},
+        {"daemon", "daemon", "stay alive and read one run request after another from stdin"},
         });
-    cmdParser.process(app);
+}
+
+static void readRunnerOptions(QCommandLineParser const &cmdParser, LAUNCH_PARAM &param, int &sessionid, int &port) {
     if (cmdParser.isSet("sessionid"))
         sessionid = cmdParser.value("sessionid").toInt();
     if (cmdParser.isSet("port"))
@@ -317,6 +345,72 @@ int runner_main(const QCoreApplication& app) {
         param.projectFps = cmdParser.value("projectFps").toInt();
     if (cmdParser.isSet("generator"))
         param.generator = cmdParser.value("generator");
+    if (cmdParser.isSet("previewlod"))
+        param.previewLodFaces = cmdParser.value("previewlod").toInt();
+    if (cmdParser.isSet("daemon"))
+        param.keepRunnerAlive = cmdParser.value("daemon").toInt();
+}
+
+static bool readExact(char *buf, size_t len) {
+    return std::cin.read(buf, len).gcount() == (std::streamsize)len;
+}
+
+//daemon request, sync with ZTcpServer::sendRunRequest:
+//  "ZRUN" | uint64 argsLen | uint64 progLen | args, one per line | program
+static int runner_daemon(int sessionid, LAUNCH_PARAM param) {
+    std::string progJson = "";
+    std::string args = "";
+    while (true) {
+        char magic[4];
+        uint64_t lens[2];
+        if (!readExact(magic, 4))
+            return 0;   //editor closed the pipe, normal shutdown
+        if (std::memcmp(magic, "ZRUN", 4) || !readExact((char *)lens, sizeof(lens))) {
+            zeno::log_error("runner daemon got a malformed request");
+            return 1;
+        }
+        args.resize(lens[0]);
+        progJson.resize(lens[1]);
+        if (!readExact(args.data(), args.size()) || !readExact(progJson.data(), progJson.size())) {
+            zeno::log_error("runner daemon got a truncated request");
+            return 1;
+        }
+
+        LAUNCH_PARAM runParam = param;
+        QCommandLineParser cmdParser;
+        addRunnerOptions(cmdParser);
+        QStringList argList = QString::fromStdString(args).split("\n");
+        argList.prepend("zenoedit");
+        if (!cmdParser.parse(argList))
+            zeno::log_warn("runner daemon: {}", cmdParser.errorText().toStdString());
+        int port = -1;
+        readRunnerOptions(cmdParser, runParam, sessionid, port);
+
+        zeno::log_debug("runner daemon starts run of session {}", sessionid);
+        //a failed run leaves the graph in an unknown state: quit and let the editor respawn us.
+        if (int ret = runner_start(progJson, sessionid, runParam))
+            return ret;
+        send_packet("{\"action\":\"runFinished\"}", "", 0);
+    }
+}
+
+}
+int runner_main(const QCoreApplication& app);
+int runner_main(const QCoreApplication& app) {
+    //MessageBox(0, "runner", "runner", MB_OK);           //convient to attach process by debugger, at windows.
+
+#ifdef __linux__
+    stderr = freopen("/dev/stdout", "w", stderr);
+#endif
+    LAUNCH_PARAM param;
+    int sessionid = 0;
+    int port = -1;
+    std::string objcachedir = "";
+    QCommandLineParser cmdParser;
+    cmdParser.addHelpOption();
+    addRunnerOptions(cmdParser);
+    cmdParser.process(app);
+    readRunnerOptions(cmdParser, param, sessionid, port);
 
     std::cerr.rdbuf(std::cout.rdbuf());
     std::clog.rdbuf(std::cout.rdbuf());
@@ -340,6 +434,16 @@ int runner_main(const QCoreApplication& app) {
 
     zeno::log_debug("runner started on sessionid={}", sessionid);
 
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);  // the program may come in binary graph form
+#endif
+    if (param.keepRunnerAlive) {
+#ifdef ZENO_IPC_USE_TCP
+        zeno::getSession().eventCallbacks->triggerEvent("preRunnerStart");
+#endif
+        return runner_daemon(sessionid, param);
+    }
+
     std::string progJson;
     std::istreambuf_iterator<char> iit(std::cin.rdbuf()), eiit;
     std::back_insert_iterator<std::string> sit(progJson);
@@ -87,6 +87,18 @@ struct PacketProc {
             clearGlobalIfNeeded();
             zeno::getSession().globalComm->addViewObject(objKey, object);
 
+        } else if (action == "refineObject") {
+            auto object = zeno::decodeObject(buf, len);
+            if (!object) {
+                zeno::log_warn("failed to decode refined object");
+                return false;
+            }
+            if (!zeno::getSession().globalComm->replaceViewObject(objKey + kPreviewLodSuffix, objKey, object))
+                return true;
+            auto mainWin = zenoApp->getMainWindow();
+            if (mainWin)
+                mainWin->updateViewport("");
+
         } else if (action == "newFrame") {
             globalCommNeedNewFrame = 1;
             clearGlobalIfNeeded();
@@ -178,6 +190,12 @@ struct PacketProc {
                 }
             }
 
+        } else if (action == "runFinished") {
+            //a runner kept alive ends each run with this packet instead of exiting.
+            ZTcpServer* pServer = zenoApp->getServer();
+            if (pServer)
+                pServer->onRunFinished();
+
         } else if (action == "reportStatus") {
             std::string statJson{buf, len};
             zeno::getSession().globalStatus->fromJson(statJson);
@@ -3,6 +3,9 @@
 #ifdef ZENO_MULTIPROCESS
 #include <cstddef>
 
+// key postfix of the coarse preview sent ahead of a heavy mesh
+constexpr const char *kPreviewLodSuffix = ":lod";
+
 void viewDecodeClear();
 void viewDecodeAppend(const char *buf, size_t n);
 void viewDecodeSetFrameCache(const char *path, int gcmax);
@@ -4,6 +4,7 @@
 #include "ztcpserver.h"
 #include <zeno/extra/GlobalState.h>
 #include <zeno/extra/GlobalComm.h>
+#include <zeno/funcs/GraphCodec.h>
 #include <zeno/utils/log.h>
 #include <QMessageBox>
 #include <zeno/zeno.h>
@@ -28,6 +29,7 @@ ZTcpServer::ZTcpServer(QObject *parent)
     , m_optixServer(nullptr)
     , m_port(0)
     , m_tcpSocket(nullptr)
+    , m_bRunnerBusy(false)
 {
 }
 
@@ -69,19 +71,22 @@ void ZTcpServer::init(const QHostAddress& address)
 void ZTcpServer::startProc(const std::string& progJson, LAUNCH_PARAM param)
 {
     ZASSERT_EXIT(m_tcpServer);
+    //a warm runner needs a main window to report the end of each run.
+    bool bKeepAlive = param.keepRunnerAlive && zenoApp->getMainWindow();
     if (m_proc && m_proc->isOpen())
     {
-        zeno::log_info("background process already running");
-        return;
+        if (m_bRunnerBusy || m_proc->arguments().indexOf("--daemon") < 0)
+        {
+            zeno::log_info("background process already running");
+            return;
+        }
+        if (!bKeepAlive)
+            killProc();
     }
 
     zeno::log_info("launching program...");
     zeno::log_debug("program JSON: {}", progJson);
 
-    m_proc = std::make_unique<QProcess>();
-    m_proc->setInputChannelMode(QProcess::InputChannelMode::ManagedInputChannel);
-    m_proc->setReadChannel(QProcess::ProcessChannel::StandardOutput);
-    m_proc->setProcessChannelMode(QProcess::ProcessChannelMode::ForwardedErrorChannel);
     int sessionid = zeno::getSession().globalState->sessionid;
 
     QString cachedir;
@@ -130,21 +135,53 @@ void ZTcpServer::startProc(const std::string& progJson, LAUNCH_PARAM param)
         "--zsg", param.zsgPath,
         "--projectFps", QString::number(param.projectFps),
         "--objcachedir", zenoApp->cacheMgr()->objCachePath(),
-        "--generator", param.generator
+        "--generator", param.generator,
+        "--previewlod", QString::number(param.previewLodFaces)
     };
 
-    m_proc->start(QCoreApplication::applicationFilePath(), args);
-
-    if (!m_proc->waitForStarted(-1)) {
-        zeno::log_warn("process failed to get started, giving up");
-        return;
+    if (m_proc)
+    {
+        //the warm runner is idle and keeps its tcp connection, so no new one will clear the decoder.
+        viewDecodeClear();
+        sendRunRequest(args, progJson);
+        m_bRunnerBusy = true;
     }
+    else
+    {
+        m_proc = std::make_unique<QProcess>();
+        m_proc->setInputChannelMode(QProcess::InputChannelMode::ManagedInputChannel);
+        m_proc->setReadChannel(QProcess::ProcessChannel::StandardOutput);
+        m_proc->setProcessChannelMode(QProcess::ProcessChannelMode::ForwardedErrorChannel);
+
+        QStringList procArgs = args;
+        if (bKeepAlive)
+            procArgs << "--daemon" << "1";
+        m_proc->start(QCoreApplication::applicationFilePath(), procArgs);
+
+        if (!m_proc->waitForStarted(-1)) {
+            zeno::log_warn("process failed to get started, giving up");
+            m_proc = nullptr;
+            return;
+        }
 
-    m_proc->write(progJson.data(), progJson.size());
-    m_proc->closeWriteChannel();
+        if (bKeepAlive)
+        {
+            sendRunRequest(args, progJson);
+            m_bRunnerBusy = true;
+        }
+        else
+        {
+            std::vector<char> progBin;
+            if (zeno::encodeGraphFromJson(progJson.c_str(), progBin))
+                m_proc->write(progBin.data(), progBin.size());
+            else
+                m_proc->write(progJson.data(), progJson.size());
+            m_proc->closeWriteChannel();
+        }
 
-    connect(m_proc.get(), SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(onProcFinished(int, QProcess::ExitStatus)));
-    connect(m_proc.get(), SIGNAL(readyRead()), this, SLOT(onProcPipeReady()));
+        connect(m_proc.get(), SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(onProcFinished(int, QProcess::ExitStatus)));
+        connect(m_proc.get(), SIGNAL(readyRead()), this, SLOT(onProcPipeReady()));
+    }
     if (ZenoMainWindow* mainwin = zenoApp->getMainWindow())
         emit zenoApp->getMainWindow()->runStarted();
 #ifdef ZENO_OPTIX_PROC
@@ -153,6 +190,33 @@ void ZTcpServer::startProc(const std::string& progJson, LAUNCH_PARAM param)
 #endif
 }
 
+//sync with runner_daemon in runnermain.cpp
+void ZTcpServer::sendRunRequest(const QStringList& args, const std::string& progJson)
+{
+    ZASSERT_EXIT(m_proc);
+    std::vector<char> progBin;
+    if (!zeno::encodeGraphFromJson(progJson.c_str(), progBin))
+        progBin.assign(progJson.begin(), progJson.end());
+    QByteArray argBytes = args.join('\n').toUtf8();
+    quint64 lens[2] = {(quint64)argBytes.size(), (quint64)progBin.size()};
+    m_proc->write("ZRUN", 4);
+    m_proc->write((const char*)lens, sizeof(lens));
+    m_proc->write(argBytes);
+    m_proc->write(progBin.data(), progBin.size());
+}
+
+void ZTcpServer::onRunFinished()
+{
+    m_bRunnerBusy = false;
+    viewDecodeFinish();
+
+    auto mainWin = zenoApp->getMainWindow();
+    if (mainWin)
+        emit mainWin->runFinished();
+    else
+        emit runFinished();
+}
+
 void ZTcpServer::startOptixCmd(const ZENO_RECORD_RUN_INITPARAM& param)
 {
     zeno::log_info("launching optix program...");
@@ -344,6 +408,7 @@ void ZTcpServer::startOptixProc()
 
 void ZTcpServer::killProc()
 {
+    m_bRunnerBusy = false;
     if (m_proc) {
         m_proc->kill();
         m_proc = nullptr;
@@ -420,6 +485,7 @@ void ZTcpServer::onDisconnect()
 
 void ZTcpServer::onProcFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
+    m_bRunnerBusy = false;
     if (exitStatus == QProcess::NormalExit)
     {
         if (m_proc)
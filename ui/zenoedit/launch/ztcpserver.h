@@ -24,6 +24,7 @@ public:
     void onFrameFinished(const QString& action, const QString& keyObj);
     void onInitFrameRange(const QString& action, int frameStart, int frameEnd);
     void onClearFrameState();
+    void onRunFinished();
 
 signals:
     void runFinished();
@@ -41,6 +42,7 @@ private:
     void sendCacheRenderInfoToOptix(const QString& finalCachePath, int cacheNum, bool applyLightAndCameraOnly, bool applyMaterialOnly);
     void dispatchPacketToOptix(const QString& info);
     void initializeNewOptixProc();
+    void sendRunRequest(const QStringList& args, const std::string& progJson);
 
     QTcpServer* m_tcpServer;
     QTcpSocket* m_tcpSocket;
@@ -50,6 +52,7 @@ private:
 
     std::vector<std::unique_ptr<QProcess>> m_optixProcs;
     int m_port;
+    bool m_bRunnerBusy;     //only meaningful for a runner kept alive between runs
 };
 
 #endif
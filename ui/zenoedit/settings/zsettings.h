@@ -19,6 +19,8 @@ const char* const zsCacheNum = "zencachenum";
 const char* const zsCacheAutoClean = "zencache-autoclean";
 const char* const zsEnableShiftChangeFOV = "viewport-EnableShiftChangeFOV";
 const char* const zsViewportPointSizeScale = "viewport-PointSizeScale";
+const char* const zsViewportPreviewLodFaces = "viewport-PreviewLodFaces";
+const char* const zsRunnerKeepAlive = "runner-KeepAlive";
 const char* const zsSubgraphType = "SubgraphType";
 
 //short cut
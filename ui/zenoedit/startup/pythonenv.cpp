@@ -2,7 +2,9 @@
 #include <Python.h>
 #include <QtWidgets>
 #include "zeno/utils/log.h"
+#include "zeno/utils/scope_exit.h"
 #include "zeno/zeno.h"
+#include "zeno/extra/EventCallbacks.h"
 #include "pythonenv.h"
 
 PyMODINIT_FUNC PyInit_zeno(void);
@@ -13,6 +15,8 @@ PyMODINIT_FUNC PyInit_zeno(void);
 #define ZENO_PYTHON_DLL_FILE "libzeno.so"
 #endif
 
+static PyThreadState* mainThreadState = nullptr;
+
 static std::wstring s2ws(std::string const& s) {
     std::wstring ws(s.size(), L' '); // Overestimate number of code points.
     ws.resize(std::mbstowcs(ws.data(), s.data(), s.size())); // Shrink to fit.
@@ -41,6 +45,18 @@ void initPythonEnv(const char* progName)
 
     Py_Initialize();
 
+    // nodes run Python on worker threads too, they take the GIL through PyGILGuard
+    zeno::scope_exit releaseGIL = [] {
+        mainThreadState = PyEval_SaveThread();
+    };
+    zeno::getSession().eventCallbacks->hookEvent("exit", [] {
+        if (!mainThreadState)
+            return;
+        PyEval_RestoreThread(mainThreadState);
+        mainThreadState = nullptr;
+        Py_Finalize();
+    });
+
     PyObject* pmodule = PyImport_ImportModule("zeno");
     if (!pmodule) {
         PyErr_Print();
@@ -1,5 +1,6 @@
 #ifdef ZENO_WITH_PYTHON3
 #include <Python.h>
+#include <zeno/extra/PyGIL.h>
 #endif
 #include "apphelper.h"
 #include <zenomodel/include/modeldata.h>
@@ -394,6 +395,8 @@ void AppHelper::initLaunchCacheParam(LAUNCH_PARAM& param)
     param.cacheDir = settings.value("zencachedir").isValid() ? settings.value("zencachedir").toString() : "";
     param.cacheNum = settings.value("zencachenum").isValid() ? settings.value("zencachenum").toInt() : 1;
     param.autoCleanCacheInCacheRoot = settings.value("zencache-autoclean").isValid() ? settings.value("zencache-autoclean").toBool() : true;
+    param.previewLodFaces = settings.value(zsViewportPreviewLodFaces).isValid() ? settings.value(zsViewportPreviewLodFaces).toInt() : 0;
+    param.keepRunnerAlive = settings.value(zsRunnerKeepAlive).isValid() ? settings.value(zsRunnerKeepAlive).toBool() : false;
 }
 
 bool AppHelper::openZsgAndRun(const ZENO_RECORD_RUN_INITPARAM& param, LAUNCH_PARAM launchParam)
@@ -537,6 +540,7 @@ sys.stdout = catchOutErr\n\
 sys.stderr = catchOutErr\n\
 "; //this is python code to redirect stdouts/stderr
 
+    zeno::PyGILGuard gil;
     //Py_Initialize();
     PyObject* pModule = PyImport_AddModule("__main__"); //create main module
     PyRun_SimpleString(stdOutErr.c_str()); //invoke code to redirect
@@ -9,6 +9,7 @@
 #include <memory>
 #include <string>
 #include <set>
+#include <vector>
 #include <any>
 #include <map>
 
@@ -20,10 +21,24 @@ struct DirtyChecker;
 struct INode;
 
 struct Context {
-    std::set<std::string> visited;
+    std::vector<bool> visited;  // indexed by INode::nodeIndex, cheap to copy per loop iteration
+
+    inline bool isVisited(size_t nodeIndex) const {
+        return nodeIndex < visited.size() && visited[nodeIndex];
+    }
+
+    inline void setVisited(size_t nodeIndex) {
+        if (nodeIndex >= visited.size())
+            visited.resize(nodeIndex + 1);
+        visited[nodeIndex] = true;
+    }
 
     inline void mergeVisited(Context const &other) {
-        visited.insert(other.visited.begin(), other.visited.end());
+        if (other.visited.size() > visited.size())
+            visited.resize(other.visited.size());
+        for (size_t i = 0; i < other.visited.size(); i++)
+            if (other.visited[i])
+                visited[i] = true;
     }
 
     ZENO_API Context();
@@ -37,6 +52,7 @@ struct Graph : std::enable_shared_from_this<Graph> {
 
     std::map<std::string, std::unique_ptr<INode>> nodes;
     std::set<std::string> nodesToExec;
+    size_t numNodeIndices = 0;  // dense ids handed out to INode::nodeIndex
     int beginFrameNumber = 0, endFrameNumber = 0;  // only use by runnermain.cpp
 
     std::map<std::string, std::string> portalIns;
@@ -63,6 +79,7 @@ struct Graph : std::enable_shared_from_this<Graph> {
     ZENO_API Graph *addSubnetNode(std::string const &id);
     ZENO_API Graph *getSubnetGraph(std::string const &id) const;
     ZENO_API bool applyNode(std::string const &id);
+    ZENO_API bool applyNode(INode *node);
     ZENO_API void completeNode(std::string const &id);
     ZENO_API void bindNodeInput(std::string const &dn, std::string const &ds,
         std::string const &sn, std::string const &ss);
@@ -71,9 +88,18 @@ struct Graph : std::enable_shared_from_this<Graph> {
     ZENO_API void setKeyFrame(std::string const &id, std::string const &par, zany const &val);
     ZENO_API void setFormula(std::string const &id, std::string const &par, zany const &val);
     ZENO_API void addNodeOutput(std::string const &id, std::string const &par);
+    // same as above, for loaders that already looked the node up
+    ZENO_API void bindNodeInput(INode *node, std::string const &ds,
+        std::string const &sn, std::string const &ss);
+    ZENO_API void setNodeInput(INode *node, std::string const &par, zany const &val);
+    ZENO_API void setKeyFrame(INode *node, std::string const &par, zany const &val);
+    ZENO_API void setFormula(INode *node, std::string const &par, zany const &val);
+    ZENO_API void addNodeOutput(INode *node, std::string const &par);
+    ZENO_API void setTempCache(INode *node);
     ZENO_API zany const &getNodeOutput(std::string const &sn, std::string const &ss) const;
     ZENO_API zany getNodeInput(std::string const &sn, std::string const &ss) const;
     ZENO_API void loadGraph(const char *json);
+    ZENO_API void loadGraphBinary(const char *buf, size_t len);
     ZENO_API void setNodeParam(std::string const &id, std::string const &par,
         std::variant<int, float, std::string, zany> const &val);  /* to be deprecated */
     ZENO_API std::map<std::string, zany> callSubnetNode(std::string const &id,
@@ -9,6 +9,7 @@
 #include <string>
 #include <set>
 #include <map>
+#include <vector>
 #include <zeno/types/CurveObject.h>
 #include <zeno/extra/GlobalState.h>
 
@@ -36,6 +37,22 @@ public:
 
     bool bTmpCache = false;
 
+    // Interned view of the sockets above, resolved once per layout so the
+    // per-apply path compares no strings. Whoever replaces or erases entries
+    // of `inputs`/`outputs`/`inputBounds` must call invalidateSockets().
+    struct ResolvedInput {
+        std::string const *name;         // key in inputBounds
+        zany *slot;                      // entry of inputs receiving the value
+        INode *srcNode;
+        std::string const *srcSocket;
+        zany const *srcOutput = nullptr; // entry of srcNode->outputs, found lazily
+        unsigned srcEpoch = 0;
+    };
+    std::vector<ResolvedInput> resolvedInputs;
+    unsigned socketEpoch = 0;
+    bool socketsResolved = false;
+    size_t nodeIndex = (size_t)-1;       // dense id within graph, see Graph::applyNode
+
     ZENO_API INode();
     ZENO_API virtual ~INode();
 
@@ -55,8 +72,12 @@ protected:
     ZENO_API virtual void complete();
     ZENO_API virtual void apply() = 0;
 
+    ZENO_API void resolveSockets();
+    ZENO_API bool requireResolvedInput(ResolvedInput &in);
+
 public:
     ZENO_API bool requireInput(std::string const &ds);
+    ZENO_API void invalidateSockets();
 
     ZENO_API virtual void preApply();
 
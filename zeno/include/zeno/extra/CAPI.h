@@ -5,6 +5,11 @@
 
 #include <cstring>
 #include <set>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
 #include <stdexcept>
 #include <memory>
 
@@ -85,6 +90,15 @@ ZENO_CAPI Zeno_Error Zeno_InvokeObjectFactory(Zeno_Object *objectRet_, const cha
 ZENO_CAPI Zeno_Error Zeno_InvokeObjectDefactory(Zeno_Object object_, const char *typeName_, void **ffiObjRet_) ZENO_CAPI_NOEXCEPT;
 ZENO_CAPI Zeno_Error Zeno_InvokeCFunctionPtr(void *ffiObjArg_, const char *typeName_, void **ffiObjRet_) ZENO_CAPI_NOEXCEPT;
 
+// batched calls, one crossing for count_ objects; values_ holds count_ * dim_ scalars
+ZENO_CAPI Zeno_Error Zeno_CreateObjectsInt(Zeno_Object *objectsRet_, const int *values_, size_t dim_, size_t count_) ZENO_CAPI_NOEXCEPT;
+ZENO_CAPI Zeno_Error Zeno_CreateObjectsFloat(Zeno_Object *objectsRet_, const float *values_, size_t dim_, size_t count_) ZENO_CAPI_NOEXCEPT;
+ZENO_CAPI Zeno_Error Zeno_GetObjectsInt(const Zeno_Object *objects_, int *values_, size_t dim_, size_t count_) ZENO_CAPI_NOEXCEPT;
+ZENO_CAPI Zeno_Error Zeno_GetObjectsFloat(const Zeno_Object *objects_, float *values_, size_t dim_, size_t count_) ZENO_CAPI_NOEXCEPT;
+ZENO_CAPI Zeno_Error Zeno_DestroyObjects(const Zeno_Object *objects_, size_t count_) ZENO_CAPI_NOEXCEPT;
+// all attributes of a primitive member array at once, pass null arrays to query the count first
+ZENO_CAPI Zeno_Error Zeno_GetObjectPrimDataAll(Zeno_Object object_, Zeno_PrimMembType primArrType_, size_t *countRet_, const char **keysRet_, void **ptrsRet_, size_t *lensRet_, Zeno_PrimDataType *typesRet_) ZENO_CAPI_NOEXCEPT;
+
 enum ZS_DataType {
     ZS_DataType_int = 0,
     ZS_DataType_float,
@@ -100,65 +114,146 @@ ZENO_CAPI Zeno_Error ZS_GetObjectZsVecData(Zeno_Object object_, void **ptrRet_,
 
 namespace PyZeno
 {
+// Handle table shared by all threads calling into the C API. A handle packs
+// the slot index in its low 32 bits and the slot generation in its high 32
+// bits, so a destroyed handle is rejected even after its slot is reused.
+// Slots are spread over shards by the object address, each with its own
+// lock; a shard also maps the address back to its slot so that creating a
+// handle for an object already in the table only bumps its reference count.
 template <class T>
 class LUT {
-    std::map<std::shared_ptr<T>, uint32_t> lut;
+    static constexpr uint32_t kShards = 16;
+
+    struct Slot {
+        std::shared_ptr<T> ptr;
+        uint32_t refcnt = 0;
+        uint32_t gen = 1;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mtx;
+        std::deque<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        std::unordered_map<T *, uint32_t> slotOf;
+    };
+
+    Shard shards[kShards];
+
+    static uint32_t shardOf(T *raw_p) {
+        auto h = reinterpret_cast<uintptr_t>(raw_p);
+        return static_cast<uint32_t>((h >> 4) ^ (h >> 12)) % kShards;
+    }
+
+    static uint64_t makeKey(uint32_t shard, uint32_t slot, uint32_t gen) {
+        return static_cast<uint64_t>(gen) << 32 | (static_cast<uint64_t>(slot) * kShards + shard);
+    }
+
+    [[noreturn]] static void throwInvalid(uint64_t key) {
+        throw zeno::makeError<zeno::KeyError>(std::to_string(key), zeno::cppdemangle(typeid(T)));
+    }
+
+    // locates the live slot of a key, the caller holds the shard lock
+    static Slot *findSlot(Shard const &sh, uint64_t key) {
+        uint32_t slot = static_cast<uint32_t>(key) / kShards;
+        if (ZENO_UNLIKELY(slot >= sh.slots.size()))
+            return nullptr;
+        auto &s = const_cast<Slot &>(sh.slots[slot]);
+        if (ZENO_UNLIKELY(s.refcnt == 0 || s.gen != static_cast<uint32_t>(key >> 32)))
+            return nullptr;
+        return &s;
+    }
 
 public:
     uint64_t create(std::shared_ptr<T> p) {
         T *raw_p = p.get();
-        auto [it, succ] = lut.emplace(std::move(p), 0);
-        ++it->second;
-        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(raw_p));
+        uint32_t shard = shardOf(raw_p);
+        auto &sh = shards[shard];
+        std::unique_lock lck(sh.mtx);
+        auto [it, succ] = sh.slotOf.emplace(raw_p, 0);
+        if (!succ) {
+            auto &s = sh.slots[it->second];
+            ++s.refcnt;
+            return makeKey(shard, it->second, s.gen);
+        }
+        uint32_t slot;
+        if (!sh.freeSlots.empty()) {
+            slot = sh.freeSlots.back();
+            sh.freeSlots.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(sh.slots.size());
+            sh.slots.emplace_back();
+        }
+        it->second = slot;
+        auto &s = sh.slots[slot];
+        s.ptr = std::move(p);
+        s.refcnt = 1;
+        return makeKey(shard, slot, s.gen);
     }
 
-    std::shared_ptr<T> const &access(uint64_t key) const {
-        T *raw_p = reinterpret_cast<T *>(static_cast<uint64_t>(key));
-        auto it = lut.find(make_stale_shared(raw_p));
-        if (ZENO_UNLIKELY(it == lut.end()))
-            throw zeno::makeError<zeno::KeyError>(std::to_string(key), zeno::cppdemangle(typeid(T)));
-        return it->first;
+    std::shared_ptr<T> access(uint64_t key) const {
+        auto &sh = shards[static_cast<uint32_t>(key) % kShards];
+        std::shared_lock lck(sh.mtx);
+        auto s = findSlot(sh, key);
+        if (ZENO_UNLIKELY(!s))
+            throwInvalid(key);
+        return s->ptr;
     }
 
     void destroy(uint64_t key) {
-        T *raw_p = reinterpret_cast<T *>(static_cast<uint64_t>(key));
-        auto it = lut.find(make_stale_shared(raw_p));
-        if (ZENO_UNLIKELY(it == lut.end()))
-            throw zeno::makeError<zeno::KeyError>(std::to_string(key), zeno::cppdemangle(typeid(T)));
-        if (--it->second <= 0)
-            lut.erase(it);
+        std::shared_ptr<T> last;   // released after unlocking, destructors may call back into the table
+        auto &sh = shards[static_cast<uint32_t>(key) % kShards];
+        {
+            std::unique_lock lck(sh.mtx);
+            auto s = findSlot(sh, key);
+            if (ZENO_UNLIKELY(!s))
+                throwInvalid(key);
+            if (--s->refcnt > 0)
+                return;
+            sh.slotOf.erase(s->ptr.get());
+            last = std::move(s->ptr);
+            if (++s->gen == 0)
+                s->gen = 1;
+            sh.freeSlots.push_back(static_cast<uint32_t>(key) / kShards);
+        }
     }
 };
 
+// Error state of the last C API call, kept per calling thread.
 class LastError {
-    uint32_t errcode;
-    std::string message;
+    struct State {
+        uint32_t errcode = 0;
+        std::string message;
+    };
+
+    ZENO_API static State &state() noexcept;
 
 public:
     template <class Func>
     uint32_t catched(Func const &func) noexcept {
-        errcode = 0;
-        message.clear();
+        auto &st = state();
+        st.errcode = 0;
+        st.message.clear();
         try {
             func();
         } catch (std::exception const &e) {
-            errcode = 1;
-            message = e.what();
-            zeno::log_debug("Zeno API catched error: {}", message);
+            st.errcode = 1;
+            st.message = e.what();
+            zeno::log_debug("Zeno API catched error: {}", st.message);
         } catch (...) {
-            errcode = 1;
-            message = "(unknown)";
+            st.errcode = 1;
+            st.message = "(unknown)";
             zeno::log_debug("Zeno API catched unknown error");
         }
-        return errcode;
+        return st.errcode;
     }
 
     const char *what() noexcept {
-        return message.empty() ? "(success)" : message.c_str();
+        auto &st = state();
+        return st.message.empty() ? "(success)" : st.message.c_str();
     }
 
     uint32_t code() noexcept {
-        return errcode;
+        return state().errcode;
     }
 };
 
@@ -166,21 +261,40 @@ extern LUT<zeno::Session> lutSession;
 extern LUT<zeno::Graph> lutGraph;
 extern LUT<zeno::IObject> lutObject;
 extern LastError lastError;
-extern std::map<std::string, std::shared_ptr<zeno::IObject>> tempNodeRes;
-extern std::shared_ptr<zeno::Graph> currentGraph;
+extern thread_local std::map<std::string, std::shared_ptr<zeno::IObject>> tempNodeRes;
+
+// Functions looked up by type name. Modules mostly register during static
+// initialisation, but may also do so lazily while other threads call in.
+template <class Func>
+class FuncRegistry {
+    std::map<std::string, Func> impl;
+    mutable std::shared_mutex mtx;
+
+public:
+    void add(std::string const &name, Func func) {
+        std::unique_lock lck(mtx);
+        impl.emplace(name, func);
+    }
+
+    Func find(std::string const &name) const {
+        std::shared_lock lck(mtx);
+        auto it = impl.find(name);
+        return it != impl.end() ? it->second : nullptr;
+    }
+};
 
 static auto &getObjFactory() {
-    static std::map<std::string, Zeno_Object (*)(void *)> impl;
+    static FuncRegistry<Zeno_Object (*)(void *)> impl;
     return impl;
 }
 
 static auto &getObjDefactory() {
-    static std::map<std::string, void *(*)(Zeno_Object)> impl;
+    static FuncRegistry<void *(*)(Zeno_Object)> impl;
     return impl;
 }
 
 static auto &getCFuncPtrs() {
-    static std::map<std::string, void *(*)(void *)> impl;
+    static FuncRegistry<void *(*)(void *)> impl;
     return impl;
 }    
 }
\ No newline at end of file
@@ -36,12 +36,58 @@ struct GlobalComm {
     std::string cacheFramePath;
     std::string objTmpCachePath;
 
+    // playback prefetch: decode up to `prefetchFrames` frames ahead of the
+    // play head on background threads; resident frames are bounded by
+    // `maxCachedBytes` (0 falls back to the `maxCachedFrames` count).
+    // Off unless ZENO_PREFETCH_FRAMES or framePrefetch() sets it.
+    int prefetchFrames = 0;
+    size_t maxCachedBytes = 0;
+    std::map<int, size_t> m_frameBytes;
+    size_t m_cachedBytes = 0;
+    int m_lastLoadFrame = -1;
+    int m_playDirection = 0;
+
+    // dumped frames stay resident while a background thread writes them out;
+    // eviction prefers big frames that were not touched for long.
+    struct CacheStats {
+        size_t hits = 0;            // frame was resident (or still being written) when loaded
+        size_t misses = 0;          // frame had to be read back from disk
+        size_t prefetched = 0;      // frames read ahead by the prefetcher
+        size_t evictions = 0;
+        size_t writes = 0;          // frames written by the background writer
+        size_t bytesWritten = 0;
+        size_t residentFrames = 0;
+        size_t residentBytes = 0;
+        size_t pendingWrites = 0;
+    };
+    CacheStats m_stats;
+    std::map<int, size_t> m_frameTouch;  // access tick of each resident frame
+    size_t m_touchTick = 0;
+
+    // blobs shared between frames on disk, deleted by the writer once no frame refers to them
+    std::map<int, std::vector<std::string>> m_frameBlobs;
+    std::map<std::string, int> m_blobRefs;
+    std::set<std::string> m_blobGarbage;
+    std::set<std::string> m_foreignBlobs;  // found in the dir on open, frames of an earlier session may refer to them
+
+    ZENO_API GlobalComm();
+    ZENO_API ~GlobalComm();
+    GlobalComm(GlobalComm const &) = delete;
+    GlobalComm &operator=(GlobalComm const &) = delete;
+
     ZENO_API void frameCache(std::string const &path, int gcmax);
+    ZENO_API void framePrefetch(int numFrames, size_t budgetBytes);
+    ZENO_API void cancelPrefetch();
     ZENO_API void initFrameRange(int beg, int end);
     ZENO_API void newFrame();
     ZENO_API void finishFrame();
-    ZENO_API void dumpFrameCache(int frameid, bool cacheLightCameraOnly = false, bool cacheMaterialOnly = false);
+    // keepResident keeps the written frame in memory, bounded like prefetched frames, instead of dropping it
+    ZENO_API void dumpFrameCache(int frameid, bool cacheLightCameraOnly = false, bool cacheMaterialOnly = false, bool keepResident = false);
+    ZENO_API void waitFrameCache(int frameid);
+    ZENO_API void flushFrameCache();
+    ZENO_API CacheStats cacheStats() const;
     ZENO_API void addViewObject(std::string const &key, std::shared_ptr<IObject> object);
+    ZENO_API bool replaceViewObject(std::string const &oldKey, std::string const &key, std::shared_ptr<IObject> object);
     ZENO_API int maxPlayFrames();
     ZENO_API int numOfFinishedFrame();
     ZENO_API int numOfInitializedFrame();
@@ -61,10 +107,28 @@ struct GlobalComm {
     ZENO_API std::string cachePath();
     ZENO_API bool removeCache(int frame);
     ZENO_API void removeCachePath();
-    static void toDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects& objs, bool cacheLightCameraOnly, bool cacheMaterialOnly, std::string fileName = "");
+    static void toDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects& objs, bool cacheLightCameraOnly, bool cacheMaterialOnly, std::string fileName = "", std::vector<std::string> *blobRefs = nullptr);
     static bool fromDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects& objs, std::string fileName = "");
 private:
-    ViewObjects const *_getViewObjects(const int frameid);
+    ViewObjects const *_getViewObjects(std::unique_lock<std::mutex> &lck, const int frameid);
+    bool _needPrefetch(int frameid) const;
+    void _schedulePrefetch(int frameid);
+    void _installFrame(int frameid, ViewObjects &&objs, size_t bytes);
+    void _evictFrame(int frameid);
+    void _evictCachedFrames(int frameid);
+    void _waitPrefetch(int frameid);
+    void _prefetchWorker();
+    void _touchFrame(int frameid);
+    bool _isWritePending(int frameid) const;
+    void _writeWorker();
+    void _releaseFrameBlobs(int frameid);
+    void _collectBlobs();
+    void _forgetBlobs();
+
+    struct Writer;
+    std::unique_ptr<Writer> m_writer;  // drains queued writes on destruction
+    struct Prefetcher;
+    std::unique_ptr<Prefetcher> m_prefetcher;  // must be last: joins workers first on destruction
 };
 
 }
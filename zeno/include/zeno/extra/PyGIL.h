@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Python.h>
+
+namespace zeno {
+
+// ctypes calls into zeno with the GIL released, so every entry point that
+// touches Python objects takes it back first.
+struct PyGILGuard {
+    PyGILState_STATE state = PyGILState_Ensure();
+
+    PyGILGuard() = default;
+    PyGILGuard(PyGILGuard const &) = delete;
+    PyGILGuard &operator=(PyGILGuard const &) = delete;
+
+    ~PyGILGuard() {
+        PyGILState_Release(state);
+    }
+};
+
+// drops the GIL for zeno-side work done while serving a Python call
+struct PyGILRelease {
+    PyThreadState *tstate = PyEval_SaveThread();
+
+    PyGILRelease() = default;
+    PyGILRelease(PyGILRelease const &) = delete;
+    PyGILRelease &operator=(PyGILRelease const &) = delete;
+
+    ~PyGILRelease() {
+        PyEval_RestoreThread(tstate);
+    }
+};
+
+}
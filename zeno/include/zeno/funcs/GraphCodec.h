@@ -0,0 +1,43 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace zeno {
+
+/* Compact binary form of the program JSON accepted by Graph::loadGraph.
+ * Layout: magic, string table (varint count, then varint length + bytes per
+ * string), command count, then per command: interned command name, argc and
+ * tagged arguments. Every node class, node id and socket name is interned
+ * once, so the loader never re-parses or re-allocates them. */
+namespace graphcodec {
+
+constexpr char kMagic[8] = {'Z', 'S', 'G', 'B', 'I', 'N', '0', '1'};
+
+enum class ValueTag : uint8_t {
+    Null,
+    Int,
+    Float,
+    Bool,
+    String,   // interned string id
+    Vec2i,
+    Vec3i,
+    Vec4i,
+    Vec2f,
+    Vec3f,
+    Vec4f,
+    Json,     // interned raw JSON text, for curves and other ui objects
+};
+
+}
+
+inline bool isBinaryGraph(const char *buf, size_t len) {
+    return len >= sizeof(graphcodec::kMagic)
+        && std::memcmp(buf, graphcodec::kMagic, sizeof(graphcodec::kMagic)) == 0;
+}
+
+ZENO_API bool encodeGraphFromJson(const char *json, std::vector<char> &buf);
+
+}
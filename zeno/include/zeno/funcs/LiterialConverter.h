@@ -4,6 +4,7 @@
 #include <zeno/core/IObject.h>
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/StringObject.h>
+#include <zeno/utils/fast_allocator.h>
 
 namespace zeno {
 
@@ -60,11 +61,11 @@ inline auto objectToLiterial(std::shared_ptr<IObject> const &ptr, std::string co
 }
 
 inline std::shared_ptr<IObject> objectFromLiterial(std::string const &value) {
-    return std::make_shared<StringObject>(value);
+    return make_pooled<StringObject>(value);
 }
 
 inline std::shared_ptr<IObject> objectFromLiterial(NumericValue const &value) {
-    return std::make_shared<NumericObject>(value);
+    return make_pooled<NumericObject>(value);
 }
 
 inline std::shared_ptr<IObject> objectFromLiterial(std::shared_ptr<IObject> value) {
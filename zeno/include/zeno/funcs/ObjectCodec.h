@@ -10,4 +10,29 @@ namespace zeno {
 ZENO_API std::shared_ptr<IObject> decodeObject(const char *buf, size_t len);
 ZENO_API bool encodeObject(IObject const *object, std::vector<char> &buf);
 
+// While alive, large primitive arrays encoded on this thread that repeat an
+// earlier frame of the same stream are stored once under `blobdir` and only
+// referenced from the object buffer; decoding on this thread resolves them.
+// With ZENO_CACHE_DELTA_BITS=8 or 16, positions are stored as deltas to a
+// keyframe quantised to that many bits. Attributes are packed into smaller
+// types only while a scope is alive.
+struct ObjectCodecBlobScope {
+    ZENO_API explicit ObjectCodecBlobScope(std::string blobdir);
+    ZENO_API ~ObjectCodecBlobScope();
+    ObjectCodecBlobScope(ObjectCodecBlobScope const &) = delete;
+    ObjectCodecBlobScope &operator=(ObjectCodecBlobScope const &) = delete;
+
+    // objects encoded next belong to this stream, e.g. the view key without frame
+    ZENO_API void setStream(std::string stream);
+
+    // drop what the writer remembers about `blobdir`, call after deleting it
+    ZENO_API static void forget(std::string const &blobdir);
+
+    std::string blobdir;
+    std::string stream;
+    int counter = 0;
+    std::vector<std::string> referenced;  // file names of the blobs encoded objects refer to
+    ObjectCodecBlobScope *previous = nullptr;
+};
+
 }
@@ -53,6 +53,10 @@ ZENO_API std::pair<vec3f, vec3f> primBoundingBox(PrimitiveObject *prim);
 ZENO_API void primRandomize(PrimitiveObject *prim, std::string attr, std::string dirAttr, std::string seedAttr, std::string randType, float base, float scale, int seed);
 ZENO_API void primPerlinNoise(PrimitiveObject *prim, std::string inAttr, std::string outAttr, std::string outType, float scale, float detail, float roughness, float disortion, vec3f offset, float average, float strength);
 
+ZENO_API std::shared_ptr<PrimitiveObject> primClusterSimplify(PrimitiveObject *prim, int targetFaces);
+ZENO_API int primMeshlets(PrimitiveObject *prim, int maxVerts = 64, int maxTris = 124, std::string meshletAttr = "meshlet");
+ZENO_API std::shared_ptr<PrimitiveObject> primPreviewLod(PrimitiveObject *prim, int targetFaces);
+
 ZENO_API std::shared_ptr<PrimitiveObject> primScatter(
     PrimitiveObject *prim, std::string type, std::string denAttr, float density, float minRadius, bool interpAttrs, int seed);
 
@@ -3,6 +3,7 @@
 #include <zeno/utils/vec.h>
 #include <zeno/core/IObject.h>
 #include <zeno/utils/Exception.h>
+#include <zeno/utils/fast_allocator.h>
 #include <variant>
 
 namespace zeno {
@@ -18,6 +19,15 @@ struct NumericObject : IObjectClone<NumericObject> {
   NumericObject() = default;
   NumericObject(NumericValue const &value) : value(value) {}
 
+  // literals are created and dropped in bulk, keep them off the global heap
+  virtual std::shared_ptr<IObject> clone() const override {
+    return make_pooled<NumericObject>(*this);
+  }
+
+  virtual std::shared_ptr<IObject> move_clone() override {
+    return make_pooled<NumericObject>(std::move(*this));
+  }
+
   NumericValue &get() {
       return value;
   }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <zeno/core/IObject.h>
+#include <zeno/utils/fast_allocator.h>
 #include <string>
 
 namespace zeno {
@@ -11,6 +12,14 @@ struct StringObject : IObjectClone<StringObject> {
   StringObject() = default;
   StringObject(std::string const &value) : value(value) {}
 
+  virtual std::shared_ptr<IObject> clone() const override {
+    return make_pooled<StringObject>(*this);
+  }
+
+  virtual std::shared_ptr<IObject> move_clone() override {
+    return make_pooled<StringObject>(std::move(*this));
+  }
+
   std::string const &get() const {
     return value;
   }
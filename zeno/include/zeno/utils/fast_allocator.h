@@ -1,10 +1,12 @@
 #pragma once
 
 #include <new>
+#include <algorithm>
 #include <utility>
 #include <cstddef>
 #include <type_traits>
 #include <memory>
+#include <mutex>
 
 namespace zeno {
 
@@ -51,4 +53,172 @@ struct fast_allocator {
     }
 };
 
+namespace pool_detail {
+
+/* fixed size blocks carved from never freed slabs, each thread keeps a free list
+ * and trades batches with a global depot, so frees from other threads are fine */
+template <std::size_t Size, std::size_t Align>
+struct fixed_pool {
+    struct node { node *next; };
+
+    static constexpr std::size_t kBlock = (std::max(Size, sizeof(node)) + Align - 1) / Align * Align;
+    static constexpr std::size_t kBatch = 64;
+
+    struct depot {
+        std::mutex mtx;
+        node *head = nullptr;
+        std::size_t count = 0;
+
+        void give(node *first, node *last, std::size_t n) {
+            std::lock_guard lck(mtx);
+            last->next = head;
+            head = first;
+            count += n;
+        }
+
+        node *take(std::size_t &n) {
+            std::lock_guard lck(mtx);
+            if (!head)
+                return n = 0, nullptr;
+            node *first = head, *last = head;
+            std::size_t got = 1;
+            while (got < n && last->next)
+                last = last->next, got++;
+            head = last->next;
+            count -= got;
+            last->next = nullptr;
+            n = got;
+            return first;
+        }
+    };
+
+    static depot &global() {
+        static depot *d = new depot;  // leaked on purpose, objects may die after static destructors
+        return *d;
+    }
+
+    struct cache {
+        node *head = nullptr;
+        std::size_t count = 0;
+
+        ~cache() {
+            if (head) {
+                node *last = head;
+                while (last->next)
+                    last = last->next;
+                global().give(head, last, count);
+            }
+            dead() = true;
+        }
+    };
+
+    static bool &dead() {
+        static thread_local bool d = false;
+        return d;
+    }
+
+    static cache &local() {
+        static thread_local cache c;
+        return c;
+    }
+
+    static node *refill(std::size_t &n) {
+        n = kBatch;
+        if (node *first = global().take(n))
+            return first;
+        auto slab = reinterpret_cast<std::byte *>(::operator new(kBlock * kBatch, std::align_val_t(Align)));
+        for (std::size_t i = 0; i + 1 < kBatch; i++)
+            reinterpret_cast<node *>(slab + i * kBlock)->next = reinterpret_cast<node *>(slab + (i + 1) * kBlock);
+        reinterpret_cast<node *>(slab + (kBatch - 1) * kBlock)->next = nullptr;
+        n = kBatch;
+        return reinterpret_cast<node *>(slab);
+    }
+
+    static void *allocate() {
+        if (dead()) {
+            std::size_t n = 1;
+            if (node *p = global().take(n))
+                return p;
+            return ::operator new(kBlock, std::align_val_t(Align));
+        }
+        auto &c = local();
+        if (!c.head)
+            c.head = refill(c.count);
+        node *p = c.head;
+        c.head = p->next;
+        c.count--;
+        return p;
+    }
+
+    static void deallocate(void *ptr) {
+        node *p = static_cast<node *>(ptr);
+        if (dead()) {
+            global().give(p, p, 1);
+            return;
+        }
+        auto &c = local();
+        p->next = c.head;
+        c.head = p;
+        if (++c.count >= 2 * kBatch) {
+            node *last = c.head;
+            for (std::size_t i = 1; i < kBatch; i++)
+                last = last->next;
+            node *rest = last->next;
+            global().give(c.head, last, kBatch);
+            c.head = rest;
+            c.count -= kBatch;
+        }
+    }
+};
+
+}
+
+template <class T>
+struct pool_allocator {
+    /* small-object allocator for std::allocate_shared, sizes up to kMaxSize are pooled */
+    using value_type = T;
+    using size_type = std::size_t;
+
+    static constexpr std::size_t kMaxSize = 256;
+    static constexpr std::size_t kAlign = std::max<std::size_t>(alignof(T), 16);
+    using pool_type = pool_detail::fixed_pool<(sizeof(T) + 15) / 16 * 16, kAlign>;
+
+    pool_allocator() = default;
+
+    template <class U>
+    pool_allocator(pool_allocator<U> const &) noexcept {}
+
+    static constexpr bool pooled(size_type n) {
+        return n == 1 && sizeof(T) <= kMaxSize && alignof(T) <= alignof(std::max_align_t);
+    }
+
+    static T *allocate(size_type n) {
+        if (pooled(n))
+            return static_cast<T *>(pool_type::allocate());
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(kAlign)));
+    }
+
+    static void deallocate(T *p, size_type n) {
+        if (pooled(n))
+            pool_type::deallocate(p);
+        else
+            ::operator delete(static_cast<void *>(p), std::align_val_t(kAlign));
+    }
+
+    template <class U>
+    constexpr bool operator==(pool_allocator<U> const &) const noexcept {
+        return true;
+    }
+
+    template <class U>
+    constexpr bool operator!=(pool_allocator<U> const &) const noexcept {
+        return false;
+    }
+};
+
+template <class T, class ...Args>
+std::shared_ptr<T> make_pooled(Args &&...args) {
+    return std::allocate_shared<T>(pool_allocator<T>(), std::forward<Args>(args)...);
+}
+
 }
@@ -33,7 +33,10 @@ ZENO_API zany const &Graph::getNodeOutput(
     auto node = safe_at(nodes, sn, "node name").get();
     if (node->muted_output)
         return node->muted_output;
-    return safe_at(node->outputs, ss, "output socket name of node " + node->myname);
+    auto it = node->outputs.find(ss);
+    if (it == node->outputs.end())
+        throw makeError<KeyError>(ss, "output socket name of node " + node->myname);
+    return it->second;
 }
 
 zany Graph::getNodeInput(std::string const& sn, std::string const& ss) const {
@@ -80,15 +83,20 @@ ZENO_API void Graph::completeNode(std::string const &id) {
 }
 
 ZENO_API bool Graph::applyNode(std::string const &id) {
-    if (ctx->visited.find(id) != ctx->visited.end()) {
+    return applyNode(safe_at(nodes, id, "node name").get());
+}
+
+ZENO_API bool Graph::applyNode(INode *node) {
+    if (node->nodeIndex == (size_t)-1)
+        node->nodeIndex = numNodeIndices++;
+    if (ctx->isVisited(node->nodeIndex)) {
         return false;
     }
-    ctx->visited.insert(id);
-    auto node = safe_at(nodes, id, "node name").get();
+    ctx->setVisited(node->nodeIndex);
     GraphException::translated([&] {
         node->doApply();
     }, node->myname);
-    if (dirtyChecker && dirtyChecker->amIDirty(id)) {
+    if (dirtyChecker && dirtyChecker->amIDirty(node->myname)) {
         return true;
     }
     return false;
@@ -113,22 +121,40 @@ ZENO_API void Graph::applyNodesToExec() {
 
 ZENO_API void Graph::bindNodeInput(std::string const &dn, std::string const &ds,
         std::string const &sn, std::string const &ss) {
-    safe_at(nodes, dn, "node name")->inputBounds[ds] = std::pair(sn, ss);
+    bindNodeInput(safe_at(nodes, dn, "node name").get(), ds, sn, ss);
+}
+
+ZENO_API void Graph::bindNodeInput(INode *node, std::string const &ds,
+        std::string const &sn, std::string const &ss) {
+    node->inputBounds[ds] = std::pair(sn, ss);
+    node->invalidateSockets();
 }
 
 ZENO_API void Graph::setNodeInput(std::string const &id, std::string const &par,
         zany const &val) {
-    safe_at(nodes, id, "node name")->inputs[par] = val;
+    setNodeInput(safe_at(nodes, id, "node name").get(), par, val);
+}
+
+ZENO_API void Graph::setNodeInput(INode *node, std::string const &par, zany const &val) {
+    node->inputs[par] = val;
 }
 
 ZENO_API void Graph::setKeyFrame(std::string const &id, std::string const &par, zany const &val) {
-    safe_at(nodes, id, "node name")->inputs[par] = val;
-    safe_at(nodes, id, "node name")->kframes.insert(par);
+    setKeyFrame(safe_at(nodes, id, "node name").get(), par, val);
+}
+
+ZENO_API void Graph::setKeyFrame(INode *node, std::string const &par, zany const &val) {
+    node->inputs[par] = val;
+    node->kframes.insert(par);
 }
 
 ZENO_API void Graph::setFormula(std::string const &id, std::string const &par, zany const &val) {
-    safe_at(nodes, id, "node name")->inputs[par] = val;
-    safe_at(nodes, id, "node name")->formulas.insert(par);
+    setFormula(safe_at(nodes, id, "node name").get(), par, val);
+}
+
+ZENO_API void Graph::setFormula(INode *node, std::string const &par, zany const &val) {
+    node->inputs[par] = val;
+    node->formulas.insert(par);
 }
 
 
@@ -136,8 +162,11 @@ ZENO_API std::map<std::string, zany> Graph::callSubnetNode(std::string const &id
         std::map<std::string, zany> inputs) const {
     auto se = safe_at(nodes, id, "node name").get();
     se->inputs = std::move(inputs);
+    se->invalidateSockets();
     se->doOnlyApply();
-    return std::move(se->outputs);
+    auto outputs = std::move(se->outputs);
+    se->invalidateSockets();
+    return outputs;
 }
 
 ZENO_API std::map<std::string, zany> Graph::callTempNode(std::string const &id,
@@ -152,7 +181,12 @@ ZENO_API std::map<std::string, zany> Graph::callTempNode(std::string const &id,
 
 ZENO_API void Graph::setTempCache(std::string const& id)
 {
-    safe_at(nodes, id, "node name")->bTmpCache = true;
+    setTempCache(safe_at(nodes, id, "node name").get());
+}
+
+ZENO_API void Graph::setTempCache(INode *node)
+{
+    node->bTmpCache = true;
 }
 
 ZENO_API INode* Graph::getNode(std::string const& id)
@@ -161,8 +195,12 @@ ZENO_API INode* Graph::getNode(std::string const& id)
 }
 
 ZENO_API void Graph::addNodeOutput(std::string const& id, std::string const& par) {
+    addNodeOutput(safe_at(nodes, id, "node name").get(), par);
+}
+
+ZENO_API void Graph::addNodeOutput(INode *node, std::string const& par) {
     // add "dynamic" output which is not descriped by core.
-    safe_at(nodes, id, "node name")->outputs[par] = nullptr;
+    node->outputs[par] = nullptr;
 }
 
 ZENO_API void Graph::setNodeParam(std::string const &id, std::string const &par,
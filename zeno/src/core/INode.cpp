@@ -128,8 +128,10 @@ ZENO_API void INode::preApply() {
             zeno::log_info("remove cache file: {}", path.string());
         }
     }
-    for (auto const &[ds, bound]: inputBounds) {
-        requireInput(ds);
+    if (!socketsResolved)
+        resolveSockets();
+    for (auto &in: resolvedInputs) {
+        requireResolvedInput(in);
     }
 
     log_debug("==> enter {}", myname);
@@ -144,20 +146,52 @@ ZENO_API void INode::preApply() {
     log_debug("==> leave {}", myname);
 }
 
-ZENO_API bool INode::requireInput(std::string const &ds) {
-    auto it = inputBounds.find(ds);
-    if (it == inputBounds.end())
-        return false;
-    auto [sn, ss] = it->second;
-    if (graph->applyNode(sn)) {
+ZENO_API void INode::invalidateSockets() {
+    socketsResolved = false;
+    resolvedInputs.clear();
+    socketEpoch++;
+}
+
+ZENO_API void INode::resolveSockets() {
+    resolvedInputs.clear();
+    resolvedInputs.reserve(inputBounds.size());
+    for (auto const &[ds, bound]: inputBounds) {
+        auto srcNode = safe_at(graph->nodes, bound.first, "node name").get();
+        resolvedInputs.push_back({&ds, &inputs[ds], srcNode, &bound.second});
+    }
+    socketsResolved = true;
+}
+
+ZENO_API bool INode::requireResolvedInput(ResolvedInput &in) {
+    if (graph->applyNode(in.srcNode)) {
         auto &dc = graph->getDirtyChecker();
         dc.taintThisNode(myname);
     }
-    auto ref = graph->getNodeOutput(sn, ss);
-    inputs[ds] = ref;
+    if (in.srcNode->muted_output) {
+        *in.slot = in.srcNode->muted_output;
+        return true;
+    }
+    if (!in.srcOutput || in.srcEpoch != in.srcNode->socketEpoch) {
+        auto it = in.srcNode->outputs.find(*in.srcSocket);
+        if (it == in.srcNode->outputs.end())
+            throw makeError<KeyError>(*in.srcSocket, "output socket name of node " + in.srcNode->myname);
+        in.srcOutput = &it->second;
+        in.srcEpoch = in.srcNode->socketEpoch;
+    }
+    *in.slot = *in.srcOutput;
     return true;
 }
 
+ZENO_API bool INode::requireInput(std::string const &ds) {
+    if (!socketsResolved)
+        resolveSockets();
+    for (auto &in: resolvedInputs) {
+        if (*in.name == ds)
+            return requireResolvedInput(in);
+    }
+    return false;
+}
+
 ZENO_API void INode::doOnlyApply() {
     apply();
 }
@@ -193,12 +227,16 @@ ZENO_API bool INode::has_input(std::string const &id) const {
 }
 
 ZENO_API zany INode::get_input(std::string const &id) const {
-    if (has_keyframe(id)) {
+    if (!kframes.empty() && has_keyframe(id)) {
         return get_keyframe(id);
-    } else if (has_formula(id)) {
+    } else if (!formulas.empty() && has_formula(id)) {
         return get_formula(id);
     }
-    return safe_at(inputs, id, "input socket of node `" + myname + "`");
+    // only build the error message when it is actually needed:
+    auto it = inputs.find(id);
+    if (it == inputs.end())
+        throw makeError<KeyError>(id, "input socket of node `" + myname + "`");
+    return it->second;
 }
 
 ZENO_API zany INode::resolveInput(std::string const& id) {
@@ -1,4 +1,8 @@
 #include <zeno/core/Graph.h>
+#include <zeno/core/INode.h>
+#include <zeno/core/Session.h>
+#include <zeno/funcs/GraphCodec.h>
+#include <zeno/utils/safe_at.h>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <zeno/funcs/LiterialConverter.h>
@@ -9,6 +13,7 @@
 #include <zeno/utils/vec.h>
 #include <zeno/utils/zeno_p.h>
 #include <zeno/zeno.h>
+#include <unordered_map>
 #include <stack>
 
 namespace zeno {
@@ -131,4 +136,259 @@ ZENO_API void Graph::loadGraph(const char *json) {
     }
 }
 
+namespace {
+
+using graphcodec::ValueTag;
+
+struct BinaryGraphReader {
+    const char *it;
+    const char *end;
+
+    void need(size_t n) const {
+        if (end - it < (ptrdiff_t)n)
+            throw makeError("binary graph truncated");
+    }
+
+    uint32_t varint() {
+        uint32_t x = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            need(1);
+            auto c = (unsigned char)*it++;
+            x |= (uint32_t)(c & 0x7f) << shift;
+            if (!(c & 0x80))
+                return x;
+        }
+        throw makeError("binary graph has bad varint");
+    }
+
+    template <class T>
+    T pod() {
+        need(sizeof(T));
+        T x;
+        std::memcpy(&x, it, sizeof(T));
+        it += sizeof(T);
+        return x;
+    }
+};
+
+struct BinaryValue {
+    ValueTag tag = ValueTag::Null;
+    int32_t i[4]{};
+    float f[4]{};
+    uint32_t str = 0;
+};
+
+}
+
+ZENO_API void Graph::loadGraphBinary(const char *buf, size_t len) {
+    if (!isBinaryGraph(buf, len)) {
+        throw GraphException { "None", nullptr };
+    }
+    BinaryGraphReader rd{buf + sizeof(graphcodec::kMagic), buf + len};
+
+    enum class Op {
+        Unresolved, Unknown,
+        addNode, setNodeInput, setKeyFrame, setFormula, setNodeParam,
+        bindNodeInput, completeNode, addSubnetNode, addNodeOutput,
+        pushSubnetScope, popSubnetScope, setBeginFrameNumber, setEndFrameNumber,
+        setNodeOption, markNodeChanged, cacheToDisk,
+    };
+
+    std::vector<std::string> strs(rd.varint());
+    for (auto &str: strs) {
+        auto n = rd.varint();
+        rd.need(n);
+        str.assign(rd.it, n);
+        rd.it += n;
+    }
+    // everything keyed by interned string id is resolved at most once:
+    std::vector<Op> ops(strs.size(), Op::Unresolved);
+
+    auto resolveOp = [&] (uint32_t id) {
+        if (ops[id] != Op::Unresolved)
+            return ops[id];
+        static const std::unordered_map<std::string_view, Op> lut = {
+#define _PER_OP(x) {#x, Op::x},
+            _PER_OP(addNode) _PER_OP(setNodeInput) _PER_OP(setKeyFrame) _PER_OP(setFormula)
+            _PER_OP(setNodeParam) _PER_OP(bindNodeInput) _PER_OP(completeNode) _PER_OP(addSubnetNode)
+            _PER_OP(addNodeOutput) _PER_OP(pushSubnetScope) _PER_OP(popSubnetScope)
+            _PER_OP(setBeginFrameNumber) _PER_OP(setEndFrameNumber) _PER_OP(setNodeOption)
+            _PER_OP(markNodeChanged) _PER_OP(cacheToDisk)
+#undef _PER_OP
+        };
+        auto it = lut.find(strs[id]);
+        return ops[id] = it == lut.end() ? Op::Unknown : it->second;
+    };
+
+    auto toObject = [&] (BinaryValue const &v) -> zany {
+        switch (v.tag) {
+        case ValueTag::Int: return objectFromLiterial(v.i[0]);
+        case ValueTag::Float: return objectFromLiterial(v.f[0]);
+        case ValueTag::Bool: return objectFromLiterial((bool)v.i[0]);
+        case ValueTag::String: return objectFromLiterial(strs[v.str]);
+        case ValueTag::Vec2i: return objectFromLiterial(vec2i(v.i[0], v.i[1]));
+        case ValueTag::Vec3i: return objectFromLiterial(vec3i(v.i[0], v.i[1], v.i[2]));
+        case ValueTag::Vec4i: return objectFromLiterial(vec4i(v.i[0], v.i[1], v.i[2], v.i[3]));
+        case ValueTag::Vec2f: return objectFromLiterial(vec2f(v.f[0], v.f[1]));
+        case ValueTag::Vec3f: return objectFromLiterial(vec3f(v.f[0], v.f[1], v.f[2]));
+        case ValueTag::Vec4f: return objectFromLiterial(vec4f(v.f[0], v.f[1], v.f[2], v.f[3]));
+        case ValueTag::Json: {
+            Document d;
+            d.Parse(strs[v.str].data(), strs[v.str].size());
+            return generic_get<zany>(d);
+        }
+        default:
+            log_warn("unknown type encountered in generic_get");
+            return objectFromLiterial(NumericValue(0));
+        }
+    };
+
+    auto toParam = [&] (BinaryValue const &v) -> std::variant<int, float, std::string, zany> {
+        switch (v.tag) {
+        case ValueTag::Int: return v.i[0];
+        case ValueTag::Float: return v.f[0];
+        case ValueTag::Bool: return (int)v.i[0];
+        case ValueTag::String: return strs[v.str];
+        case ValueTag::Json: {
+            Document d;
+            d.Parse(strs[v.str].data(), strs[v.str].size());
+            return generic_get<std::variant<int, float, std::string, zany>, false>(d);
+        }
+        default:
+            log_warn("unknown type encountered in generic_get");
+            return 0;
+        }
+    };
+
+    Graph *g = this;
+    using NodeCache = std::unordered_map<uint32_t, INode *>;
+    NodeCache nodeCache;
+    std::stack<std::pair<Graph *, NodeCache>> gStack;
+
+    auto nodeOf = [&] (uint32_t id) -> INode * {
+        if (auto it = nodeCache.find(id); it != nodeCache.end())
+            return it->second;
+        auto node = safe_at(g->nodes, strs[id], "node name").get();
+        nodeCache.emplace(id, node);
+        return node;
+    };
+
+    std::vector<BinaryValue> args;
+    uint32_t ncmds = rd.varint();
+    for (uint32_t c = 0; c < ncmds; c++) {
+        auto cmd = rd.varint();
+        if (cmd >= strs.size())
+            throw makeError("binary graph has bad string id");
+        args.resize(rd.varint());
+        for (auto &v: args) {
+            v.tag = rd.pod<ValueTag>();
+            switch (v.tag) {
+            case ValueTag::Null: break;
+            case ValueTag::Int: v.i[0] = rd.pod<int32_t>(); break;
+            case ValueTag::Float: v.f[0] = rd.pod<float>(); break;
+            case ValueTag::Bool: v.i[0] = rd.pod<uint8_t>(); break;
+            case ValueTag::Vec2i: case ValueTag::Vec3i: case ValueTag::Vec4i:
+                for (int k = 0; k < (int)v.tag - (int)ValueTag::Vec2i + 2; k++)
+                    v.i[k] = rd.pod<int32_t>();
+                break;
+            case ValueTag::Vec2f: case ValueTag::Vec3f: case ValueTag::Vec4f:
+                for (int k = 0; k < (int)v.tag - (int)ValueTag::Vec2f + 2; k++)
+                    v.f[k] = rd.pod<float>();
+                break;
+            case ValueTag::String: case ValueTag::Json:
+                v.str = rd.varint();
+                if (v.str >= strs.size())
+                    throw makeError("binary graph has bad string id");
+                break;
+            default:
+                throw makeError("binary graph has bad value tag");
+            }
+        }
+
+        auto op = resolveOp(cmd);
+        auto str = [&] (size_t k) -> std::string const & {
+            if (k >= args.size() || args[k].tag != ValueTag::String)
+                throw makeError("binary graph command " + strs[cmd] + " expects a string argument");
+            return strs[args[k].str];
+        };
+        auto sid = [&] (size_t k) {
+            str(k);
+            return args[k].str;
+        };
+        auto arg = [&] (size_t k) -> BinaryValue const & {
+            if (k >= args.size())
+                throw makeError("binary graph command " + strs[cmd] + " misses arguments");
+            return args[k];
+        };
+        const char *maybeNodeName = op == Op::addNode ? str(1).c_str() : (
+            args.size() >= 1 && args[0].tag == ValueTag::String ? strs[args[0].str].c_str() : "(not a node)");
+
+        GraphException::translated([&] {
+            switch (op) {
+            case Op::addNode:
+                g->addNode(str(0), str(1));
+                break;
+            case Op::setNodeInput:
+                g->setNodeInput(nodeOf(sid(0)), str(1), toObject(arg(2)));
+                break;
+            case Op::setKeyFrame:
+                g->setKeyFrame(nodeOf(sid(0)), str(1), toObject(arg(2)));
+                break;
+            case Op::setFormula:
+                g->setFormula(nodeOf(sid(0)), str(1), toObject(arg(2)));
+                break;
+            case Op::setNodeParam:
+                nodeOf(sid(0));
+                g->setNodeParam(str(0), str(1), toParam(arg(2)));
+                break;
+            case Op::bindNodeInput:
+                g->bindNodeInput(nodeOf(sid(0)), str(1), str(2), str(3));
+                break;
+            case Op::completeNode:
+                nodeOf(sid(0))->doComplete();
+                break;
+            case Op::addSubnetNode:
+                g->addSubnetNode(str(1));
+                nodeCache.erase(sid(1));
+                break;
+            case Op::addNodeOutput:
+                g->addNodeOutput(nodeOf(sid(0)), str(1));
+                break;
+            case Op::pushSubnetScope: {
+                auto subg = g->getSubnetGraph(str(0));
+                gStack.emplace(g, std::move(nodeCache));
+                nodeCache = {};
+                g = subg;
+            } break;
+            case Op::popSubnetScope:
+                if (gStack.empty())
+                    throw makeError("binary graph pops an empty subnet scope");
+                g = gStack.top().first;
+                nodeCache = std::move(gStack.top().second);
+                gStack.pop();
+                break;
+            case Op::setBeginFrameNumber:
+                this->beginFrameNumber = arg(0).i[0];
+                break;
+            case Op::setEndFrameNumber:
+                this->endFrameNumber = arg(0).i[0];
+                break;
+            case Op::setNodeOption:
+                // skip this for compatibility
+                break;
+            case Op::markNodeChanged:
+                g->getDirtyChecker().taintThisNode(str(0));
+                //todo: mark node data change.
+                break;
+            case Op::cacheToDisk:
+                g->setTempCache(nodeOf(sid(0)));
+                break;
+            default:
+                log_warn("got unexpected command: {}", strs[cmd]);
+                break;
+            }
+        }, maybeNodeName);
+    }
+}
+
 }
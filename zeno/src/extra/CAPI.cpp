@@ -8,8 +8,62 @@ LUT<Session> lutSession;
 LUT<Graph> lutGraph;
 LUT<IObject> lutObject;
 LastError lastError;
-std::map<std::string, std::shared_ptr<IObject>> tempNodeRes;
-std::shared_ptr<Graph> currentGraph;
+thread_local std::map<std::string, std::shared_ptr<IObject>> tempNodeRes;
+
+ZENO_API LastError::State &LastError::state() noexcept {
+    static thread_local State st;
+    return st;
+}
+
+template <class T, size_t N>
+static std::shared_ptr<NumericObject> numericFromScalars(const T *value_) {
+    if constexpr (N == 1)
+        return std::make_shared<NumericObject>(value_[0]);
+    else {
+        zeno::vec<N, T> val;
+        for (size_t i = 0; i < N; i++)
+            val[i] = value_[i];
+        return std::make_shared<NumericObject>(val);
+    }
+}
+
+template <class T, size_t N>
+static void numericToScalars(NumericObject *ptr, T *value_) {
+    if constexpr (N == 1)
+        value_[0] = ptr->get<T>();
+    else {
+        auto const &val = ptr->get<zeno::vec<N, T>>();
+        for (size_t i = 0; i < N; i++)
+            value_[i] = val[i];
+    }
+}
+
+template <class T>
+static void createObjects(Zeno_Object *objectsRet_, const T *values_, size_t dim_, size_t count_) {
+    if (ZENO_UNLIKELY(dim_ < 1 || dim_ > 4))
+        throw zeno::makeError("invalid numeric dimension " + std::to_string(dim_));
+    index_switch<4>(dim_ - 1, [&] (auto dim) {
+        constexpr size_t N = dim.value + 1;
+        for (size_t i = 0; i < count_; i++)
+            objectsRet_[i] = lutObject.create(numericFromScalars<T, N>(values_ + i * N));
+    });
+}
+
+template <class T>
+static void getObjects(const Zeno_Object *objects_, T *values_, size_t dim_, size_t count_) {
+    if (ZENO_UNLIKELY(dim_ < 1 || dim_ > 4))
+        throw zeno::makeError("invalid numeric dimension " + std::to_string(dim_));
+    index_switch<4>(dim_ - 1, [&] (auto dim) {
+        constexpr size_t N = dim.value + 1;
+        for (size_t i = 0; i < count_; i++) {
+            auto obj = lutObject.access(objects_[i]);
+            auto ptr = dynamic_cast<NumericObject *>(obj.get());
+            if (ZENO_UNLIKELY(ptr == nullptr))
+                throw zeno::makeError<TypeError>(typeid(NumericObject), typeid(*obj), "get object as numeric");
+            numericToScalars<T, N>(ptr, values_ + i * N);
+        }
+    });
+}
 }
 
 extern "C" {
@@ -124,7 +178,8 @@ ZENO_CAPI Zeno_Error Zeno_ObjectIncReference(Zeno_Object object_) ZENO_CAPI_NOEX
 ZENO_CAPI Zeno_Error Zeno_GetObjectLiterialType(Zeno_Object object_, int *typeRet_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
         *typeRet_ = [&] {
-            auto optr = PyZeno::lutObject.access(object_).get();
+            auto obj = PyZeno::lutObject.access(object_);
+            auto optr = obj.get();
             if (auto strptr = dynamic_cast<StringObject *>(optr)) {
                 return 1;
             }
@@ -153,7 +208,8 @@ ZENO_CAPI Zeno_Error Zeno_GetObjectLiterialType(Zeno_Object object_, int *typeRe
 
 ZENO_CAPI Zeno_Error Zeno_GetObjectInt(Zeno_Object object_, int *value_, size_t dim_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto optr = PyZeno::lutObject.access(object_).get();
+        auto obj = PyZeno::lutObject.access(object_);
+        auto optr = obj.get();
         auto ptr = dynamic_cast<NumericObject *>(optr);
         if (ZENO_UNLIKELY(ptr == nullptr))
             throw zeno::makeError<TypeError>(typeid(NumericObject), typeid(*optr), "get object as numeric");
@@ -181,7 +237,8 @@ ZENO_CAPI Zeno_Error Zeno_GetObjectInt(Zeno_Object object_, int *value_, size_t
 
 ZENO_CAPI Zeno_Error Zeno_GetObjectFloat(Zeno_Object object_, float *value_, size_t dim_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto optr = PyZeno::lutObject.access(object_).get();
+        auto obj = PyZeno::lutObject.access(object_);
+        auto optr = obj.get();
         auto ptr = dynamic_cast<NumericObject *>(optr);
         if (ZENO_UNLIKELY(ptr == nullptr))
             throw zeno::makeError<TypeError>(typeid(NumericObject), typeid(*optr), "get object as numeric");
@@ -209,7 +266,8 @@ ZENO_CAPI Zeno_Error Zeno_GetObjectFloat(Zeno_Object object_, float *value_, siz
 
 ZENO_CAPI Zeno_Error Zeno_GetObjectString(Zeno_Object object_, char *strBuf_, size_t *strLenRet_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto optr = PyZeno::lutObject.access(object_).get();
+        auto obj = PyZeno::lutObject.access(object_);
+        auto optr = obj.get();
         auto ptr = dynamic_cast<StringObject *>(optr);
         if (ZENO_UNLIKELY(ptr == nullptr))
             throw zeno::makeError<TypeError>(typeid(StringObject), typeid(*optr), "get object as string");
@@ -222,7 +280,8 @@ ZENO_CAPI Zeno_Error Zeno_GetObjectString(Zeno_Object object_, char *strBuf_, si
 
 ZENO_CAPI Zeno_Error Zeno_GetObjectPrimData(Zeno_Object object_, Zeno_PrimMembType primArrType_, const char *attrName_, void **ptrRet_, size_t *lenRet_, Zeno_PrimDataType *typeRet_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto optr = PyZeno::lutObject.access(object_).get();
+        auto obj = PyZeno::lutObject.access(object_);
+        auto optr = obj.get();
         auto prim = dynamic_cast<PrimitiveObject *>(optr);
         if (ZENO_UNLIKELY(prim == nullptr))
             throw zeno::makeError<TypeError>(typeid(PrimitiveObject), typeid(*optr), "get object as primitive");
@@ -250,7 +309,8 @@ ZENO_CAPI Zeno_Error Zeno_GetObjectPrimData(Zeno_Object object_, Zeno_PrimMembTy
 
 ZENO_CAPI Zeno_Error Zeno_AddObjectPrimAttr(Zeno_Object object_, Zeno_PrimMembType primArrType_, const char *attrName_, Zeno_PrimDataType dataType_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto optr = PyZeno::lutObject.access(object_).get();
+        auto obj = PyZeno::lutObject.access(object_);
+        auto optr = obj.get();
         auto prim = dynamic_cast<PrimitiveObject *>(optr);
         if (ZENO_UNLIKELY(prim == nullptr))
             throw zeno::makeError<TypeError>(typeid(PrimitiveObject), typeid(*optr), "get object as primitive");
@@ -275,7 +335,8 @@ ZENO_CAPI Zeno_Error Zeno_AddObjectPrimAttr(Zeno_Object object_, Zeno_PrimMembTy
 
 ZENO_CAPI Zeno_Error Zeno_GetObjectPrimDataKeys(Zeno_Object object_, Zeno_PrimMembType primArrType_, size_t *lenRet_, const char **keysRet_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto optr = PyZeno::lutObject.access(object_).get();
+        auto obj = PyZeno::lutObject.access(object_);
+        auto optr = obj.get();
         auto prim = dynamic_cast<PrimitiveObject *>(optr);
         if (ZENO_UNLIKELY(prim == nullptr))
             throw zeno::makeError<TypeError>(typeid(PrimitiveObject), typeid(*optr), "get object as primitive");
@@ -303,7 +364,8 @@ ZENO_CAPI Zeno_Error Zeno_GetObjectPrimDataKeys(Zeno_Object object_, Zeno_PrimMe
 
 ZENO_CAPI Zeno_Error Zeno_ResizeObjectPrimData(Zeno_Object object_, Zeno_PrimMembType primArrType_, size_t newSize_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto optr = PyZeno::lutObject.access(object_).get();
+        auto obj = PyZeno::lutObject.access(object_);
+        auto optr = obj.get();
         auto prim = dynamic_cast<PrimitiveObject *>(optr);
         if (ZENO_UNLIKELY(prim == nullptr))
             throw zeno::makeError<TypeError>(typeid(PrimitiveObject), typeid(*optr), "get object as primitive");
@@ -322,30 +384,95 @@ ZENO_CAPI Zeno_Error Zeno_ResizeObjectPrimData(Zeno_Object object_, Zeno_PrimMem
     });
 }
 
+ZENO_CAPI Zeno_Error Zeno_GetObjectPrimDataAll(Zeno_Object object_, Zeno_PrimMembType primArrType_, size_t *countRet_, const char **keysRet_, void **ptrsRet_, size_t *lensRet_, Zeno_PrimDataType *typesRet_) ZENO_CAPI_NOEXCEPT {
+    return PyZeno::lastError.catched([=] {
+        auto obj = PyZeno::lutObject.access(object_);
+        auto optr = obj.get();
+        auto prim = dynamic_cast<PrimitiveObject *>(optr);
+        if (ZENO_UNLIKELY(prim == nullptr))
+            throw zeno::makeError<TypeError>(typeid(PrimitiveObject), typeid(*optr), "get object as primitive");
+        auto memb = invoker_variant(static_cast<size_t>(primArrType_),
+            &PrimitiveObject::verts,
+            &PrimitiveObject::points,
+            &PrimitiveObject::lines,
+            &PrimitiveObject::tris,
+            &PrimitiveObject::quads,
+            &PrimitiveObject::loops,
+            &PrimitiveObject::polys,
+            &PrimitiveObject::uvs);
+        std::visit([&] (auto const &memb) {
+            auto &attArr = memb(*prim);
+            *countRet_ = attArr.template num_attrs<AttrAcceptAll>() + 1;
+            if (keysRet_ == nullptr && ptrsRet_ == nullptr && lensRet_ == nullptr && typesRet_ == nullptr)
+                return;
+            size_t index = 0;
+            attArr.template forall_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+                using T = std::decay_t<decltype(arr[0])>;
+                if (keysRet_) keysRet_[index] = key.c_str();
+                if (ptrsRet_) ptrsRet_[index] = reinterpret_cast<void *>(arr.data());
+                if (lensRet_) lensRet_[index] = arr.size();
+                if (typesRet_) typesRet_[index] = static_cast<Zeno_PrimDataType>(variant_index<AttrAcceptAll, T>::value);
+                index++;
+            });
+        }, memb);
+    });
+}
+
+ZENO_CAPI Zeno_Error Zeno_CreateObjectsInt(Zeno_Object *objectsRet_, const int *values_, size_t dim_, size_t count_) ZENO_CAPI_NOEXCEPT {
+    return PyZeno::lastError.catched([=] {
+        PyZeno::createObjects(objectsRet_, values_, dim_, count_);
+    });
+}
+
+ZENO_CAPI Zeno_Error Zeno_CreateObjectsFloat(Zeno_Object *objectsRet_, const float *values_, size_t dim_, size_t count_) ZENO_CAPI_NOEXCEPT {
+    return PyZeno::lastError.catched([=] {
+        PyZeno::createObjects(objectsRet_, values_, dim_, count_);
+    });
+}
+
+ZENO_CAPI Zeno_Error Zeno_GetObjectsInt(const Zeno_Object *objects_, int *values_, size_t dim_, size_t count_) ZENO_CAPI_NOEXCEPT {
+    return PyZeno::lastError.catched([=] {
+        PyZeno::getObjects(objects_, values_, dim_, count_);
+    });
+}
+
+ZENO_CAPI Zeno_Error Zeno_GetObjectsFloat(const Zeno_Object *objects_, float *values_, size_t dim_, size_t count_) ZENO_CAPI_NOEXCEPT {
+    return PyZeno::lastError.catched([=] {
+        PyZeno::getObjects(objects_, values_, dim_, count_);
+    });
+}
+
+ZENO_CAPI Zeno_Error Zeno_DestroyObjects(const Zeno_Object *objects_, size_t count_) ZENO_CAPI_NOEXCEPT {
+    return PyZeno::lastError.catched([=] {
+        for (size_t i = 0; i < count_; i++)
+            PyZeno::lutObject.destroy(objects_[i]);
+    });
+}
+
 ZENO_CAPI Zeno_Error Zeno_InvokeObjectFactory(Zeno_Object *objectRet_, const char *typeName_, void *ffiObj_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto it = PyZeno::getObjFactory().find(typeName_);
-        if (ZENO_UNLIKELY(it == PyZeno::getObjFactory().end()))
+        auto factory = PyZeno::getObjFactory().find(typeName_);
+        if (ZENO_UNLIKELY(!factory))
             throw zeno::makeError("invalid typeName [" + (std::string)typeName_ + "] in ObjFactory");
-        *objectRet_ = it->second(ffiObj_);
+        *objectRet_ = factory(ffiObj_);
     });
 }
 
 ZENO_CAPI Zeno_Error Zeno_InvokeObjectDefactory(Zeno_Object object_, const char *typeName_, void **ffiObjRet_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto it = PyZeno::getObjDefactory().find(typeName_);
-        if (ZENO_UNLIKELY(it == PyZeno::getObjDefactory().end()))
+        auto defactory = PyZeno::getObjDefactory().find(typeName_);
+        if (ZENO_UNLIKELY(!defactory))
             throw zeno::makeError("invalid typeName [" + (std::string)typeName_ + "] in ObjDefactory");
-        *ffiObjRet_ = it->second(object_);
+        *ffiObjRet_ = defactory(object_);
     });
 }
 
 ZENO_CAPI Zeno_Error Zeno_InvokeCFunctionPtr(void *ffiObjArg_, const char *typeName_, void **ffiObjRet_) ZENO_CAPI_NOEXCEPT {
     return PyZeno::lastError.catched([=] {
-        auto it = PyZeno::getCFuncPtrs().find(typeName_);
-        if (ZENO_UNLIKELY(it == PyZeno::getCFuncPtrs().end()))
+        auto cfunc = PyZeno::getCFuncPtrs().find(typeName_);
+        if (ZENO_UNLIKELY(!cfunc))
             throw zeno::makeError("invalid typeName [" + (std::string)typeName_ + "] in CFuncPtrs");
-        *ffiObjRet_ = it->second(ffiObjArg_);
+        *ffiObjRet_ = cfunc(ffiObjArg_);
     });
 }
 
@@ -378,17 +505,17 @@ ZENO_API std::shared_ptr<Graph> capiFindGraphSharedPtr(Zeno_Graph graph_) {
 }
 
 ZENO_API int capiRegisterObjectFactory(std::string const &typeName_, Zeno_Object (*factory_)(void *)) {
-    PyZeno::getObjFactory().emplace(typeName_, factory_);
+    PyZeno::getObjFactory().add(typeName_, factory_);
     return 1;
 }
 
 ZENO_API int capiRegisterObjectDefactory(std::string const &typeName_, void *(*defactory_)(Zeno_Object)) {
-    PyZeno::getObjDefactory().emplace(typeName_, defactory_);
+    PyZeno::getObjDefactory().add(typeName_, defactory_);
     return 1;
 }
 
 ZENO_API int capiRegisterCFunctionPtr(std::string const &typeName_, void *(*cfunc_)(void *)) {
-    PyZeno::getCFuncPtrs().emplace(typeName_, cfunc_);
+    PyZeno::getCFuncPtrs().add(typeName_, cfunc_);
     return 1;
 }
 
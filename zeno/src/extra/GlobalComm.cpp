@@ -2,7 +2,12 @@
 #include <zeno/extra/GlobalState.h>
 #include <zeno/funcs/ObjectCodec.h>
 #include <zeno/utils/log.h>
+#include <zeno/utils/envconfig.h>
+#include <condition_variable>
 #include <filesystem>
+#include <thread>
+#include <atomic>
+#include <deque>
 #include <algorithm>
 #include <fstream>
 #include <cassert>
@@ -18,26 +23,28 @@
 
 namespace zeno {
 
-std::vector<std::filesystem::path> cachepath(3);
 std::unordered_set<std::string> lightCameraNodes({
     "CameraEval", "CameraNode", "CihouMayaCameraFov", "ExtractCameraData", "GetAlembicCamera","MakeCamera",
     "LightNode", "BindLight", "ProceduralSky", "HDRSky", "SkyComposer"
     });
 std::set<std::string> matNodeNames = {"ShaderFinalize", "ShaderVolume", "ShaderVolumeHomogeneous"};
 
-void GlobalComm::toDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects &objs, bool cacheLightCameraOnly, bool cacheMaterialOnly, std::string fileName) {
+void GlobalComm::toDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects &objs, bool cacheLightCameraOnly, bool cacheMaterialOnly, std::string fileName, std::vector<std::string> *blobRefs) {
     if (cachedir.empty()) return;
     std::filesystem::path dir = std::filesystem::u8path(cachedir + "/" + std::to_string(1000000 + frameid).substr(1));
     if (!std::filesystem::exists(dir) && !std::filesystem::create_directories(dir))
     {
         log_critical("can not create path: {}", dir);
     }
+    std::vector<std::filesystem::path> cachepath(3);
     std::vector<std::vector<char>> bufCaches(3);
     std::vector<std::vector<size_t>> poses(3);
     std::vector<std::string> keys(3);
+    ObjectCodecBlobScope blobs(cachedir + "/blobs");
     for (auto const &[key, obj]: objs) {
 
         size_t bufsize =0;
+        blobs.setStream(key.substr(0, key.find(':')));
         std::string nodeName = key.substr(key.find("-") + 1, key.find(":") - key.find("-") -1);
         if (cacheLightCameraOnly && (lightCameraNodes.count(nodeName) || obj->userData().get2<int>("isL", 0) || std::dynamic_pointer_cast<CameraObject>(obj)))
         {
@@ -144,13 +151,17 @@ void GlobalComm::toDisk(std::string cachedir, int frameid, GlobalComm::ViewObjec
         std::copy(bufCaches[i].begin(), bufCaches[i].end(), oit);
     }
     objs.clear();
+    if (blobRefs)
+        *blobRefs = std::move(blobs.referenced);
 }
 
 bool GlobalComm::fromDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects &objs, std::string fileName) {
     if (cachedir.empty())
         return false;
     objs.clear();
+    ObjectCodecBlobScope blobs(cachedir + "/blobs");
     auto dir = std::filesystem::u8path(cachedir) / std::to_string(1000000 + frameid).substr(1);
+    std::vector<std::filesystem::path> cachepath(3);
     if (fileName == "")
     {
         cachepath[0] = dir / "lightCameraObj.zencache";
@@ -211,12 +222,89 @@ bool GlobalComm::fromDisk(std::string cachedir, int frameid, GlobalComm::ViewObj
                 log_error("zeno cache file broken (4.{})", k);
             }
             const char *p = dat.data() + pos + poses[k];
-            objs.try_emplace(keys[k], decodeObject(p, poses[k + 1] - poses[k]));
+            if (auto obj = decodeObject(p, poses[k + 1] - poses[k]))
+                objs.try_emplace(keys[k], std::move(obj));
         }
     }
     return true;
 }
 
+static size_t frameDiskBytes(std::string const &cachedir, int frameid) {
+    if (cachedir.empty())
+        return 0;
+    auto dir = std::filesystem::u8path(cachedir) / std::to_string(1000000 + frameid).substr(1);
+    std::error_code ec;
+    size_t bytes = 0;
+    for (auto const &name: {"lightCameraObj.zencache", "materialObj.zencache", "normalObj.zencache"}) {
+        auto size = std::filesystem::file_size(dir / name, ec);
+        if (!ec)
+            bytes += size;
+    }
+    return bytes;
+}
+
+struct GlobalComm::Prefetcher {
+    std::mutex mtx;
+    std::condition_variable cv;      // new work queued or shutting down
+    std::condition_variable doneCv;  // an in-flight frame finished
+    std::deque<int> queue;
+    std::set<int> inflight;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> epoch{0};  // bumped on scrub to discard stale work
+    bool stopped = false;
+
+    ~Prefetcher() {
+        {
+            std::lock_guard lk(mtx);
+            stopped = true;
+            queue.clear();
+        }
+        cv.notify_all();
+        for (auto &worker: workers)
+            worker.join();
+    }
+};
+
+struct GlobalComm::Writer {
+    struct Job {
+        int frameid;
+        std::string cachedir;
+        ViewObjects objs;
+        bool cacheLightCameraOnly;
+        bool cacheMaterialOnly;
+    };
+    static constexpr size_t kMaxPending = 2;  // dumpFrameCache blocks beyond this
+
+    mutable std::mutex mtx;
+    std::condition_variable cv;      // new job queued or shutting down
+    std::condition_variable doneCv;  // a job finished
+    std::deque<std::shared_ptr<Job>> queue;
+    std::map<int, std::shared_ptr<Job>> pending;  // queued or being written
+    std::thread worker;
+    bool stopped = false;
+
+    ~Writer() {
+        {
+            std::lock_guard lk(mtx);
+            stopped = true;
+        }
+        cv.notify_all();
+        // queued frames are still written, the cache would be missing them otherwise
+        if (worker.joinable())
+            worker.join();
+    }
+};
+
+ZENO_API GlobalComm::GlobalComm()
+    : prefetchFrames(envconfig::getInt("PREFETCH_FRAMES", 0))
+    , maxCachedBytes(envconfig::getUint64("CACHE_BUDGET_MB", 0) << 20)
+    , m_writer(std::make_unique<Writer>())
+    , m_prefetcher(std::make_unique<Prefetcher>())
+{
+}
+
+ZENO_API GlobalComm::~GlobalComm() = default;
+
 ZENO_API void GlobalComm::newFrame() {
     std::lock_guard lck(m_mtx);
     log_debug("GlobalComm::newFrame {}", m_frames.size());
@@ -231,13 +319,59 @@ ZENO_API void GlobalComm::finishFrame() {
     m_maxPlayFrame += 1;
 }
 
-ZENO_API void GlobalComm::dumpFrameCache(int frameid, bool cacheLightCameraOnly, bool cacheMaterialOnly) {
+ZENO_API void GlobalComm::dumpFrameCache(int frameid, bool cacheLightCameraOnly, bool cacheMaterialOnly, bool keepResident) {
+    auto &wr = *m_writer;
+    {
+        std::unique_lock lk(wr.mtx);
+        wr.doneCv.wait(lk, [&] { return wr.queue.size() < Writer::kMaxPending; });
+    }
     std::lock_guard lck(m_mtx);
     int frameIdx = frameid - beginFrameNumber;
-    if (frameIdx >= 0 && frameIdx < m_frames.size()) {
-        log_debug("dumping frame {}", frameid);
-        toDisk(cacheFramePath, frameid, m_frames[frameIdx].view_objects, cacheLightCameraOnly, cacheMaterialOnly);
+    if (frameIdx < 0 || frameIdx >= m_frames.size() || cacheFramePath.empty())
+        return;
+    log_debug("dumping frame {}", frameid);
+    auto &objs = m_frames[frameIdx].view_objects;
+    auto job = std::make_shared<Writer::Job>(Writer::Job{frameid, cacheFramePath, objs, cacheLightCameraOnly, cacheMaterialOnly});
+    // a partial dump only writes some objects, keeping the rest resident would disagree with the disk
+    if (keepResident && maxCachedFrames != 0 && !cacheLightCameraOnly && !cacheMaterialOnly) {
+        m_inCacheFrames.insert(frameid);
+        // sized once written, drop what a previous dump of this frame counted
+        auto &bytes = m_frameBytes[frameid];
+        m_cachedBytes -= bytes;
+        bytes = 0;
+        _touchFrame(frameid);
+        _evictCachedFrames(m_lastLoadFrame < 0 ? frameid : m_lastLoadFrame);
+    } else {
+        objs.clear();
     }
+    std::lock_guard lk(wr.mtx);
+    if (!wr.worker.joinable())
+        wr.worker = std::thread([this] { _writeWorker(); });
+    wr.queue.push_back(job);
+    wr.pending[frameid] = std::move(job);
+    wr.cv.notify_one();
+}
+
+ZENO_API void GlobalComm::waitFrameCache(int frameid) {
+    auto &wr = *m_writer;
+    std::unique_lock lk(wr.mtx);
+    wr.doneCv.wait(lk, [&] { return !wr.pending.count(frameid); });
+}
+
+ZENO_API void GlobalComm::flushFrameCache() {
+    auto &wr = *m_writer;
+    std::unique_lock lk(wr.mtx);
+    wr.doneCv.wait(lk, [&] { return wr.pending.empty(); });
+}
+
+ZENO_API GlobalComm::CacheStats GlobalComm::cacheStats() const {
+    std::lock_guard lck(m_mtx);
+    CacheStats stats = m_stats;
+    stats.residentFrames = m_inCacheFrames.size();
+    stats.residentBytes = m_cachedBytes;
+    std::lock_guard lk(m_writer->mtx);
+    stats.pendingWrites = m_writer->pending.size();
+    return stats;
 }
 
 ZENO_API void GlobalComm::addViewObject(std::string const &key, std::shared_ptr<IObject> object) {
@@ -247,10 +381,31 @@ ZENO_API void GlobalComm::addViewObject(std::string const &key, std::shared_ptr<
     m_frames.back().view_objects.try_emplace(key, std::move(object));
 }
 
+// swaps a preview object of the last frame for its refined version, the new
+// key makes the viewport reload it even after the frame was completed
+ZENO_API bool GlobalComm::replaceViewObject(std::string const &oldKey, std::string const &key, std::shared_ptr<IObject> object) {
+    std::lock_guard lck(m_mtx);
+    log_debug("GlobalComm::replaceViewObject {} -> {}", oldKey, key);
+    if (m_frames.empty()) throw makeError("empty frame cache");
+    auto &objs = m_frames.back().view_objects.m_curr;
+    if (!objs.erase(oldKey))
+        return false;
+    objs.insert_or_assign(key, std::move(object));
+    return true;
+}
+
 ZENO_API void GlobalComm::clearState() {
+    cancelPrefetch();
+    flushFrameCache();
     std::lock_guard lck(m_mtx);
     m_frames.clear();
     m_inCacheFrames.clear();
+    m_frameBytes.clear();
+    m_cachedBytes = 0;
+    m_frameTouch.clear();
+    m_stats = {};
+    m_lastLoadFrame = -1;
+    m_playDirection = 0;
     m_maxPlayFrame = 0;
     maxCachedFrames = 1;
     cacheFramePath = {};
@@ -258,18 +413,46 @@ ZENO_API void GlobalComm::clearState() {
 
 ZENO_API void GlobalComm::clearFrameState()
 {
+    cancelPrefetch();
+    flushFrameCache();
     std::lock_guard lck(m_mtx);
     m_frames.clear();
     m_inCacheFrames.clear();
+    m_frameBytes.clear();
+    m_cachedBytes = 0;
+    m_frameTouch.clear();
+    m_lastLoadFrame = -1;
+    m_playDirection = 0;
     m_maxPlayFrame = 0;
 }
 
 ZENO_API void GlobalComm::frameCache(std::string const &path, int gcmax) {
     std::lock_guard lck(m_mtx);
+    if (path != cacheFramePath) {
+        m_foreignBlobs.clear();
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(std::filesystem::u8path(path + "/blobs"), ec), end; !ec && it != end; it.increment(ec))
+            m_foreignBlobs.insert(it->path().filename().u8string());
+    }
     cacheFramePath = path;
     maxCachedFrames = gcmax;
 }
 
+ZENO_API void GlobalComm::framePrefetch(int numFrames, size_t budgetBytes) {
+    std::lock_guard lck(m_mtx);
+    prefetchFrames = numFrames;
+    maxCachedBytes = budgetBytes;
+}
+
+ZENO_API void GlobalComm::cancelPrefetch() {
+    auto &pf = *m_prefetcher;
+    std::unique_lock lk(pf.mtx);
+    pf.epoch++;
+    pf.queue.clear();
+    // in-flight decodes cannot be interrupted, but their results are dropped:
+    pf.doneCv.wait(lk, [&] { return pf.inflight.empty(); });
+}
+
 ZENO_API void GlobalComm::initFrameRange(int beg, int end) {
     std::lock_guard lck(m_mtx);
     beginFrameNumber = beg;
@@ -298,36 +481,58 @@ ZENO_API std::pair<int, int> GlobalComm::frameRange() {
 }
 
 ZENO_API GlobalComm::ViewObjects const *GlobalComm::getViewObjects(const int frameid) {
-    std::lock_guard lck(m_mtx);
-    return _getViewObjects(frameid);
+    std::unique_lock lck(m_mtx);
+    return _getViewObjects(lck, frameid);
 }
 
-GlobalComm::ViewObjects const* GlobalComm::_getViewObjects(const int frameid) {
+GlobalComm::ViewObjects const* GlobalComm::_getViewObjects(std::unique_lock<std::mutex> &lck, const int frameid) {
     int frameIdx = frameid - beginFrameNumber;
     if (frameIdx < 0 || frameIdx >= m_frames.size())
         return nullptr;
     if (maxCachedFrames != 0) {
         // load back one gc:
         if (!m_inCacheFrames.count(frameid)) {  // notinmem then cacheit
-            bool ret = fromDisk(cacheFramePath, frameid, m_frames[frameIdx].view_objects);
-            if (!ret)
-                return nullptr;
-
-            m_inCacheFrames.insert(frameid);
-            // and dump one as balance:
-            if (m_inCacheFrames.size() && m_inCacheFrames.size() > maxCachedFrames) { // notindisk then dumpit
-                for (int i: m_inCacheFrames) {
-                    if (i != frameid) {
-                        // seems that objs will not be modified when load_objects called later.
-                        // so, there is no need to dump.
-                        //toDisk(cacheFramePath, i, m_frames[i - beginFrameNumber].view_objects);
-                        m_frames[i - beginFrameNumber].view_objects.clear();
-                        m_inCacheFrames.erase(i);
-                        break;
+            ViewObjects objs;
+            std::shared_ptr<Writer::Job> job;
+            {
+                std::lock_guard lk(m_writer->mtx);
+                if (auto it = m_writer->pending.find(frameid); it != m_writer->pending.end())
+                    job = it->second;
+            }
+            if (job && !job->cacheLightCameraOnly && !job->cacheMaterialOnly) {
+                // evicted before its write finished, the job still holds the objects
+                objs = job->objs;
+                m_stats.hits++;
+            } else {
+                if (job) {
+                    // the writer takes m_mtx once a write is done, don't hold it while waiting
+                    lck.unlock();
+                    waitFrameCache(frameid);
+                    lck.lock();
+                    frameIdx = frameid - beginFrameNumber;
+                    if (frameIdx < 0 || frameIdx >= m_frames.size())
+                        return nullptr;
+                    if (m_inCacheFrames.count(frameid)) {
+                        m_stats.hits++;
+                        _touchFrame(frameid);
+                        return &m_frames[frameIdx].view_objects;
                     }
                 }
+                bool ret = fromDisk(cacheFramePath, frameid, objs);
+                if (!ret)
+                    return nullptr;
+                m_stats.misses++;
             }
+            // seems that objs will not be modified when load_objects called later.
+            // so, there is no need to dump when evicting.
+            _installFrame(frameid, std::move(objs), frameDiskBytes(cacheFramePath, frameid));
+            _evictCachedFrames(frameid);
+        } else {
+            m_stats.hits++;
+            _touchFrame(frameid);
         }
+    } else {
+        m_stats.hits++;
     }
     return &m_frames[frameIdx].view_objects;
 }
@@ -355,7 +560,8 @@ ZENO_API bool GlobalComm::load_objects(
     if (!callback)
         return false;
 
-    std::lock_guard lck(m_mtx);
+    _waitPrefetch(frameid);
+    std::unique_lock lck(m_mtx);
 
     int frame = frameid;
     frame -= beginFrameNumber;
@@ -367,7 +573,8 @@ ZENO_API bool GlobalComm::load_objects(
 
     isFrameValid = true;
     bool inserted = false;
-    auto const* viewObjs = _getViewObjects(frameid);
+    auto const* viewObjs = _getViewObjects(lck, frameid);
+    _schedulePrefetch(frameid);
     if (viewObjs) {
         zeno::log_trace("load_objects: {} objects at frame {}", viewObjs->size(), frameid);
         inserted = callback(viewObjs->m_curr);
@@ -419,6 +626,7 @@ ZENO_API std::string GlobalComm::cachePath()
 
 ZENO_API bool GlobalComm::removeCache(int frame)
 {
+    waitFrameCache(frame);
     std::lock_guard lck(m_mtx);
     bool hasZencacheOnly = true;
     std::filesystem::path dirToRemove = std::filesystem::u8path(cacheFramePath + "/" + std::to_string(1000000 + frame).substr(1));
@@ -435,11 +643,26 @@ ZENO_API bool GlobalComm::removeCache(int frame)
         }
         if (hasZencacheOnly)
         {
+            if (m_inCacheFrames.count(frame))
+                _evictFrame(frame);
             m_frames[frame - beginFrameNumber].frame_state = FRAME_BROKEN;
             std::filesystem::remove_all(dirToRemove);
+            _releaseFrameBlobs(frame);
             zeno::log_info("remove dir: {}", dirToRemove);
         }
     }
+    //the shared blobs go with the last frame that may reference them
+    std::filesystem::path blobDir = std::filesystem::u8path(cacheFramePath + "/blobs");
+    if (frame == endFrameNumber && std::filesystem::exists(blobDir))
+    {
+        bool onlyBlobs = true;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(std::filesystem::u8path(cacheFramePath)))
+            onlyBlobs = onlyBlobs && entry.path().filename() == "blobs";
+        if (onlyBlobs) {
+            std::filesystem::remove_all(blobDir);
+            _forgetBlobs();
+        }
+    }
     if (frame == endFrameNumber && std::filesystem::exists(std::filesystem::u8path(cacheFramePath)) && std::filesystem::is_empty(std::filesystem::u8path(cacheFramePath)))
     {
         std::filesystem::remove(std::filesystem::u8path(cacheFramePath));
@@ -450,12 +673,241 @@ ZENO_API bool GlobalComm::removeCache(int frame)
 
 ZENO_API void GlobalComm::removeCachePath()
 {
+    flushFrameCache();
     std::lock_guard lck(m_mtx);
     std::filesystem::path dirToRemove = std::filesystem::u8path(cacheFramePath);
     if (std::filesystem::exists(dirToRemove) && cacheFramePath.find(".") == std::string::npos)
     {
         std::filesystem::remove_all(dirToRemove);
         zeno::log_info("remove dir: {}", dirToRemove);
+        _forgetBlobs();
+    }
+}
+
+bool GlobalComm::_needPrefetch(int frameid) const {
+    int frameIdx = frameid - beginFrameNumber;
+    return maxCachedFrames != 0 && !cacheFramePath.empty()
+        && frameIdx >= 0 && frameIdx < m_frames.size()
+        && m_frames[frameIdx].frame_state == FRAME_COMPLETED
+        && !m_inCacheFrames.count(frameid)
+        && !_isWritePending(frameid);
+}
+
+void GlobalComm::_releaseFrameBlobs(int frameid) {
+    auto it = m_frameBlobs.find(frameid);
+    if (it == m_frameBlobs.end())
+        return;
+    for (auto const &name: it->second) {
+        if (--m_blobRefs[name] <= 0) {
+            m_blobRefs.erase(name);
+            m_blobGarbage.insert(name);
+        }
+    }
+    m_frameBlobs.erase(it);
+}
+
+void GlobalComm::_collectBlobs() {
+    for (auto const &name: m_blobGarbage) {
+        if (m_blobRefs.count(name) || m_foreignBlobs.count(name))
+            continue;
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::u8path(cacheFramePath + "/blobs/" + name), ec);
+        log_debug("collected zencache blob {}", name);
+    }
+    m_blobGarbage.clear();
+}
+
+void GlobalComm::_forgetBlobs() {
+    m_frameBlobs.clear();
+    m_blobRefs.clear();
+    m_blobGarbage.clear();
+    m_foreignBlobs.clear();
+    ObjectCodecBlobScope::forget(cacheFramePath + "/blobs");
+}
+
+bool GlobalComm::_isWritePending(int frameid) const {
+    std::lock_guard lk(m_writer->mtx);
+    return m_writer->pending.count(frameid);
+}
+
+void GlobalComm::_touchFrame(int frameid) {
+    m_frameTouch[frameid] = ++m_touchTick;
+}
+
+void GlobalComm::_installFrame(int frameid, ViewObjects &&objs, size_t bytes) {
+    m_frames[frameid - beginFrameNumber].view_objects = std::move(objs);
+    m_inCacheFrames.insert(frameid);
+    m_frameBytes[frameid] = bytes;
+    m_cachedBytes += bytes;
+    _touchFrame(frameid);
+}
+
+void GlobalComm::_evictFrame(int frameid) {
+    m_frames[frameid - beginFrameNumber].view_objects.clear();
+    m_inCacheFrames.erase(frameid);
+    if (auto it = m_frameBytes.find(frameid); it != m_frameBytes.end()) {
+        m_cachedBytes -= it->second;
+        m_frameBytes.erase(it);
+    }
+    m_frameTouch.erase(frameid);
+    m_stats.evictions++;
+}
+
+void GlobalComm::_evictCachedFrames(int frameid) {
+    // frames just ahead of the play head are the last to go, then big frames
+    // that were not touched for long, then the farthest ones:
+    auto evictionRank = [&] (int i) {
+        int ahead = (i - frameid) * m_playDirection;
+        bool inWindow = m_playDirection != 0 && ahead > 0 && ahead <= prefetchFrames;
+        auto touch = m_frameTouch.find(i);
+        size_t age = m_touchTick - (touch != m_frameTouch.end() ? touch->second : 0);
+        auto bytes = m_frameBytes.find(i);
+        size_t megs = (bytes != m_frameBytes.end() ? bytes->second >> 20 : 0) + 1;
+        return std::make_tuple(!inWindow, age * megs, std::abs(i - frameid));
+    };
+    auto overBudget = [&] {
+        if (maxCachedBytes != 0)
+            return m_cachedBytes > maxCachedBytes;
+        size_t maxFrames = maxCachedFrames + (m_playDirection != 0 ? std::max(prefetchFrames, 0) : 0);
+        return m_inCacheFrames.size() > maxFrames;
+    };
+    while (m_inCacheFrames.size() > 1 && overBudget()) {
+        int victim = frameid;
+        for (int i: m_inCacheFrames) {
+            if (i != frameid && (victim == frameid || evictionRank(i) > evictionRank(victim)))
+                victim = i;
+        }
+        if (victim == frameid)
+            break;
+        _evictFrame(victim);
+    }
+}
+
+void GlobalComm::_schedulePrefetch(int frameid) {
+    int delta = m_lastLoadFrame < 0 ? 0 : frameid - m_lastLoadFrame;
+    m_lastLoadFrame = frameid;
+    if (delta != 0 && std::abs(delta) <= std::max(prefetchFrames, 1)) {
+        m_playDirection = delta > 0 ? 1 : -1;
+    } else if (delta != 0) {
+        // a scrub: whatever was queued for the old position is useless now
+        m_playDirection = 0;
+        auto &pf = *m_prefetcher;
+        std::lock_guard lk(pf.mtx);
+        pf.epoch++;
+        pf.queue.clear();
+    }
+    if (m_playDirection == 0 || prefetchFrames <= 0)
+        return;
+
+    auto &pf = *m_prefetcher;
+    std::lock_guard lk(pf.mtx);
+    if (pf.workers.empty()) {
+        size_t nworkers = std::clamp(std::thread::hardware_concurrency() / 4, 1u, 4u);
+        for (size_t i = 0; i < nworkers; i++)
+            pf.workers.emplace_back([this] { _prefetchWorker(); });
+    }
+    pf.queue.clear();
+    for (int k = 1; k <= prefetchFrames; k++) {
+        int i = frameid + k * m_playDirection;
+        if (_needPrefetch(i) && !pf.inflight.count(i))
+            pf.queue.push_back(i);
+    }
+    pf.cv.notify_all();
+}
+
+void GlobalComm::_waitPrefetch(int frameid) {
+    auto &pf = *m_prefetcher;
+    std::unique_lock lk(pf.mtx);
+    pf.doneCv.wait(lk, [&] { return !pf.inflight.count(frameid); });
+}
+
+void GlobalComm::_prefetchWorker() {
+    auto &pf = *m_prefetcher;
+    while (true) {
+        int frameid;
+        unsigned epoch;
+        {
+            std::unique_lock lk(pf.mtx);
+            pf.cv.wait(lk, [&] { return pf.stopped || !pf.queue.empty(); });
+            if (pf.stopped)
+                return;
+            frameid = pf.queue.front();
+            pf.queue.pop_front();
+            epoch = pf.epoch;
+            pf.inflight.insert(frameid);
+        }
+
+        std::string cachedir;
+        {
+            std::lock_guard lck(m_mtx);
+            if (_needPrefetch(frameid) && pf.epoch == epoch)
+                cachedir = cacheFramePath;
+        }
+
+        ViewObjects objs;
+        bool ret = !cachedir.empty() && fromDisk(cachedir, frameid, objs);
+        size_t bytes = ret ? frameDiskBytes(cachedir, frameid) : 0;
+
+        {
+            std::lock_guard lck(m_mtx);
+            if (ret && pf.epoch == epoch && cachedir == cacheFramePath && _needPrefetch(frameid)) {
+                log_debug("prefetched frame {} ({} bytes)", frameid, bytes);
+                m_stats.prefetched++;
+                _installFrame(frameid, std::move(objs), bytes);
+                _evictCachedFrames(m_lastLoadFrame < 0 ? frameid : m_lastLoadFrame);
+            }
+            std::lock_guard lk(pf.mtx);
+            pf.inflight.erase(frameid);
+        }
+        pf.doneCv.notify_all();
+    }
+}
+
+
+void GlobalComm::_writeWorker() {
+    auto &wr = *m_writer;
+    while (true) {
+        std::shared_ptr<Writer::Job> job;
+        ViewObjects objs;
+        {
+            std::unique_lock lk(wr.mtx);
+            wr.cv.wait(lk, [&] { return wr.stopped || !wr.queue.empty(); });
+            if (wr.queue.empty())
+                return;
+            job = wr.queue.front();
+            wr.queue.pop_front();
+            objs = job->objs;  // toDisk clears what it is given
+        }
+        wr.doneCv.notify_all();
+
+        std::vector<std::string> blobRefs;
+        toDisk(job->cachedir, job->frameid, objs, job->cacheLightCameraOnly, job->cacheMaterialOnly, "", &blobRefs);
+        size_t bytes = frameDiskBytes(job->cachedir, job->frameid);
+        {
+            // released before taking m_mtx, loaders wait for a write while holding it
+            std::lock_guard lk(wr.mtx);
+            if (auto it = wr.pending.find(job->frameid); it != wr.pending.end() && it->second == job)
+                wr.pending.erase(it);
+        }
+        wr.doneCv.notify_all();
+
+        std::lock_guard lck(m_mtx);
+        log_debug("wrote frame {} ({} bytes)", job->frameid, bytes);
+        m_stats.writes++;
+        m_stats.bytesWritten += bytes;
+        if (job->cachedir == cacheFramePath) {
+            _releaseFrameBlobs(job->frameid);
+            for (auto const &name: blobRefs)
+                m_blobRefs[name]++;
+            m_frameBlobs[job->frameid] = std::move(blobRefs);
+            // only here, no frame is being encoded that might refer to a blob we delete
+            _collectBlobs();
+        }
+        if (auto it = m_frameBytes.find(job->frameid); it != m_frameBytes.end() && job->cachedir == cacheFramePath) {
+            m_cachedBytes += bytes - it->second;
+            it->second = bytes;
+            _evictCachedFrames(m_lastLoadFrame < 0 ? job->frameid : m_lastLoadFrame);
+        }
     }
 }
 
@@ -0,0 +1,283 @@
+#include <zeno/funcs/GraphCodec.h>
+#include <zeno/utils/log.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+#include <unordered_map>
+#include <string_view>
+#include <optional>
+#include <string>
+#include <memory>
+#include <limits>
+
+namespace zeno {
+
+namespace {
+
+using graphcodec::ValueTag;
+
+static void putVarint(std::vector<char> &out, uint32_t x) {
+    while (x >= 0x80) {
+        out.push_back((char)(x & 0x7f | 0x80));
+        x >>= 7;
+    }
+    out.push_back((char)x);
+}
+
+template <class T>
+static void putPod(std::vector<char> &out, T const &x) {
+    auto p = (char const *)&x;
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+struct StringTable {
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string_view> strs;
+
+    uint32_t intern(const char *str, size_t len) {
+        auto [it, inserted] = ids.try_emplace(std::string(str, len), (uint32_t)strs.size());
+        if (inserted)
+            strs.emplace_back(it->first);
+        return it->second;
+    }
+};
+
+// SAX handler turning the `[[cmd, args...], ...]` program array into the
+// binary command stream in one pass, without building a DOM.
+struct GraphEncodeHandler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, GraphEncodeHandler> {
+    StringTable table;
+    std::vector<char> body;
+    std::vector<char> cmdArgs;
+    uint32_t numCmds = 0;
+    uint32_t cmdArgc = 0;
+    int depth = 0;
+
+    // numeric array argument, becomes a vecNi/vecNf if it has 2..4 elements
+    std::optional<std::vector<double>> vecArg;
+    bool vecAllInt = true;
+    bool vecBroken = false;
+    int vecNest = 0;
+
+    // raw JSON capture of object arguments
+    std::unique_ptr<rapidjson::StringBuffer> rawBuf;
+    std::unique_ptr<rapidjson::Writer<rapidjson::StringBuffer>> rawWriter;
+    int rawDepth = 0;
+
+    bool capturing() const { return rawWriter != nullptr; }
+
+    void beginRaw() {
+        rawBuf = std::make_unique<rapidjson::StringBuffer>();
+        rawWriter = std::make_unique<rapidjson::Writer<rapidjson::StringBuffer>>(*rawBuf);
+        rawDepth = 0;
+    }
+
+    void endRaw() {
+        rawWriter = nullptr;
+        cmdArgs.push_back((char)ValueTag::Json);
+        putVarint(cmdArgs, table.intern(rawBuf->GetString(), rawBuf->GetSize()));
+        rawBuf = nullptr;
+        cmdArgc++;
+    }
+
+    void endVec() {
+        auto vals = std::move(*vecArg);
+        vecArg = std::nullopt;
+        size_t n = vals.size();
+        if (vecBroken || n < 2 || n > 4) {
+            // not a vector literal, loadGraph has no meaning for it either
+            scalar(ValueTag::Null);
+            return;
+        }
+        if (vecAllInt) {
+            cmdArgs.push_back((char)((int)ValueTag::Vec2i + (int)n - 2));
+            for (double v: vals)
+                putPod(cmdArgs, (int32_t)v);
+        } else {
+            cmdArgs.push_back((char)((int)ValueTag::Vec2f + (int)n - 2));
+            for (double v: vals)
+                putPod(cmdArgs, (float)v);
+        }
+        cmdArgc++;
+    }
+
+    void scalar(ValueTag tag) {
+        cmdArgs.push_back((char)tag);
+        cmdArgc++;
+    }
+
+    bool number(double v, bool isInt) {
+        if (vecArg) {
+            vecArg->push_back(v);
+            vecAllInt = vecAllInt && isInt;
+        } else if (depth != 2) {
+            return false;
+        } else if (isInt) {
+            scalar(ValueTag::Int);
+            putPod(cmdArgs, (int32_t)v);
+        } else {
+            scalar(ValueTag::Float);
+            putPod(cmdArgs, (float)v);
+        }
+        return true;
+    }
+
+    bool Null() {
+        if (capturing()) return rawWriter->Null();
+        if (vecArg) { vecBroken = true; return true; }
+        if (depth != 2) return false;
+        scalar(ValueTag::Null);
+        return true;
+    }
+
+    bool Bool(bool b) {
+        if (capturing()) return rawWriter->Bool(b);
+        if (vecArg) { vecBroken = true; return true; }
+        if (depth != 2) return false;
+        scalar(ValueTag::Bool);
+        cmdArgs.push_back((char)b);
+        return true;
+    }
+
+    bool Int(int i) {
+        if (capturing()) return rawWriter->Int(i);
+        return number(i, true);
+    }
+
+    bool Uint(unsigned u) {
+        if (capturing()) return rawWriter->Uint(u);
+        return number(u, u <= (unsigned)std::numeric_limits<int>::max());
+    }
+
+    bool Int64(int64_t i) {
+        if (capturing()) return rawWriter->Int64(i);
+        return number((double)i, false);
+    }
+
+    bool Uint64(uint64_t u) {
+        if (capturing()) return rawWriter->Uint64(u);
+        return number((double)u, false);
+    }
+
+    bool Double(double d) {
+        if (capturing()) return rawWriter->Double(d);
+        return number(d, false);
+    }
+
+    bool String(const char *str, rapidjson::SizeType len, bool copy) {
+        if (capturing()) return rawWriter->String(str, len, copy);
+        if (vecArg) { vecBroken = true; return true; }
+        if (depth != 2) return false;
+        if (cmdArgc == 0) {
+            // the command name
+            putVarint(body, table.intern(str, len));
+            cmdArgc = 1;
+            return true;
+        }
+        scalar(ValueTag::String);
+        putVarint(cmdArgs, table.intern(str, len));
+        return true;
+    }
+
+    bool Key(const char *str, rapidjson::SizeType len, bool copy) {
+        if (capturing()) return rawWriter->Key(str, len, copy);
+        return vecArg.has_value();
+    }
+
+    bool StartObject() {
+        if (!capturing()) {
+            if (vecArg) {
+                vecBroken = true;
+                vecNest++;
+                return true;
+            }
+            if (depth != 2) return false;
+            beginRaw();
+        }
+        rawDepth++;
+        return rawWriter->StartObject();
+    }
+
+    bool EndObject(rapidjson::SizeType n) {
+        if (!capturing()) {
+            vecNest--;
+            return vecArg.has_value();
+        }
+        bool ok = rawWriter->EndObject(n);
+        if (--rawDepth == 0)
+            endRaw();
+        return ok;
+    }
+
+    bool StartArray() {
+        if (capturing()) {
+            rawDepth++;
+            return rawWriter->StartArray();
+        }
+        if (vecArg) {
+            // nested arrays are never vector literals
+            vecBroken = true;
+            vecNest++;
+            return true;
+        }
+        depth++;
+        if (depth == 2) {
+            cmdArgs.clear();
+            cmdArgc = 0;
+        } else if (depth == 3) {
+            vecArg.emplace();
+            vecAllInt = true;
+            vecBroken = false;
+            vecNest = 0;
+        }
+        return true;
+    }
+
+    bool EndArray(rapidjson::SizeType n) {
+        if (capturing()) {
+            bool ok = rawWriter->EndArray(n);
+            if (--rawDepth == 0)
+                endRaw();
+            return ok;
+        }
+        if (vecArg && vecNest > 0) {
+            vecNest--;
+            return true;
+        }
+        if (depth == 3) {
+            endVec();
+        } else if (depth == 2) {
+            if (cmdArgc == 0)
+                return false;
+            putVarint(body, cmdArgc - 1);
+            body.insert(body.end(), cmdArgs.begin(), cmdArgs.end());
+            numCmds++;
+        }
+        depth--;
+        return true;
+    }
+};
+
+}
+
+ZENO_API bool encodeGraphFromJson(const char *json, std::vector<char> &buf) {
+    GraphEncodeHandler handler;
+    rapidjson::Reader reader;
+    rapidjson::StringStream ss(json);
+    if (!reader.Parse(ss, handler)) {
+        log_error("cannot encode program JSON: parse error {} at offset {}",
+                  (int)reader.GetParseErrorCode(), reader.GetErrorOffset());
+        return false;
+    }
+
+    buf.insert(buf.end(), std::begin(graphcodec::kMagic), std::end(graphcodec::kMagic));
+    putVarint(buf, (uint32_t)handler.table.strs.size());
+    for (auto const &str: handler.table.strs) {
+        putVarint(buf, (uint32_t)str.size());
+        buf.insert(buf.end(), str.begin(), str.end());
+    }
+    putVarint(buf, handler.numCmds);
+    buf.insert(buf.end(), handler.body.begin(), handler.body.end());
+    return true;
+}
+
+}
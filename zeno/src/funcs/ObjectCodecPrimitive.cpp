@@ -1,11 +1,24 @@
 #include <zeno/funcs/ObjectCodec.h>
 #include <zeno/types/PrimitiveObject.h>
 #include <zeno/types/MaterialObject.h>
+#include <zeno/types/UserData.h>
 #include <zeno/utils/variantswitch.h>
 #include <zeno/utils/log.h>
 //#include <zeno/utils/zeno_p.h>
+#include <zeno/utils/envconfig.h>
+#include <zeno/utils/Error.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_reduce.h>
 #include <algorithm>
 #include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
 namespace zeno {
 
 namespace _implObjectCodec {
@@ -19,44 +32,509 @@ struct AttributeHeader {
     char name[128];
 };
 
+// AttributeHeader::type holds the AttrAcceptAll index in its low byte and the packing above it
+enum AttrPacking : size_t {
+    kPackRaw = 0,
+    kPackHalf,      // float components as IEEE half
+    kPackU8,        // int components in [0, 255]
+    kPackU16,       // int components in [0, 65535]
+    kPackUnorm8,    // float components in [0, 1], lossy
+    kPackUnorm16,   // float components in [0, 1], lossy
+    kPackOct32,     // unit vec3f as two snorm16 octahedral coordinates, lossy
+};
+
 struct AttrVectorHeader {
     size_t size;
     size_t nattrs;
 };
 
+// a size with this bit set is followed by a BlobRef instead of the raw array
+constexpr size_t kBlobRef = size_t(1) << 63;
+constexpr size_t kMinBlobBytes = 64 << 10;
+constexpr int kKeyframeInterval = 16;
+
+struct BlobRef {
+    uint64_t hash;
+    uint64_t bytes;
+    uint32_t mode;      // 0: the stored array, 1: quantised deltas to it follow
+    uint32_t bits;
+    float scale[3];
+    float pad;
+};
+
+thread_local ObjectCodecBlobScope *tlsBlobScope = nullptr;
+
+uint64_t hashBytes(const char *data, size_t bytes) {
+    constexpr size_t kChunk = 1 << 20;
+    size_t nchunks = (bytes + kChunk - 1) / kChunk;
+    std::vector<uint64_t> partial(nchunks);
+    parallel_for(nchunks, [&] (size_t c) {
+        uint64_t h = 0x9e3779b97f4a7c15ull ^ c;
+        size_t b = c * kChunk, e = std::min(bytes, b + kChunk), i = b;
+        for (; i + 8 <= e; i += 8) {
+            uint64_t w;
+            std::memcpy(&w, data + i, 8);
+            h = (h ^ (w * 0xff51afd7ed558ccdull)) * 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 29;
+        }
+        for (; i < e; i++)
+            h = (h ^ (unsigned char)data[i]) * 1099511628211ull;
+        partial[c] = h;
+    });
+    uint64_t h = bytes;
+    for (auto p: partial)
+        h ^= p + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+std::filesystem::path blobPath(std::string const &blobdir, uint64_t hash, uint64_t bytes) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%llx.zenblob", (unsigned long long)hash, (unsigned long long)bytes);
+    return std::filesystem::u8path(blobdir) / name;
+}
+
+// frame cache writer state, kept per blob dir for the lifetime of the process
+struct BlobWriter {
+    struct Stream {
+        uint64_t lastHash = 0;
+        uint64_t keyHash = 0;
+        std::vector<vec3f> keyPos;
+        int sinceKey = 0;
+    };
+    std::map<std::string, Stream> streams;
+    std::set<uint64_t> written;
+
+    // blobs may have been collected since we wrote them, so always look at the disk
+    bool store(std::string const &blobdir, uint64_t hash, const char *data, size_t bytes) {
+        auto path = blobPath(blobdir, hash, bytes);
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) {
+            std::filesystem::create_directories(path.parent_path(), ec);
+            auto tmp = path;
+            tmp += ".tmp";
+            std::ofstream ofs(tmp, std::ios::binary);
+            ofs.write(data, bytes);
+            ofs.close();
+            if (!ofs) {
+                log_error("failed to write zencache blob {}", path);
+                return false;
+            }
+            std::filesystem::rename(tmp, path, ec);
+            if (ec) {
+                log_error("failed to write zencache blob {}", path);
+                return false;
+            }
+        }
+        written.insert(hash);
+        return true;
+    }
+};
+
+std::mutex g_writerMtx;
+std::map<std::string, BlobWriter> g_writers;
+
+// recently read blobs, so that neighbouring frames read each one from disk once
+struct BlobReader {
+    static constexpr size_t kMaxBytes = size_t(256) << 20;
+    std::mutex mtx;
+    std::list<std::pair<std::string, std::shared_ptr<std::vector<char> const>>> lru;
+    size_t bytes = 0;
+
+    std::shared_ptr<std::vector<char> const> load(std::filesystem::path const &path, size_t size) {
+        auto key = path.u8string();
+        {
+            std::lock_guard lck(mtx);
+            for (auto it = lru.begin(); it != lru.end(); ++it) {
+                if (it->first == key) {
+                    lru.splice(lru.begin(), lru, it);
+                    return it->second;
+                }
+            }
+        }
+        auto data = std::make_shared<std::vector<char>>(size);
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs.read(data->data(), size))
+            throw makeError("zencache blob missing or truncated: " + key);
+        std::lock_guard lck(mtx);
+        lru.emplace_front(key, data);
+        bytes += size;
+        while (bytes > kMaxBytes && lru.size() > 1) {
+            bytes -= lru.back().second->size();
+            lru.pop_back();
+        }
+        return data;
+    }
+};
+
+BlobReader g_reader;
+
+int deltaBits() {
+    static int bits = envconfig::getInt("CACHE_DELTA_BITS", 0);
+    return bits == 8 || bits == 16 ? bits : 0;
+}
+
+template <class Q>
+void quantiseDeltas(vec3f const *pos, vec3f const *key, size_t n, BlobRef &ref, std::vector<char> &out) {
+    constexpr float qmax = (float)std::numeric_limits<Q>::max();
+    vec3f maxabs(0);
+    for (size_t i = 0; i < n; i++)
+        maxabs = zeno::max(maxabs, zeno::abs(pos[i] - key[i]));
+    for (int c = 0; c < 3; c++)
+        ref.scale[c] = maxabs[c] > 0 ? maxabs[c] / qmax : 1.f;
+    size_t base = out.size();
+    out.resize(base + n * 3 * sizeof(Q));
+    auto *q = reinterpret_cast<Q *>(out.data() + base);
+    parallel_for(n, [&] (size_t i) {
+        for (int c = 0; c < 3; c++)
+            q[i * 3 + c] = (Q)std::lround((pos[i][c] - key[i][c]) / ref.scale[c]);
+    });
+}
+
+// Decides whether an array goes to the blob store. On success `out` holds the
+// BlobRef, followed by the quantised deltas if any.
+template <class T>
+bool encodeBlob(std::string const &name, T const *data, size_t n, std::vector<char> &out) {
+    auto scope = tlsBlobScope;
+    size_t bytes = sizeof(T) * n;
+    if (!scope || bytes < kMinBlobBytes)
+        return false;
+    auto hash = hashBytes((const char *)data, bytes);
+    std::lock_guard lck(g_writerMtx);
+    auto &writer = g_writers[scope->blobdir];
+    auto &stream = writer.streams[scope->stream + '#' + std::to_string(scope->counter) + '/' + name];
+    BlobRef ref{hash, bytes, 0, 0, {1, 1, 1}, 0};
+
+    if constexpr (std::is_same_v<T, vec3f>) {
+        if (name == "verts" && deltaBits()) {
+            std::error_code ec;
+            if (stream.sinceKey > 0 && !std::filesystem::exists(blobPath(scope->blobdir, stream.keyHash, bytes), ec))
+                stream.sinceKey = 0;
+            bool sameKey = stream.sinceKey > 0 && stream.keyHash == hash;
+            if (!sameKey && stream.sinceKey > 0 && stream.sinceKey < kKeyframeInterval && stream.keyPos.size() == n) {
+                ref.hash = stream.keyHash;
+                ref.mode = 1;
+                ref.bits = deltaBits();
+                out.resize(sizeof(BlobRef));
+                if (ref.bits == 8)
+                    quantiseDeltas<int8_t>(data, stream.keyPos.data(), n, ref, out);
+                else
+                    quantiseDeltas<int16_t>(data, stream.keyPos.data(), n, ref, out);
+                std::memcpy(out.data(), &ref, sizeof(BlobRef));
+                scope->referenced.push_back(blobPath({}, ref.hash, bytes).u8string());
+                stream.sinceKey++;
+                stream.lastHash = hash;
+                return true;
+            }
+            if (!sameKey) {
+                if (!writer.store(scope->blobdir, hash, (const char *)data, bytes))
+                    return false;
+                stream.keyHash = hash;
+                stream.keyPos.assign(data, data + n);
+                stream.sinceKey = 1;
+            } else {
+                stream.sinceKey++;
+            }
+            stream.lastHash = hash;
+            scope->referenced.push_back(blobPath({}, hash, bytes).u8string());
+            out.assign((const char *)&ref, (const char *)(&ref + 1));
+            return true;
+        }
+    }
+
+    // arrays seen once stay inline; the second occurrence goes to the store
+    bool repeated = writer.written.count(hash) || stream.lastHash == hash;
+    stream.lastHash = hash;
+    if (!repeated || !writer.store(scope->blobdir, hash, (const char *)data, bytes))
+        return false;
+    scope->referenced.push_back(blobPath({}, hash, bytes).u8string());
+    out.assign((const char *)&ref, (const char *)(&ref + 1));
+    return true;
+}
+
+template <class T, class It>
+void decodeArray(std::vector<T> &arr, size_t size, It &it) {
+    if (!(size & kBlobRef)) {
+        arr.reserve(size);
+        std::copy_n((T const *)it, size, std::back_inserter(arr));
+        it += sizeof(T) * size;
+        return;
+    }
+    size &= ~kBlobRef;
+    BlobRef ref;
+    std::copy_n(it, sizeof(ref), (char *)&ref);
+    it += sizeof(ref);
+    if (!tlsBlobScope)
+        throw makeError("zencache blob referenced outside of a blob scope");
+    if (ref.bytes != sizeof(T) * size)
+        throw makeError("zencache blob size mismatch");
+    auto blob = g_reader.load(blobPath(tlsBlobScope->blobdir, ref.hash, ref.bytes), ref.bytes);
+    arr.resize(size);
+    std::memcpy(arr.data(), blob->data(), ref.bytes);
+    if (ref.mode == 1) {
+        if constexpr (std::is_same_v<T, vec3f>) {
+            auto apply = [&] (auto const *q) {
+                parallel_for(size, [&] (size_t i) {
+                    for (int c = 0; c < 3; c++)
+                        arr[i][c] += q[i * 3 + c] * ref.scale[c];
+                });
+            };
+            if (ref.bits == 8)
+                apply((int8_t const *)it);
+            else
+                apply((int16_t const *)it);
+            it += size * 3 * (ref.bits / 8);
+        } else {
+            throw makeError("zencache delta on a non-vec3f array");
+        }
+    }
+}
+
+uint16_t floatToHalf(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t fexp = (x >> 23) & 0xff;
+    uint32_t mant = x & 0x7fffff;
+    if (fexp == 0xff)
+        return sign | 0x7c00 | (mant ? 0x200 : 0);
+    int exp = (int)fexp - 127 + 15;
+    if (exp >= 31)
+        return sign | 0x7c00;
+    if (exp <= 0) {
+        if (exp < -10)
+            return sign;
+        mant |= 0x800000;
+        int shift = 14 - exp;
+        uint32_t h = mant >> shift, rem = mant & ((1u << shift) - 1), mid = 1u << (shift - 1);
+        if (rem > mid || (rem == mid && (h & 1)))
+            h++;
+        return sign | h;
+    }
+    uint32_t h = sign | (exp << 10) | (mant >> 13);
+    uint32_t rem = mant & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+        h++;  // a carry into the exponent is still the right rounding
+    return h;
+}
+
+float halfToFloat(uint16_t h) {
+    uint32_t sign = uint32_t(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f, mant = h & 0x3ff, x;
+    if (exp == 0) {
+        if (mant == 0) {
+            x = sign;
+        } else {
+            exp = 127 - 15 + 1;
+            while (!(mant & 0x400)) {
+                mant <<= 1;
+                exp--;
+            }
+            x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+        }
+    } else if (exp == 31) {
+        x = sign | 0x7f800000 | (mant << 13);
+    } else {
+        x = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+    }
+    float f;
+    std::memcpy(&f, &x, 4);
+    return f;
+}
+
+vec2f octWrap(vec2f v) {
+    return {(1 - std::abs(v[1])) * (v[0] >= 0 ? 1 : -1), (1 - std::abs(v[0])) * (v[1] >= 0 ? 1 : -1)};
+}
+
+template <class T>
+using attr_scalar_t = std::conditional_t<std::is_same_v<decay_vec_t<T>, int>, int, float>;
+
+template <class T>
+constexpr size_t attrDim = is_vec_n<T> ? is_vec_n<T> : 1;
+
+template <class T>
+size_t packedBytes(size_t packing, size_t n) {
+    switch (packing) {
+    case kPackHalf: case kPackU16: case kPackUnorm16: return n * attrDim<T> * 2;
+    case kPackU8: case kPackUnorm8: return n * attrDim<T>;
+    case kPackOct32: return n * 4;
+    default: return n * sizeof(T);
+    }
+}
+
+// Picks the smallest lossless packing, or the lossy one asked for in userData
+// `quantise_<attr>` ("half", "unorm8", "unorm16", "oct32").
+template <class T>
+size_t choosePacking(std::vector<T> const &attr, std::string const &hint) {
+    using S = attr_scalar_t<T>;
+    auto comps = reinterpret_cast<S const *>(attr.data());
+    size_t ncomps = attr.size() * attrDim<T>;
+    if (!ncomps)
+        return kPackRaw;
+    if constexpr (std::is_same_v<S, int>) {
+        int lo = parallel_reduce_min(comps, comps + ncomps);
+        int hi = parallel_reduce_max(comps, comps + ncomps);
+        if (lo >= 0 && hi <= 0xff)
+            return kPackU8;
+        if (lo >= 0 && hi <= 0xffff)
+            return kPackU16;
+    } else {
+        if (hint == "half")
+            return kPackHalf;
+        if (hint == "unorm8")
+            return kPackUnorm8;
+        if (hint == "unorm16")
+            return kPackUnorm16;
+        if (hint == "oct32") {
+            if constexpr (std::is_same_v<T, vec3f>)
+                return kPackOct32;
+            log_warn("zencache: oct32 quantisation only applies to vec3f attributes");
+        } else if (!hint.empty()) {
+            log_warn("zencache: unknown quantisation `{}`", hint);
+        }
+        bool exact = parallel_reduce(size_t(0), ncomps, true, [] (bool a, bool b) { return a && b; }, [&] (size_t i) {
+            float back = halfToFloat(floatToHalf(comps[i]));
+            return std::memcmp(&back, &comps[i], 4) == 0;
+        });
+        if (exact)
+            return kPackHalf;
+    }
+    return kPackRaw;
+}
+
+template <class T>
+std::vector<char> encodePacked(std::vector<T> const &attr, size_t packing) {
+    using S = attr_scalar_t<T>;
+    auto comps = reinterpret_cast<S const *>(attr.data());
+    size_t ncomps = attr.size() * attrDim<T>;
+    std::vector<char> out(packedBytes<T>(packing, attr.size()));
+    auto store = [&] (auto *dst, auto f) {
+        parallel_for(ncomps, [&] (size_t i) {
+            dst[i] = f(comps[i]);
+        });
+    };
+    switch (packing) {
+    case kPackHalf:
+        store((uint16_t *)out.data(), [] (S c) { return floatToHalf(c); });
+        break;
+    case kPackU8:
+        store((uint8_t *)out.data(), [] (S c) { return (uint8_t)c; });
+        break;
+    case kPackU16:
+        store((uint16_t *)out.data(), [] (S c) { return (uint16_t)c; });
+        break;
+    case kPackUnorm8:
+        store((uint8_t *)out.data(), [] (S c) { return (uint8_t)std::lround(std::clamp((float)c, 0.f, 1.f) * 255); });
+        break;
+    case kPackUnorm16:
+        store((uint16_t *)out.data(), [] (S c) { return (uint16_t)std::lround(std::clamp((float)c, 0.f, 1.f) * 65535); });
+        break;
+    case kPackOct32:
+        if constexpr (std::is_same_v<T, vec3f>) {
+            auto dst = (int16_t *)out.data();
+            parallel_for(attr.size(), [&] (size_t i) {
+                auto v = attr[i];
+                float l1 = std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]);
+                vec2f p = l1 > 0 ? vec2f(v[0], v[1]) / l1 : vec2f(0);
+                if (v[2] < 0)
+                    p = octWrap(p);
+                dst[i * 2 + 0] = (int16_t)std::lround(std::clamp(p[0], -1.f, 1.f) * 32767);
+                dst[i * 2 + 1] = (int16_t)std::lround(std::clamp(p[1], -1.f, 1.f) * 32767);
+            });
+        }
+        break;
+    }
+    return out;
+}
+
+// the packed bytes are stored inline or as a blob, like any other array
+template <class T, class It>
+void decodePacked(std::vector<T> &attr, size_t size, size_t packing, It &it) {
+    using S = attr_scalar_t<T>;
+    size_t n = size & ~kBlobRef;
+    std::vector<char> in;
+    decodeArray(in, packedBytes<T>(packing, n) | (size & kBlobRef), it);
+    attr.resize(n);
+    auto comps = reinterpret_cast<S *>(attr.data());
+    size_t ncomps = n * attrDim<T>;
+    auto load = [&] (auto const *src, auto f) {
+        parallel_for(ncomps, [&] (size_t i) {
+            comps[i] = (S)f(src[i]);
+        });
+    };
+    switch (packing) {
+    case kPackHalf:
+        load((uint16_t const *)in.data(), [] (uint16_t c) { return halfToFloat(c); });
+        break;
+    case kPackU8:
+        load((uint8_t const *)in.data(), [] (uint8_t c) { return c; });
+        break;
+    case kPackU16:
+        load((uint16_t const *)in.data(), [] (uint16_t c) { return c; });
+        break;
+    case kPackUnorm8:
+        load((uint8_t const *)in.data(), [] (uint8_t c) { return c * (1.f / 255); });
+        break;
+    case kPackUnorm16:
+        load((uint16_t const *)in.data(), [] (uint16_t c) { return c * (1.f / 65535); });
+        break;
+    case kPackOct32:
+        if constexpr (std::is_same_v<T, vec3f>) {
+            auto src = (int16_t const *)in.data();
+            parallel_for(n, [&] (size_t i) {
+                vec2f p(src[i * 2 + 0] / 32767.f, src[i * 2 + 1] / 32767.f);
+                float z = 1 - std::abs(p[0]) - std::abs(p[1]);
+                if (z < 0)
+                    p = octWrap(p);
+                attr[i] = normalize(vec3f(p[0], p[1], z));
+            });
+            break;
+        }
+        [[fallthrough]];
+    default:
+        throw makeError("zencache: bad attribute packing " + std::to_string(packing));
+    }
+}
+
 template <class T0, class It>
 void decodeAttrVector(AttrVector<T0> &arr, It &it) {
     AttrVectorHeader header;
     std::copy_n(it, sizeof(header), (char *)&header);
     it += sizeof(header);
-    arr.values.reserve(header.size);
-    std::copy_n((T0 const *)it, header.size, std::back_inserter(arr.values));
-    it += sizeof(T0) * header.size;
+    decodeArray(arr.values, header.size, it);
 
     for (int a = 0; a < header.nattrs; a++) {
         AttributeHeader h;
         std::copy_n(it, sizeof(h), (char *)&h);
         it += sizeof(h);
         std::string key{h.name, h.namelen};
-        index_switch<std::variant_size_v<AttrAcceptAll>>((size_t)h.type, [&] (auto type) {
+        size_t packing = h.type >> 8;
+        index_switch<std::variant_size_v<AttrAcceptAll>>((size_t)h.type & 0xff, [&] (auto type) {
             using T = std::variant_alternative_t<type.value, AttrAcceptAll>;
             auto &attr = arr.template add_attr<T>(key);
             attr.clear();
-            attr.reserve(h.size);
-            std::copy_n((T const *)it, h.size, std::back_inserter(attr));
-            it += sizeof(T) * h.size;
+            if (packing != kPackRaw)
+                decodePacked(attr, h.size, packing, it);
+            else
+                decodeArray(attr, h.size, it);
         });
     }
     arr.update();
 }
 
 template <class T0, class It>
-void encodeAttrVector(AttrVector<T0> const &arr, It &it) {
+void encodeAttrVector(AttrVector<T0> const &arr, std::string const &name, UserData const &ud, It &it) {
+    std::vector<char> blob;
     AttrVectorHeader header;
     header.size = arr.size();
     header.nattrs = arr.template num_attrs<AttrAcceptAll>();
+    bool isBlob = encodeBlob(name, arr.data(), arr.size(), blob);
+    if (isBlob)
+        header.size |= kBlobRef;
     it = std::copy_n((char const *)&header, sizeof(header), it);
-    it = std::copy_n((char const *)arr.data(), sizeof(T0) * arr.size(), it);
+    if (isBlob)
+        it = std::copy(blob.begin(), blob.end(), it);
+    else
+        it = std::copy_n((char const *)arr.data(), sizeof(T0) * arr.size(), it);
 
     arr.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &attr) {
         AttributeHeader h;
@@ -65,8 +543,29 @@ void encodeAttrVector(AttrVector<T0> const &arr, It &it) {
         h.size = attr.size();
         h.namelen = key.size();
         std::strncpy(h.name, key.c_str(), sizeof(h.name));
+        // pack first, so that blobs hold the packed bytes too; only the cache
+        // writer packs, the scan isn't worth it for objects sent to the editor
+        size_t packing = tlsBlobScope ? choosePacking(attr, ud.get2<std::string>("quantise_" + key, "")) : kPackRaw;
+        h.type |= packing << 8;
+        std::vector<char> packed;
+        char const *data = (char const *)attr.data();
+        size_t bytes = sizeof(T) * attr.size();
+        if (packing != kPackRaw) {
+            packed = encodePacked(attr, packing);
+            data = packed.data();
+            bytes = packed.size();
+        }
+        blob.clear();
+        bool isBlob = packing != kPackRaw
+            ? encodeBlob(name + '.' + key, data, bytes, blob)
+            : encodeBlob(name + '.' + key, attr.data(), attr.size(), blob);
+        if (isBlob)
+            h.size |= kBlobRef;
         it = std::copy_n((char const *)&h, sizeof(h), it);
-        it = std::copy_n((char const *)attr.data(), sizeof(T) * attr.size(), it);
+        if (isBlob)
+            it = std::copy(blob.begin(), blob.end(), it);
+        else
+            it = std::copy_n(data, bytes, it);
     });
 }
 
@@ -75,15 +574,20 @@ void encodeAttrVector(AttrVector<T0> const &arr, It &it) {
 std::shared_ptr<PrimitiveObject> decodePrimitiveObject(const char *it);
 std::shared_ptr<PrimitiveObject> decodePrimitiveObject(const char *it) {
     auto obj = std::make_shared<PrimitiveObject>();
-    decodeAttrVector(obj->verts, it);
-    decodeAttrVector(obj->points, it);
-    decodeAttrVector(obj->lines, it);
-    decodeAttrVector(obj->tris, it);
-    decodeAttrVector(obj->quads, it);
-    decodeAttrVector(obj->loops, it);
-    decodeAttrVector(obj->polys, it);
-    decodeAttrVector(obj->edges, it);
-    decodeAttrVector(obj->uvs, it);
+    try {
+        decodeAttrVector(obj->verts, it);
+        decodeAttrVector(obj->points, it);
+        decodeAttrVector(obj->lines, it);
+        decodeAttrVector(obj->tris, it);
+        decodeAttrVector(obj->quads, it);
+        decodeAttrVector(obj->loops, it);
+        decodeAttrVector(obj->polys, it);
+        decodeAttrVector(obj->edges, it);
+        decodeAttrVector(obj->uvs, it);
+    } catch (std::exception const &e) {
+        log_error("failed to decode primitive: {}", e.what());
+        return nullptr;
+    }
     if (*it++ == '1') {
         obj->mtl = std::make_shared<MaterialObject>();
         obj->mtl->deserialize(it);
@@ -93,15 +597,20 @@ std::shared_ptr<PrimitiveObject> decodePrimitiveObject(const char *it) {
 
 bool encodePrimitiveObject(PrimitiveObject const *obj, std::back_insert_iterator<std::vector<char>> it);
 bool encodePrimitiveObject(PrimitiveObject const *obj, std::back_insert_iterator<std::vector<char>> it) {
-    encodeAttrVector(obj->verts, it);
-    encodeAttrVector(obj->points, it);
-    encodeAttrVector(obj->lines, it);
-    encodeAttrVector(obj->tris, it);
-    encodeAttrVector(obj->quads, it);
-    encodeAttrVector(obj->loops, it);
-    encodeAttrVector(obj->polys, it);
-    encodeAttrVector(obj->edges, it);
-    encodeAttrVector(obj->uvs, it);
+    // userData() would add an empty one, don't touch objects other threads may be reading
+    static UserData const noUserData;
+    auto const &ud = obj->m_userData.has_value() ? obj->userData() : noUserData;
+    encodeAttrVector(obj->verts, "verts", ud, it);
+    encodeAttrVector(obj->points, "points", ud, it);
+    encodeAttrVector(obj->lines, "lines", ud, it);
+    encodeAttrVector(obj->tris, "tris", ud, it);
+    encodeAttrVector(obj->quads, "quads", ud, it);
+    encodeAttrVector(obj->loops, "loops", ud, it);
+    encodeAttrVector(obj->polys, "polys", ud, it);
+    encodeAttrVector(obj->edges, "edges", ud, it);
+    encodeAttrVector(obj->uvs, "uvs", ud, it);
+    if (tlsBlobScope)
+        tlsBlobScope->counter++;
     if (obj->mtl) {
         *it++ = '1';
         for (char c: obj->mtl->serialize())
@@ -114,4 +623,23 @@ bool encodePrimitiveObject(PrimitiveObject const *obj, std::back_insert_iterator
 
 }
 
+ZENO_API ObjectCodecBlobScope::ObjectCodecBlobScope(std::string blobdir_)
+    : blobdir(std::move(blobdir_)), previous(_implObjectCodec::tlsBlobScope) {
+    _implObjectCodec::tlsBlobScope = this;
+}
+
+ZENO_API ObjectCodecBlobScope::~ObjectCodecBlobScope() {
+    _implObjectCodec::tlsBlobScope = previous;
+}
+
+ZENO_API void ObjectCodecBlobScope::forget(std::string const &blobdir) {
+    std::lock_guard lck(_implObjectCodec::g_writerMtx);
+    _implObjectCodec::g_writers.erase(blobdir);
+}
+
+ZENO_API void ObjectCodecBlobScope::setStream(std::string stream_) {
+    stream = std::move(stream_);
+    counter = 0;
+}
+
 }
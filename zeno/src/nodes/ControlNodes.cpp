@@ -4,7 +4,14 @@
 #include <zeno/types/DummyObject.h>
 #include <zeno/extra/ContextManaged.h>
 #include <zeno/extra/evaluate_condition.h>
+#include <zeno/extra/SubnetNode.h>
 #include <zeno/utils/safe_at.h>
+#include <zeno/utils/log.h>
+#include <zeno/para/parallel_for.h>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
 
 namespace zeno {
 
@@ -56,12 +63,12 @@ struct BeginFor : IBeginFor {
         m_count = get_input<zeno::NumericObject>("count")->get<int>();
         set_output("FOR", std::make_shared<zeno::DummyObject>());
         if (outputs.find("index") == outputs.end()) {
-            set_output("index", std::make_shared<zeno::NumericObject>());
+            set_output("index", make_pooled<zeno::NumericObject>());
         }
     }
 
     virtual void update() override final {
-        auto ret = std::make_shared<zeno::NumericObject>();
+        auto ret = make_pooled<zeno::NumericObject>();
         ret->set(m_index);
         set_output("index", std::move(ret));
         m_index++;
@@ -152,7 +159,7 @@ struct BeginForEach : IBeginFor {
     }
 
     virtual void update() override final {
-        auto ret = std::make_shared<zeno::NumericObject>();
+        auto ret = make_pooled<zeno::NumericObject>();
         ret->set(m_index);
         set_output("index", std::move(ret));
         auto obj = m_list->arr[m_index];
@@ -170,10 +177,211 @@ ZENDEFNODE(BeginForEach, {
     {"control"},
 });
 
+// stands in for a node outside the loop body inside a parallel iteration graph
+struct ForEachProxy : zeno::INode {
+    virtual void apply() override {}
+};
+
 struct EndForEach : EndFor {
     std::vector<zany> result;
     std::vector<zany> dropped_result;
 
+    struct IterResult {
+        bool accept = true;
+        zany object;
+        zany list;
+    };
+
+    void gatherResult(IterResult &it) {
+        auto &dst = it.accept ? result : dropped_result;
+        if (it.object)
+            dst.push_back(std::move(it.object));
+        if (it.list) {
+            for (auto obj: safe_dynamic_cast<ListObject>(it.list, "input socket `list` of EndForEach ")->arr)
+                dst.push_back(std::move(obj));
+        }
+    }
+
+    // Runs the iterations concurrently, each worker task owning a private
+    // copy of the loop body. Nodes not depending on BeginForEach are applied
+    // once here, and each worker gets its own clones of their outputs, since
+    // nodes may modify their inputs in place. Returns false if the loop
+    // carries state between iterations, drives an inner loop that doesn't
+    // depend on it, or holds objects that can't be cloned, and must run
+    // sequentially.
+    bool parallelApply(std::string const &forName, BeginForEach *fore) {
+        if (inputBounds.count("accumate") || fore->inputBounds.count("accumate"))
+            return false;
+        for (auto const &[name, node]: graph->nodes) {
+            if (auto brk = dynamic_cast<BreakFor *>(node.get());
+                brk && brk->inputBounds.count("FOR") && brk->inputBounds.at("FOR").first == forName)
+                return false;
+        }
+
+        // the body is everything between the outputs of BeginForEach and our inputs
+        std::map<std::string, bool> varying;
+        std::function<bool(std::string const &)> dependsOnFor = [&] (std::string const &name) {
+            if (auto it = varying.find(name); it != varying.end())
+                return it->second;
+            varying[name] = name == forName;
+            bool v = name == forName;
+            if (!v) {
+                for (auto const &[ds, bound]: safe_at(graph->nodes, name, "node name")->inputBounds)
+                    v = dependsOnFor(bound.first) || v;
+            }
+            return varying[name] = v;
+        };
+        std::vector<std::pair<std::string, std::pair<std::string, std::string>>> roots;
+        for (auto const &[ds, bound]: inputBounds) {
+            if (ds == "object" || ds == "list" || ds == "accept") {
+                dependsOnFor(bound.first);
+                roots.emplace_back(ds, bound);
+            }
+        }
+        std::vector<INode *> body;
+        std::set<std::string> shared{forName};
+        for (auto const &[name, v]: varying) {
+            auto node = graph->nodes.at(name).get();
+            if (!v) {
+                shared.insert(name);
+            } else if (name != forName) {
+                if (dynamic_cast<SubnetNode *>(node))
+                    return false;
+                body.push_back(node);
+            }
+        }
+        // an inner loop whose BeginFor doesn't depend on us is shared, but its
+        // EndFor or BreakFor in the body still has to drive the real node
+        for (auto node: body) {
+            if (auto it = node->inputBounds.find("FOR"); it != node->inputBounds.end()
+                && shared.count(it->second.first)
+                && dynamic_cast<IBeginFor *>(graph->nodes.at(it->second.first).get()))
+                return false;
+        }
+
+        for (auto const &name: shared)
+            graph->applyNode(name);
+        size_t count = fore->m_list->arr.size();
+        std::vector<IterResult> iters(count);
+#ifdef ZENO_PARALLEL_STL
+        size_t nworkers = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(count, 1));
+#else
+        size_t nworkers = 1;    // parallel_for is serial without the parallel STL
+#endif
+
+        // private copies of the shared outputs and of the body's own inputs for each worker
+        struct Copies {
+            std::map<std::string, std::map<std::string, zany>> outputs, inputs;
+            std::map<std::string, zany> muted;
+        };
+        auto cloneInto = [] (std::map<std::string, zany> const &objs, std::map<std::string, zany> &ret) {
+            for (auto const &[key, obj]: objs) {
+                auto &copy = ret[key];
+                if (obj && !(copy = obj->clone()))
+                    return false;
+            }
+            return true;
+        };
+        std::vector<Copies> copies(nworkers);
+        for (auto &cp: copies) {
+            for (auto const &name: shared) {
+                auto node = graph->nodes.at(name).get();
+                if (name == forName)
+                    continue;
+                if (!cloneInto(node->outputs, cp.outputs[name]))
+                    return false;
+                if (node->muted_output && !(cp.muted[name] = node->muted_output->clone()))
+                    return false;
+            }
+            for (auto node: body) {
+                if (!cloneInto(node->inputs, cp.inputs[node->myname]))
+                    return false;
+            }
+        }
+        log_debug("EndForEach: {} iterations over {} body nodes on {} workers", count, body.size(), nworkers);
+
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+        std::mutex errMtx;
+        std::exception_ptr error;
+        auto worker = [&] (size_t t) {
+            if (next >= count || failed)
+                return;     // the other workers already took every iteration
+            try {
+                auto g = std::make_shared<Graph>();
+                g->session = graph->session;
+                g->subgraphNode = graph->subgraphNode;
+                for (auto const &name: shared) {
+                    auto orig = graph->nodes.at(name).get();
+                    auto proxy = std::make_unique<ForEachProxy>();
+                    proxy->graph = g.get();
+                    proxy->myname = name;
+                    proxy->nodeClass = orig->nodeClass;
+                    if (name == forName) {
+                        proxy->outputs = orig->outputs;
+                    } else {
+                        proxy->outputs = std::move(copies[t].outputs[name]);
+                        proxy->muted_output = std::move(copies[t].muted[name]);
+                    }
+                    g->nodes[name] = std::move(proxy);
+                }
+                for (auto orig: body) {
+                    auto node = orig->nodeClass->new_instance();
+                    node->graph = g.get();
+                    node->myname = orig->myname;
+                    node->nodeClass = orig->nodeClass;
+                    node->inputBounds = orig->inputBounds;
+                    node->inputs = std::move(copies[t].inputs[orig->myname]);
+                    node->kframes = orig->kframes;
+                    node->formulas = orig->formulas;
+                    node->doComplete();
+                    g->nodes[orig->myname] = std::move(node);
+                }
+                auto forProxy = g->nodes.at(forName).get();
+                while (true) {
+                    size_t i = next++;
+                    if (i >= count || failed)
+                        break;
+                    forProxy->outputs["index"] = make_pooled<NumericObject>((int)i);
+                    forProxy->outputs["object"] = fore->m_list->arr[i];
+                    forProxy->invalidateSockets();
+                    g->ctx = std::make_unique<Context>();
+                    for (auto const &[ds, bound]: roots) {
+                        auto src = g->nodes.at(bound.first).get();
+                        g->applyNode(src);
+                        auto val = src->muted_output ? src->muted_output
+                            : safe_at(src->outputs, bound.second, "output socket name of node " + bound.first);
+                        if (ds == "accept")
+                            iters[i].accept = evaluate_condition(val.get());
+                        else if (ds == "object")
+                            iters[i].object = std::move(val);
+                        else
+                            iters[i].list = std::move(val);
+                    }
+                }
+            } catch (...) {
+                std::lock_guard lck(errMtx);
+                if (!error)
+                    error = std::current_exception();
+                failed = true;
+            }
+        };
+        // workers are tasks of the shared pool, so parallel loops nested in
+        // the body don't multiply the threads
+        parallel_for(nworkers, worker);
+        if (error)
+            std::rethrow_exception(error);
+
+        for (auto &it: iters)
+            gatherResult(it);
+        fore->m_index = count;
+        if (count) {
+            fore->set_output("index", std::make_shared<NumericObject>((int)count - 1));
+            fore->set_output("object", fore->m_list->arr.back());
+        }
+        return true;
+    }
+
     virtual void post_do_apply() override {
         bool accept = true;
         if (requireInput("accept")) {
@@ -210,7 +418,18 @@ struct EndForEach : EndFor {
     }
 
     virtual void preApply() override {
-        EndFor::preApply();
+        bool done = false;
+        if (get_param<bool>("parallel")) {
+            auto [sn, ss] = safe_at(inputBounds, "FOR", "input socket of EndForEach");
+            if (auto fore = dynamic_cast<BeginForEach *>(graph->nodes.at(sn).get()); fore) {
+                graph->applyNode(sn);
+                done = parallelApply(sn, fore);
+                if (!done)
+                    log_warn("EndForEach {}: loop carries state between iterations, drives an invariant inner loop or holds objects that cannot be cloned, running sequentially", myname);
+            }
+        }
+        if (!done)
+            EndFor::preApply();
         if (get_param<bool>("doConcat")) {
             decltype(result) newres;
             for (auto &xs: result) {
@@ -243,7 +462,7 @@ struct EndForEach : EndFor {
 ZENDEFNODE(EndForEach, {
     {"object", "list", "accumate", {"bool", "accept", "1"}, "FOR"},
     {"list", "droppedList", "accumate"},
-    {{"bool", "doConcat", "0"}},
+    {{"bool", "doConcat", "0"}, {"bool", "parallel", "0"}},
     {"control"},
 });
 
@@ -269,7 +488,7 @@ struct BeginSubstep : IBeginFor {
     }
 
     virtual void update() override final {
-        auto ret = std::make_shared<zeno::NumericObject>();
+        auto ret = make_pooled<zeno::NumericObject>();
         ret->set(m_elapsed);
         set_output("elapsed_time", std::move(ret));
     }
@@ -13,6 +13,7 @@
 #include <zeno/utils/string.h>
 #include <zeno/utils/scope_exit.h>
 #include <zeno/extra/CAPIInternals.h>
+#include <zeno/extra/PyGIL.h>
 #include <cwchar>
 #include <utility>
 #include <thread>
@@ -70,15 +71,18 @@ namespace zeno {
             PyObject* pyFunc;
 
             explicit PythonFunctor(PyObject* pyFunc_) : pyFunc(pyFunc_) {
+                PyGILGuard gil;
                 Py_INCREF(pyFunc);
             }
 
             PythonFunctor(PythonFunctor const& that) : pyFunc(that.pyFunc) {
+                PyGILGuard gil;
                 Py_INCREF(pyFunc);
             }
 
             PythonFunctor& operator=(PythonFunctor const& that) {
                 if (std::addressof(that) != this) {
+                    PyGILGuard gil;
                     Py_DECREF(pyFunc);
                     pyFunc = that.pyFunc;
                     Py_INCREF(pyFunc);
@@ -87,10 +91,12 @@ namespace zeno {
             }
 
             ~PythonFunctor() {
+                PyGILGuard gil;
                 Py_DECREF(pyFunc);
             }
 
             std::map<std::string, zany> operator()(std::map<std::string, zany> args) const {
+                PyGILGuard gil;
                 std::map<std::string, zany> rets;
                 PyObject* pyKwargs = PyDict_New();
                 scope_exit pyKwargsDel = [=] {
@@ -150,6 +156,7 @@ namespace zeno {
         };
 
         static Zeno_Object factoryFunctionObject(void* inObj_) {
+            PyGILGuard gil;
             PyObject* tmpFunc = reinterpret_cast<PyObject*>(inObj_);
             auto funcObj = std::make_shared<FunctionObject>(PythonFunctor(tmpFunc));
             Zeno_Object funcHandle = capiLoadObjectSharedPtr(funcObj);
@@ -159,6 +166,7 @@ namespace zeno {
         static int defFunctionObjectFactory = capiRegisterObjectFactory("FunctionObject", factoryFunctionObject);
 
         static PyObject* callFunctionObjectCFunc(PyObject* pyHandleAndKwargs_) {
+            PyGILGuard gil;
             PyObject* pyHandleVal = PyTuple_GetItem(pyHandleAndKwargs_, 0);
             PyObject* pyKwargs = PyTuple_GetItem(pyHandleAndKwargs_, 1);
             Zeno_Object obj = PyLong_AsUnsignedLongLong(pyHandleVal);
@@ -182,7 +190,10 @@ namespace zeno {
                     objParams.emplace(std::move(keyStr), capiFindObjectSharedPtr(handle));
                 }
             }
-            objParams = objFunc->call(objParams);
+            {
+                PyGILRelease nogil;
+                objParams = objFunc->call(objParams);
+            }
             PyDict_Clear(pyKwargs);
             for (auto const& [k, v] : objParams) {
                 PyObject* handleObj = PyLong_FromUnsignedLongLong(capiLoadObjectSharedPtr(v));
@@ -194,6 +205,7 @@ namespace zeno {
         static int defCallFunctionObjectCFunc = capiRegisterCFunctionPtr("FunctionObject_call", reinterpret_cast<void* (*)(void*)>(callFunctionObjectCFunc));
 
         static void* defactoryFunctionObject(Zeno_Object inHandle_) {
+            PyGILGuard gil;
             auto objSp = capiFindObjectSharedPtr(inHandle_);
             auto funcObj = dynamic_cast<FunctionObject*>(objSp.get());
             if (!funcObj) throw makeError<TypeError>(typeid(FunctionObject), typeid(*objSp),
@@ -214,6 +226,7 @@ namespace zeno {
 
                 auto args = has_input("args") ? get_input<DictObject>("args") : std::make_shared<DictObject>();
                 auto path = has_input("path") ? get_input2<std::string>("path") : "";
+                PyGILGuard gil;
                 int ret;
                 PyObject* argsDict = PyDict_New();
                 scope_exit argsDel = [=] {
@@ -3,8 +3,8 @@
 #include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/types/NumericObject.h>
-#include <zeno/utils/tuple_hash.h>
-#include <unordered_map>
+#include <zeno/para/parallel_for.h>
+#include <atomic>
 
 namespace zeno {
 
@@ -12,51 +12,58 @@ ZENO_API void primMarkIsland(PrimitiveObject *prim, std::string tagAttr) {
     // Oh, I mean, Tesla was a great DJ
     auto &tagVert = prim->add_attr<int>(tagAttr);
     auto m = tagVert.size();
-    std::vector<int> found(m);
-    for (int i = 0; i < m; i++) {
-        found[i] = i;
-    }
+    // lock-free union-find, a root is always the smallest index of its island,
+    // so the labels do not depend on thread scheduling
+    std::vector<std::atomic<int>> found(m);
+    parallel_for(m, [&] (size_t i) {
+        found[i].store(i, std::memory_order_relaxed);
+    });
     auto find = [&] (int i) {
-        while (i != found[i])
-            i = found[i];
-        return i;
+        while (true) {
+            int p = found[i].load(std::memory_order_relaxed);
+            if (p == i)
+                return i;
+            int gp = found[p].load(std::memory_order_relaxed);
+            if (p != gp)
+                found[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            i = gp;
+        }
     };
-    for (int i = 0; i < prim->lines.size(); i++) {
+    auto link = [&] (int e0, int e1) {
+        while (true) {
+            e0 = find(e0);
+            e1 = find(e1);
+            if (e0 == e1)
+                return;
+            if (e0 < e1)
+                std::swap(e0, e1);
+            if (found[e0].compare_exchange_strong(e0, e1, std::memory_order_relaxed))
+                return;
+        }
+    };
+    parallel_for(prim->lines.size(), [&] (size_t i) {
         auto ind = prim->lines[i];
-        int e0 = find(ind[0]);
-        int e1 = find(ind[1]);
-        found[e1] = e0;
-    }
-    for (int i = 0; i < prim->tris.size(); i++) {
+        link(ind[0], ind[1]);
+    });
+    parallel_for(prim->tris.size(), [&] (size_t i) {
         auto ind = prim->tris[i];
-        int e0 = find(ind[0]);
-        int e1 = find(ind[1]);
-        int e2 = find(ind[2]);
-        found[e1] = e0;
-        found[e2] = e0;
-    }
-    for (int i = 0; i < prim->quads.size(); i++) {
+        link(ind[0], ind[1]);
+        link(ind[0], ind[2]);
+    });
+    parallel_for(prim->quads.size(), [&] (size_t i) {
         auto ind = prim->quads[i];
-        int e0 = find(ind[0]);
-        int e1 = find(ind[1]);
-        int e2 = find(ind[2]);
-        int e3 = find(ind[3]);
-        found[e1] = e0;
-        found[e2] = e0;
-        found[e3] = e0;
-    }
-    for (int i = 0; i < prim->polys.size(); i++) {
+        link(ind[0], ind[1]);
+        link(ind[0], ind[2]);
+        link(ind[0], ind[3]);
+    });
+    parallel_for(prim->polys.size(), [&] (size_t i) {
         auto [base, len] = prim->polys[i];
-        if (len <= 1) continue;
-        int e0 = find(prim->loops[base]);
-        for (int j = base + 1; j < base + len; j++) {
-            int ej = find(prim->loops[j]);
-            found[ej] = e0;
-        }
-    }
-    for (int i = 0; i < m; i++) {
+        for (int j = base + 1; j < base + len; j++)
+            link(prim->loops[base], prim->loops[j]);
+    });
+    parallel_for(m, [&] (size_t i) {
         tagVert[i] = find(i);
-    }
+    });
 }
 
 namespace {
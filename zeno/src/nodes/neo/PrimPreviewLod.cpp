@@ -0,0 +1,481 @@
+#include <zeno/zeno.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/types/UserData.h>
+#include <zeno/funcs/PrimitiveUtils.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_sort.h>
+#include <zeno/utils/log.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <list>
+#include <mutex>
+#include <map>
+#include <utility>
+
+namespace zeno {
+
+namespace {
+
+// Coarse connectivity of a vertex-clustered level. It is built once from the
+// pose a topology is first seen with; later poses of the same topology only
+// re-place the cluster vertices, so deforming meshes never re-cluster.
+struct ClusterLod {
+    std::vector<int> cluster;       // fine vert -> coarse vert, -1 if unused
+    std::vector<vec3i> tris;        // coarse tris
+    std::vector<int> triSrc;        // coarse tri -> fine tri it came from
+    std::vector<int> cornerStart;   // coarse vert -> range into corners
+    std::vector<int> corners;       // fine corners (tri * 3 + k) of each coarse vert
+    int numClusters = 0;
+
+    std::size_t bytes() const {
+        return (cluster.size() + triSrc.size() + cornerStart.size() + corners.size()) * sizeof(int)
+            + tris.size() * sizeof(vec3i);
+    }
+};
+
+std::size_t topologyHash(PrimitiveObject *prim, int targetFaces) {
+    constexpr std::size_t kChunk = 1 << 16;
+    auto const *bytes = reinterpret_cast<unsigned char const *>(prim->tris.data());
+    std::size_t nbytes = prim->tris.size() * sizeof(vec3i);
+    std::size_t nchunks = (nbytes + kChunk - 1) / kChunk;
+    std::vector<std::uint64_t> partial(nchunks);
+    parallel_for(nchunks, [&] (std::size_t c) {
+        std::uint64_t h = 14695981039346656037ull;
+        for (std::size_t i = c * kChunk, e = std::min(nbytes, i + kChunk); i < e; i++)
+            h = (h ^ bytes[i]) * 1099511628211ull;
+        partial[c] = h;
+    });
+    std::uint64_t h = 14695981039346656037ull;
+    auto mix = [&] (std::uint64_t v) {
+        h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    };
+    mix(prim->verts.size());
+    mix(prim->tris.size());
+    mix(targetFaces);
+    for (auto p: partial)
+        mix(p);
+    return h;
+}
+
+std::uint64_t cellKey(vec3f const &p, vec3f const &bmin, float inv, int res) {
+    auto c = (p - bmin) * inv;
+    auto x = (std::uint64_t)std::clamp((int)c[0], 0, res - 1);
+    auto y = (std::uint64_t)std::clamp((int)c[1], 0, res - 1);
+    auto z = (std::uint64_t)std::clamp((int)c[2], 0, res - 1);
+    return x | y << 21 | z << 42;
+}
+
+std::shared_ptr<ClusterLod> buildClusterLod(PrimitiveObject *prim, int targetFaces) {
+    auto const &pos = prim->verts.values;
+    auto const &tris = prim->tris.values;
+    auto lod = std::make_shared<ClusterLod>();
+
+    std::vector<unsigned char> used(pos.size());
+    for (auto const &ind: tris)
+        used[ind[0]] = used[ind[1]] = used[ind[2]] = 1;
+    vec3f bmin(1e30f), bmax(-1e30f);
+    for (std::size_t i = 0; i < pos.size(); i++) {
+        if (used[i]) {
+            bmin = zeno::min(bmin, pos[i]);
+            bmax = zeno::max(bmax, pos[i]);
+        }
+    }
+    auto ext = bmax - bmin;
+    float extent = std::max({ext[0], ext[1], ext[2], 1e-6f});
+
+    // a closed surface keeps about twice as many faces as vertices, and the
+    // occupied cells of a surface grow with the square of the resolution
+    std::size_t targetCells = std::max(targetFaces / 2, 4);
+    int res = std::clamp((int)std::sqrt((float)targetCells), 2, (1 << 21) - 1);
+    std::vector<std::uint64_t> keys(pos.size()), cells;
+    for (int iter = 0; iter < 4; iter++) {
+        float inv = res / extent;
+        parallel_for(pos.size(), [&] (std::size_t i) {
+            keys[i] = used[i] ? cellKey(pos[i], bmin, inv, res) : ~std::uint64_t{};
+        });
+        cells = keys;
+        parallel_sort(cells.begin(), cells.end(), std::less<std::uint64_t>());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+        if (!cells.empty() && cells.back() == ~std::uint64_t{})
+            cells.pop_back();
+        float ratio = (float)targetCells / std::max<std::size_t>(cells.size(), 1);
+        if (ratio > 0.8f && ratio < 1.25f)
+            break;
+        res = std::clamp((int)(res * std::sqrt(ratio)), 2, (1 << 21) - 1);
+    }
+
+    std::vector<int> cellOf(pos.size());
+    parallel_for(pos.size(), [&] (std::size_t i) {
+        cellOf[i] = used[i] ? (int)(std::lower_bound(cells.begin(), cells.end(), keys[i]) - cells.begin()) : -1;
+    });
+
+    // collapse tris, drop degenerate ones and duplicates, keeping source order
+    std::vector<vec3i> mapped(tris.size());
+    std::vector<std::pair<vec3i, int>> sorted;
+    parallel_for(tris.size(), [&] (std::size_t i) {
+        mapped[i] = vec3i(cellOf[tris[i][0]], cellOf[tris[i][1]], cellOf[tris[i][2]]);
+    });
+    sorted.reserve(tris.size());
+    for (std::size_t i = 0; i < mapped.size(); i++) {
+        auto m = mapped[i];
+        if (m[0] == m[1] || m[1] == m[2] || m[2] == m[0])
+            continue;
+        std::sort(m.begin(), m.end());
+        sorted.emplace_back(m, (int)i);
+    }
+    auto faceKey = [] (vec3i const &m) {
+        return std::tie(m[0], m[1], m[2]);
+    };
+    parallel_sort(sorted.begin(), sorted.end(), [&] (auto const &a, auto const &b) {
+        return std::make_pair(faceKey(a.first), a.second) < std::make_pair(faceKey(b.first), b.second);
+    });
+    std::vector<int> keep;
+    keep.reserve(sorted.size());
+    for (std::size_t i = 0; i < sorted.size(); i++)
+        if (i == 0 || faceKey(sorted[i].first) != faceKey(sorted[i - 1].first))
+            keep.push_back(sorted[i].second);
+    parallel_sort(keep.begin(), keep.end(), std::less<int>());
+
+    // renumber the cells that survive as coarse vertices
+    std::vector<int> remap(cells.size(), -1);
+    for (int f: keep)
+        for (int k = 0; k < 3; k++)
+            remap[mapped[f][k]] = 0;
+    for (auto &r: remap)
+        if (r == 0)
+            r = lod->numClusters++;
+    lod->cluster.resize(pos.size());
+    parallel_for(pos.size(), [&] (std::size_t i) {
+        lod->cluster[i] = cellOf[i] < 0 ? -1 : remap[cellOf[i]];
+    });
+    lod->tris.resize(keep.size());
+    lod->triSrc = keep;
+    parallel_for(keep.size(), [&] (std::size_t i) {
+        auto m = mapped[keep[i]];
+        lod->tris[i] = vec3i(remap[m[0]], remap[m[1]], remap[m[2]]);
+    });
+
+    // corners grouped per coarse vert, for the per-pose quadric gather
+    lod->cornerStart.assign(lod->numClusters + 1, 0);
+    for (auto const &ind: tris)
+        for (int k = 0; k < 3; k++)
+            if (int c = lod->cluster[ind[k]]; c >= 0)
+                lod->cornerStart[c + 1]++;
+    for (int c = 0; c < lod->numClusters; c++)
+        lod->cornerStart[c + 1] += lod->cornerStart[c];
+    lod->corners.resize(lod->cornerStart.back());
+    std::vector<int> fill(lod->cornerStart.begin(), lod->cornerStart.end() - 1);
+    for (std::size_t f = 0; f < tris.size(); f++)
+        for (int k = 0; k < 3; k++)
+            if (int c = lod->cluster[tris[f][k]]; c >= 0)
+                lod->corners[fill[c]++] = (int)f * 3 + k;
+    return lod;
+}
+
+// Places every coarse vertex at the minimizer of the summed plane quadrics of
+// its fine faces, pulled slightly towards the cluster centroid so that flat
+// and degenerate clusters stay well conditioned.
+void placeClusters(PrimitiveObject *prim, ClusterLod const &lod, std::vector<vec3f> &out) {
+    auto const &pos = prim->verts.values;
+    auto const &tris = prim->tris.values;
+    std::vector<std::array<float, 10>> quad(tris.size());
+    parallel_for(tris.size(), [&] (std::size_t f) {
+        auto a = pos[tris[f][0]], b = pos[tris[f][1]], c = pos[tris[f][2]];
+        auto n = cross(b - a, c - a);
+        float area = length(n);
+        auto &q = quad[f];
+        if (area < 1e-20f) {
+            q.fill(0);
+            return;
+        }
+        n /= area;
+        float d = -dot(n, a);
+        q = {n[0] * n[0] * area, n[0] * n[1] * area, n[0] * n[2] * area,
+             n[1] * n[1] * area, n[1] * n[2] * area, n[2] * n[2] * area,
+             -d * n[0] * area, -d * n[1] * area, -d * n[2] * area, area};
+    });
+    out.resize(lod.numClusters);
+    parallel_for((std::size_t)lod.numClusters, [&] (std::size_t c) {
+        double q[10] = {};
+        vec3f mean(0), lo(1e30f), hi(-1e30f);
+        int cb = lod.cornerStart[c], ce = lod.cornerStart[c + 1];
+        for (int i = cb; i < ce; i++) {
+            int corner = lod.corners[i];
+            auto const &fq = quad[corner / 3];
+            for (int k = 0; k < 10; k++)
+                q[k] += fq[k];
+            auto p = pos[tris[corner / 3][corner % 3]];
+            mean += p;
+            lo = zeno::min(lo, p);
+            hi = zeno::max(hi, p);
+        }
+        mean /= (float)std::max(ce - cb, 1);
+        double eps = 1e-3 * q[9] + 1e-12;
+        double a00 = q[0] + eps, a01 = q[1], a02 = q[2];
+        double a11 = q[3] + eps, a12 = q[4], a22 = q[5] + eps;
+        double b0 = q[6] + eps * mean[0], b1 = q[7] + eps * mean[1], b2 = q[8] + eps * mean[2];
+        double c00 = a11 * a22 - a12 * a12, c01 = a02 * a12 - a01 * a22, c02 = a01 * a12 - a02 * a11;
+        double det = a00 * c00 + a01 * c01 + a02 * c02;
+        if (std::abs(det) < 1e-30) {
+            out[c] = mean;
+            return;
+        }
+        double c11 = a00 * a22 - a02 * a02, c12 = a01 * a02 - a00 * a12, c22 = a00 * a11 - a01 * a01;
+        vec3f x((c00 * b0 + c01 * b1 + c02 * b2) / det,
+                (c01 * b0 + c11 * b1 + c12 * b2) / det,
+                (c02 * b0 + c12 * b1 + c22 * b2) / det);
+        // sharp features may put the minimizer far away, keep it by its members
+        out[c] = zeno::min(zeno::max(x, lo), hi);
+    });
+}
+
+// bounded by bytes, as the per-vert and per-corner arrays are as large as the mesh
+struct LodCache {
+    std::mutex mtx;
+    std::list<std::pair<std::size_t, std::shared_ptr<ClusterLod>>> lru;
+    std::size_t bytes = 0;
+    static constexpr std::size_t kMaxBytes = std::size_t(256) << 20;
+
+    std::shared_ptr<ClusterLod> get(PrimitiveObject *prim, int targetFaces) {
+        auto hash = topologyHash(prim, targetFaces);
+        {
+            std::lock_guard lck(mtx);
+            for (auto it = lru.begin(); it != lru.end(); ++it) {
+                if (it->first == hash) {
+                    lru.splice(lru.begin(), lru, it);
+                    return it->second;
+                }
+            }
+        }
+        auto lod = buildClusterLod(prim, targetFaces);
+        std::lock_guard lck(mtx);
+        lru.emplace_front(hash, lod);
+        bytes += lod->bytes();
+        while (bytes > kMaxBytes && lru.size() > 1) {
+            bytes -= lru.back().second->bytes();
+            lru.pop_back();
+        }
+        return lod;
+    }
+};
+
+std::uint32_t expandBits(std::uint32_t v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+}
+
+ZENO_API std::shared_ptr<PrimitiveObject> primClusterSimplify(PrimitiveObject *prim, int targetFaces) {
+    static LodCache cache;
+    auto lod = cache.get(prim, targetFaces);
+    auto ret = std::make_shared<PrimitiveObject>();
+    placeClusters(prim, *lod, ret->verts.values);
+
+    // corner-weighted averages of the fine vertex attributes
+    prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+        using T = std::decay_t<decltype(arr[0])>;
+        auto &out = ret->verts.add_attr<T>(key);
+        auto const &tris = prim->tris.values;
+        parallel_for((std::size_t)lod->numClusters, [&] (std::size_t c) {
+            int cb = lod->cornerStart[c], ce = lod->cornerStart[c + 1];
+            if constexpr (std::is_same_v<T, float> || std::is_same_v<T, vec2f> ||
+                          std::is_same_v<T, vec3f> || std::is_same_v<T, vec4f>) {
+                T sum(0);
+                for (int i = cb; i < ce; i++)
+                    sum += arr[tris[lod->corners[i] / 3][lod->corners[i] % 3]];
+                out[c] = sum / (float)std::max(ce - cb, 1);
+            } else {
+                out[c] = arr[tris[lod->corners[cb] / 3][lod->corners[cb] % 3]];
+            }
+        });
+    });
+
+    ret->tris.values = lod->tris;
+    prim->tris.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+        // per-corner uvs do not survive the collapse
+        if (key == "uv0" || key == "uv1" || key == "uv2")
+            return;
+        using T = std::decay_t<decltype(arr[0])>;
+        auto &out = ret->tris.add_attr<T>(key);
+        parallel_for(lod->triSrc.size(), [&] (std::size_t i) {
+            out[i] = arr[lod->triSrc[i]];
+        });
+    });
+
+    // lines and points follow their clusters; verts no triangle uses are kept as they are
+    std::vector<int> extra, extraOf(prim->verts.size(), -1);
+    auto mapVert = [&] (int v) {
+        if (lod->cluster[v] >= 0)
+            return lod->cluster[v];
+        if (extraOf[v] < 0) {
+            extraOf[v] = lod->numClusters + (int)extra.size();
+            extra.push_back(v);
+        }
+        return extraOf[v];
+    };
+    std::vector<int> lineSrc, pointSrc;
+    for (std::size_t i = 0; i < prim->lines.size(); i++) {
+        vec2i m(mapVert(prim->lines[i][0]), mapVert(prim->lines[i][1]));
+        if (m[0] != m[1]) {
+            ret->lines.values.push_back(m);
+            lineSrc.push_back((int)i);
+        }
+    }
+    std::vector<int> points;
+    for (std::size_t i = 0; i < prim->points.size(); i++)
+        points.push_back(mapVert(prim->points[i]));
+    std::vector<unsigned char> seen(lod->numClusters + extra.size());
+    for (std::size_t i = 0; i < points.size(); i++) {
+        if (!std::exchange(seen[points[i]], 1)) {
+            ret->points.values.push_back(points[i]);
+            pointSrc.push_back((int)i);
+        }
+    }
+    if (!extra.empty()) {
+        ret->verts.resize(lod->numClusters + extra.size());
+        for (std::size_t j = 0; j < extra.size(); j++)
+            ret->verts[lod->numClusters + j] = prim->verts[extra[j]];
+        prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+            using T = std::decay_t<decltype(arr[0])>;
+            auto &out = ret->verts.attr<T>(key);
+            for (std::size_t j = 0; j < extra.size(); j++)
+                out[lod->numClusters + j] = arr[extra[j]];
+        });
+    }
+    auto copyAttrs = [] (auto const &from, auto &to, std::vector<int> const &src) {
+        from.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+            using T = std::decay_t<decltype(arr[0])>;
+            auto &out = to.template add_attr<T>(key);
+            for (std::size_t i = 0; i < src.size(); i++)
+                out[i] = arr[src[i]];
+        });
+    };
+    copyAttrs(prim->lines, ret->lines, lineSrc);
+    copyAttrs(prim->points, ret->points, pointSrc);
+    ret->userData() = prim->userData();
+    return ret;
+}
+
+ZENO_API int primMeshlets(PrimitiveObject *prim, int maxVerts, int maxTris, std::string meshletAttr) {
+    auto &tris = prim->tris.values;
+    auto const &pos = prim->verts.values;
+    if (tris.empty())
+        return 0;
+    auto [bmin, bmax] = primBoundingBox(prim);
+    auto inv = 1023.f / zeno::max(bmax - bmin, vec3f(1e-6f));
+    std::vector<std::pair<std::uint32_t, int>> order(tris.size());
+    parallel_for(tris.size(), [&] (std::size_t f) {
+        auto c = (pos[tris[f][0]] + pos[tris[f][1]] + pos[tris[f][2]]) / 3.f;
+        auto q = zeno::min(zeno::max((c - bmin) * inv, vec3f(0)), vec3f(1023));
+        order[f] = {expandBits((std::uint32_t)q[0]) << 2 | expandBits((std::uint32_t)q[1]) << 1
+                    | expandBits((std::uint32_t)q[2]), (int)f};
+    });
+    parallel_sort(order.begin(), order.end(), std::less<std::pair<std::uint32_t, int>>());
+
+    std::vector<int> perm(tris.size());
+    for (std::size_t i = 0; i < tris.size(); i++)
+        perm[i] = order[i].second;
+    auto revamp = [&] (auto &arr) {
+        std::decay_t<decltype(arr)> tmp(arr.size());
+        parallel_for(perm.size(), [&] (std::size_t i) {
+            tmp[i] = arr[perm[i]];
+        });
+        arr = std::move(tmp);
+    };
+    revamp(tris);
+    prim->tris.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+        revamp(arr);
+    });
+
+    // greedily cut the Morton-ordered stream into meshlets
+    auto &meshlet = prim->tris.add_attr<int>(meshletAttr);
+    std::vector<int> stamp(pos.size(), -1);
+    int id = 0, nverts = 0, ntris = 0;
+    for (std::size_t f = 0; f < tris.size(); f++) {
+        int fresh = 0;
+        for (int k = 0; k < 3; k++)
+            fresh += stamp[tris[f][k]] != id;
+        if (ntris + 1 > maxTris || nverts + fresh > maxVerts) {
+            id++;
+            nverts = ntris = 0;
+        }
+        for (int k = 0; k < 3; k++) {
+            if (stamp[tris[f][k]] != id) {
+                stamp[tris[f][k]] = id;
+                nverts++;
+            }
+        }
+        ntris++;
+        meshlet[f] = id;
+    }
+    prim->userData().set2("meshletCount", id + 1);
+    return id + 1;
+}
+
+ZENO_API std::shared_ptr<PrimitiveObject> primPreviewLod(PrimitiveObject *prim, int targetFaces) {
+    auto ret = primClusterSimplify(prim, targetFaces);
+    primMeshlets(ret.get(), 64, 124, "meshlet");
+    return ret;
+}
+
+namespace {
+
+struct PrimClusterSimplify : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        auto targetFaces = get_input2<int>("targetFaces");
+        auto ret = primClusterSimplify(prim.get(), targetFaces);
+        if (get_input2<bool>("meshlets"))
+            primMeshlets(ret.get(), 64, 124, "meshlet");
+        log_info("PrimClusterSimplify: {} -> {} faces", prim->tris.size(), ret->tris.size());
+        set_output("prim", std::move(ret));
+    }
+};
+
+ZENO_DEFNODE(PrimClusterSimplify)({
+    {
+        {"PrimitiveObject", "prim"},
+        {"int", "targetFaces", "50000"},
+        {"bool", "meshlets", "0"},
+    },
+    {
+        {"PrimitiveObject", "prim"},
+    },
+    {},
+    {"primitive"},
+});
+
+struct PrimMeshlets : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        auto count = primMeshlets(prim.get(), get_input2<int>("maxVerts"), get_input2<int>("maxTris"),
+                                  get_input2<std::string>("meshletAttr"));
+        set_output("prim", std::move(prim));
+        set_output2("count", count);
+    }
+};
+
+ZENO_DEFNODE(PrimMeshlets)({
+    {
+        {"PrimitiveObject", "prim"},
+        {"int", "maxVerts", "64"},
+        {"int", "maxTris", "124"},
+        {"string", "meshletAttr", "meshlet"},
+    },
+    {
+        {"PrimitiveObject", "prim"},
+        {"int", "count"},
+    },
+    {},
+    {"primitive"},
+});
+
+}
+
+}
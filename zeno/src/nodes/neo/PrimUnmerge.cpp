@@ -10,156 +10,178 @@
 
 namespace zeno {
 
-ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeVerts(PrimitiveObject *prim, std::string tagAttr) {
-    if (!prim->verts.size()) return {};
-
-    auto const &tagArr = prim->verts.attr<int>(tagAttr);
-    int tagMax = parallel_reduce_max(tagArr.begin(), tagArr.end()) + 1;
+namespace {
 
-    std::vector<std::shared_ptr<PrimitiveObject>> primList(tagMax);
-    for (int tag = 0; tag < tagMax; tag++) {
-        primList[tag] = std::make_shared<PrimitiveObject>();
+// elements grouped piece by piece with one prefix sum, keeping their order inside a piece
+struct PieceLayout {
+    std::vector<int> piece;   // piece of each element, -1 if dropped
+    std::vector<int> order;   // kept elements, piece after piece
+    std::vector<int> offset;  // start of each piece in order, npieces + 1 entries
+    std::vector<int> local;   // index of each kept element inside its piece
+
+    void build(int npieces) {
+        offset.assign(npieces + 1, 0);
+        for (int p: piece) {
+            if (p >= 0)
+                offset[p + 1]++;
+        }
+        for (int p = 0; p < npieces; p++)
+            offset[p + 1] += offset[p];
+        order.resize(offset[npieces]);
+        local.assign(piece.size(), -1);
+        std::vector<int> cursor(offset.begin(), offset.end() - 1);
+        for (int i = 0; i < piece.size(); i++) {
+            if (int p = piece[i]; p >= 0) {
+                local[i] = cursor[p] - offset[p];
+                order[cursor[p]++] = i;
+            }
+        }
     }
 
-#if 1
-    std::vector<std::vector<int>> aux_arrays;
-    aux_arrays.resize(tagMax);
-    for (int tag = 0; tag < tagMax; tag++) {
-      aux_arrays[tag].resize(0);
+    int const *slice(int p) const {
+        return order.data() + offset[p];
     }
-    //auto const &tagArr = prim->verts.attr<int>(tagAttr);
-    for (int i = 0; i < prim->size(); i++) {
-      aux_arrays[tagArr[i]].emplace_back(i);
-    }
-    for (int tag = 0; tag < tagMax; tag++) {
-        primList[tag]->assign(prim);
-        primFilterVerts(primList[tag].get(), tagAttr, tag, false, {}, "verts", aux_arrays[tag].data(), aux_arrays[tag].size(),true);
+
+    int size(int p) const {
+        return offset[p + 1] - offset[p];
     }
+};
 
-#else
-    std::vector<std::vector<int>> vert_revamp(tagMax);
-    std::vector<int> vert_unrevamp(prim->verts.size());
+template <class T>
+void gatherAttrVector(AttrVector<T> &out, AttrVector<T> const &in, int const *revamp, size_t n) {
+    out.resize(n);
+    for (size_t i = 0; i < n; i++)
+        out.values[i] = in.values[revamp[i]];
+    in.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+        using V = std::decay_t<decltype(arr[0])>;
+        auto &outarr = out.template add_attr<V>(key);
+        for (size_t i = 0; i < n; i++)
+            outarr[i] = arr[revamp[i]];
+    });
+}
 
-    for (size_t i = 0; i < prim->verts.size(); i++) {
-        int tag = tagArr[i];
-        vert_revamp[tag].push_back(i);
-        vert_unrevamp[i] = tag;
+template <class T>
+int pieceOfIndices(T const &ind, std::vector<int> const &vertPiece) {
+    if constexpr (std::is_same_v<T, int>) {
+        return vertPiece[ind];
+    } else {
+        int p = vertPiece[ind[0]];
+        for (int j = 1; j < is_vec_n<T>; j++) {
+            if (vertPiece[ind[j]] != p)
+                return -1;
+        }
+        return p;
     }
+}
 
-    for (int tag = 0; tag < tagMax; tag++) {
-        auto &revamp = vert_revamp[tag];
-        auto const &outprim = primList[tag];
+template <class T, class Remap>
+void remapIndices(std::vector<T> &inds, Remap const &remap) {
+    for (auto &ind: inds) {
+        if constexpr (std::is_same_v<T, int>) {
+            ind = remap(ind);
+        } else {
+            for (int j = 0; j < is_vec_n<T>; j++)
+                ind[j] = remap(ind[j]);
+        }
+    }
+}
 
-        outprim->verts.resize(revamp.size());
-        parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-            outprim->verts[i] = prim->verts[revamp[i]];
-        });
-        prim->verts.foreach_attr([&] (auto const &key, auto const &inarr) {
-            using T = std::decay_t<decltype(inarr[0])>;
-            auto &outarr = outprim->verts.add_attr<T>(key);
-            parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                outarr[i] = inarr[revamp[i]];
-            });
-        });
+// polys with their loops compacted, and uvs too if loops have "uvs", loops still index the input verts
+void gatherPolys(PrimitiveObject *out, PrimitiveObject const *prim, int const *revamp, size_t n) {
+    gatherAttrVector(out->polys, prim->polys, revamp, n);
+    std::vector<int> loopRevamp;
+    for (auto &[base, len]: out->polys.values) {
+        int newBase = loopRevamp.size();
+        for (int j = base; j < base + len; j++)
+            loopRevamp.push_back(j);
+        base = newBase;
+    }
+    gatherAttrVector(out->loops, prim->loops, loopRevamp.data(), loopRevamp.size());
+    if (prim->uvs.size() && out->loops.attr_is<int>("uvs")) {
+        auto &uvs = out->loops.attr<int>("uvs");
+        std::vector<int> uvRevamp(uvs);
+        std::sort(uvRevamp.begin(), uvRevamp.end());
+        uvRevamp.erase(std::unique(uvRevamp.begin(), uvRevamp.end()), uvRevamp.end());
+        for (auto &uv: uvs)
+            uv = std::lower_bound(uvRevamp.begin(), uvRevamp.end(), uv) - uvRevamp.begin();
+        gatherAttrVector(out->uvs, prim->uvs, uvRevamp.data(), uvRevamp.size());
     }
+}
 
-    std::vector<std::vector<int>> face_revamp;
-
-    auto mock = [&] (auto getter) {
-        auto &prim_tris = getter(prim);
-        if (prim_tris.size()) {
-            face_revamp.clear();
-            face_revamp.resize(tagMax);
-            using T = std::decay_t<decltype(prim_tris[0])>;
-
-            for (size_t i = 0; i < prim_tris.size(); i++) {
-                auto ind = reinterpret_cast<decay_vec_t<T> const *>(&prim_tris[i]);
-                int tag = vert_unrevamp[ind[0]];
-                bool bad = false;
-                for (int j = 1; j < is_vec_n<T>; j++) {
-                    int new_tag = vert_unrevamp[ind[j]];
-                    if (tag != new_tag) {
-                        bad = true;
-                        break;
-                    }
-                }
-                if (!bad) face_revamp[tag].push_back(i);
-            }
+std::shared_ptr<PrimitiveObject> makePiece(PrimitiveObject const *prim) {
+    auto outprim = std::make_shared<PrimitiveObject>();
+    static_cast<IObject &>(*outprim) = *prim;
+    outprim->mtl = prim->mtl;
+    outprim->inst = prim->inst;
+    return outprim;
+}
 
-            for (int tag = 0; tag < tagMax; tag++) {
-                auto &revamp = face_revamp[tag];
-                auto &v_revamp = vert_revamp[tag];
-                auto *outprim = primList[tag].get();
-                auto &outprim_tris = getter(outprim);
-
-                outprim_tris.resize(revamp.size());
-                parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                    auto ind = reinterpret_cast<decay_vec_t<T> const *>(&prim_tris[revamp[i]]);
-                    auto outind = reinterpret_cast<decay_vec_t<T> *>(&outprim_tris[i]);
-                    for (int j = 0; j < is_vec_n<T>; j++) {
-                        outind[j] = v_revamp[ind[j]];
-                    }
-                });
-
-                prim_tris.foreach_attr([&] (auto const &key, auto const &inarr) {
-                    using T = std::decay_t<decltype(inarr[0])>;
-                    auto &outarr = outprim_tris.template add_attr<T>(key);
-                    parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                        outarr[i] = inarr[revamp[i]];
-                    });
-                });
-            }
-        }
+}
+
+ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeVerts(PrimitiveObject *prim, std::string tagAttr) {
+    if (!prim->verts.size()) return {};
+
+    auto const &tagArr = prim->verts.attr<int>(tagAttr);
+    int tagMax = parallel_reduce_max(tagArr.begin(), tagArr.end()) + 1;
+
+    std::vector<std::shared_ptr<PrimitiveObject>> primList(tagMax);
+    parallel_for((size_t)tagMax, [&] (size_t tag) {
+        primList[tag] = makePiece(prim);
+    });
+
+    PieceLayout vertLayout;
+    vertLayout.piece.resize(prim->verts.size());
+    parallel_for(prim->verts.size(), [&] (size_t i) {
+        vertLayout.piece[i] = std::max(tagArr[i], -1);
+    });
+    vertLayout.build(tagMax);
+    auto remap = [&] (int i) { return vertLayout.local[i]; };
+    parallel_for((size_t)tagMax, [&] (size_t tag) {
+        gatherAttrVector(primList[tag]->verts, prim->verts, vertLayout.slice(tag), vertLayout.size(tag));
+    });
+
+    // a face goes to a piece only if all of its verts are in it
+    auto split = [&] (auto getter) {
+        auto const &in = getter(prim);
+        if (!in.size())
+            return;
+        PieceLayout faceLayout;
+        faceLayout.piece.resize(in.size());
+        parallel_for(in.size(), [&] (size_t i) {
+            faceLayout.piece[i] = pieceOfIndices(in[i], vertLayout.piece);
+        });
+        faceLayout.build(tagMax);
+        parallel_for((size_t)tagMax, [&] (size_t tag) {
+            auto &out = getter(primList[tag].get());
+            gatherAttrVector(out, in, faceLayout.slice(tag), faceLayout.size(tag));
+            remapIndices(out.values, remap);
+        });
     };
-    mock([] (auto &&p) -> auto & { return p->points; });
-    mock([] (auto &&p) -> auto & { return p->lines; });
-    mock([] (auto &&p) -> auto & { return p->tris; });
-    mock([] (auto &&p) -> auto & { return p->quads; });
+    split([] (auto *p) -> auto & { return p->points; });
+    split([] (auto *p) -> auto & { return p->lines; });
+    split([] (auto *p) -> auto & { return p->tris; });
+    split([] (auto *p) -> auto & { return p->quads; });
+    split([] (auto *p) -> auto & { return p->edges; });
 
     if (prim->polys.size()) {
-        face_revamp.clear();
-        face_revamp.resize(tagMax);
-
-        for (size_t i = 0; i < prim->polys.size(); i++) {
-            auto &[base, len] = prim->polys[i];
-            if (len <= 0) continue;
-            int tag = vert_unrevamp[prim->loops[base]];
-            bool bad = false;
-            for (int j = base + 1; j < base + len; i++) {
-                int new_tag = vert_unrevamp[prim->loops[j]];
-                if (tag != new_tag) {
-                    bad = true;
-                    break;
-                }
+        PieceLayout polyLayout;
+        polyLayout.piece.resize(prim->polys.size());
+        parallel_for(prim->polys.size(), [&] (size_t i) {
+            auto [base, len] = prim->polys[i];
+            int p = len > 0 ? vertLayout.piece[prim->loops[base]] : -1;
+            for (int j = base + 1; j < base + len && p >= 0; j++) {
+                if (vertLayout.piece[prim->loops[j]] != p)
+                    p = -1;
             }
-            if (!bad) face_revamp[tag].push_back(i);
-        }
-
-        for (int tag = 0; tag < tagMax; tag++) {
-            auto &revamp = face_revamp[tag];
-            auto &v_revamp = vert_revamp[tag];
+            polyLayout.piece[i] = p;
+        });
+        polyLayout.build(tagMax);
+        parallel_for((size_t)tagMax, [&] (size_t tag) {
             auto *outprim = primList[tag].get();
-
-            outprim->polys.resize(revamp.size());
-            for (size_t i = 0; i < revamp.size(); i++) {
-                auto const &[base, len] = prim->polys[revamp[i]];
-                int new_base = outprim->loops.size();
-                for (int j = base; j < base + len; j++) {
-                    outprim->loops.push_back(prim->loops[j]);
-                }
-                outprim->polys[i] = {new_base, len};
-            }
-
-            prim->polys.foreach_attr([&] (auto const &key, auto const &inarr) {
-                using T = std::decay_t<decltype(inarr[0])>;
-                auto &outarr = outprim->polys.add_attr<T>(key);
-                parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                    outarr[i] = inarr[revamp[i]];
-                });
-            });
-        }
+            gatherPolys(outprim, prim, polyLayout.slice(tag), polyLayout.size(tag));
+            remapIndices(outprim->loops.values, remap);
+        });
     }
-#endif
 
     return primList;
 }
@@ -206,110 +228,117 @@ void remap_attr_on_faces(PrimitiveObject *prim, std::string tagAttr, std::map<in
     }
 }
 
-ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeFaces(PrimitiveObject *prim, std::string tagAttr) {
-    if (!prim->verts.size()) return {};
-
-    if (prim->tris.size() > 0 && prim->polys.size() > 0) {
-        primPolygonate(prim, true);
+// drop names no face of the piece refers to, e.g. abcpath_{i} in userData
+static void remapFaceNames(PrimitiveObject *prim, std::string const &name) {
+    auto name_set = get_attr_on_faces(prim, name, true);
+    std::map<int, int> mapping;
+    std::vector<std::string> names;
+    for (auto &k: name_set) {
+        mapping[k] = names.size();
+        names.push_back(prim->userData().get2<std::string>(format("{}_{}", name, k)));
+    }
+    remap_attr_on_faces(prim, name, mapping);
+    auto old_count = prim->userData().get2<int>(name + "_count", 0);
+    for (int j = 0; j < old_count; j++) {
+        prim->userData().del(format("{}_{}", name, j));
     }
 
-    std::vector<std::shared_ptr<PrimitiveObject>> list;
+    for (int j = 0; j < names.size(); j++) {
+        prim->userData().set2(format("{}_{}", name, j), names[j]);
+    }
+    prim->userData().set2(name + "_count", int(name_set.size()));
+}
 
+// pieces are clones with the other faces removed, used when points, lines or quads are present
+static void primUnmergeFacesLegacy(PrimitiveObject *prim, std::string const &tagAttr,
+                                   std::vector<std::shared_ptr<PrimitiveObject>> &list) {
     std::map<int, std::vector<int>> mapping;
     if (prim->tris.size() > 0) {
         auto &attr = prim->tris.attr<int>(tagAttr);
         for (auto i = 0; i < prim->tris.size(); i++) {
-            if (mapping.count(attr[i]) == 0) {
-                mapping[attr[i]] = {};
-            }
             mapping[attr[i]].push_back(i);
         }
         for (auto &[key, val]: mapping) {
             auto new_prim = std::dynamic_pointer_cast<PrimitiveObject>(prim->clone());
-            new_prim->tris.resize(val.size());
-            for (auto i = 0; i < val.size(); i++) {
-                new_prim->tris[i] = prim->tris[val[i]];
-            }
-            new_prim->tris.foreach_attr<AttrAcceptAll>([&](auto const &key, auto &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                auto &attr = prim->tris.attr<T>(key);
-                for (auto i = 0; i < arr.size(); i++) {
-                    arr[i] = attr[val[i]];
-                }
-            });
+            gatherAttrVector(new_prim->tris, prim->tris, val.data(), val.size());
             list.push_back(new_prim);
         }
     }
     else if (prim->polys.size() > 0) {
         auto &attr = prim->polys.attr<int>(tagAttr);
         for (auto i = 0; i < prim->polys.size(); i++) {
-            if (mapping.count(attr[i]) == 0) {
-                mapping[attr[i]] = {};
-            }
             mapping[attr[i]].push_back(i);
         }
         for (auto &[key, val]: mapping) {
             auto new_prim = std::dynamic_pointer_cast<PrimitiveObject>(prim->clone());
-            new_prim->polys.resize(val.size());
-            for (auto i = 0; i < val.size(); i++) {
-                new_prim->polys[i] = prim->polys[val[i]];
-            }
-            new_prim->polys.foreach_attr<AttrAcceptAll>([&](auto const &key, auto &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                auto &attr = prim->polys.attr<T>(key);
-                for (auto i = 0; i < arr.size(); i++) {
-                    arr[i] = attr[val[i]];
-                }
-            });
+            gatherAttrVector(new_prim->polys, prim->polys, val.data(), val.size());
             list.push_back(new_prim);
         }
     }
-    for (auto i = 0; i < list.size(); i++) {
+    parallel_for(list.size(), [&] (size_t i) {
         primKillDeadVerts(list[i].get());
-        // remove unused abcpath
-        {
-            auto abcpath_set = get_attr_on_faces(list[i].get(), "abcpath", true);
-            std::map<int, int> mapping;
-            std::vector<std::string> abcpaths;
-            for (auto &k: abcpath_set) {
-                mapping[k] = abcpaths.size();
-                abcpaths.push_back(list[i]->userData().get2<std::string>(format("abcpath_{}", k)));
-            }
-            remap_attr_on_faces(list[i].get(), "abcpath", mapping);
-            auto old_abcpath_count = list[i]->userData().get2<int>("abcpath_count", 0);
-            for (int j = 0; j < old_abcpath_count; j++) {
-                list[i]->userData().del(format("abcpath_{}", j));
-            }
+    });
+}
 
-            for (int j = 0; j < abcpaths.size(); j++) {
-                list[i]->userData().set2(format("abcpath_{}", j), abcpaths[j]);
-            }
-            list[i]->userData().set2("abcpath_count", int(abcpath_set.size()));
-        }
-        // remove unused faceset
-        {
-            auto abcpath_set = get_attr_on_faces(list[i].get(), "faceset", true);
-            std::map<int, int> mapping;
-            std::vector<std::string> abcpaths;
-            for (auto &k: abcpath_set) {
-                mapping[k] = abcpaths.size();
-                abcpaths.push_back(list[i]->userData().get2<std::string>(format("faceset_{}", k)));
-            }
-            remap_attr_on_faces(list[i].get(), "faceset", mapping);
-            auto old_abcpath_count = list[i]->userData().get2<int>("faceset_count", 0);
-            for (int j = 0; j < old_abcpath_count; j++) {
-                list[i]->userData().del(format("faceset_{}", j));
-            }
+ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeFaces(PrimitiveObject *prim, std::string tagAttr) {
+    if (!prim->verts.size()) return {};
 
-            for (int j = 0; j < abcpaths.size(); j++) {
-                list[i]->userData().set2(format("faceset_{}", j), abcpaths[j]);
+    if (prim->tris.size() > 0 && prim->polys.size() > 0) {
+        primPolygonate(prim, true);
+    }
+
+    std::vector<std::shared_ptr<PrimitiveObject>> list;
+
+    bool isPolys = prim->polys.size() > 0;
+    bool onlyFaces = !prim->points.size() && !prim->lines.size() && !prim->quads.size() && !prim->edges.size()
+        && (isPolys || (!prim->loops.size() && !prim->uvs.size()));
+    if (onlyFaces && (prim->tris.size() || isPolys)) {
+        // pieces hold just their faces and the verts those use, built in parallel
+        auto const &attr = isPolys ? prim->polys.attr<int>(tagAttr) : prim->tris.attr<int>(tagAttr);
+        std::vector<int> tags(attr);
+        std::sort(tags.begin(), tags.end());
+        tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+        PieceLayout faceLayout;
+        faceLayout.piece.resize(attr.size());
+        parallel_for(attr.size(), [&] (size_t i) {
+            faceLayout.piece[i] = std::lower_bound(tags.begin(), tags.end(), attr[i]) - tags.begin();
+        });
+        faceLayout.build(tags.size());
+
+        list.resize(tags.size());
+        parallel_for(tags.size(), [&] (size_t p) {
+            auto outprim = makePiece(prim);
+            std::vector<int> vertRevamp;
+            if (isPolys) {
+                gatherPolys(outprim.get(), prim, faceLayout.slice(p), faceLayout.size(p));
+                vertRevamp = outprim->loops.values;
+            } else {
+                gatherAttrVector(outprim->tris, prim->tris, faceLayout.slice(p), faceLayout.size(p));
+                vertRevamp.reserve(outprim->tris.size() * 3);
+                for (auto const &ind: outprim->tris)
+                    vertRevamp.insert(vertRevamp.end(), {ind[0], ind[1], ind[2]});
             }
-            list[i]->userData().set2("faceset_count", int(abcpath_set.size()));
-        }
+            std::sort(vertRevamp.begin(), vertRevamp.end());
+            vertRevamp.erase(std::unique(vertRevamp.begin(), vertRevamp.end()), vertRevamp.end());
+            gatherAttrVector(outprim->verts, prim->verts, vertRevamp.data(), vertRevamp.size());
+            auto remap = [&] (int i) {
+                return int(std::lower_bound(vertRevamp.begin(), vertRevamp.end(), i) - vertRevamp.begin());
+            };
+            if (isPolys)
+                remapIndices(outprim->loops.values, remap);
+            else
+                remapIndices(outprim->tris.values, remap);
+            list[p] = std::move(outprim);
+        });
+    } else {
+        primUnmergeFacesLegacy(prim, tagAttr, list);
     }
+    parallel_for(list.size(), [&] (size_t i) {
+        remapFaceNames(list[i].get(), "abcpath");
+        remapFaceNames(list[i].get(), "faceset");
+    });
     return list;
 }
-
 namespace {
 
 struct PrimUnmerge : INode {
@@ -145,11 +145,11 @@ struct NumericOperator : zeno::INode {
 
     virtual void apply() override {
         auto op = get_param<std::string>("op_type");
-        auto ret = std::make_unique<zeno::NumericObject>();
+        auto ret = zeno::make_pooled<zeno::NumericObject>();
         auto lhs = get_input<zeno::NumericObject>("lhs");
         auto rhs = has_input("rhs") ?
             get_input<zeno::NumericObject>("rhs")
-            : std::make_shared<zeno::NumericObject>(0);
+            : zeno::make_pooled<zeno::NumericObject>(0);
         
         // todo: no ternary ops..
         std::visit([op, &ret](auto const &lhs, auto const &rhs) {
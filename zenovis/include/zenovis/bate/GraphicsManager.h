@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <vector>
 #include <zeno/types/UserData.h>
 #include <zeno/utils/MapStablizer.h>
@@ -39,14 +40,36 @@ struct GraphicsManager {
         return false;
     }
 
+    // view keys are "<node><postfix>:<frame>:<session>", the part before the
+    // frame identifies the same output across frames
+    static std::string view_stream(std::string const &key) {
+        return key.substr(0, key.find(':'));
+    }
+
     bool load_objects(std::vector<std::pair<std::string, std::shared_ptr<zeno::IObject>>> const &objs) {
+        // graphics about to be dropped by this pass, by stream, so that their
+        // successors can take over the device buffers
+        std::map<std::string, IGraphic *> retiring;
+        {
+            std::set<std::string> keys;
+            for (auto const &[key, obj] : objs)
+                keys.insert(key);
+            for (auto const &[key, gra] : graphics.pairs())
+                if (!keys.count(key))
+                    retiring.emplace(view_stream(key), gra);
+        }
         auto ins = graphics.insertPass();
         realtime_graphics.clear();
         for (auto const &[key, obj] : objs) {
             if (load_realtime_object(key, obj)) continue;
             if (ins.may_emplace(key)) {
                 zeno::log_debug("load_object: loading graphics [{}]", key);
-                auto ig = makeGraphic(scene, obj.get());
+                IGraphic *previous = nullptr;
+                if (auto it = retiring.find(view_stream(key)); it != retiring.end()) {
+                    previous = it->second;
+                    retiring.erase(it);
+                }
+                auto ig = makeGraphic(scene, obj.get(), previous);
                 zeno::log_debug("load_object: loaded graphics to {}", ig.get());
                 ig->nameid = key;
                 ig->objholder = obj;
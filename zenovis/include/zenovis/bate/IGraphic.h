@@ -71,6 +71,8 @@ struct IPicker : IGraphicDraw {
 
 struct MakeGraphicVisitor {
     Scene *in_scene{};
+    IGraphic *in_previous{}; // graphic of the same view stream in the last frame
+
     std::unique_ptr<IGraphic> out_result;
 
 #define _ZENO_PER_XMACRO(TypeName, ...) \
@@ -79,7 +81,7 @@ ZENO_XMACRO_IObject(_ZENO_PER_XMACRO)
 #undef _ZENO_PER_XMACRO
 };
 
-std::unique_ptr<IGraphic> makeGraphic(Scene *scene, zeno::IObject *obj);
+std::unique_ptr<IGraphic> makeGraphic(Scene *scene, zeno::IObject *obj, IGraphic *previous = nullptr);
 std::unique_ptr<IGraphicDraw> makeGraphicAxis(Scene *scene);
 std::unique_ptr<IGraphicDraw> makeGraphicGrid(Scene *scene);
 std::unique_ptr<IGraphicDraw> makeGraphicSelectBox(Scene *scene);
@@ -9,6 +9,7 @@ struct Buffer : zeno::disable_copy {
     GLuint buf;
     GLuint target{GL_ARRAY_BUFFER};
     GLuint m_usage = GL_STATIC_DRAW;
+    size_t m_size = 0;
 
     Buffer(GLuint target = GL_ARRAY_BUFFER) : target(target) {
         CHECK_GL(glGenBuffers(1, &buf));
@@ -33,6 +34,7 @@ struct Buffer : zeno::disable_copy {
     void bind_data(const void *data, size_t size,
                    GLuint usage = GL_STATIC_DRAW) {
         m_usage = usage;
+        m_size = size;
         CHECK_GL(glBindBuffer(target, buf));
         CHECK_GL(glBufferData(target, size, data, usage));
     }
@@ -1,3 +1,6 @@
+#include <cstdint>
+#include <cstring>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
@@ -24,11 +27,15 @@ namespace {
 
 using namespace opengl;
 
+using Hash = std::uint64_t;
+
 struct ZhxxDrawObject {
     std::vector<std::unique_ptr<Buffer>> vbos;
     std::unique_ptr<Buffer> ebo;
     size_t count = 0;
     Program *prog{};
+    std::vector<Hash> hashes; // of the inputs each vbo was built from
+    Hash eboHash = 0;
 };
 #if 0
 static void parsePointsDrawBuffer(zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
@@ -59,118 +66,191 @@ static void parsePointsDrawBuffer(zeno::PrimitiveObject *prim, ZhxxDrawObject &o
 }
 #endif
 
-static void parseLinesDrawBuffer(zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
-    auto const &pos = prim->attr<zeno::vec3f>("pos");
-    auto const &clr = prim->attr<zeno::vec3f>("clr");
-    auto const &nrm = prim->attr<zeno::vec3f>("nrm");
-    auto const &tang = prim->attr<zeno::vec3f>("tang");
-    auto const &lines = prim->lines;
-    obj.count = prim->lines.size();
-    obj.vbos.resize(5);
-    std::vector<zeno::vec2i> linesdata(obj.count);
-    std::vector<zeno::vec3f> _pos(obj.count * 2);
-    std::vector<zeno::vec3f> _clr(obj.count * 2);
-    std::vector<zeno::vec3f> _nrm(obj.count * 2);
-    std::vector<zeno::vec3f> _uv(obj.count * 2);
-    std::vector<zeno::vec3f> _tang(obj.count * 2);
-#pragma omp parallel for
-    for (auto i = 0; i < obj.count; i++) {
-        _pos[i * 2 + 0] = pos[lines[i][0]];
-        _pos[i * 2 + 1] = pos[lines[i][1]];
-
-        _clr[i * 2 + 0] = clr[lines[i][0]];
-        _clr[i * 2 + 1] = clr[lines[i][1]];
+static Hash hashCombine(Hash a, Hash b) {
+    return a ^ (b + 0x9e3779b97f4a7c15ull + (a << 6) + (a >> 2));
+}
 
-        _nrm[i * 2 + 0] = nrm[lines[i][0]];
-        _nrm[i * 2 + 1] = nrm[lines[i][1]];
+// content hash of an attribute array, chunks are hashed in parallel
+static Hash hashBytes(const void *data, size_t size) {
+    constexpr size_t kChunk = 1 << 20;
+    auto bytes = static_cast<const unsigned char *>(data);
+    size_t nchunks = (size + kChunk - 1) / kChunk;
+    std::vector<Hash> partial(nchunks);
+#pragma omp parallel for
+    for (intptr_t c = 0; c < (intptr_t)nchunks; c++) {
+        size_t base = c * kChunk, n = std::min(kChunk, size - base);
+        Hash h = 14695981039346656037ull;
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            std::uint64_t w;
+            std::memcpy(&w, bytes + base + i, 8);
+            h = (h ^ w) * 1099511628211ull;
+        }
+        for (; i < n; i++)
+            h = (h ^ bytes[base + i]) * 1099511628211ull;
+        partial[c] = h;
+    }
+    Hash h = size;
+    for (auto p: partial)
+        h = hashCombine(h, p);
+    return h;
+}
 
-        _tang[i * 2 + 0] = tang[lines[i][0]];
-        _tang[i * 2 + 1] = tang[lines[i][1]];
+template <class T>
+static Hash hashArray(std::vector<T> const &arr) {
+    return hashBytes(arr.data(), arr.size() * sizeof(T));
+}
 
-        linesdata[i] = zeno::vec2i(i * 2, i * 2 + 1);
+// Fills slot with data. prev is the buffer of the same slot in the graphic
+// of the previous frame, its buffer object is rewritten in place rather than
+// allocating a new one; contents that change every frame go DYNAMIC_DRAW.
+static void uploadBuffer(std::unique_ptr<Buffer> &slot, std::unique_ptr<Buffer> prev,
+                         GLuint target, const void *data, size_t size) {
+    if (!prev) {
+        slot = std::make_unique<Buffer>(target);
+        slot->bind_data(data, size);
+        return;
     }
-    bool has_uv = lines.has_attr("uv0") && lines.has_attr("uv1");
-    if (has_uv) {
-        auto &uv0 = lines.attr<zeno::vec3f>("uv0");
-        auto &uv1 = lines.attr<zeno::vec3f>("uv1");
-        for (auto i = 0; i < obj.count; i++) {
-            _uv[i * 2 + 0] = uv0[i];
-            _uv[i * 2 + 1] = uv1[i];
-        }
+    slot = std::move(prev);
+    if (slot->m_size == size && size) {
+        slot->bind();
+        slot->bind_sub_data(data, size, 0);
+    } else {
+        slot->bind_data(data, size, GL_DYNAMIC_DRAW);
     }
+}
 
-    obj.vbos[0] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[0]->bind_data(_pos.data(), _pos.size() * sizeof(_pos[0]));
-    obj.vbos[1] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[1]->bind_data(_clr.data(), _clr.size() * sizeof(_clr[0]));
-    obj.vbos[2] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[2]->bind_data(_nrm.data(), _nrm.size() * sizeof(_nrm[0]));
-    obj.vbos[3] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[3]->bind_data(_uv.data(), _uv.size() * sizeof(_uv[0]));
-    obj.vbos[4] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[4]->bind_data(_tang.data(), _tang.size() * sizeof(_tang[0]));
+// Per-corner attributes of the uv draw path of lines (N = 2) or
+// triangles (N = 3), expanded by a background job.
+struct CornerBuffers {
+    std::vector<zeno::vec3f> data[5]; // pos, clr, nrm, uv, tang
+    std::vector<int> indices;
+    Hash hashes[5] = {};
+    Hash eboHash = 0;
+    bool reuse[5] = {};               // unchanged since the previous frame
+    bool reuseEbo = false;
+};
 
-    if (obj.count) {
-        obj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-        obj.ebo->bind_data(&(linesdata[0]), obj.count * sizeof(linesdata[0]));
-    }
+static zeno::vec3f triangleTangent(zeno::vec3f const &pos0, zeno::vec3f const &pos1, zeno::vec3f const &pos2,
+                                   zeno::vec3f const &uv0, zeno::vec3f const &uv1, zeno::vec3f const &uv2) {
+    auto edge0 = pos1 - pos0;
+    auto edge1 = pos2 - pos0;
+    auto deltaUV0 = uv1 - uv0;
+    auto deltaUV1 = uv2 - uv0;
+
+    auto f = 1.0f / (deltaUV0[0] * deltaUV1[1] -
+                     deltaUV1[0] * deltaUV0[1] + 1e-5);
+
+    zeno::vec3f tangent;
+    tangent[0] = f * (deltaUV1[1] * edge0[0] - deltaUV0[1] * edge1[0]);
+    tangent[1] = f * (deltaUV1[1] * edge0[1] - deltaUV0[1] * edge1[1]);
+    tangent[2] = f * (deltaUV1[1] * edge0[2] - deltaUV0[1] * edge1[2]);
+    return tangent;
 }
 
-static void computeTrianglesTangent(zeno::PrimitiveObject *prim) {
-    const auto &tris = prim->tris;
-    const auto &pos = prim->attr<zeno::vec3f>("pos");
-    auto const &nrm = prim->attr<zeno::vec3f>("nrm");
-    auto &tang = prim->tris.add_attr<zeno::vec3f>("tang");
-    bool has_uv =
-        tris.has_attr("uv0") && tris.has_attr("uv1") && tris.has_attr("uv2");
-    //printf("!!has_uv = %d\n", has_uv);
-    const zeno::vec3f *uv0_data = nullptr;
-    const zeno::vec3f *uv1_data = nullptr;
-    const zeno::vec3f *uv2_data = nullptr;
-    if(has_uv)
-    {
-        uv0_data = tris.attr<zeno::vec3f>("uv0").data();
-        uv1_data = tris.attr<zeno::vec3f>("uv1").data();
-        uv2_data = tris.attr<zeno::vec3f>("uv2").data();
-    }
+template <int N>
+static auto &cornerElements(zeno::PrimitiveObject *prim) {
+    if constexpr (N == 3)
+        return prim->tris;
+    else
+        return prim->lines;
+}
+
+// Decides which slots have to be rebuilt by comparing input hashes with the
+// slots of prev, the same draw object of the previous frame.
+template <int N>
+static CornerBuffers planCornerBuffers(zeno::PrimitiveObject *prim, Hash const *vertHashes,
+                                      ZhxxDrawObject const &prev) {
+    auto const &elems = cornerElements<N>(prim);
+    static const char *uvNames[3] = {"uv0", "uv1", "uv2"};
+    CornerBuffers res;
+    Hash topo = hashArray(elems.values);
+    Hash uvHash = elems.size();
+    for (int k = 0; k < N; k++)
+        uvHash = hashCombine(uvHash, hashArray(elems.template attr<zeno::vec3f>(uvNames[k])));
+    res.hashes[0] = hashCombine(topo, vertHashes[0]);
+    res.hashes[1] = hashCombine(topo, vertHashes[1]);
+    res.hashes[2] = hashCombine(topo, vertHashes[2]);
+    res.hashes[3] = uvHash;
+    if constexpr (N == 3)
+        res.hashes[4] = hashCombine(res.hashes[0], uvHash);
+    else
+        res.hashes[4] = hashCombine(topo, vertHashes[4]);
+    res.eboHash = elems.size();
+    for (int i = 0; i < 5; i++)
+        res.reuse[i] = i < prev.vbos.size() && prev.vbos[i] && i < prev.hashes.size() && prev.hashes[i] == res.hashes[i];
+    res.reuseEbo = prev.ebo && prev.eboHash == res.eboHash;
+    return res;
+}
+
+// Expands the slots that are not reused, without touching prim.
+template <int N>
+static CornerBuffers expandCornerBuffers(std::shared_ptr<zeno::PrimitiveObject> prim, CornerBuffers res) {
+    auto const &elems = cornerElements<N>(prim.get());
+    static const char *uvNames[3] = {"uv0", "uv1", "uv2"};
+    size_t count = elems.size();
+    const zeno::vec3f *vert[5] = {
+        prim->attr<zeno::vec3f>("pos").data(),
+        prim->attr<zeno::vec3f>("clr").data(),
+        prim->attr<zeno::vec3f>("nrm").data(),
+        nullptr,
+        prim->attr<zeno::vec3f>("tang").data(),
+    };
+    const zeno::vec3f *uvs[N];
+    for (int k = 0; k < N; k++)
+        uvs[k] = elems.template attr<zeno::vec3f>(uvNames[k]).data();
+    for (int s = 0; s < 5; s++)
+        if (!res.reuse[s])
+            res.data[s].resize(count * N);
+    if (!res.reuseEbo)
+        res.indices.resize(count * N);
+
 #pragma omp parallel for
-    for (auto i = 0; i < prim->tris.size(); ++i) {
-        if (has_uv) {
-            const auto &pos0 = pos[tris[i][0]];
-            const auto &pos1 = pos[tris[i][1]];
-            const auto &pos2 = pos[tris[i][2]];
-            auto uv0 = uv0_data[i];
-            auto uv1 = uv1_data[i];
-            auto uv2 = uv2_data[i];
-
-            auto edge0 = pos1 - pos0;
-            auto edge1 = pos2 - pos0;
-            auto deltaUV0 = uv1 - uv0;
-            auto deltaUV1 = uv2 - uv0;
-
-            auto f = 1.0f / (deltaUV0[0] * deltaUV1[1] -
-                             deltaUV1[0] * deltaUV0[1] + 1e-5);
-
-            zeno::vec3f tangent;
-            tangent[0] = f * (deltaUV1[1] * edge0[0] - deltaUV0[1] * edge1[0]);
-            tangent[1] = f * (deltaUV1[1] * edge0[1] - deltaUV0[1] * edge1[1]);
-            tangent[2] = f * (deltaUV1[1] * edge0[2] - deltaUV0[1] * edge1[2]);
-            //printf("%f %f %f\n", tangent[0], tangent[1], tangent[3]);
-            auto tanlen = zeno::length(tangent);
-            tangent *(1.f / (tanlen + 1e-8));
-            /*if (std::abs(tanlen) < 1e-8) {//fix by BATE
-                zeno::vec3f n = nrm[tris[i][0]], unused;
-                zeno::pixarONB(n, tang[i], unused);//TODO calc this in shader?
+    for (intptr_t i = 0; i < (intptr_t)count; i++) {
+        auto const &e = elems[i];
+        for (int s: {0, 1, 2})
+            if (!res.reuse[s])
+                for (int k = 0; k < N; k++)
+                    res.data[s][i * N + k] = vert[s][e[k]];
+        if (!res.reuse[3])
+            for (int k = 0; k < N; k++)
+                res.data[3][i * N + k] = uvs[k][i];
+        if (!res.reuse[4]) {
+            if constexpr (N == 3) {
+                auto tang = triangleTangent(vert[0][e[0]], vert[0][e[1]], vert[0][e[2]],
+                                            uvs[0][i], uvs[1][i], uvs[2][i]);
+                for (int k = 0; k < N; k++)
+                    res.data[4][i * N + k] = tang;
             } else {
-                tang[i] = tangent * (1.f / tanlen);
-            }*/
-            tang[i] = tangent;
-        } else {
-            tang[i] = zeno::vec3f(0);
-            //zeno::vec3f n = nrm[tris[i][0]], unused;
-            //zeno::pixarONB(n, tang[i], unused);
+                for (int k = 0; k < N; k++)
+                    res.data[4][i * N + k] = vert[4][e[k]];
+            }
         }
+        if (!res.reuseEbo)
+            for (int k = 0; k < N; k++)
+                res.indices[i * N + k] = i * N + k;
     }
+    return res;
+}
+
+static void uploadCornerBuffers(CornerBuffers &res, ZhxxDrawObject &obj, ZhxxDrawObject &prev) {
+    obj.vbos.resize(5);
+    obj.hashes.assign(res.hashes, res.hashes + 5);
+    for (int s = 0; s < 5; s++) {
+        std::unique_ptr<Buffer> old = s < prev.vbos.size() ? std::move(prev.vbos[s]) : nullptr;
+        if (res.reuse[s])
+            obj.vbos[s] = std::move(old);
+        else
+            uploadBuffer(obj.vbos[s], std::move(old), GL_ARRAY_BUFFER,
+                         res.data[s].data(), res.data[s].size() * sizeof(res.data[s][0]));
+    }
+    obj.eboHash = res.eboHash;
+    if (res.reuseEbo)
+        obj.ebo = std::move(prev.ebo);
+    else if (!res.indices.empty())
+        uploadBuffer(obj.ebo, std::move(prev.ebo), GL_ELEMENT_ARRAY_BUFFER,
+                     res.indices.data(), res.indices.size() * sizeof(res.indices[0]));
+    prev = {};
 }
 #if 0
 static void parseTrianglesDrawBufferCompress(zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
@@ -257,75 +337,6 @@ static void parseTrianglesDrawBufferCompress(zeno::PrimitiveObject *prim, ZhxxDr
     /* TOCK(bindebo); */
 }
 #endif
-static void parseTrianglesDrawBuffer(zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
-    /* TICK(parse); */
-    auto const &pos = prim->attr<zeno::vec3f>("pos");
-    auto const &clr = prim->attr<zeno::vec3f>("clr");
-    auto const &nrm = prim->attr<zeno::vec3f>("nrm");
-    auto const &tris = prim->tris;
-
-    obj.count = tris.size();
-    obj.vbos.resize(5);
-    std::vector<zeno::vec3i> trisdata(obj.count);
-    auto &tang = prim->tris.attr<zeno::vec3f>("tang");
-    std::vector<zeno::vec3f> _pos(obj.count * 3);
-    std::vector<zeno::vec3f> _clr(obj.count * 3);
-    std::vector<zeno::vec3f> _nrm(obj.count * 3);
-    std::vector<zeno::vec3f> _uv(obj.count * 3);
-    std::vector<zeno::vec3f> _tang(obj.count * 3);
-
-#pragma omp parallel for
-    for (auto i = 0; i < obj.count; i++) {
-        _pos[i * 3 + 0] = pos[tris[i][0]];
-        _pos[i * 3 + 1] = pos[tris[i][1]];
-        _pos[i * 3 + 2] = pos[tris[i][2]];
-
-        _clr[i * 3 + 0] = clr[tris[i][0]];
-        _clr[i * 3 + 1] = clr[tris[i][1]];
-        _clr[i * 3 + 2] = clr[tris[i][2]];
-
-        _nrm[i * 3 + 0] = nrm[tris[i][0]];
-        _nrm[i * 3 + 1] = nrm[tris[i][1]];
-        _nrm[i * 3 + 2] = nrm[tris[i][2]];
-
-        _tang[i * 3 + 0] = tang[i];
-        _tang[i * 3 + 1] = tang[i];
-        _tang[i * 3 + 2] = tang[i];
-
-        trisdata[i] = zeno::vec3i(i * 3, i * 3 + 1, i * 3 + 2);
-    }
-    bool has_uv =
-            tris.has_attr("uv0") && tris.has_attr("uv1") && tris.has_attr("uv2");
-    if (has_uv) {
-        auto &uv0 = tris.attr<zeno::vec3f>("uv0");
-        auto &uv1 = tris.attr<zeno::vec3f>("uv1");
-        auto &uv2 = tris.attr<zeno::vec3f>("uv2");
-        for (auto i = 0; i < obj.count; i++) {
-            _uv[i * 3 + 0] = uv0[i];
-            _uv[i * 3 + 1] = uv1[i];
-            _uv[i * 3 + 2] = uv2[i];
-        }
-    }
-
-    obj.vbos[0] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[0]->bind_data(_pos.data(), _pos.size() * sizeof(_pos[0]));
-    obj.vbos[1] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[1]->bind_data(_clr.data(), _clr.size() * sizeof(_clr[0]));
-    obj.vbos[2] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[2]->bind_data(_nrm.data(), _nrm.size() * sizeof(_nrm[0]));
-    obj.vbos[3] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[3]->bind_data(_uv.data(), _uv.size() * sizeof(_uv[0]));
-    obj.vbos[4] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    obj.vbos[4]->bind_data(_tang.data(), _tang.size() * sizeof(_tang[0]));
-    /* TOCK(bindvbo); */
-    /* TICK(bindebo); */
-    if (obj.count) {
-        obj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-        obj.ebo->bind_data(&(trisdata[0]), obj.count * sizeof(trisdata[0]));
-    }
-    /* TOCK(bindebo); */
-}
-
 struct ZhxxGraphicPrimitive final : IGraphicDraw {
     Scene *scene;
     std::vector<std::unique_ptr<Buffer>> vbos = std::vector<std::unique_ptr<Buffer>>(5);
@@ -357,9 +368,25 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
     ZhxxDrawObject polyEdgeObj = {};
     ZhxxDrawObject polyUvObj = {};
 
-    explicit ZhxxGraphicPrimitive(Scene *scene_, zeno::PrimitiveObject *primArg)
+    // input hashes of vbos, slots that did not change since the previous
+    // frame keep its buffers instead of uploading again
+    Hash vboHashes[5] = {};
+    Hash pointsHash = 0;
+
+    // uv draw paths are expanded per corner in the background and uploaded
+    // on the first draw, together with the buffers taken over from the
+    // previous frame
+    std::future<CornerBuffers> lineJob, triJob;
+    ZhxxDrawObject linePrev, triPrev;
+
+    explicit ZhxxGraphicPrimitive(Scene *scene_, zeno::PrimitiveObject *primArg, ZhxxGraphicPrimitive *prev = nullptr)
         : scene(scene_), primUnique(std::make_shared<zeno::PrimitiveObject>(*primArg)) {
         prim = primUnique.get();
+        if (prev) {
+            prev->flushPending();
+            linePrev = std::move(prev->lineObj);
+            triPrev = std::move(prev->triObj);
+        }
         invisible = prim->userData().get2<bool>("invisible", 0);
         zeno::log_trace("rendering primitive size {}", prim->size());
 
@@ -554,57 +581,55 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
         auto const &tang = prim->attr<zeno::vec3f>("tang");
         vertex_count = prim->size();
 
-        vbos[0] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-        vbos[0]->bind_data(pos.data(), pos.size() * sizeof(pos[0]));
-        vbos[1] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-        vbos[1]->bind_data(clr.data(), clr.size() * sizeof(clr[0]));
-        vbos[2] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-        vbos[2]->bind_data(nrm.data(), nrm.size() * sizeof(nrm[0]));
-        vbos[3] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-        vbos[3]->bind_data(uv.data(), uv.size() * sizeof(uv[0]));
-        vbos[4] = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-        vbos[4]->bind_data(tang.data(), tang.size() * sizeof(tang[0]));
+        const std::vector<zeno::vec3f> *vertAttrs[5] = {&pos, &clr, &nrm, &uv, &tang};
+        Hash vertHashes[5];
+        for (int i = 0; i < 5; i++) {
+            vertHashes[i] = hashArray(*vertAttrs[i]);
+            std::unique_ptr<Buffer> old = prev ? std::move(prev->vbos[i]) : nullptr;
+            if (old && prev->vboHashes[i] == vertHashes[i])
+                vbos[i] = std::move(old);
+            else
+                uploadBuffer(vbos[i], std::move(old), GL_ARRAY_BUFFER,
+                             vertAttrs[i]->data(), vertAttrs[i]->size() * sizeof(zeno::vec3f));
+            vboHashes[i] = vertHashes[i];
+        }
 
         points_count = prim->points.size();
         if (points_count) {
             pointObj.count = points_count;
-            pointObj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-            pointObj.ebo->bind_data(prim->points.data(),
-                                    points_count * sizeof(prim->points[0]));
+            pointsHash = hashArray(prim->points.values);
+            std::unique_ptr<Buffer> old = prev ? std::move(prev->pointObj.ebo) : nullptr;
+            if (old && prev->pointsHash == pointsHash)
+                pointObj.ebo = std::move(old);
+            else
+                uploadBuffer(pointObj.ebo, std::move(old), GL_ELEMENT_ARRAY_BUFFER,
+                             prim->points.data(), points_count * sizeof(prim->points[0]));
             pointObj.prog = get_points_program();
         }
 
         lines_count = prim->lines.size();
         if (lines_count) {
-            // lines_ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-            // lines_ebo->bind_data(prim->lines.data(), lines_count * sizeof(prim->lines[0]));
-            // lines_prog = get_lines_program();
+            lineObj.count = lines_count;
             if (!(prim->lines.has_attr("uv0") && prim->lines.has_attr("uv1"))) {
-                lineObj.count = lines_count;
-                lineObj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-                lineObj.ebo->bind_data(prim->lines.data(),
-                                       lines_count * sizeof(prim->lines[0]));
+                uploadElements(lineObj, linePrev, prim->lines.values);
             } else {
-                parseLinesDrawBuffer(&*prim, lineObj);
+                auto plan = planCornerBuffers<2>(prim, vertHashes, linePrev);
+                lineJob = std::async(std::launch::async, expandCornerBuffers<2>, primUnique, std::move(plan));
             }
             lineObj.prog = get_lines_program();
         }
 
         tris_count = prim->tris.size();
         if (tris_count) {
+            triObj.count = tris_count;
             if (!(prim->tris.has_attr("uv0") && prim->tris.has_attr("uv1") &&
                   prim->tris.has_attr("uv2"))) {
-                triObj.count = tris_count;
-                triObj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-                triObj.ebo->bind_data(prim->tris.data(),
-                                      tris_count * sizeof(prim->tris[0]));
-
+                uploadElements(triObj, triPrev, prim->tris.values);
             } else {
-                computeTrianglesTangent(&*prim);
-                parseTrianglesDrawBuffer(&*prim, triObj);
+                auto plan = planCornerBuffers<3>(prim, vertHashes, triPrev);
+                triJob = std::async(std::launch::async, expandCornerBuffers<3>, primUnique, std::move(plan));
             }
 
-            bool findCamera = false;
             triObj.prog = get_tris_program();
         }
 
@@ -618,7 +643,31 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
         }
     }
 
+    // index buffer of a draw path that uses the per-vertex vbos
+    template <class T>
+    static void uploadElements(ZhxxDrawObject &obj, ZhxxDrawObject &prev, std::vector<T> const &elems) {
+        obj.eboHash = hashArray(elems);
+        if (prev.ebo && prev.vbos.empty() && prev.eboHash == obj.eboHash)
+            obj.ebo = std::move(prev.ebo);
+        else
+            uploadBuffer(obj.ebo, std::move(prev.ebo), GL_ELEMENT_ARRAY_BUFFER,
+                         elems.data(), elems.size() * sizeof(elems[0]));
+        prev = {};
+    }
+
+    void flushPending() {
+        if (lineJob.valid()) {
+            auto res = lineJob.get();
+            uploadCornerBuffers(res, lineObj, linePrev);
+        }
+        if (triJob.valid()) {
+            auto res = triJob.get();
+            uploadCornerBuffers(res, triObj, triPrev);
+        }
+    }
+
     virtual void draw() override {
+        flushPending();
         bool selected = scene->selected.count(nameid) > 0;
         if (scene->drawOptions->uv_mode && !selected) {
             return;
@@ -827,7 +876,8 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
 }
 
 void MakeGraphicVisitor::visit(zeno::PrimitiveObject *obj) {
-     this->out_result = std::make_unique<ZhxxGraphicPrimitive>(this->in_scene, obj);
+     this->out_result = std::make_unique<ZhxxGraphicPrimitive>(this->in_scene, obj,
+         dynamic_cast<ZhxxGraphicPrimitive *>(this->in_previous));
 }
 
 } // namespace zenovis